@@ -0,0 +1,110 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "ShadowAtlas.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+//Atlas benchmark setup (matching the LightManager's atlas)
+#define ATLAS_SIZE 4096
+#define ATLAS_MIN_TILE_SIZE 128
+#define ATLAS_MAX_TILE_SIZE 2048
+
+// --------------------------------------------------------
+// Atlas benchmark - packs a random set of lights' shadow tiles into
+// the shadow atlas every frame, and checks every tile is in the atlas,
+// on a multiple of its size and not overlapping another. Counts the
+// tiles that were halved to fit, or didn't fit at all
+// --------------------------------------------------------
+int RunAtlasBenchmark(int lightCount, int frames)
+{
+	ShadowAtlas atlas;
+	atlas.Init(ATLAS_SIZE, ATLAS_MIN_TILE_SIZE);
+
+	FastRandom rng;
+	rng.Seed(1);
+
+	printf("Packing %d lights' shadows into a %d x %d atlas for %d frames\n", lightCount, ATLAS_SIZE, ATLAS_SIZE, frames);
+
+	//Which texels are covered, in the smallest tiles
+	int cells = ATLAS_SIZE / ATLAS_MIN_TILE_SIZE;
+	std::vector<unsigned char> covered(cells * cells);
+
+	std::vector<int> sizes;
+	std::vector<ShadowAtlasRect> rects;
+	double packTime = 0;
+	double fill = 0;
+	long long tiles = 0;
+	long long shrunk = 0;
+	long long dropped = 0;
+	long long overlapping = 0;
+	long long misplaced = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//A directional light's 2 cascades, point lights' 6 faces or spot lights, mostly small on screen
+		sizes.clear();
+		for (int l = 0; l < lightCount; l++)
+		{
+			float type = rng.NextFloat();
+			int count = type < 0.1f ? 2 : type < 0.5f ? 6 : 1;
+			float importance = type < 0.1f ? 1 : rng.NextFloat() * rng.NextFloat();
+			sizes.insert(sizes.end(), count, ShadowAtlas::GetTileSize(importance, ATLAS_MIN_TILE_SIZE, ATLAS_MAX_TILE_SIZE));
+		}
+		rects.resize(sizes.size());
+
+		auto start = std::chrono::high_resolution_clock::now();
+		atlas.Pack(sizes.data(), (int)sizes.size(), rects.data());
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		packTime += elapsed.count();
+
+		std::fill(covered.begin(), covered.end(), 0);
+		for (size_t i = 0; i < rects.size(); i++)
+		{
+			ShadowAtlasRect rect = rects[i];
+			tiles++;
+			if (rect.size == 0)
+			{
+				dropped++;
+				continue;
+			}
+			if (rect.size < sizes[i])
+				shrunk++;
+			if (rect.x < 0 || rect.y < 0 || rect.x + rect.size > ATLAS_SIZE || rect.y + rect.size > ATLAS_SIZE ||
+				rect.x % rect.size != 0 || rect.y % rect.size != 0)
+			{
+				misplaced++;
+				continue;
+			}
+
+			//Any cell already covered means the tile overlaps another
+			bool overlaps = false;
+			for (int y = rect.y / ATLAS_MIN_TILE_SIZE; y < (rect.y + rect.size) / ATLAS_MIN_TILE_SIZE; y++)
+			{
+				for (int x = rect.x / ATLAS_MIN_TILE_SIZE; x < (rect.x + rect.size) / ATLAS_MIN_TILE_SIZE; x++)
+				{
+					overlaps = overlaps || covered[y * cells + x];
+					covered[y * cells + x] = 1;
+				}
+			}
+			if (overlaps)
+				overlapping++;
+		}
+		fill += (double)atlas.GetUsedArea() / ((double)ATLAS_SIZE * ATLAS_SIZE);
+	}
+
+	printf("\nTime per pack (ms)\n");
+	printf("  pack           %.4f\n", packTime / frames);
+	printf("\nMemory (MB)\n");
+	printf("  atlas + cache  %.0f\n", 2.0 * ATLAS_SIZE * ATLAS_SIZE * 2 / (1024 * 1024));
+	printf("  old maps       %.0f (16 per light)\n", 16.0 * lightCount);
+	printf("\nResults\n");
+	printf("  filled         %.1f%%\n", fill * 100 / frames);
+	printf("  shrunk         %lld of %lld\n", shrunk, tiles);
+	printf("  didn't fit     %lld of %lld\n", dropped, tiles);
+	printf("  overlapping    %lld of %lld\n", overlapping, tiles);
+	printf("  misplaced      %lld of %lld\n", misplaced, tiles);
+	return overlapping > 0 || misplaced > 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "SpatialHash.h"
+#include "ColliderBatch.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// Order a pair of colliders so pair lists can be compared
+static ColliderPair SortPair(Collider* a, Collider* b)
+{
+	if (a < b)
+		return { a, b };
+	return { b, a };
+}
+
+// Compare pairs by their colliders' addresses
+static bool PairLess(const ColliderPair& a, const ColliderPair& b)
+{
+	return a.a < b.a || (a.a == b.a && a.b < b.b);
+}
+
+// --------------------------------------------------------
+// Broadphase benchmark - moves colliders around a spatial hash
+// and times the pair query, checking it against brute force
+// --------------------------------------------------------
+int RunBroadphaseBenchmark(int colliderCount, int frames)
+{
+	//Spread the colliders out at about the density of a busy level
+	float worldSize = sqrtf((float)colliderCount) * 2.0f;
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> place(-worldSize / 2, worldSize / 2);
+	std::uniform_real_distribution<float> move(-0.05f, 0.05f);
+	std::uniform_real_distribution<float> angle(0, XM_2PI);
+
+	SpatialHash spatialHash;
+	std::vector<Collider*> colliders;
+	std::vector<XMFLOAT3> positions;
+	for (int i = 0; i < colliderCount; i++)
+	{
+		XMFLOAT3 position = XMFLOAT3(place(rng), 0, place(rng));
+		Collider* collider = new Collider(position, XMFLOAT3(0.9f, 0.9f, 0.9f));
+		XMFLOAT4 rotation;
+		XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0, angle(rng), 0));
+		collider->SetRotation(rotation);
+		spatialHash.Insert(collider);
+
+		colliders.push_back(collider);
+		positions.push_back(position);
+	}
+
+	printf("Running %d frames with %d colliders (%.0f x %.0f area, %.1f cells)\n",
+		frames, colliderCount, worldSize, worldSize, spatialHash.GetCellSize());
+
+	std::vector<ColliderPair> pairs;
+	std::vector<ColliderPair> brutePairs;
+	std::vector<float> frameTimes;
+	frameTimes.reserve(frames);
+	double bruteTime = 0;
+	int bruteChecks = 0;
+	int mismatches = 0;
+	double totalPairs = 0;
+	int totalHits = 0;
+	std::vector<int> separatingAxes;
+	unsigned long long axisTests = 0;
+	unsigned long long separatedAxisTests = 0;
+	unsigned long long separatedPairs = 0;
+	double narrowphaseTime = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//Everything drifts a little every frame
+		for (int i = 0; i < colliderCount; i++)
+		{
+			positions[i].x += move(rng);
+			positions[i].z += move(rng);
+			colliders[i]->SetPosition(positions[i]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		spatialHash.QueryPairs(pairs);
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		frameTimes.push_back(elapsed.count());
+		totalPairs += pairs.size();
+
+		//Narrowphase on the candidates
+		separatingAxes.resize(pairs.size());
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < pairs.size(); i++)
+		{
+			separatingAxes[i] = ColliderBatch::FindSeparatingAxis(
+				pairs[i].a->GetOrientedBox(), pairs[i].b->GetOrientedBox());
+		}
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+		narrowphaseTime += elapsed.count();
+
+		for (size_t i = 0; i < pairs.size(); i++)
+		{
+			if (separatingAxes[i] < 0)
+				totalHits++;
+			axisTests += separatingAxes[i] < 0 ? SAT_AXIS_COUNT : separatingAxes[i] + 1;
+			if (separatingAxes[i] >= 0)
+			{
+				separatedPairs++;
+				separatedAxisTests += separatingAxes[i] + 1;
+			}
+		}
+
+		//Check against every pair on the first, last and every 100th frame
+		if (frame == 0 || frame == frames - 1 || frame % 100 == 0)
+		{
+			auto bruteStart = std::chrono::high_resolution_clock::now();
+			brutePairs.clear();
+			std::vector<XMFLOAT3> mins(colliderCount);
+			std::vector<XMFLOAT3> maxs(colliderCount);
+			for (int i = 0; i < colliderCount; i++)
+			{
+				colliders[i]->GetBounds(&mins[i], &maxs[i]);
+			}
+			for (int i = 0; i < colliderCount; i++)
+				for (int j = i + 1; j < colliderCount; j++)
+				{
+					if (mins[i].x <= maxs[j].x && maxs[i].x >= mins[j].x &&
+						mins[i].y <= maxs[j].y && maxs[i].y >= mins[j].y &&
+						mins[i].z <= maxs[j].z && maxs[i].z >= mins[j].z)
+						brutePairs.push_back(SortPair(colliders[i], colliders[j]));
+				}
+			std::chrono::duration<double, std::milli> bruteElapsed = std::chrono::high_resolution_clock::now() - bruteStart;
+			bruteTime += bruteElapsed.count();
+			bruteChecks++;
+
+			std::vector<ColliderPair> sortedPairs;
+			for (size_t i = 0; i < pairs.size(); i++)
+			{
+				sortedPairs.push_back(SortPair(pairs[i].a, pairs[i].b));
+			}
+			std::sort(sortedPairs.begin(), sortedPairs.end(), PairLess);
+			std::sort(brutePairs.begin(), brutePairs.end(), PairLess);
+			bool same = sortedPairs.size() == brutePairs.size();
+			for (size_t i = 0; same && i < sortedPairs.size(); i++)
+			{
+				same = sortedPairs[i].a == brutePairs[i].a && sortedPairs[i].b == brutePairs[i].b;
+			}
+			if (!same)
+			{
+				printf("Frame %d: spatial hash found %zu pairs, brute force found %zu\n",
+					frame, sortedPairs.size(), brutePairs.size());
+				mismatches++;
+			}
+		}
+	}
+
+	std::vector<float> sortedTimes = frameTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+	double totalTime = 0;
+	for (size_t i = 0; i < frameTimes.size(); i++)
+	{
+		totalTime += frameTimes[i];
+	}
+
+	printf("\nRefresh + pair query (ms)\n");
+	printf("  mean   %.4f\n", totalTime / frames);
+	printf("  p50    %.4f\n", Percentile(sortedTimes, 50));
+	printf("  p99    %.4f\n", Percentile(sortedTimes, 99));
+	printf("  max    %.4f\n", sortedTimes[sortedTimes.size() - 1]);
+	printf("\nBrute force bounds check (ms)\n");
+	printf("  mean   %.4f\n", bruteTime / bruteChecks);
+	printf("\nPairs\n");
+	printf("  candidates per frame %.1f\n", totalPairs / frames);
+	printf("  SAT hits per frame   %.1f\n", (double)totalHits / frames);
+	printf("  occupied cells       %d of %d kept\n", spatialHash.GetOccupiedCellCount(), spatialHash.GetCellCount());
+	printf("\nNarrowphase\n");
+	printf("  axis tests per pair  %.2f\n", axisTests / totalPairs);
+	printf("  ...not touching      %.2f\n", (double)separatedAxisTests / std::max(separatedPairs, 1ULL));
+	printf("  time per frame (ms)  %.4f\n", narrowphaseTime / frames);
+	printf("  mismatched frames    %d of %d checked\n", mismatches, bruteChecks);
+
+	for (int i = 0; i < colliderCount; i++)
+	{
+		delete colliders[i];
+	}
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
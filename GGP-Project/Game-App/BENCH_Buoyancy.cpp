@@ -0,0 +1,120 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "SwimmerManager.h"
+#include "JobSystem.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Buoyancy benchmark - N swimmers floating in the water,
+// integrated with the SIMD and scalar kernels (checking they
+// match exactly), plus the cost of reading and writing the
+// swimmers' transforms and of the full threaded step
+// --------------------------------------------------------
+int RunBuoyancyBenchmark(int swimmerCount, int frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> place(-50, 50);
+	std::uniform_real_distribution<float> height(-1, 0.5f);
+
+	//Mostly floating, with a few leaving (no buoyancy) and a few
+	//on a trail (not in the water) so every lane mask is used
+	SwimmerManager* swimmerManager = SwimmerManager::GetInstance();
+	SwimmerPhysics* physics = swimmerManager->GetPhysics();
+	for (int i = 0; i < swimmerCount; i++)
+	{
+		Swimmer* swimmer = swimmerManager->CreateSwimmer();
+		swimmer->SetPosition(place(rng), height(rng), place(rng));
+		if (i % 16 == 7)
+			swimmer->SetSwimmerState(SwimmerState::Leaving);
+		else if (i % 16 == 15)
+			swimmer->SetSwimmerState(SwimmerState::Still);
+		else swimmer->SetSwimmerState(SwimmerState::Floating);
+	}
+	int count = physics->GetCount();
+
+	printf("Running %d frames of buoyancy for %d swimmers (%d lanes)\n",
+		frames, count, SwimmerPhysics::GetLaneCount());
+
+	std::vector<float> startVelocities(count);
+	std::vector<float> simdHeights(count);
+	std::vector<float> simdVelocities(count);
+	float deltaTime = 1.0f / 60;
+	double gatherTime = 0;
+	double simdTime = 0;
+	double scalarTime = 0;
+	double writeTime = 0;
+	long long mismatches = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		physics->Gather(0, count, deltaTime);
+		std::chrono::duration<double, std::milli> gatherElapsed = std::chrono::high_resolution_clock::now() - start;
+		gatherTime += gatherElapsed.count();
+
+		for (int i = 0; i < count; i++)
+		{
+			startVelocities[i] = physics->GetVelocity(i);
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		physics->Integrate(0, count);
+		std::chrono::duration<double, std::milli> simdElapsed = std::chrono::high_resolution_clock::now() - start;
+		simdTime += simdElapsed.count();
+
+		for (int i = 0; i < count; i++)
+		{
+			simdHeights[i] = physics->GetHeight(i);
+			simdVelocities[i] = physics->GetVelocity(i);
+			physics->SetVelocity(i, startVelocities[i]);
+		}
+
+		//Same step again from the same state, one swimmer at a time
+		physics->Gather(0, count, deltaTime);
+		start = std::chrono::high_resolution_clock::now();
+		physics->IntegrateScalar(0, count);
+		std::chrono::duration<double, std::milli> scalarElapsed = std::chrono::high_resolution_clock::now() - start;
+		scalarTime += scalarElapsed.count();
+
+		for (int i = 0; i < count; i++)
+		{
+			float scalarHeight = physics->GetHeight(i);
+			float scalarVelocity = physics->GetVelocity(i);
+			if (memcmp(&scalarHeight, &simdHeights[i], sizeof(float)) != 0 ||
+				memcmp(&scalarVelocity, &simdVelocities[i], sizeof(float)) != 0)
+				mismatches++;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		physics->WriteBack(0, count);
+		std::chrono::duration<double, std::milli> writeElapsed = std::chrono::high_resolution_clock::now() - start;
+		writeTime += writeElapsed.count();
+	}
+
+	//The whole step, split across the job system
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		physics->Step(deltaTime);
+	}
+	std::chrono::duration<double, std::milli> stepElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	double perSwimmer = 1000000.0 / ((double)count * frames);
+	printf("\nTime per swimmer (ns)\n");
+	printf("  integrate simd    %.3f\n", simdTime * perSwimmer);
+	printf("  integrate scalar  %.3f (%.1fx)\n", scalarTime * perSwimmer, scalarTime / simdTime);
+	printf("  gather            %.3f\n", gatherTime * perSwimmer);
+	printf("  write back        %.3f\n", writeTime * perSwimmer);
+	printf("\nTime per step (ms)\n");
+	printf("  serial            %.3f\n", (gatherTime + simdTime + writeTime) / frames);
+	printf("  threaded (%d+1)    %.3f\n", JobSystem::GetInstance()->GetWorkerCount(), stepElapsed.count() / frames);
+	printf("\nResults\n");
+	printf("  mismatched  %lld of %lld\n", mismatches, (long long)count * frames);
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
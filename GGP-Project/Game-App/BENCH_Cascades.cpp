@@ -0,0 +1,127 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "ShadowCascades.h"
+#include "GameSimulation.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+//Cascade benchmark setup (matching the game's light) and points checked per cascade
+#define CASCADE_COUNT 2
+#define CASCADE_SHADOW_DISTANCE 60.0f
+#define CASCADE_SAMPLES 256
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Cascade benchmark - fits shadow cascades to a camera following a
+// boat around the arena every frame, and checks that every point the
+// camera sees in the arena lands in its cascade, and that the texels
+// stay on the same spots in the world. Counts the frames each cascade
+// moved on, which the renderer redraws its static casters on
+// --------------------------------------------------------
+int RunCascadeBenchmark(int size, int frames)
+{
+	ShadowCascades cascades;
+	cascades.Init(CASCADE_COUNT, size, 0.5f, CASCADE_SHADOW_DISTANCE);
+	float radius = LEVEL_RADIUS + 2.0f;
+	cascades.SetSceneBounds(XMFLOAT3(-radius, -8, -radius), XMFLOAT3(radius, 8, radius));
+
+	//The game's light, pointing down along its rotation
+	XMFLOAT3 lightDirection;
+	XMStoreFloat3(&lightDirection, XMVector3Rotate(XMVectorSet(0, 0, 1, 0),
+		XMQuaternionRotationRollPitchYaw(XMConvertToRadians(60), XMConvertToRadians(-45), 0)));
+
+	//The camera looks down at the boat from behind it
+	float pitch = XMConvertToRadians(CASCADE_CAMERA_PITCH);
+	XMFLOAT3 forward(0, -sinf(pitch), cosf(pitch));
+	XMFLOAT3 up(0, cosf(pitch), sinf(pitch));
+	float fov = 0.25f * XM_PI;
+	float aspectRatio = 16.0f / 9;
+
+	FastRandom rng;
+	rng.Seed(1);
+
+	printf("Fitting %d cascades of %d x %d for %d frames\n", CASCADE_COUNT, size, size, frames);
+
+	double fitTime = 0;
+	long long checked = 0;
+	long long outside = 0;
+	long long unsnapped = 0;
+	long long moved = 0;
+	double texelsPerUnit[CASCADE_COUNT] = {};
+	XMFLOAT4X4 lastProjections[CASCADE_COUNT] = {};
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//Circle the arena slowly, so the fits move a fraction of a texel at a time
+		float angle = frame * 0.001f;
+		XMFLOAT3 position(cosf(angle) * (LEVEL_RADIUS - 3), 16, sinf(angle) * (LEVEL_RADIUS - 3) - 23);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		cascades.Fit(position, forward, up, fov, aspectRatio, 0.1f, 100.0f, lightDirection);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		fitTime += elapsed.count();
+
+		for (int c = 0; c < CASCADE_COUNT; c++)
+		{
+			XMFLOAT4X4 view = cascades.GetViewMatrix(c);
+			XMFLOAT4X4 projection = cascades.GetProjectionMatrix(c);
+			if (memcmp(&projection, &lastProjections[c], sizeof(XMFLOAT4X4)) != 0)
+				moved++;
+			lastProjections[c] = projection;
+			XMMATRIX viewProj = XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&projection), XMLoadFloat4x4(&view)));
+			texelsPerUnit[c] += size * projection._11 * 0.5f;
+
+			//Points the camera sees in this cascade's slice, that are in the arena
+			XMFLOAT3 corners[8];
+			ShadowCascades::GetSliceCorners(position, forward, up, fov, aspectRatio,
+				cascades.GetSplit(c), cascades.GetSplit(c + 1), corners);
+			for (int i = 0; i < CASCADE_SAMPLES; i++)
+			{
+				float u = rng.NextFloat();
+				float v = rng.NextFloat();
+				float w = rng.NextFloat();
+				XMVECTOR nearPoint = XMVectorLerp(XMVectorLerp(XMLoadFloat3(&corners[0]), XMLoadFloat3(&corners[1]), u),
+					XMVectorLerp(XMLoadFloat3(&corners[2]), XMLoadFloat3(&corners[3]), u), v);
+				XMVECTOR farPoint = XMVectorLerp(XMVectorLerp(XMLoadFloat3(&corners[4]), XMLoadFloat3(&corners[5]), u),
+					XMVectorLerp(XMLoadFloat3(&corners[6]), XMLoadFloat3(&corners[7]), u), v);
+				XMFLOAT3 point;
+				XMStoreFloat3(&point, XMVectorLerp(nearPoint, farPoint, w));
+				if (fabsf(point.x) > radius || fabsf(point.y) > 8 || fabsf(point.z) > radius)
+					continue;
+
+				XMFLOAT3 shadowPos;
+				XMStoreFloat3(&shadowPos, XMVector3TransformCoord(XMLoadFloat3(&point), viewProj));
+				checked++;
+				if (fabsf(shadowPos.x) > 1 || fabsf(shadowPos.y) > 1 || shadowPos.z < 0 || shadowPos.z > 1)
+					outside++;
+			}
+
+			//The world's origin should always be on a texel's corner
+			XMFLOAT3 origin;
+			XMStoreFloat3(&origin, XMVector3TransformCoord(XMVectorSet(0, 0, 0, 1), viewProj));
+			float texelX = (origin.x * 0.5f + 0.5f) * size;
+			float texelY = (origin.y * 0.5f + 0.5f) * size;
+			if (fabsf(texelX - floorf(texelX + 0.5f)) > 0.01f || fabsf(texelY - floorf(texelY + 0.5f)) > 0.01f)
+				unsnapped++;
+		}
+	}
+
+	printf("\nTime per fit (ms)\n");
+	printf("  fit            %.4f\n", fitTime / frames);
+	printf("\nTexels per world unit\n");
+	for (int c = 0; c < CASCADE_COUNT; c++)
+	{
+		printf("  cascade %d      %.1f (ends at %.1f)\n", c, texelsPerUnit[c] / frames, cascades.GetSplit(c + 1));
+	}
+	printf("  old single map %.1f\n", 2048 / 30.0f);
+	printf("\nResults\n");
+	printf("  outside        %lld of %lld\n", outside, checked);
+	printf("  unsnapped      %lld of %lld\n", unsnapped, (long long)CASCADE_COUNT * frames);
+	printf("  moved          %lld of %lld\n", moved, (long long)CASCADE_COUNT * frames);
+	return outside > 0 || unsnapped > 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "LightClusters.h"
+#include "GameSimulation.h"
+#include "JobSystem.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+//Cluster benchmark camera (matching the game's) and points checked per frame
+#define CLUSTER_NEAR_CLIP 0.1f
+#define CLUSTER_FAR_CLIP 100.0f
+#define CLUSTER_SAMPLES 4096
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Cluster benchmark - bins a set of moving glow sticks (point
+// lights) and spot lights into the light clusters of a camera
+// circling the arena every frame, with the SIMD tests on the
+// JobSystem and the scalar ones, which have to match. Checks random
+// points in the view against every light, and counts the lights that
+// reach one that aren't in its cluster
+// --------------------------------------------------------
+int RunClusterBenchmark(int lightCount, int frames)
+{
+	LightClusters simd;
+	LightClusters scalar;
+
+	//Lights scattered around the arena: glow sticks floating on the water, and spot lights above it
+	FastRandom rng;
+	rng.Seed(1);
+	std::vector<XMFLOAT3> positions(lightCount);
+	std::vector<XMFLOAT3> directions(lightCount);
+	std::vector<float> ranges(lightCount);
+	std::vector<float> cosAngles(lightCount);
+	for (int l = 0; l < lightCount; l++)
+	{
+		float angle = rng.NextFloat() * XM_2PI;
+		float distance = sqrtf(rng.NextFloat()) * LEVEL_RADIUS;
+		bool spot = rng.NextFloat() < 0.1f;
+		positions[l] = XMFLOAT3(cosf(angle) * distance, spot ? 3 + rng.NextFloat() * 3 : rng.NextFloat(), sinf(angle) * distance);
+		if (spot)
+		{
+			XMStoreFloat3(&directions[l], XMVector3Normalize(XMVectorSet(rng.NextFloat() - 0.5f, -1, rng.NextFloat() - 0.5f, 0)));
+			ranges[l] = 4 + rng.NextFloat() * 6;
+			cosAngles[l] = powf(0.01f, 1.0f / (2 + rng.NextFloat() * 28));
+		}
+		else
+		{
+			directions[l] = XMFLOAT3(0, 0, 0);
+			ranges[l] = 1 + rng.NextFloat() * 3;
+			cosAngles[l] = -1;
+		}
+	}
+
+	//The camera looks down at the boat from behind it
+	float pitch = XMConvertToRadians(CASCADE_CAMERA_PITCH);
+	XMFLOAT3 forward(0, -sinf(pitch), cosf(pitch));
+	XMFLOAT3 up(0, cosf(pitch), sinf(pitch));
+	float fov = 0.25f * XM_PI;
+	float aspectRatio = 16.0f / 9;
+	float tanHalfFovY = tanf(fov * 0.5f);
+	float tanHalfFovX = tanHalfFovY * aspectRatio;
+
+	printf("Binning %d lights into %d x %d x %d clusters for %d frames (%d lanes)\n", lightCount,
+		CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z, frames, LightClusters::GetLaneCount());
+
+	double simdTime = 0;
+	double scalarTime = 0;
+	long long mismatches = 0;
+	long long checked = 0;
+	long long missed = 0;
+	long long reaching = 0;
+	long long clusterLights = 0;
+	int mostLights = 0;
+	double indexCount = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//The glow sticks bob and drift a little every frame
+		simd.Clear();
+		scalar.Clear();
+		simd.AddGlobalLight();
+		scalar.AddGlobalLight();
+		for (int l = 0; l < lightCount; l++)
+		{
+			XMFLOAT3 position = positions[l];
+			position.x += sinf(frame * 0.01f + l) * 0.5f;
+			position.y += sinf(frame * 0.05f + l * 0.3f) * 0.2f;
+			positions[l] = position;
+			if (cosAngles[l] < 0)
+			{
+				simd.AddPointLight(position, ranges[l]);
+				scalar.AddPointLight(position, ranges[l]);
+			}
+			else
+			{
+				simd.AddSpotLight(position, directions[l], ranges[l], cosAngles[l]);
+				scalar.AddSpotLight(position, directions[l], ranges[l], cosAngles[l]);
+			}
+		}
+
+		//Circle the arena
+		float angle = frame * 0.01f;
+		XMFLOAT3 cameraPosition(cosf(angle) * (LEVEL_RADIUS - 3), 16, sinf(angle) * (LEVEL_RADIUS - 3) - 23);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		simd.Build(cameraPosition, forward, up, fov, aspectRatio, CLUSTER_NEAR_CLIP, CLUSTER_FAR_CLIP);
+		std::chrono::duration<double, std::milli> simdElapsed = std::chrono::high_resolution_clock::now() - start;
+		simdTime += simdElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		scalar.BuildScalar(cameraPosition, forward, up, fov, aspectRatio, CLUSTER_NEAR_CLIP, CLUSTER_FAR_CLIP);
+		std::chrono::duration<double, std::milli> scalarElapsed = std::chrono::high_resolution_clock::now() - start;
+		scalarTime += scalarElapsed.count();
+
+		const ClusterRange* ranges1 = simd.GetClusterRanges();
+		const ClusterRange* ranges2 = scalar.GetClusterRanges();
+		if (simd.GetLightIndexCount() != scalar.GetLightIndexCount() ||
+			memcmp(ranges1, ranges2, sizeof(ClusterRange) * CLUSTER_COUNT) != 0 ||
+			memcmp(simd.GetLightIndices(), scalar.GetLightIndices(), sizeof(unsigned int) * simd.GetLightIndexCount()) != 0)
+			mismatches++;
+		indexCount += simd.GetLightIndexCount();
+		for (int c = 0; c < CLUSTER_COUNT; c++)
+		{
+			mostLights = std::max(mostLights, (int)ranges1[c].count);
+		}
+
+		//Random points in the view, and the cluster their pixel would look in
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&cameraPosition), XMLoadFloat3(&forward), XMLoadFloat3(&up));
+		XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+		const unsigned int* indices = simd.GetLightIndices();
+		for (int s = 0; s < CLUSTER_SAMPLES; s++)
+		{
+			float u = rng.NextFloat();
+			float v = rng.NextFloat();
+			float depth = CLUSTER_NEAR_CLIP * powf(CLUSTER_FAR_CLIP / CLUSTER_NEAR_CLIP, rng.NextFloat());
+			XMFLOAT3 point;
+			XMStoreFloat3(&point, XMVector3TransformCoord(XMVectorSet(
+				(2 * u - 1) * tanHalfFovX * depth, (1 - 2 * v) * tanHalfFovY * depth, depth, 1), inverseView));
+			int x = std::min((int)(u * CLUSTER_COUNT_X), CLUSTER_COUNT_X - 1);
+			int y = std::min((int)(v * CLUSTER_COUNT_Y), CLUSTER_COUNT_Y - 1);
+			ClusterRange range = ranges1[LightClusters::GetClusterIndex(x, y, simd.GetSlice(depth))];
+			checked++;
+			clusterLights += range.count;
+
+			//Every light that reaches the point has to be in its cluster (the directional light is light 0)
+			for (int l = 0; l < lightCount; l++)
+			{
+				XMVECTOR toPoint = XMVectorSubtract(XMLoadFloat3(&point), XMLoadFloat3(&positions[l]));
+				if (XMVectorGetX(XMVector3Length(toPoint)) > ranges[l])
+					continue;
+				if (cosAngles[l] >= 0 &&
+					XMVectorGetX(XMVector3Dot(XMVector3Normalize(toPoint), XMLoadFloat3(&directions[l]))) < cosAngles[l])
+					continue;
+				reaching++;
+				if (std::find(indices + range.offset, indices + range.offset + range.count, (unsigned int)(l + 1)) ==
+					indices + range.offset + range.count)
+					missed++;
+			}
+		}
+	}
+
+	printf("\nTime per build (ms)\n");
+	printf("  simd           %.4f\n", simdTime / frames);
+	printf("  scalar         %.4f (%.1fx)\n", scalarTime / frames, scalarTime / simdTime);
+	printf("\nLights per pixel\n");
+	printf("  every light    %d\n", lightCount + 1);
+	printf("  cluster        %.2f (most in a cluster %d)\n", (double)clusterLights / checked, mostLights);
+	printf("  reaching       %.2f\n", (double)reaching / checked + 1);
+	printf("  index list     %.0f per frame\n", indexCount / frames);
+	printf("\nResults\n");
+	printf("  mismatched     %lld of %d frames\n", mismatches, frames);
+	printf("  missed         %lld of %lld\n", missed, reaching);
+	return mismatches > 0 || missed > 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "SwimmerManager.h"
+#include "JobSystem.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Flocking benchmark - N floating swimmers spread over an area
+// that grows with N, steered with the neighbour grid. The first
+// frame is checked against brute force (every pair), then the
+// gather, steering and write back are timed, plus the threaded step
+// --------------------------------------------------------
+int RunFlockBenchmark(int swimmerCount, int frames)
+{
+	SwimmerManager* swimmerManager = SwimmerManager::GetInstance();
+	swimmerManager->SetLevelRadius(sqrtf(swimmerCount * POPULATION_AREA_PER_SWIMMER / XM_PI));
+	swimmerManager->SetMaxSwimmerCount(swimmerCount);
+	std::vector<Swimmer*> swimmers;
+	for (int i = 0; i < swimmerCount; i++)
+	{
+		Swimmer* swimmer = swimmerManager->SpawnSwimmer();
+		if (swimmer == nullptr)
+			continue;
+		XMFLOAT3 position = swimmer->GetPosition();
+		swimmer->SetPosition(position.x, 0, position.z);
+		swimmer->SetSwimmerState(SwimmerState::Floating);
+		swimmers.push_back(swimmer);
+	}
+	int count = (int)swimmers.size();
+	SwimmerFlock* flock = swimmerManager->GetFlock();
+	XMFLOAT3 boatPosition = XMFLOAT3(0, 0, 0);
+	float deltaTime = 1.0f / 60;
+
+	printf("Running %d frames of flocking for %d swimmers\n", frames, count);
+
+	//Check the grid finds the same neighbours as checking every pair
+	//(the sums are added in a different order, so they can round differently)
+	flock->Gather(swimmers, boatPosition, deltaTime);
+	flock->Steer(0, count);
+	std::vector<XMFLOAT2> gridVelocities(count);
+	for (int i = 0; i < count; i++)
+	{
+		gridVelocities[i] = flock->GetNewVelocity(i);
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	flock->SteerBruteForce(0, count);
+	std::chrono::duration<double, std::milli> bruteElapsed = std::chrono::high_resolution_clock::now() - start;
+	int mismatches = 0;
+	for (int i = 0; i < count; i++)
+	{
+		XMFLOAT2 brute = flock->GetNewVelocity(i);
+		if (fabsf(brute.x - gridVelocities[i].x) > 1e-4f || fabsf(brute.y - gridVelocities[i].y) > 1e-4f)
+			mismatches++;
+	}
+
+	double gatherTime = 0;
+	double steerTime = 0;
+	double writeTime = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		start = std::chrono::high_resolution_clock::now();
+		flock->Gather(swimmers, boatPosition, deltaTime);
+		std::chrono::duration<double, std::milli> gatherElapsed = std::chrono::high_resolution_clock::now() - start;
+		gatherTime += gatherElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		flock->Steer(0, count);
+		std::chrono::duration<double, std::milli> steerElapsed = std::chrono::high_resolution_clock::now() - start;
+		steerTime += steerElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		flock->WriteBack(0, count);
+		std::chrono::duration<double, std::milli> writeElapsed = std::chrono::high_resolution_clock::now() - start;
+		writeTime += writeElapsed.count();
+	}
+
+	//The whole step, split across the job system
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		flock->Step(swimmers, boatPosition, deltaTime);
+	}
+	std::chrono::duration<double, std::milli> stepElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	printf("\nTime per step (ms)\n");
+	printf("  gather + grid     %.3f\n", gatherTime / frames);
+	printf("  steer             %.3f\n", steerTime / frames);
+	printf("  write back        %.3f\n", writeTime / frames);
+	printf("  steer brute force %.3f (%.1fx)\n", bruteElapsed.count(), bruteElapsed.count() / (steerTime / frames));
+	printf("  threaded (%d+1)    %.3f\n", JobSystem::GetInstance()->GetWorkerCount(), stepElapsed.count() / frames);
+	printf("\nResults\n");
+	printf("  mismatched  %d of %d\n", mismatches, count);
+
+	//Send the swimmers away while their entities are still alive
+	swimmerManager->Reset();
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
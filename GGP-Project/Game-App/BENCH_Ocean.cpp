@@ -0,0 +1,100 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "OceanFFT.h"
+#include "JobSystem.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+//Ocean benchmark patch, and how far off the FFT can be (fraction of the rms height)
+#define OCEAN_PATCH_LENGTH 64.0f
+#define OCEAN_RMS_HEIGHT 0.5f
+#define OCEAN_TOLERANCE 0.001
+#define OCEAN_QUERY_POINTS 4096
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Ocean benchmark - a SIZE x SIZE FFT ocean updated every frame,
+// with the heights at a few texels checked against summing every
+// wave in the spectrum, and the CPU height queries timed
+// --------------------------------------------------------
+int RunOceanBenchmark(int size, int frames)
+{
+	OceanFFT* ocean = new OceanFFT();
+	if (!ocean->Init(size, OCEAN_PATCH_LENGTH, XMFLOAT2(10, 4), OCEAN_RMS_HEIGHT, 1, 1))
+		return 1;
+
+	FastRandom rng;
+	rng.Seed(1);
+	std::vector<float> xs(OCEAN_QUERY_POINTS);
+	std::vector<float> zs(OCEAN_QUERY_POINTS);
+	std::vector<float> heights(OCEAN_QUERY_POINTS);
+	for (int i = 0; i < OCEAN_QUERY_POINTS; i++)
+	{
+		xs[i] = (rng.NextFloat() * 2 - 1) * OCEAN_PATCH_LENGTH;
+		zs[i] = (rng.NextFloat() * 2 - 1) * OCEAN_PATCH_LENGTH;
+	}
+	float deltaTime = 1.0f / 60;
+
+	printf("Running %d frames of a %d x %d ocean on %d worker threads\n", frames, size, size,
+		JobSystem::GetInstance()->GetWorkerCount());
+
+	std::vector<float> updateTimes(frames);
+	double queryTime = 0;
+	long long checks = 0;
+	long long mismatches = 0;
+	double maxError = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		double time = (frame + 1) * (double)deltaTime;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		ocean->Update(time);
+		std::chrono::duration<double, std::milli> updateElapsed = std::chrono::high_resolution_clock::now() - start;
+		updateTimes[frame] = (float)updateElapsed.count();
+
+		std::fill(heights.begin(), heights.end(), 0.0f);
+		start = std::chrono::high_resolution_clock::now();
+		ocean->AddHeights(xs.data(), zs.data(), heights.data(), OCEAN_QUERY_POINTS);
+		std::chrono::duration<double, std::milli> queryElapsed = std::chrono::high_resolution_clock::now() - start;
+		queryTime += queryElapsed.count();
+
+		//Summing every wave is slow, so only check a couple of texels now and then
+		if (frame % 16 == 0)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				int x = rng.Next() & (size - 1);
+				int z = rng.Next() & (size - 1);
+				double error = fabs(ocean->GetHeights()[z * size + x] - ocean->GetReferenceHeight(time, x, z));
+				maxError = std::max(maxError, error);
+				if (error > OCEAN_RMS_HEIGHT * OCEAN_TOLERANCE)
+					mismatches++;
+				checks++;
+			}
+		}
+	}
+
+	std::vector<float> sorted = updateTimes;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0;
+	for (float t : updateTimes)
+		total += t;
+	printf("\nTime per update (ms)\n");
+	printf("  mean           %.4f\n", total / frames);
+	printf("  p50            %.4f\n", Percentile(sorted, 50));
+	printf("  p99            %.4f\n", Percentile(sorted, 99));
+	printf("\nTime per height query (ns)\n");
+	printf("  bilinear       %.3f\n", queryTime * 1000000.0 / ((double)OCEAN_QUERY_POINTS * frames));
+	printf("\nResults\n");
+	printf("  max height error %.7f (rms height %.2f)\n", maxError, OCEAN_RMS_HEIGHT);
+	printf("  mismatched     %lld of %lld\n", mismatches, checks);
+	delete ocean;
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "ColliderBatch.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// SAT benchmark - tests a box against a batch of boxes with
+// the SIMD and scalar paths and checks they agree exactly
+// --------------------------------------------------------
+int RunSATBenchmark(int boxCount, int frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> place(-3, 3);
+	std::uniform_real_distribution<float> extent(0.2f, 1.2f);
+	std::uniform_real_distribution<float> angle(0, XM_2PI);
+
+	//Random box with a random rotation
+	auto randomBox = [&]()
+	{
+		OrientedBox box;
+		XMFLOAT3X3 rot;
+		XMStoreFloat3x3(&rot, XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)));
+		box.center = XMFLOAT3(place(rng), place(rng) * 0.2f, place(rng));
+		box.axes[0] = XMFLOAT3(rot._11, rot._12, rot._13);
+		box.axes[1] = XMFLOAT3(rot._21, rot._22, rot._23);
+		box.axes[2] = XMFLOAT3(rot._31, rot._32, rot._33);
+		box.half = XMFLOAT3(extent(rng), extent(rng), extent(rng));
+		return box;
+	};
+
+	ColliderBatch batch;
+	std::vector<OrientedBox> boxes;
+	for (int i = 0; i < boxCount; i++)
+	{
+		boxes.push_back(randomBox());
+		batch.Add(boxes[i]);
+	}
+
+	printf("Running %d frames testing a box against %d boxes (%d lanes)\n",
+		frames, boxCount, ColliderBatch::GetLaneCount());
+
+	std::vector<int> simdAxes(boxCount);
+	std::vector<int> scalarAxes(boxCount);
+	double simdTime = 0;
+	double scalarTime = 0;
+	long long mismatches = 0;
+	long long overlaps = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		OrientedBox box = randomBox();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		batch.Test(box, simdAxes.data());
+		std::chrono::duration<double, std::milli> simdElapsed = std::chrono::high_resolution_clock::now() - start;
+		simdTime += simdElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		batch.TestScalar(box, scalarAxes.data());
+		std::chrono::duration<double, std::milli> scalarElapsed = std::chrono::high_resolution_clock::now() - start;
+		scalarTime += scalarElapsed.count();
+
+		for (int i = 0; i < boxCount; i++)
+		{
+			if (simdAxes[i] != scalarAxes[i])
+				mismatches++;
+
+			//The single axis test has to agree with the full one
+			if (scalarAxes[i] >= 0 && !ColliderBatch::SeparatesOnAxis(box, boxes[i], scalarAxes[i]))
+				mismatches++;
+			if (scalarAxes[i] < 0)
+				overlaps++;
+		}
+	}
+
+	double pairs = (double)boxCount * frames;
+	printf("\nTime per pair (ns)\n");
+	printf("  scalar %.2f\n", scalarTime * 1000000 / pairs);
+	printf("  SIMD   %.2f\n", simdTime * 1000000 / pairs);
+	printf("  speedup %.2fx\n", scalarTime / simdTime);
+	printf("\nResults\n");
+	printf("  overlapping    %.1f%%\n", overlaps * 100 / pairs);
+	printf("  mismatched     %lld of %.0f\n", mismatches, pairs);
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
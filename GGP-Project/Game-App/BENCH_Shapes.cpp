@@ -0,0 +1,116 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "Collider.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Shape benchmark - times each pair of collider shapes, and checks
+// the capsule-box test against points sampled along the capsule
+// --------------------------------------------------------
+int RunShapeBenchmark(int shapeCount, int frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> place(-3, 3);
+	std::uniform_real_distribution<float> angle(0, XM_2PI);
+
+	//Random collider with a random rotation
+	auto randomCollider = [&](ColliderShape shape, XMFLOAT3 size)
+	{
+		Collider* collider = new Collider(XMFLOAT3(place(rng), place(rng) * 0.2f, place(rng)), size, XMFLOAT3(0, 0, 0), shape);
+		XMFLOAT4 rotation;
+		XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)));
+		collider->SetRotation(rotation);
+		return collider;
+	};
+
+	//Swimmer and boat sized shapes
+	const char* shapeNames[] = { "sphere", "capsule", "box" };
+	XMFLOAT3 swimmerSize = XMFLOAT3(0.9f, 0.9f, 0.9f);
+	XMFLOAT3 boatSize = XMFLOAT3(0.9f, 0.8f, 2.3f);
+	std::vector<Collider*> targets[3];
+	for (int s = 0; s < 3; s++)
+	{
+		for (int i = 0; i < shapeCount; i++)
+		{
+			targets[s].push_back(randomCollider((ColliderShape)s, swimmerSize));
+		}
+	}
+
+	printf("Running %d frames testing each shape against %d of each shape\n", frames, shapeCount);
+
+	double times[3][3] = {};
+	long long overlaps[3][3] = {};
+	long long mismatches = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (int s = 0; s < 3; s++)
+		{
+			Collider* tester = randomCollider((ColliderShape)s, s == (int)ColliderShape::Sphere ? swimmerSize : boatSize);
+			for (int t = 0; t < 3; t++)
+			{
+				long long hits = 0;
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < shapeCount; i++)
+				{
+					hits += tester->Collides(targets[t][i]) ? 1 : 0;
+				}
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+				times[s][t] += elapsed.count();
+				overlaps[s][t] += hits;
+			}
+
+			//A sphere at any point along the capsule touching a box means the capsule does
+			if (s == (int)ColliderShape::Capsule)
+			{
+				XMFLOAT3 segStart;
+				XMFLOAT3 segEnd;
+				tester->GetSegment(&segStart, &segEnd);
+				for (int i = 0; i < shapeCount; i++)
+				{
+					Collider* box = targets[(int)ColliderShape::Box][i];
+					bool sampledHit = false;
+					for (int k = 0; k <= 32 && !sampledHit; k++)
+					{
+						float t = k / 32.0f;
+						Collider probe(XMFLOAT3(segStart.x + (segEnd.x - segStart.x) * t,
+							segStart.y + (segEnd.y - segStart.y) * t,
+							segStart.z + (segEnd.z - segStart.z) * t), XMFLOAT3(boatSize.x, boatSize.x, boatSize.x),
+							XMFLOAT3(0, 0, 0), ColliderShape::Sphere);
+						sampledHit = probe.Collides(box);
+					}
+					if (sampledHit && !tester->Collides(box))
+						mismatches++;
+				}
+			}
+			delete tester;
+		}
+	}
+
+	double pairs = (double)shapeCount * frames;
+	printf("\nTime per pair (ns)\n");
+	for (int s = 0; s < 3; s++)
+	{
+		for (int t = 0; t < 3; t++)
+		{
+			printf("  %-7s vs %-7s %6.2f (%.1f%% overlapping)\n", shapeNames[s], shapeNames[t],
+				times[s][t] * 1000000 / pairs, overlaps[s][t] * 100 / pairs);
+		}
+	}
+	printf("\nCapsule-box missed sampled hits  %lld\n", mismatches);
+
+	for (int s = 0; s < 3; s++)
+	{
+		for (size_t i = 0; i < targets[s].size(); i++)
+		{
+			delete targets[s][i];
+		}
+	}
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
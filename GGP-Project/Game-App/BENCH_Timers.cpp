@@ -0,0 +1,112 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "TimerWheel.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+//Longest delay in the timer benchmark (seconds)
+#define TIMER_MAX_DELAY 60.0f
+
+// --------------------------------------------------------
+// Timer benchmark - N gameplay timers with random delays (up to
+// TIMER_MAX_DELAY seconds) that start over when they fire, with every
+// fourth firing cancelling another timer and starting it over too.
+// Every firing is checked against when it was due, then the wheel
+// is timed against each object counting down its own timer
+// --------------------------------------------------------
+int RunTimerBenchmark(int timerCount, int frames)
+{
+	TimerWheel* timerWheel = TimerWheel::GetInstance();
+	FastRandom rng;
+	rng.Seed(1);
+	float deltaTime = 1.0f / 60;
+
+	printf("Running %d frames with %d timers\n", frames, timerCount);
+
+	std::vector<TimerHandle> handles(timerCount);
+	std::vector<double> dueTimes(timerCount);
+	std::vector<unsigned int> starts(timerCount, 0);       //Which start of each timer is the live one
+	long long firings = 0;
+	long long early = 0;
+	long long late = 0;
+	long long stale = 0;
+	std::function<void(int)> startTimer = [&](int i)
+	{
+		double delay = rng.NextFloat() * TIMER_MAX_DELAY;
+		unsigned int start = ++starts[i];
+		dueTimes[i] = timerWheel->GetTime() + delay;
+		handles[i] = timerWheel->Schedule(delay, [&, i, start]()
+		{
+			//Cancelled timers should never fire
+			if (start != starts[i])
+			{
+				stale++;
+				return;
+			}
+
+			//Timers fire on the first step after the tick they're due on
+			firings++;
+			double error = timerWheel->GetTime() - dueTimes[i];
+			if (error < -1e-6)
+				early++;
+			else if (error >= 2 * deltaTime)
+				late++;
+
+			if (firings % 4 == 0)
+			{
+				int other = (int)(rng.Next() % timerCount);
+				timerWheel->Cancel(handles[other]);
+				startTimer(other);
+			}
+			startTimer(i);
+		});
+	};
+	for (int i = 0; i < timerCount; i++)
+	{
+		startTimer(i);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		timerWheel->Advance(deltaTime);
+	}
+	std::chrono::duration<double, std::milli> wheelElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	//The same timers, with every object checking its own each step
+	std::vector<float> countdowns(timerCount);
+	for (int i = 0; i < timerCount; i++)
+	{
+		countdowns[i] = rng.NextFloat() * TIMER_MAX_DELAY;
+	}
+	long long polledFirings = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (int i = 0; i < timerCount; i++)
+		{
+			countdowns[i] -= deltaTime;
+			if (countdowns[i] <= 0)
+			{
+				countdowns[i] = rng.NextFloat() * TIMER_MAX_DELAY;
+				polledFirings++;
+			}
+		}
+	}
+	std::chrono::duration<double, std::milli> pollElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	printf("\nTime per step (ms)\n");
+	printf("  timer wheel %.4f (%.1f fired per step)\n", wheelElapsed.count() / frames, (double)firings / frames);
+	printf("  polling     %.4f (%.1f fired per step)\n", pollElapsed.count() / frames, (double)polledFirings / frames);
+	printf("\nResults\n");
+	printf("  pending     %d\n", timerWheel->GetPendingCount());
+	printf("  early       %lld of %lld\n", early, firings);
+	printf("  late        %lld of %lld\n", late, firings);
+	printf("  cancelled but fired %lld\n", stale);
+	return early + late + stale > 0 ? 2 : 0;
+}
+
+#endif
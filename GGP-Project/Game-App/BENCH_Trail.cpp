@@ -0,0 +1,99 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "TrailPath.h"
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Trail benchmark - a coiled trail of N points moves forward a
+// point every frame (a new point at its end, its first point
+// trimmed) and a boat sized capsule is tested against it. Times
+// the update and the query together: refitting the hierarchy,
+// rebuilding it from scratch, and brute force
+// --------------------------------------------------------
+int RunTrailBenchmark(int pointCount, int frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> angle(0, XM_2PI);
+
+	//A spiral with points half a unit apart, like a long trail coiled up
+	//(long enough for the trail to move along it every frame)
+	std::vector<XMFLOAT3> spiral;
+	float spiralAngle = 0;
+	for (int i = 0; i < pointCount + frames; i++)
+	{
+		float spiralRadius = 2 + spiralAngle * 0.35f;
+		spiral.push_back(XMFLOAT3(cosf(spiralAngle) * spiralRadius, 0, sinf(spiralAngle) * spiralRadius));
+		spiralAngle += 0.5f / spiralRadius;
+	}
+	float worldRadius = 2 + spiralAngle * 0.35f + 1;
+	std::uniform_real_distribution<float> place(-worldRadius, worldRadius);
+
+	//One path is refit as the trail moves, the other is rebuilt every frame
+	TrailPath refitPath(0.45f);
+	TrailPath rebuiltPath(0.45f);
+	for (int i = 0; i < pointCount; i++)
+		refitPath.AddPoint(spiral[i]);
+	refitPath.Build();
+
+	printf("Running %d frames moving a %d point trail and testing a capsule against it\n", frames, pointCount);
+
+	double refitTime = 0;
+	double rebuildTime = 0;
+	double bruteTime = 0;
+	long long nodeVisits = 0;
+	int hits = 0;
+	int mismatches = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		//Boat sized capsule somewhere over the trail
+		float heading = angle(rng);
+		XMFLOAT3 center = XMFLOAT3(place(rng), 0, place(rng));
+		XMFLOAT3 start = XMFLOAT3(center.x - cosf(heading) * 0.7f, 0, center.z - sinf(heading) * 0.7f);
+		XMFLOAT3 end = XMFLOAT3(center.x + cosf(heading) * 0.7f, 0, center.z + sinf(heading) * 0.7f);
+
+		//Move the trail a point and refit
+		auto begin = std::chrono::high_resolution_clock::now();
+		refitPath.AddPoint(spiral[pointCount + frame]);
+		refitPath.RemoveFirstPoint();
+		bool refitHit = refitPath.IntersectsCapsule(start, end, 0.45f);
+		std::chrono::duration<double, std::milli> refitElapsed = std::chrono::high_resolution_clock::now() - begin;
+		refitTime += refitElapsed.count();
+		nodeVisits += refitPath.GetLastNodeVisits();
+
+		//Rebuild the whole path from the moved trail
+		begin = std::chrono::high_resolution_clock::now();
+		rebuiltPath.Clear();
+		for (int i = frame + 1; i <= pointCount + frame; i++)
+			rebuiltPath.AddPoint(spiral[i]);
+		bool rebuiltHit = rebuiltPath.IntersectsCapsule(start, end, 0.45f);
+		std::chrono::duration<double, std::milli> rebuildElapsed = std::chrono::high_resolution_clock::now() - begin;
+		rebuildTime += rebuildElapsed.count();
+
+		begin = std::chrono::high_resolution_clock::now();
+		bool bruteHit = refitPath.IntersectsCapsuleBruteForce(start, end, 0.45f);
+		std::chrono::duration<double, std::milli> bruteElapsed = std::chrono::high_resolution_clock::now() - begin;
+		bruteTime += bruteElapsed.count();
+
+		if (refitHit != bruteHit || rebuiltHit != bruteHit)
+			mismatches++;
+		if (refitHit)
+			hits++;
+	}
+
+	printf("\nTime per frame, moving the trail and one query (us)\n");
+	printf("  refit       %.3f (%.1f nodes visited)\n", refitTime * 1000 / frames, (double)nodeVisits / frames);
+	printf("  rebuild     %.3f\n", rebuildTime * 1000 / frames);
+	printf("  brute force %.3f\n", bruteTime * 1000 / frames);
+	printf("  speedup     %.1fx over rebuilding, %.1fx over brute force\n", rebuildTime / refitTime, bruteTime / refitTime);
+	printf("\nResults\n");
+	printf("  hits        %.1f%%\n", hits * 100.0 / frames);
+	printf("  mismatched  %d of %d\n", mismatches, frames);
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
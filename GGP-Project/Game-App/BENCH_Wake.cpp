@@ -0,0 +1,149 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "WakeField.h"
+#include "JobSystem.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+//Wake benchmark field (world units across) and impulses per frame
+#define WAKE_EXTENT 30.0f
+#define WAKE_IMPULSES 32
+
+//Points queried a frame (about what the swimmers and boats ask for)
+#define WAKE_QUERY_POINTS 4096
+
+//Most a batched query can be off from the reference
+#define WAKE_TOLERANCE 1e-4f
+
+// --------------------------------------------------------
+// Reference height at a point - the bilinear sample of the
+// heights the field's queries used before its texels
+// --------------------------------------------------------
+static float ReferenceHeight(const float* heights, int size, float cellSize, float x, float z)
+{
+	float u = (x + WAKE_EXTENT * 0.5f) / cellSize;
+	float v = (z + WAKE_EXTENT * 0.5f) / cellSize;
+	if (!(u >= 0 && v >= 0 && u < size - 1 && v < size - 1))
+		return 0;
+
+	int x0 = (int)u;
+	int z0 = (int)v;
+	float fu = u - x0;
+	float fv = v - z0;
+	const float* cell = &heights[z0 * size + x0];
+	float top = cell[0] + (cell[1] - cell[0]) * fu;
+	float bottom = cell[size] + (cell[size + 1] - cell[size]) * fu;
+	return top + (bottom - top) * fv;
+}
+
+// --------------------------------------------------------
+// Wake benchmark - a SIZE x SIZE wake field given impulses and
+// stepped every frame, then queried for heights and normals at
+// random points, which are checked against four height samples
+// a point (the slopes by central differences)
+// --------------------------------------------------------
+int RunWakeBenchmark(int size, int frames)
+{
+	WakeField* wake = new WakeField();
+	if (!wake->Init(size, WAKE_EXTENT, 4, 0.6f, 1.0f / 60))
+		return 1;
+	float cellSize = WAKE_EXTENT / (size - 1);
+
+	FastRandom rng;
+	rng.Seed(1);
+
+	printf("Running %d frames of a %d x %d wake field with %d impulses and %d queries a frame\n",
+		frames, size, size, WAKE_IMPULSES, WAKE_QUERY_POINTS);
+
+	std::vector<float> xs(WAKE_QUERY_POINTS), zs(WAKE_QUERY_POINTS);
+	std::vector<float> heights(WAKE_QUERY_POINTS), nxs(WAKE_QUERY_POINTS), nys(WAKE_QUERY_POINTS), nzs(WAKE_QUERY_POINTS);
+	std::vector<float> refHeights(WAKE_QUERY_POINTS), refNxs(WAKE_QUERY_POINTS), refNys(WAKE_QUERY_POINTS), refNzs(WAKE_QUERY_POINTS);
+
+	double stepTime = 0;
+	double queryTime = 0;
+	double referenceTime = 0;
+	long long mismatches = 0;
+	float maxError = 0;
+	float maxHeight = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (int i = 0; i < WAKE_IMPULSES; i++)
+		{
+			float x = (rng.NextFloat() - 0.5f) * WAKE_EXTENT;
+			float z = (rng.NextFloat() - 0.5f) * WAKE_EXTENT;
+			wake->AddImpulse(x, z, rng.NextFloat() * 0.01f, 0.8f);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		wake->Step();
+		std::chrono::duration<double, std::milli> stepElapsed = std::chrono::high_resolution_clock::now() - start;
+		stepTime += stepElapsed.count();
+
+		//Some points land just off the field, where there are no ripples
+		for (int i = 0; i < WAKE_QUERY_POINTS; i++)
+		{
+			xs[i] = (rng.NextFloat() - 0.5f) * WAKE_EXTENT * 1.05f;
+			zs[i] = (rng.NextFloat() - 0.5f) * WAKE_EXTENT * 1.05f;
+			heights[i] = refHeights[i] = 0;
+			nxs[i] = refNxs[i] = 0;
+			nys[i] = refNys[i] = 1;
+			nzs[i] = refNzs[i] = 0;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		wake->AddHeights(xs.data(), zs.data(), heights.data(), WAKE_QUERY_POINTS);
+		wake->TiltNormals(xs.data(), zs.data(), nxs.data(), nys.data(), nzs.data(), WAKE_QUERY_POINTS);
+		std::chrono::duration<double, std::milli> queryElapsed = std::chrono::high_resolution_clock::now() - start;
+		queryTime += queryElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		const float* field = wake->GetHeights();
+		for (int i = 0; i < WAKE_QUERY_POINTS; i++)
+		{
+			float x = xs[i];
+			float z = zs[i];
+			refHeights[i] += ReferenceHeight(field, size, cellSize, x, z);
+			float slopeX = (ReferenceHeight(field, size, cellSize, x + cellSize, z) - ReferenceHeight(field, size, cellSize, x - cellSize, z)) / (2 * cellSize);
+			float slopeZ = (ReferenceHeight(field, size, cellSize, x, z + cellSize) - ReferenceHeight(field, size, cellSize, x, z - cellSize)) / (2 * cellSize);
+			float nx = refNxs[i] / refNys[i] - slopeX;
+			float nz = refNzs[i] / refNys[i] - slopeZ;
+			float length = sqrtf(nx * nx + 1 + nz * nz);
+			refNxs[i] = nx / length;
+			refNys[i] = 1 / length;
+			refNzs[i] = nz / length;
+		}
+		std::chrono::duration<double, std::milli> referenceElapsed = std::chrono::high_resolution_clock::now() - start;
+		referenceTime += referenceElapsed.count();
+
+		//Cells on the edge have no neighbours outside, so the reference differs there
+		float edge = WAKE_EXTENT * 0.5f - 2 * cellSize;
+		for (int i = 0; i < WAKE_QUERY_POINTS; i++)
+		{
+			maxHeight = std::max(maxHeight, fabsf(heights[i]));
+			if (fabsf(xs[i]) > edge || fabsf(zs[i]) > edge)
+				continue;
+
+			float error = std::max(fabsf(heights[i] - refHeights[i]),
+				std::max(fabsf(nxs[i] - refNxs[i]), std::max(fabsf(nys[i] - refNys[i]), fabsf(nzs[i] - refNzs[i]))));
+			maxError = std::max(maxError, error);
+			if (error > WAKE_TOLERANCE)
+				mismatches++;
+		}
+	}
+
+	printf("\nTime per frame (ms)\n");
+	printf("  step           %.4f\n", stepTime / frames);
+	printf("  queries        %.4f\n", queryTime / frames);
+	printf("  reference      %.4f (%.1fx)\n", referenceTime / frames, referenceTime / queryTime);
+	printf("\nResults\n");
+	printf("  max height     %.4f\n", maxHeight);
+	printf("  max error      %.7f\n", maxError);
+	printf("  mismatched     %lld of %lld\n", mismatches, (long long)WAKE_QUERY_POINTS * frames);
+	delete wake;
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
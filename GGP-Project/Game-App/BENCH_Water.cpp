@@ -0,0 +1,130 @@
+#ifdef HEADLESS
+#include "Benchmarks.h"
+#include "GameSimulation.h"
+#include "FastRandom.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Exact height of the waves under a point, in double precision
+// with the standard library's sine (to check the batched queries)
+// --------------------------------------------------------
+static double ReferenceWaveHeight(WaterSurface* water, double x, double z)
+{
+	WaterWaveStruct* waves = water->GetWaveStructArray();
+	int count = water->GetWaveCount();
+
+	//Step back by the sideways displacement until it settles
+	double px = x;
+	double pz = z;
+	for (int i = 0; i < 32; i++)
+	{
+		double dx = 0;
+		double dz = 0;
+		for (int w = 0; w < count; w++)
+		{
+			double theta = waves[w].Frequency * (waves[w].Direction.x * px + waves[w].Direction.y * pz) + waves[w].Phase;
+			dx += waves[w].Steepness * waves[w].Amplitude * waves[w].Direction.x * cos(theta);
+			dz += waves[w].Steepness * waves[w].Amplitude * waves[w].Direction.y * cos(theta);
+		}
+		px = x - dx;
+		pz = z - dz;
+	}
+
+	double y = water->GetSurfaceY();
+	for (int w = 0; w < count; w++)
+	{
+		double theta = waves[w].Frequency * (waves[w].Direction.x * px + waves[w].Direction.y * pz) + waves[w].Phase;
+		y += waves[w].Amplitude * sin(theta);
+	}
+	return y;
+}
+
+// --------------------------------------------------------
+// Water benchmark - N points spread over the level, sampled
+// under the game's waves with the SIMD and scalar paths (which
+// have to match) and checked against a double precision reference
+// --------------------------------------------------------
+int RunWaterBenchmark(int pointCount, int frames)
+{
+	//Set up the game's waves (without the ocean and wakes, which have their own benchmarks)
+	GameSimulation* simulation = new GameSimulation();
+	simulation->Init(nullptr, nullptr, nullptr, nullptr);
+	WaterSurface* water = WaterSurface::GetInstance();
+	water->SetOcean(nullptr);
+	water->SetWake(nullptr);
+
+	FastRandom rng;
+	rng.Seed(1);
+	std::vector<float> xs(pointCount);
+	std::vector<float> zs(pointCount);
+	for (int i = 0; i < pointCount; i++)
+	{
+		xs[i] = (rng.NextFloat() * 2 - 1) * LEVEL_RADIUS;
+		zs[i] = (rng.NextFloat() * 2 - 1) * LEVEL_RADIUS;
+	}
+	std::vector<float> heights(pointCount);
+	std::vector<float> scalarHeights(pointCount);
+	std::vector<float> nxs(pointCount);
+	std::vector<float> nys(pointCount);
+	std::vector<float> nzs(pointCount);
+	float deltaTime = 1.0f / 60;
+
+	printf("Running %d frames sampling %d points under %d waves\n", frames, pointCount, water->GetWaveCount());
+
+	double simdTime = 0;
+	double scalarTime = 0;
+	double normalTime = 0;
+	long long mismatches = 0;
+	double maxError = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		water->Advance(deltaTime);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		water->SampleHeights(xs.data(), zs.data(), heights.data(), pointCount);
+		std::chrono::duration<double, std::milli> simdElapsed = std::chrono::high_resolution_clock::now() - start;
+		simdTime += simdElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		water->SampleHeightsScalar(xs.data(), zs.data(), scalarHeights.data(), pointCount);
+		std::chrono::duration<double, std::milli> scalarElapsed = std::chrono::high_resolution_clock::now() - start;
+		scalarTime += scalarElapsed.count();
+
+		start = std::chrono::high_resolution_clock::now();
+		water->SampleNormals(xs.data(), zs.data(), nxs.data(), nys.data(), nzs.data(), pointCount);
+		std::chrono::duration<double, std::milli> normalElapsed = std::chrono::high_resolution_clock::now() - start;
+		normalTime += normalElapsed.count();
+
+		for (int i = 0; i < pointCount; i++)
+		{
+			if (heights[i] != scalarHeights[i])
+				mismatches++;
+		}
+
+		//Check a few points a frame against the reference
+		for (int i = frame % 64; i < pointCount; i += 64)
+		{
+			double error = fabs(heights[i] - ReferenceWaveHeight(water, xs[i], zs[i]));
+			maxError = std::max(maxError, error);
+		}
+	}
+
+	double perPoint = 1000000.0 / ((double)pointCount * frames);
+	printf("\nTime per point (ns)\n");
+	printf("  height simd    %.3f\n", simdTime * perPoint);
+	printf("  height scalar  %.3f (%.1fx)\n", scalarTime * perPoint, scalarTime / simdTime);
+	printf("  normal simd    %.3f\n", normalTime * perPoint);
+	printf("\nTime per frame (ms)\n");
+	printf("  heights        %.4f\n", simdTime / frames);
+	printf("\nResults\n");
+	printf("  max height error %.6f\n", maxError);
+	printf("  mismatched     %lld of %lld\n", mismatches, (long long)pointCount * frames);
+	return mismatches > 0 ? 2 : 0;
+}
+
+#endif
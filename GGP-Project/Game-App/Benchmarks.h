@@ -0,0 +1,48 @@
+#pragma once
+#ifdef HEADLESS
+#include <vector>
+
+//Area each swimmer gets in the large population mode and the flocking benchmark
+#define POPULATION_AREA_PER_SWIMMER 4.0f
+
+//The game camera's pitch (the cascade and cluster benchmarks follow a camera like it)
+#define CASCADE_CAMERA_PITCH 40.75f
+
+// --------------------------------------------------------
+// A benchmark the headless benchmark can run instead of the
+// game, picked with its flag ("-colliders N [-frames N]")
+// --------------------------------------------------------
+struct BenchmarkMode
+{
+	const char* flag;
+	const char* countName;       //What the number after the flag is (N or SIZE)
+	int (*run)(int count, int frames);       //Returns 0 if every check passed
+};
+
+// --------------------------------------------------------
+// Get a percentile from sorted values
+//
+// percent - 0 to 100
+// --------------------------------------------------------
+float Percentile(const std::vector<float>& sorted, float percent);
+
+// --------------------------------------------------------
+// The benchmarks (each in its own BENCH_ file). Each one takes
+// what the number after its flag is and the amount of frames,
+// prints a report, and returns 0 if every check passed
+// --------------------------------------------------------
+int RunBroadphaseBenchmark(int colliderCount, int frames);
+int RunSATBenchmark(int boxCount, int frames);
+int RunShapeBenchmark(int shapeCount, int frames);
+int RunTrailBenchmark(int pointCount, int frames);
+int RunBuoyancyBenchmark(int swimmerCount, int frames);
+int RunFlockBenchmark(int swimmerCount, int frames);
+int RunTimerBenchmark(int timerCount, int frames);
+int RunWaterBenchmark(int pointCount, int frames);
+int RunOceanBenchmark(int size, int frames);
+int RunWakeBenchmark(int size, int frames);
+int RunCascadeBenchmark(int size, int frames);
+int RunAtlasBenchmark(int lightCount, int frames);
+int RunClusterBenchmark(int lightCount, int frames);
+
+#endif
@@ -3,9 +3,9 @@
 #include "SwimmerManager.h"
 #include "EntityManager.h"
 
-#if defined(DEBUG) || defined(_DEBUG)
-#include "ResourceManager.h"
-#endif
+//Trail spacing along the boat's path (the old 0.8s and 0.5s lags at full speed)
+#define TRAIL_FIRST_DISTANCE 2.4f
+#define TRAIL_SPACING 1.5f
 
 using namespace std;
 using namespace DirectX;
@@ -13,14 +13,24 @@ using namespace DirectX;
 Boat::Boat(Mesh * mesh, Material * material, float levelRadius) : Entity(mesh, material, "player")
 {
 	state = BoatState::Starting;
+	seekStart = 0;
 	trail = std::vector<Swimmer*>();
 	swimmerManager = SwimmerManager::GetInstance();
 	inputManager = InputManager::GetInstance();
 	this->levelRadius = levelRadius;
+	trailFollowers = 0;
+	trailPathStart = 0;
+	trailPathEnd = 0;
+
+	//Swimmers don't spawn on us or our trail
+	swimmerManager->SetSnake(this, &trailHistory);
 }
 
 Boat::~Boat()
-{ }
+{
+	TimerWheel::GetInstance()->Cancel(seekTimer);
+	swimmerManager->SetSnake(nullptr, nullptr);
+}
 
 // Calls Input, Move, and CheckCollisions every frame
 void Boat::Update(float deltaTime)
@@ -38,6 +48,12 @@ void Boat::Update(float deltaTime)
 	case BoatState::Playing:
 		Input(deltaTime);
 		Move(deltaTime);
+
+		//Only keep as much path as the trail needs
+		trailHistory.Record(GetPosition());
+		UpdateTrailPath();
+		trailHistory.Trim(GetTrailDistance((int)trail.size()));
+
 		CheckCollisions();
 		break;
 	
@@ -88,21 +104,15 @@ void Boat::Input(float deltaTime)
 	if (inputManager->GetMouseButtonDown(MouseButtons::L))
 	{
 		// Create the swimmer.
-		Swimmer* swimmer = new Swimmer(
-			ResourceManager::GetInstance()->GetMesh("Assets\\Models\\swimmer.obj"),
-			ResourceManager::GetInstance()->GetMaterial("swimmer"),
-			"swimmer"
-		);
-		swimmer->SetScale(0.05f, 0.05f, 0.05f);
-		swimmer->AddCollider(DirectX::XMFLOAT3(0.9f, 0.9f, 0.9f), DirectX::XMFLOAT3(0, 0, 0));
-		swimmer->SetDebug(true);
+		Swimmer* swimmer = swimmerManager->CreateSwimmer();
 
 		// Get the leader.
 		Entity* leader = nullptr;
 		if (trail.size() < 1)
 			leader = this;
 		else leader = trail[trail.size() - 1];
-		swimmer->JoinTrail(leader);
+		swimmer->SetTrailDistance(GetTrailDistance((int)trail.size()));
+		swimmer->JoinTrail(leader, &trailHistory);
 
 		trail.push_back(swimmer);
 	}
@@ -113,11 +123,24 @@ void Boat::Reset()
 {
 	// Detach all swimmers.
 	ClearSwimmers();
+	trailHistory.Clear();
+	trailPath.Clear();
+	trailFollowers = 0;
 
 	// Set crashed to false.
 	state = BoatState::Resetting;
-	seekTimer = 0;
 	seekPos = GetPosition();
+
+	//Seek for a second
+	TimerWheel* timerWheel = TimerWheel::GetInstance();
+	timerWheel->Cancel(seekTimer);
+	seekStart = timerWheel->GetTime();
+	seekTimer = timerWheel->Schedule(1, [this]()
+	{
+		state = BoatState::Starting;
+		SetPosition(0, 0, 0);
+		SnapPreviousTransform();
+	});
 }
 
 // Moves the boat forward
@@ -129,21 +152,14 @@ void Boat::Move(float deltaTime)
 // Seeks 0,0,0 
 void Boat::SeekOrigin(float deltaTime)
 {
-	seekTimer += deltaTime;
-
-	//Check when seek is finished
-	if (seekTimer >= 1)
-	{
-		state = BoatState::Starting;
-		SetPosition(0, 0, 0);
-		return;
-	}
+	//The seek timer finishes the seek
+	float seekTime = (float)(TimerWheel::GetInstance()->GetTime() - seekStart);
 
 	//Lerp movement vector
-	XMVECTOR move = XMVectorLerp(XMLoadFloat3(&seekPos), XMVectorSet(0, 0, 0, 0), seekTimer);
+	XMVECTOR move = XMVectorLerp(XMLoadFloat3(&seekPos), XMVectorSet(0, 0, 0, 0), seekTime);
 
 	//Calculate arc
-	float arc = sin(seekTimer * XM_PI) * 3; //arc height is 2
+	float arc = sin(seekTime * XM_PI) * 3; //arc height is 2
 
 	//Move the boat
 	XMFLOAT3 movement;
@@ -152,13 +168,14 @@ void Boat::SeekOrigin(float deltaTime)
 	SetPosition(movement);
 
 	//Rotate the boat
-	XMVECTOR slerp = XMQuaternionSlerp(XMLoadFloat4(&GetRotation()), XMVectorSet(0, 0, 0, 1), seekTimer);
+	XMFLOAT4 currentRotation = GetRotation();
+	XMVECTOR slerp = XMQuaternionSlerp(XMLoadFloat4(&currentRotation), XMVectorSet(0, 0, 0, 1), seekTime);
 	XMFLOAT4 rotation;
 	XMStoreFloat4(&rotation, slerp);
 	SetRotation(rotation);
 }
 
-// Checks for collisions and calls corresponding collide methods
+// Checks if the boat left the level or hit its own trail
 void Boat::CheckCollisions()
 {
 	float x = this->GetPosition().x;
@@ -172,29 +189,99 @@ void Boat::CheckCollisions()
 		GameOver();
 		return;
 	}
-	
-	// Check collisions with swimmers in our trail
-	for (int i = 1; i < trail.size(); i++)
+
+	// Check collisions with the trail (besides the swimmer right behind us)
+	if (trailPath.GetPointCount() > 0)
 	{
-		Swimmer* swmr = trail[i];
-		if (swmr != nullptr	&& swmr->GetState() == SwimmerState::Following
-			&& GetCollider()->Collides(swmr->GetCollider()))
+		trailPath.SetRadius(trail[1]->GetCollider()->GetRadius());
+
+		XMFLOAT3 start;
+		XMFLOAT3 end;
+		GetCollider()->GetSegment(&start, &end);
+		if (trailPath.IntersectsCapsule(start, end, GetCollider()->GetRadius()))
 		{
 			GameOver();
 			return;
 		}
 	}
+}
 
-	// Check collisions with swimmers floating in the scene
-	for (int i = swimmerManager->GetSwimmerCount() - 1; i >= 0; i--) 
+// Keep the trail's path over the history between the last following swimmer and the second one
+void Boat::UpdateTrailPath()
+{
+	// Swimmers only start following after their leader does, so the
+	// following swimmers are always the start of the trail
+	while (trailFollowers + 1 < (int)trail.size() && trail[trailFollowers + 1]->GetState() == SwimmerState::Following)
+		trailFollowers++;
+	if (trailFollowers == 0)
+		return;
+
+	double headDistance = trailHistory.GetHeadDistance();
+	double nearCutoff = headDistance - GetTrailDistance(1);
+	double farCutoff = headDistance - GetTrailDistance(trailFollowers);
+	int historyStart = trailHistory.GetFirstSampleIndex();
+	int historyEnd = historyStart + trailHistory.GetSampleCount();
+	if (trailPath.GetPointCount() == 0)
 	{
-		Swimmer* swmr = swimmerManager->GetSwimmer(i);
-		if (swmr != nullptr && swmr->GetState() == SwimmerState::Floating &&
-			GetCollider()->Collides(swmr->GetCollider()))
-		{
-			AttachSwimmer(swmr, i);
-		}
+		trailPathStart = historyStart;
+		trailPathEnd = historyStart;
+	}
+
+	//History points never move once recorded, so only the ones that
+	//fell behind the second swimmer since last step are added
+	while (trailPathEnd < historyEnd && trailHistory.GetSample(trailPathEnd).distance <= nearCutoff)
+	{
+		trailPath.AddPoint(trailHistory.GetSample(trailPathEnd).position);
+		trailPathEnd++;
 	}
+	if (trailPathEnd == trailPathStart)
+		return;
+
+	//Keep one point at or past the last following swimmer (the path grows
+	//back when another swimmer starts following)
+	while (trailPathStart > historyStart && trailHistory.GetSample(trailPathStart).distance > farCutoff)
+	{
+		trailPathStart--;
+		trailPath.AddFirstPoint(trailHistory.GetSample(trailPathStart).position);
+	}
+	while (trailPathEnd - trailPathStart > 1 && trailHistory.GetSample(trailPathStart + 1).distance <= farCutoff)
+	{
+		trailPath.RemoveFirstPoint();
+		trailPathStart++;
+	}
+}
+
+// Called when the boat starts touching something
+void Boat::OnCollisionEnter(GameObject* other)
+{
+	Swimmer* swmr = AsSwimmer(other);
+	if (swmr != nullptr)
+		HitSwimmer(swmr);
+}
+
+// Called while the boat keeps touching something
+void Boat::OnCollisionStay(GameObject* other)
+{
+	Swimmer* swmr = AsSwimmer(other);
+	if (swmr != nullptr)
+		HitSwimmer(swmr);
+}
+
+// Handle the boat touching a swimmer
+void Boat::HitSwimmer(Swimmer* swmr)
+{
+	// Check collisions with swimmers floating in the scene
+	// (the trail is checked in CheckCollisions)
+	if (state == BoatState::Playing && swmr->GetState() == SwimmerState::Floating)
+		AttachSwimmer(swmr);
+}
+
+// Get a gameobject as a swimmer (nullptr if it isn't one)
+Swimmer* Boat::AsSwimmer(GameObject* object)
+{
+	if (object == nullptr || object->GetName() != "swimmer")
+		return nullptr;
+	return (Swimmer*)object;
 }
 
 // Runs the calls for when the player gets a gameover (hits a wall, etc)
@@ -225,13 +312,13 @@ void Boat::ClearSwimmers()
 	for (int i = 0; i < trail.size(); i++)
 	{
 		if (trail[i] != nullptr)
-			trail[i]->SetSwimmerState(SwimmerState::Leaving);
+			swimmerManager->ReleaseSwimmer(trail[i]);
 	}
 	trail.clear();
 }
 
 // Attach a swimmer at the end of the trail
-void Boat::AttachSwimmer(Swimmer* swimmer, int index) 
+void Boat::AttachSwimmer(Swimmer* swimmer) 
 {
 	// Get the leader.
 	Entity* leader = nullptr;
@@ -239,10 +326,15 @@ void Boat::AttachSwimmer(Swimmer* swimmer, int index)
 		leader = this;
 	else leader = trail[trail.size() - 1];
 		
-	if (trail.size() == 0)
-		swimmer->SetLagSeconds(0.8f);
+	swimmer->SetTrailDistance(GetTrailDistance((int)trail.size()));
 
 	// Attach the swimmer.
 	trail.push_back(swimmer);
-	swimmerManager->AttachSwimmer(swimmer, leader, index);
+	swimmerManager->AttachSwimmer(swimmer, leader, &trailHistory, swimmerManager->GetSwimmerIndex(swimmer));
+}
+
+// Get how far behind the boat a swimmer at a spot in the trail follows
+float Boat::GetTrailDistance(int trailIndex)
+{
+	return TRAIL_FIRST_DISTANCE + trailIndex * TRAIL_SPACING;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Swimmer.h"
 #include "InputManager.h"
 #include "SwimmerManager.h"
+#include "TrailPath.h"
 
 enum class BoatState { Starting, Playing, Crashed, Resetting };
 
@@ -22,15 +23,43 @@ private:
 	SwimmerManager* swimmerManager;
 	InputManager* inputManager;
 	std::vector<Swimmer*> trail;
+	TrailHistory trailHistory;       //Path the boat travelled (the trail follows it)
+	TrailPath trailPath;       //Centerline of the trail behind the first swimmer (built from the history)
+	int trailFollowers;       //Following swimmers from the second one on (the path ends at the last)
+	int trailPathStart;       //History index of the path's first point
+	int trailPathEnd;       //History index after the path's last point
 
 	//Seek timer
-	float seekTimer;
+	double seekStart;       //Timer wheel time the seek started
+	TimerHandle seekTimer;       //Ends the seek
 	DirectX::XMFLOAT3 seekPos;
 
 	// --------------------------------------------------------
 	// Attach a swimmer at the end of the trail
 	// --------------------------------------------------------
-	void AttachSwimmer(Swimmer* swimmer, int index);
+	void AttachSwimmer(Swimmer* swimmer);
+
+	// --------------------------------------------------------
+	// Get how far behind the boat a swimmer at a spot in the trail follows
+	// --------------------------------------------------------
+	float GetTrailDistance(int trailIndex);
+
+	// --------------------------------------------------------
+	// Keep the trail's path over the history points between the last
+	// following swimmer and the second one. Only adds and removes the
+	// points at its ends, so it costs O(log n) per point that changed
+	// --------------------------------------------------------
+	void UpdateTrailPath();
+
+	// --------------------------------------------------------
+	// Get a gameobject as a swimmer (nullptr if it isn't one)
+	// --------------------------------------------------------
+	Swimmer* AsSwimmer(GameObject* object);
+
+	// --------------------------------------------------------
+	// Handle the boat touching a swimmer (picks floating swimmers up)
+	// --------------------------------------------------------
+	void HitSwimmer(Swimmer* swimmer);
 	
 public:
 	Boat(Mesh* mesh, Material* material, float levelRadius);
@@ -67,10 +96,20 @@ public:
 	void SeekOrigin(float deltaTime);
 
 	// --------------------------------------------------------
-	// Checks for collisions and calls corresponding collide methods
+	// Checks if the boat left the level or hit its own trail
 	// --------------------------------------------------------
 	void CheckCollisions();
 
+	// --------------------------------------------------------
+	// Called by the CollisionManager when the boat starts touching something
+	// --------------------------------------------------------
+	void OnCollisionEnter(GameObject* other);
+
+	// --------------------------------------------------------
+	// Called by the CollisionManager while the boat keeps touching something
+	// --------------------------------------------------------
+	void OnCollisionStay(GameObject* other);
+
 	// --------------------------------------------------------
 	// Code called when the player hits the edge of the level
 	// --------------------------------------------------------
@@ -2,6 +2,7 @@
 
 #include <WindowsX.h>
 #include <sstream>
+#include <cmath>
 
 // Define the static instance variable so our OS-level 
 // message handling function below can talk to our object
@@ -50,6 +51,12 @@ DXCore::DXCore(
 	// Initialize fields
 	fpsFrameCount = 0;
 	fpsTimeElapsed = 0.0f;
+
+	fixedTimestep = 0.0f;
+	maxFixedSteps = 1;
+	accumulator = 0.0f;
+	simulationTime = 0.0f;
+	interpolationAlpha = 1.0f;
 	
 	device = 0;
 	context = 0;
@@ -373,7 +380,7 @@ HRESULT DXCore::Run()
 				UpdateTitleBarStats();
 
 			// The game loop
-			Update(deltaTime, totalTime);
+			Simulate();
 			Draw(deltaTime, totalTime);
 		}
 	}
@@ -384,6 +391,64 @@ HRESULT DXCore::Run()
 }
 
 
+// --------------------------------------------------------
+// Set the fixed simulation rate
+//
+// tickRate - Simulation steps per second (0 for variable steps)
+// maxSteps - Most steps to catch up on in a single frame.
+//            Any extra time is dropped so a long frame can't
+//            cause a spiral of ever longer frames
+// --------------------------------------------------------
+void DXCore::SetFixedTimestep(float tickRate, int maxSteps)
+{
+	fixedTimestep = tickRate > 0.0f ? 1.0f / tickRate : 0.0f;
+	maxFixedSteps = maxSteps > 0 ? maxSteps : 1;
+	accumulator = 0.0f;
+	interpolationAlpha = 1.0f;
+}
+
+// --------------------------------------------------------
+// How far the current frame is between the previous and the
+// latest simulation step (0 - 1), for render interpolation
+// --------------------------------------------------------
+float DXCore::GetInterpolationAlpha()
+{
+	return interpolationAlpha;
+}
+
+// --------------------------------------------------------
+// Run the simulation for this frame's delta time, either
+// as a single variable step or as a number of fixed steps
+// --------------------------------------------------------
+void DXCore::Simulate()
+{
+	// Variable timestep
+	if (fixedTimestep <= 0.0f)
+	{
+		simulationTime = totalTime;
+		interpolationAlpha = 1.0f;
+		Update(deltaTime, totalTime);
+		return;
+	}
+
+	// Consume the frame's time in fixed steps
+	accumulator += deltaTime;
+	int steps = 0;
+	while (accumulator >= fixedTimestep && steps < maxFixedSteps)
+	{
+		simulationTime += fixedTimestep;
+		Update(fixedTimestep, simulationTime);
+		accumulator -= fixedTimestep;
+		steps++;
+	}
+
+	// Too far behind, drop the time we couldn't catch up on
+	if (accumulator >= fixedTimestep)
+		accumulator = fmodf(accumulator, fixedTimestep);
+
+	interpolationAlpha = accumulator / fixedTimestep;
+}
+
 // --------------------------------------------------------
 // Sends an OS-level window close message to our process, which
 // will be handled by our message processing function
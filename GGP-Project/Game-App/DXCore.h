@@ -36,6 +36,12 @@ public:
 	HRESULT InitDirectX();
 	HRESULT Run();				
 	void Quit();
+
+	// Fixed timestep simulation - Update() is called in steps of
+	// 1 / tickRate seconds, at most maxSteps times per frame.
+	// A tickRate of 0 goes back to one variable step per frame
+	void SetFixedTimestep(float tickRate, int maxSteps);
+	float GetInterpolationAlpha();	// How far Draw() is between the last two steps (0-1)
 	virtual void OnResize();
 	
 	// Pure virtual methods for setup and game functionality
@@ -81,11 +87,19 @@ private:
 	__int64 currentTime;
 	__int64 previousTime;
 
+	// Fixed timestep data
+	float fixedTimestep;
+	int maxFixedSteps;
+	float accumulator;
+	float simulationTime;
+	float interpolationAlpha;
+
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
 	
 	void UpdateTimer();			// Updates the timer for this frame
+	void Simulate();			// Runs this frame's simulation step(s)
 	void UpdateTitleBarStats();	// Puts debug info in the title bar
 };
 
@@ -1,8 +1,13 @@
 #include "FocusCamera.h"
 #include "ExtendedMath.h"
+#include <cmath>
 
 using namespace DirectX;
 
+//How quickly the camera catches up to its target
+#define FOLLOW_LERP 0.005f //Fraction of the way moved...
+#define FOLLOW_LERP_RATE 60 //...this many times a second
+
 // Constructor - Set up the focus camera
 FocusCamera::FocusCamera(GameObject* obj, DirectX::XMFLOAT3 anchor,
 	XMFLOAT3 anchorRotation, float zoomDist, float yMinimum) : Camera()
@@ -30,7 +35,7 @@ FocusCamera::FocusCamera(GameObject* obj, DirectX::XMFLOAT3 anchor,
 FocusCamera::~FocusCamera()
 { }
 
-// Update the camera (runs every frame)
+// Update the camera's zoom (runs every simulation step)
 void FocusCamera::Update(float deltaTime)
 {
 #if defined(DEBUG) || defined(_DEBUG)
@@ -61,18 +66,30 @@ void FocusCamera::Update(float deltaTime)
 
 	//Keep zoom inbounds
 	zoom = ExtendedMath::Clamp(zoom, 0.0f, 1.0f);
-	
+}
+
+// Move the camera after the focus object (runs every rendered frame)
+void FocusCamera::Follow(float deltaTime, float alpha)
+{
+#if defined(DEBUG) || defined(_DEBUG)
+	//The debug camera moves itself
+	if (fpsMovement)
+		return;
+#endif
+
+	//Follow where the focus object is drawn, not where the last step left it
+	XMFLOAT3 focusPos = focusObj->GetInterpolatedPosition(alpha);
+
 	//Get target position
-	//XMFLOAT3 targetPos;
-	XMVECTOR targetPos = XMVectorLerp(XMLoadFloat3(&anchorPos),
-		XMLoadFloat3(&focusObj->GetPosition()), zoom);
+	XMVECTOR targetPos = XMVectorLerp(XMLoadFloat3(&anchorPos), XMLoadFloat3(&focusPos), zoom);
 
-	//Lerp new position
-	XMVECTOR newPos = XMVectorLerp(XMLoadFloat3(&GetPosition()), targetPos, 0.005f);
+	//Lerp new position (the same amount per second at any frame rate)
+	float followAmount = 1.0f - powf(1.0f - FOLLOW_LERP, deltaTime * FOLLOW_LERP_RATE);
+	XMVECTOR newPos = XMVectorLerp(XMLoadFloat3(&GetPosition()), targetPos, followAmount);
 
 	//Check if we are too close
 	XMFLOAT3 position;
-	XMVECTOR distVec = XMVector3Length(XMVectorSubtract(XMLoadFloat3(&focusObj->GetPosition()), newPos));
+	XMVECTOR distVec = XMVector3Length(XMVectorSubtract(XMLoadFloat3(&focusPos), newPos));
 	float distance = XMVectorGetX(distVec);
 	if (moveIn && distance <= maxZoom)
 	{
@@ -89,7 +106,7 @@ void FocusCamera::Update(float deltaTime)
 	//Rotate camera
 	XMFLOAT4X4 rotMat;
 	XMStoreFloat4x4(&rotMat, XMMatrixLookAtLH(XMLoadFloat3(&GetPosition()),
-		XMLoadFloat3(&focusObj->GetPosition()),
+		XMLoadFloat3(&focusPos),
 		XMLoadFloat3(&GetUpAxis())));
 
 	XMFLOAT4 destRot = ExtendedMath::MatrixToQuaternion(rotMat);
@@ -58,12 +58,22 @@ public:
 	~FocusCamera();
 
 	// --------------------------------------------------------
-	// Update the camera (runs every frame)
+	// Update the camera's zoom from the input (runs every
+	// simulation step)
 	//
-	// deltaTime - The time between frames
+	// deltaTime - The time between steps
 	// --------------------------------------------------------
 	void Update(float deltaTime);
 
+	// --------------------------------------------------------
+	// Move the camera after the focus object, where it's drawn
+	// between the last two simulation steps (runs every frame)
+	//
+	// deltaTime - The time between frames
+	// alpha - How far the frame is between the last two steps
+	// --------------------------------------------------------
+	void Follow(float deltaTime, float alpha);
+
 	// --------------------------------------------------------
 	// Set the focus object for this camera
 	// --------------------------------------------------------
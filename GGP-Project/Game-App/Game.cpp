@@ -1,5 +1,6 @@
 #include "Game.h"
 #include "LightManager.h"
+#include "SwimmerManager.h"
 #include "Vertex.h"
 #include "MAT_PBRTexture.h"
 #include "MAT_Water.h"
@@ -31,6 +32,8 @@ Game::Game(HINSTANCE hInstance)
 	printf("Console window created successfully.  Feel free to printf() here.\n");
 #endif
 
+	replayInputLog = false;
+
 }
 
 // --------------------------------------------------------
@@ -47,6 +50,9 @@ Game::~Game()
 
 	//Delete the camera
 	if (camera) { delete camera; }
+
+	//Delete the simulation
+	if (simulation) { delete simulation; }
 }
 
 // --------------------------------------------------------
@@ -64,16 +70,24 @@ void Game::Init()
 	renderer = Renderer::GetInstance();
 	renderer->Init(device, width, height);
 	entityManager = EntityManager::GetInstance();
-	swimmerManager = SwimmerManager::GetInstance();
-	swimmerManager->SetLevelRadius(LEVEL_RADIUS - 1);
 
 	//Initialize singleton data
 	inputManager->Init(hWnd);
 
+	//Run the simulation at a fixed rate, the renderer interpolates between steps
+	SetFixedTimestep(SIMULATION_TICK_RATE, MAX_SIMULATION_STEPS);
+
 	//Create game entities
-	gameState = GameState::Menu;
 	CreateEntities();
 
+	//Record or replay input
+	if (!inputLogPath.empty())
+	{
+		if (replayInputLog)
+			simulation->StartReplay(inputLogPath.c_str());
+		else simulation->StartRecording(inputLogPath.c_str());
+	}
+
 	//Initialize transformation modifiers
 	position = -2;
 	rotation = 0;
@@ -92,6 +106,10 @@ void Game::Init()
 	DirectionalLight* dLight = lightManager->CreateDirectionalLight(true, XMFLOAT3(1, 1, 1), 1);
 	dLight->SetRotation(60, -45, 0);
 
+	//Only fit the shadow cascades to the arena (and the walls around it)
+	float shadowRadius = LEVEL_RADIUS + 2.0f;
+	dLight->SetShadowBounds(XMFLOAT3(-shadowRadius, -8, -shadowRadius), XMFLOAT3(shadowRadius, 8, shadowRadius));
+
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.
 	// Essentially: "What kind of shape should the GPU draw with our data?"
@@ -107,6 +125,7 @@ void Game::LoadAssets()
 	resourceManager->LoadVertexShader("VertexShader.cso", device, context);
 	resourceManager->LoadPixelShader("PixelShader.cso", device, context);
 
+	resourceManager->LoadVertexShader("VS_Water.cso", device, context);
 	resourceManager->LoadPixelShader("PS_Water.cso", device, context);
 	resourceManager->LoadPixelShader("PS_ShineWater.cso", device, context);
 
@@ -120,6 +139,7 @@ void Game::LoadAssets()
 	resourceManager->LoadPixelShader("PS_Sky.cso", device, context);
 
 	resourceManager->LoadVertexShader("VS_Shadow.cso", device, context);
+	resourceManager->LoadPixelShader("PS_ShadowFill.cso", device, context);
 
 	//Create meshes
 	resourceManager->LoadMesh("Assets\\Models\\cube.obj", device);
@@ -205,7 +225,8 @@ void Game::LoadAssets()
 	resourceManager->AddMaterial("area", mat_area);
 	
 	//Water surface material
-	Material* mat_water = new MAT_Water(vs, resourceManager->GetPixelShader("PS_ShineWater.cso"),
+	Material* mat_water = new MAT_Water(resourceManager->GetVertexShader("VS_Water.cso"),
+		resourceManager->GetPixelShader("PS_ShineWater.cso"),
 		XMFLOAT2(2, 2), waterSamplerState, 
 		resourceManager->GetTexture2D("Assets/Textures/Water/blue.png"),
 		resourceManager->GetTexture2D("Assets/Textures/Water/water_normal_2.png"),
@@ -236,21 +257,19 @@ void Game::CreateEntities()
 	Entity* area = new Entity(resourceManager->GetMesh("Assets\\Models\\area.obj"),
 		resourceManager->GetMaterial("area"));
 	area->SetScale(2.18f, 0.5f, 2.18f);
+	area->SetStatic(true);
 
-	// Player (Boat) - Create the player.
-	player = new Boat(
+	//Create the gameplay simulation (player and swimmers)
+	simulation = new GameSimulation();
+	simulation->Init(
 		resourceManager->GetMesh("Assets\\Models\\boat.obj"),
 		resourceManager->GetMaterial("boat"),
-		LEVEL_RADIUS
+		resourceManager->GetMesh("Assets\\Models\\swimmer.obj"),
+		resourceManager->GetMaterial("swimmer")
 	);
-	player->SetPosition(0, 0, 0); // Set the player's initial position.
-	player->AddCollider(XMFLOAT3(0.9f, 0.8f, 2.3f), XMFLOAT3(0, 0, 0));
-#if defined(DEBUG) || defined(_DEBUG)
-	player->SetDebug(true);
-#endif
 
 	//Create the camera and initialize matrices
-	camera = new FocusCamera(player, XMFLOAT3(0, 16, -23), XMFLOAT3(40.75f, 0, 0), 4, 2);
+	camera = new FocusCamera(simulation->GetPlayer(), XMFLOAT3(0, 16, -23), XMFLOAT3(40.75f, 0, 0), 4, 2);
 	camera->CreateProjectionMatrix(0.25f * XM_PI, (float)width / height, 0.1f, 100.0f);
 }
 
@@ -279,7 +298,11 @@ void Game::Update(float deltaTime, float totalTime)
 {
 	inputManager->UpdateFocus();
 	if (!inputManager->IsWindowFocused())
+	{
+		//Paused, hold the entities still for render interpolation
+		entityManager->StorePreviousTransforms();
 		return;
+	}
 
 	//The only call to UpdateMousePos() for the InputManager
 	//Get the current mouse position
@@ -292,43 +315,14 @@ void Game::Update(float deltaTime, float totalTime)
 	if (inputManager->GetKey(VK_ESCAPE))
 		Quit();
 
-	//Update the camera
+	//Update the camera's zoom (it follows the boat in Draw)
 	camera->Update(deltaTime);
 	
-	//Gamestate switch
-	switch (gameState)
-	{
-		case GameState::Menu:
-			gameState = GameState::Playing;
-			break;
-
-		case GameState::Playing:
-			// Updates the swimmer generator/manager.
-			if(player->GetState() == BoatState::Playing)
-				swimmerManager->Update(deltaTime);
-
-			entityManager->Update(deltaTime);
+	//Run the gameplay
+	simulation->Update(deltaTime);
 
-			//Check for gameover
-			if (player->GetState() == BoatState::Crashed)
-				gameState = GameState::GameOver;
-			break;
-
-		case GameState::GameOver:
-			entityManager->Update(deltaTime);
-
-			//Check for reset input
-			if (inputManager->GetKey(VK_SPACE))
-			{
-				player->Reset();
-				swimmerManager->Reset();
-				gameState = GameState::Playing;
-			}
-			break;
-
-		default:
-			break;
-	}
+	//Move the glow sticks to the swimmers
+	UpdateGlowSticks();
 
 	//Updates water's scrolling normal map
 	translate += 0.025f * deltaTime;
@@ -342,12 +336,60 @@ void Game::Update(float deltaTime, float totalTime)
 	inputManager->UpdateStates();
 }
 
+// --------------------------------------------------------
+// Keep a glow stick light on every floating swimmer
+// --------------------------------------------------------
+void Game::UpdateGlowSticks()
+{
+	static const XMFLOAT3 glowColors[] =
+	{
+		XMFLOAT3(0.2f, 1.0f, 0.3f),
+		XMFLOAT3(1.0f, 0.3f, 0.8f),
+		XMFLOAT3(0.2f, 0.6f, 1.0f),
+		XMFLOAT3(1.0f, 0.8f, 0.1f)
+	};
+	const int glowColorCount = sizeof(glowColors) / sizeof(glowColors[0]);
+
+	LightManager* lightManager = LightManager::GetInstance();
+	SwimmerManager* swimmerManager = SwimmerManager::GetInstance();
+	int count = swimmerManager->GetSwimmerCount();
+
+	//Hand out lights for new swimmers (no shadows, there can be hundreds)
+	while ((int)glowSticks.size() < count)
+	{
+		int color = (int)glowSticks.size() % glowColorCount;
+		PointLight* glowStick = lightManager->CreatePointLight(false, GLOW_STICK_RANGE, glowColors[color], GLOW_STICK_INTENSITY);
+		if (glowStick == nullptr)
+			break;
+		glowSticks.push_back(glowStick);
+	}
+
+	//Take back the lights of swimmers that are gone
+	while ((int)glowSticks.size() > count)
+	{
+		lightManager->RemoveLight(glowSticks.back());
+		glowSticks.pop_back();
+	}
+
+	for (size_t i = 0; i < glowSticks.size(); i++)
+	{
+		XMFLOAT3 position = swimmerManager->GetSwimmer((int)i)->GetPosition();
+		position.y += GLOW_STICK_HEIGHT;
+		glowSticks[i]->SetPosition(position);
+	}
+}
+
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
+	//Place the camera behind the boat where it's drawn this frame
+	float alpha = GetInterpolationAlpha();
+	camera->Follow(deltaTime, alpha);
+
 	//Draw all entities in the renderer
+	renderer->SetInterpolationAlpha(alpha);
 	renderer->SetClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Needed for clearing the post process buffer texture and the back buffer.
 	renderer->Draw(context, device, camera, backBufferRTV, depthStencilView, samplerState, width, height);
 
@@ -358,6 +400,15 @@ void Game::Draw(float deltaTime, float totalTime)
 }
 
 
+// --------------------------------------------------------
+// Record this session's input to a file, or replay a recorded one
+// --------------------------------------------------------
+void Game::SetInputLog(std::string path, bool replay)
+{
+	inputLogPath = path;
+	replayInputLog = replay;
+}
+
 #pragma region Mouse Input
 
 // --------------------------------------------------------
@@ -7,12 +7,13 @@
 #include "EntityManager.h"
 #include "FocusCamera.h"
 #include "ResourceManager.h"
-#include "SwimmerManager.h"
-#include "Boat.h"
+#include "GameSimulation.h"
 
-#define LEVEL_RADIUS 13
-
-enum class GameState {Menu, Playing, GameOver};
+#define SIMULATION_TICK_RATE 60 //Simulation steps per second
+#define MAX_SIMULATION_STEPS 5 //Most steps to catch up on in one frame
+#define GLOW_STICK_RANGE 2.5f //How far a swimmer's glow stick lights
+#define GLOW_STICK_INTENSITY 1.5f
+#define GLOW_STICK_HEIGHT 0.4f //Above the swimmer
 
 class Game 
 	: public DXCore
@@ -37,17 +38,21 @@ public:
 	void OnMouseUp	 (WPARAM buttonState, int x, int y, int button);
 	void OnMouseMove (WPARAM buttonState, int x, int y);
 	void OnMouseWheel(float wheelDelta,   int x, int y);
+
+	// Record this session's input to a file, or replay a recorded
+	// one (call before Run)
+	void SetInputLog(std::string path, bool replay);
 private:
 	//Singletons
 	Renderer* renderer;
 	InputManager* inputManager;
 	ResourceManager* resourceManager;
 	EntityManager* entityManager;
-	SwimmerManager* swimmerManager;
 
 	//Gameplay
-	GameState gameState;
-	Boat* player;
+	GameSimulation* simulation;
+	std::string inputLogPath;
+	bool replayInputLog;
 
 	//Sampler states
 	ID3D11SamplerState* samplerState;
@@ -63,8 +68,16 @@ private:
 	//Water
 	float translate; //used to scroll the water's normal map
 
+	//A glow stick light for each floating swimmer
+	std::vector<PointLight*> glowSticks;
+
 	// Initialization helper methods - feel free to customize, combine, etc.
 	void LoadAssets();
 	void CreateEntities();
+
+	// --------------------------------------------------------
+	// Keep a glow stick light on every floating swimmer
+	// --------------------------------------------------------
+	void UpdateGlowSticks();
 };
 
@@ -0,0 +1,218 @@
+#include "GameSimulation.h"
+#include <cmath>
+
+//Ripples from things moving through the water (height pushed per unit moved)
+#define WAKE_BOAT_STRENGTH 0.08f
+#define WAKE_BOAT_RADIUS 1.2f
+#define WAKE_SWIMMER_STRENGTH 0.05f
+#define WAKE_SWIMMER_RADIUS 0.5f
+
+//Anything that moved further than this in a step was placed, not moved
+#define WAKE_MAX_MOVE 1.0f
+
+using namespace DirectX;
+
+// Constructor - Set up the simulation's singletons
+GameSimulation::GameSimulation()
+{
+	inputManager = InputManager::GetInstance();
+	inputRecorder = InputRecorder::GetInstance();
+	entityManager = EntityManager::GetInstance();
+	collisionManager = CollisionManager::GetInstance();
+	timerWheel = TimerWheel::GetInstance();
+	waterSurface = WaterSurface::GetInstance();
+	swimmerManager = SwimmerManager::GetInstance();
+
+	gameState = GameState::Menu;
+	player = nullptr;
+}
+
+// Destructor for when an instance is deleted
+GameSimulation::~GameSimulation()
+{
+	//Send the swimmers away while their entities are still alive
+	swimmerManager->Reset();
+
+	if (waterSurface->GetOcean() == &ocean)
+		waterSurface->SetOcean(nullptr);
+	if (waterSurface->GetWake() == &wake)
+		waterSurface->SetWake(nullptr);
+}
+
+// Create the player and set up the swimmers
+void GameSimulation::Init(Mesh* boatMesh, Material* boatMat, Mesh* swimmerMesh, Material* swimmerMat)
+{
+	swimmerManager->SetLevelRadius(LEVEL_RADIUS - 1);
+	swimmerManager->SetSwimmerAssets(swimmerMesh, swimmerMat);
+
+	//A gentle swell for the swimmers to bob on
+	waterSurface->ClearWaves();
+	waterSurface->SetSurfaceY(SURFACE_Y);
+	waterSurface->AddWave(XMFLOAT2(1, 0.3f), 9, 0.12f, 0.6f);
+	waterSurface->AddWave(XMFLOAT2(-0.4f, 1), 5.5f, 0.07f, 0.5f);
+	waterSurface->AddWave(XMFLOAT2(0.7f, -0.8f), 3.1f, 0.04f, 0.4f);
+
+	//Wind blown chop, tiled every 16 units
+	if (ocean.Init(64, 16, XMFLOAT2(5, 2), 0.04f, 0.8f, 1))
+		waterSurface->SetOcean(&ocean);
+
+	//Ripples over the whole level, stepped at 30 Hz
+	if (wake.Init(128, LEVEL_RADIUS * 2 + 4, 4, 0.6f, 1.0f / 30))
+		waterSurface->SetWake(&wake);
+
+	// Player (Boat) - Create the player.
+	player = new Boat(boatMesh, boatMat, LEVEL_RADIUS);
+	player->SetPosition(0, 0, 0); // Set the player's initial position.
+	player->AddCollider(XMFLOAT3(0.9f, 0.8f, 2.3f), XMFLOAT3(0, 0, 0), ColliderShape::Capsule);
+	player->GetCollider()->SetCollisionLayer(LAYER_BOAT, LAYER_SWIMMER);
+#if defined(DEBUG) || defined(_DEBUG)
+	player->SetDebug(true);
+#endif
+
+	gameState = GameState::Menu;
+}
+
+// Run a single simulation step
+void GameSimulation::Update(float deltaTime)
+{
+	//Take this step's input and time from the log
+	if (inputRecorder->GetMode() == RecorderMode::Replaying)
+	{
+		if (!inputRecorder->ReplayStep(&deltaTime))
+		{
+			printf("Input recording ended early\n");
+			inputRecorder->Stop();
+		}
+	}
+	//Hold the keys still for the whole step so they can be recorded
+	else if (inputRecorder->GetMode() == RecorderMode::Recording)
+		inputManager->CaptureKeys();
+
+	//Start a new simulation step for render interpolation
+	entityManager->StorePreviousTransforms();
+
+	//Run the gameplay timers that came due (before anything updates)
+	timerWheel->Advance(deltaTime);
+	waterSurface->Advance(deltaTime);
+
+	//Gamestate switch
+	switch (gameState)
+	{
+		case GameState::Menu:
+			gameState = GameState::Playing;
+			break;
+
+		case GameState::Playing:
+			// Updates the swimmer generator/manager.
+			if(player->GetState() == BoatState::Playing)
+				swimmerManager->Update(deltaTime);
+
+			swimmerManager->UpdatePhysics(deltaTime, player->GetPosition());
+			entityManager->Update(deltaTime);
+			collisionManager->Update();
+
+			//Check for gameover
+			if (player->GetState() == BoatState::Crashed)
+				gameState = GameState::GameOver;
+			break;
+
+		case GameState::GameOver:
+			swimmerManager->UpdatePhysics(deltaTime, player->GetPosition());
+			entityManager->Update(deltaTime);
+			collisionManager->Update();
+
+			//Check for reset input
+			if (inputManager->GetKey(VK_SPACE))
+			{
+				player->Reset();
+				swimmerManager->Reset();
+				gameState = GameState::Playing;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	StirWater();
+
+	//Record or check the step
+	if (inputRecorder->GetMode() == RecorderMode::Recording)
+		inputRecorder->RecordStep(deltaTime, GetChecksum());
+	else if (inputRecorder->GetMode() == RecorderMode::Replaying)
+	{
+		inputRecorder->CheckStep(GetChecksum());
+		if (!inputRecorder->HasReplaySteps())
+			inputRecorder->Stop();
+	}
+}
+
+// Push ripples into the water where things moved
+void GameSimulation::StirWater()
+{
+	if (waterSurface->GetWake() != &wake || player == nullptr)
+		return;
+
+	//The boat pushes a bow wave along its path
+	XMFLOAT3 position = player->GetPosition();
+	XMFLOAT3 previous = player->GetPreviousPosition();
+	float moved = sqrtf((position.x - previous.x) * (position.x - previous.x)
+		+ (position.z - previous.z) * (position.z - previous.z));
+	if (moved > 0 && moved < WAKE_MAX_MOVE)
+		wake.AddImpulse(position.x, position.z, WAKE_BOAT_STRENGTH * moved, WAKE_BOAT_RADIUS);
+
+	//Swimmers splash as they paddle around
+	int count = swimmerManager->GetSwimmerCount();
+	for (int i = 0; i < count; i++)
+	{
+		Swimmer* swimmer = swimmerManager->GetSwimmer(i);
+		position = swimmer->GetPosition();
+		previous = swimmer->GetPreviousPosition();
+		moved = sqrtf((position.x - previous.x) * (position.x - previous.x)
+			+ (position.z - previous.z) * (position.z - previous.z));
+		if (moved > 0 && moved < WAKE_MAX_MOVE)
+			wake.AddImpulse(position.x, position.z, WAKE_SWIMMER_STRENGTH * moved, WAKE_SWIMMER_RADIUS);
+	}
+}
+
+// Record every step's input, delta time and checksum to a file
+bool GameSimulation::StartRecording(const char* path)
+{
+	//Restart the randomness so the replay can start from the same seed
+	unsigned int seed = swimmerManager->GetSeed();
+	swimmerManager->SetSeed(seed);
+
+	return inputRecorder->StartRecording(path, seed);
+}
+
+// Replay a recorded session from a file
+bool GameSimulation::StartReplay(const char* path)
+{
+	if (!inputRecorder->StartReplay(path))
+		return false;
+
+	swimmerManager->SetSeed(inputRecorder->GetSeed());
+	return true;
+}
+
+// Hash the state of the world (entities and game state)
+unsigned long long GameSimulation::GetChecksum()
+{
+	unsigned long long checksum = entityManager->GetWorldChecksum();
+	checksum ^= (unsigned long long)gameState << 56;
+	checksum ^= (unsigned long long)player->GetState() << 48;
+	checksum ^= (unsigned long long)swimmerManager->GetSwimmerCount() << 32;
+	return checksum;
+}
+
+// Get the current state of the game
+GameState GameSimulation::GetGameState()
+{
+	return gameState;
+}
+
+// Get the player's boat
+Boat* GameSimulation::GetPlayer()
+{
+	return player;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <DirectXMath.h>
+#include "InputManager.h"
+#include "InputRecorder.h"
+#include "EntityManager.h"
+#include "CollisionManager.h"
+#include "TimerWheel.h"
+#include "WaterSurface.h"
+#include "SwimmerManager.h"
+#include "Boat.h"
+
+#define LEVEL_RADIUS 13
+
+enum class GameState {Menu, Playing, GameOver};
+
+// --------------------------------------------------------
+// The gameplay simulation (player, swimmers and game state).
+//
+// Has no window, input device or D3D resources of its own, so
+// it can be run by the Game or headless by the benchmark
+// --------------------------------------------------------
+class GameSimulation
+{
+private:
+	//Singletons
+	InputManager* inputManager;
+	InputRecorder* inputRecorder;
+	EntityManager* entityManager;
+	CollisionManager* collisionManager;
+	TimerWheel* timerWheel;
+	WaterSurface* waterSurface;
+	SwimmerManager* swimmerManager;
+
+	//Chop on top of the swell, and the ripples things leave behind
+	OceanFFT ocean;
+	WakeField wake;
+
+	//Gameplay
+	GameState gameState;
+	Boat* player;
+
+	// --------------------------------------------------------
+	// Push ripples into the water where the boat and the
+	// floating swimmers moved this step
+	// --------------------------------------------------------
+	void StirWater();
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up the simulation's singletons
+	// --------------------------------------------------------
+	GameSimulation();
+
+	// --------------------------------------------------------
+	// Destructor for when an instance is deleted
+	// --------------------------------------------------------
+	~GameSimulation();
+
+	// --------------------------------------------------------
+	// Create the player and set up the swimmers.
+	// Meshes and materials can be nullptr when nothing is rendered
+	// --------------------------------------------------------
+	void Init(Mesh* boatMesh, Material* boatMat, Mesh* swimmerMesh, Material* swimmerMat);
+
+	// --------------------------------------------------------
+	// Run a single simulation step
+	// --------------------------------------------------------
+	void Update(float deltaTime);
+
+	// --------------------------------------------------------
+	// Record every step's input, delta time and checksum to a file.
+	// Call after Init and before the first Update
+	// --------------------------------------------------------
+	bool StartRecording(const char* path);
+
+	// --------------------------------------------------------
+	// Replay a recorded session from a file, overriding input and
+	// delta time. Call after Init and before the first Update
+	// --------------------------------------------------------
+	bool StartReplay(const char* path);
+
+	// --------------------------------------------------------
+	// Hash the state of the world (entities and game state)
+	// --------------------------------------------------------
+	unsigned long long GetChecksum();
+
+	// --------------------------------------------------------
+	// Get the current state of the game
+	// --------------------------------------------------------
+	GameState GetGameState();
+
+	// --------------------------------------------------------
+	// Get the player's boat
+	// --------------------------------------------------------
+	Boat* GetPlayer();
+};
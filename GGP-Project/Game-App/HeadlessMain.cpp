@@ -0,0 +1,463 @@
+// --------------------------------------------------------
+// Headless benchmark - runs the gameplay simulation for a number of
+// frames at a fixed timestep with scripted input, without a window,
+// input devices or a GPU, and reports frame time percentiles,
+// entity counts and allocations.
+//
+// Only built when HEADLESS is defined. The CMakeLists.txt in the
+// GGP-Project folder builds it (with the BENCH_ files and the
+// gameplay sources) on Linux, e.g.:
+//
+//   cmake -S . -B build -DDIRECTXMATH_INCLUDE_DIR=<DirectXMath>/Inc
+//   cmake --build build
+//
+// DirectXMath is https://github.com/Microsoft/DirectXMath, which needs
+// the sal.h from DirectX-Headers on Linux. It's built with AVX like
+// the game; configure with -DHEADLESS_AVX=OFF for the 4 lane kernels
+//
+// Usage: headless-benchmark [-frames N] [-tickrate HZ] [-swimmers N | -population N]
+//                           [-script FILE] [-record FILE | -replay FILE]
+//        headless-benchmark -<benchmark> N [-frames N]
+//
+// -population runs the game in the large population stress mode: up to
+// N swimmers spawned in batches over an area that grows with N, with
+// far away swimmers' physics and flocking throttled.
+//
+// -record saves the run's input, delta times, seed and checksums, and
+// -replay runs a recording (from here or the game) again, exactly, for
+// A/B comparisons. A replay runs until the recording ends
+//
+// The other benchmarks (in benchmarkModes below) each live in their own
+// BENCH_ file, which says what they check:
+//   -colliders  broadphase             -water     wave height queries
+//   -sat        batched SAT            -ocean     FFT ocean
+//   -shapes     every pair of shapes   -wake      wake field step and queries
+//   -trail      boat vs its trail      -cascades  shadow cascade fitting
+//   -buoyancy   swimmer water physics  -atlas     shadow atlas packing
+//   -flock      swimmer flocking       -clusters  clustered light culling
+//   -timers     timer wheel
+//
+// Script files have one key event per line: "<frame> <key> <down|up>",
+// where key is a single character or LEFT, RIGHT, UP, DOWN or SPACE.
+// Lines starting with # are ignored
+// --------------------------------------------------------
+#ifdef HEADLESS
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cfloat>
+#include "Benchmarks.h"
+#include "GameSimulation.h"
+
+//Large population stress mode
+#define POPULATION_SPAWN_BATCH 1000
+#define POPULATION_SPAWN_INTERVAL 0.1f
+#define POPULATION_THROTTLE_INTERVAL 4
+#define POPULATION_FULL_RATE_DISTANCE 20.0f
+
+using namespace DirectX;
+
+//Allocation tracking
+static std::atomic<unsigned long long> allocationCount(0);
+static std::atomic<unsigned long long> allocationBytes(0);
+
+void* operator new(size_t size)
+{
+	allocationCount++;
+	allocationBytes += size;
+
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+//A scripted key press or release
+struct ScriptedKey
+{
+	int frame;
+	char key;
+	bool down;
+};
+
+// Convert a key name from a script to a key code
+static bool ParseKey(const char* name, char* key)
+{
+	if (strcmp(name, "LEFT") == 0) { *key = VK_LEFT; return true; }
+	if (strcmp(name, "RIGHT") == 0) { *key = VK_RIGHT; return true; }
+	if (strcmp(name, "UP") == 0) { *key = VK_UP; return true; }
+	if (strcmp(name, "DOWN") == 0) { *key = VK_DOWN; return true; }
+	if (strcmp(name, "SPACE") == 0) { *key = VK_SPACE; return true; }
+	if (strlen(name) == 1) { *key = name[0]; return true; }
+	return false;
+}
+
+// Load a script of key events
+static bool LoadScript(const char* path, std::vector<ScriptedKey>& script)
+{
+	FILE* file = fopen(path, "r");
+	if (file == nullptr)
+	{
+		printf("Could not open input script %s\n", path);
+		return false;
+	}
+
+	char line[256];
+	int lineNumber = 0;
+	while (fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+
+		int frame;
+		char keyName[32];
+		char state[8];
+		ScriptedKey event;
+		if (sscanf(line, "%d %31s %7s", &frame, keyName, state) != 3 || !ParseKey(keyName, &event.key))
+		{
+			printf("Skipping bad input script line %d: %s", lineNumber, line);
+			continue;
+		}
+
+		event.frame = frame;
+		event.down = strcmp(state, "down") == 0;
+		script.push_back(event);
+	}
+	fclose(file);
+
+	//Events are applied in frame order
+	std::stable_sort(script.begin(), script.end(),
+		[](const ScriptedKey& a, const ScriptedKey& b) { return a.frame < b.frame; });
+	return true;
+}
+
+// Build the default script - weave left and straight, and
+// press space every few seconds to restart after a game over
+static void BuildDefaultScript(int frames, std::vector<ScriptedKey>& script)
+{
+	for (int frame = 0; frame < frames; frame += 150)
+	{
+		script.push_back({ frame, 'A', true });
+		script.push_back({ frame + 90, 'A', false });
+	}
+	for (int frame = 240; frame < frames; frame += 240)
+	{
+		script.push_back({ frame, VK_SPACE, true });
+		script.push_back({ frame + 1, VK_SPACE, false });
+	}
+
+	std::stable_sort(script.begin(), script.end(),
+		[](const ScriptedKey& a, const ScriptedKey& b) { return a.frame < b.frame; });
+}
+
+// Get a percentile from sorted values
+float Percentile(const std::vector<float>& sorted, float percent)
+{
+	if (sorted.size() == 0)
+		return 0;
+
+	size_t index = (size_t)(percent / 100.0f * (sorted.size() - 1) + 0.5f);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+//The benchmarks that can run instead of the game
+static const BenchmarkMode benchmarkModes[] =
+{
+	{ "-colliders", "N", RunBroadphaseBenchmark },
+	{ "-sat", "N", RunSATBenchmark },
+	{ "-shapes", "N", RunShapeBenchmark },
+	{ "-trail", "N", RunTrailBenchmark },
+	{ "-buoyancy", "N", RunBuoyancyBenchmark },
+	{ "-flock", "N", RunFlockBenchmark },
+	{ "-timers", "N", RunTimerBenchmark },
+	{ "-water", "N", RunWaterBenchmark },
+	{ "-ocean", "SIZE", RunOceanBenchmark },
+	{ "-wake", "SIZE", RunWakeBenchmark },
+	{ "-cascades", "SIZE", RunCascadeBenchmark },
+	{ "-atlas", "N", RunAtlasBenchmark },
+	{ "-clusters", "N", RunClusterBenchmark }
+};
+
+// Find the benchmark a command line flag picks (nullptr if it isn't one)
+static const BenchmarkMode* FindBenchmarkMode(const char* flag)
+{
+	for (const BenchmarkMode& mode : benchmarkModes)
+	{
+		if (strcmp(flag, mode.flag) == 0)
+			return &mode;
+	}
+	return nullptr;
+}
+
+// --------------------------------------------------------
+// Entry point for the headless benchmark
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int frames = 10000;
+	float tickRate = 60;
+	int maxSwimmers = 5;
+	const char* scriptPath = nullptr;
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	const BenchmarkMode* benchmark = nullptr;
+	int benchmarkCount = 0;
+	int population = 0;
+
+	//Read the arguments
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-tickrate") == 0 && i + 1 < argc)
+			tickRate = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-swimmers") == 0 && i + 1 < argc)
+			maxSwimmers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-script") == 0 && i + 1 < argc)
+			scriptPath = argv[++i];
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+			recordPath = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+			replayPath = argv[++i];
+		else if (strcmp(argv[i], "-population") == 0 && i + 1 < argc)
+			population = atoi(argv[++i]);
+		else if (FindBenchmarkMode(argv[i]) != nullptr && i + 1 < argc)
+		{
+			benchmark = FindBenchmarkMode(argv[i]);
+			benchmarkCount = atoi(argv[++i]);
+		}
+		else
+		{
+			printf("Usage: %s [-frames N] [-tickrate HZ] [-swimmers N | -population N] [-script FILE] [-record FILE | -replay FILE]\n", argv[0]);
+			for (const BenchmarkMode& usage : benchmarkModes)
+			{
+				printf("       %s %s %s [-frames N]\n", argv[0], usage.flag, usage.countName);
+			}
+			return 1;
+		}
+	}
+	if (frames <= 0 || tickRate <= 0)
+	{
+		printf("Frames and tick rate must be positive\n");
+		return 1;
+	}
+	if (benchmark != nullptr && benchmarkCount > 0)
+		return benchmark->run(benchmarkCount, frames);
+
+	//Set up the input script
+	std::vector<ScriptedKey> script;
+	if (scriptPath != nullptr)
+	{
+		if (!LoadScript(scriptPath, script))
+			return 1;
+	}
+	else BuildDefaultScript(frames, script);
+
+	InputManager* inputManager = InputManager::GetInstance();
+	inputManager->Init(nullptr);
+	inputManager->SetScriptedInput(true);
+
+	//Create the simulation without any meshes or materials
+	EntityManager* entityManager = EntityManager::GetInstance();
+	GameSimulation* simulation = new GameSimulation();
+	simulation->Init(nullptr, nullptr, nullptr, nullptr);
+	SwimmerManager* swimmerManager = SwimmerManager::GetInstance();
+	swimmerManager->SetMaxSwimmerCount(maxSwimmers);
+	if (population > 0)
+	{
+		maxSwimmers = population;
+		swimmerManager->SetMaxSwimmerCount(population);
+		swimmerManager->SetSpawnBatch(POPULATION_SPAWN_BATCH, POPULATION_SPAWN_INTERVAL);
+		swimmerManager->SetLevelRadius(sqrtf(population * POPULATION_AREA_PER_SWIMMER / XM_PI));
+		swimmerManager->GetPhysics()->SetThrottle(POPULATION_THROTTLE_INTERVAL, POPULATION_FULL_RATE_DISTANCE);
+		swimmerManager->GetFlock()->SetThrottle(POPULATION_THROTTLE_INTERVAL, POPULATION_FULL_RATE_DISTANCE);
+	}
+
+	//Record or replay the run
+	InputRecorder* inputRecorder = InputRecorder::GetInstance();
+	if (replayPath != nullptr)
+	{
+		if (!simulation->StartReplay(replayPath))
+			return 1;
+		script.clear();
+	}
+	else if (recordPath != nullptr && !simulation->StartRecording(recordPath))
+		return 1;
+	bool replaying = replayPath != nullptr;
+
+	//Stats (allocated up front so they don't show up in the frames)
+	std::vector<float> frameTimes;
+	std::vector<unsigned long long> frameAllocations;
+	frameTimes.reserve(frames);
+	frameAllocations.reserve(frames);
+	float phaseTotals[(int)UpdatePhase::Count] = {};
+	int minEntities = entityManager->GetEntityCount();
+	int maxEntities = minEntities;
+	double entityTotal = 0;
+	int gameOvers = 0;
+	double candidateTotal = 0;
+	double contactTotal = 0;
+	double floatingTotal = 0;
+	double activeTotal = 0;
+	double physicsTotal = 0;
+
+	if (replaying)
+		printf("Running a replay (%d swimmers max)\n", maxSwimmers);
+	else printf("Running %d frames at %.1f Hz (%d swimmers max)\n", frames, tickRate, maxSwimmers);
+
+	//Run the simulation
+	float deltaTime = 1.0f / tickRate;
+	size_t nextEvent = 0;
+	unsigned long long startBytes = allocationBytes;
+	int frame;
+	for (frame = 0; replaying ? inputRecorder->GetMode() == RecorderMode::Replaying : frame < frames; frame++)
+	{
+		//Feed the script's input for this frame
+		while (nextEvent < script.size() && script[nextEvent].frame <= frame)
+		{
+			inputManager->SetScriptedKey(script[nextEvent].key, script[nextEvent].down);
+			nextEvent++;
+		}
+
+		GameState previousState = simulation->GetGameState();
+		unsigned long long startAllocations = allocationCount;
+		auto start = std::chrono::high_resolution_clock::now();
+
+		simulation->Update(deltaTime);
+		inputManager->UpdateStates();
+
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		frameTimes.push_back(elapsed.count());
+		frameAllocations.push_back(allocationCount - startAllocations);
+
+		for (int p = 0; p < (int)UpdatePhase::Count; p++)
+		{
+			phaseTotals[p] += entityManager->GetPhaseTime((UpdatePhase)p);
+		}
+
+		int entityCount = entityManager->GetEntityCount();
+		minEntities = std::min(minEntities, entityCount);
+		maxEntities = std::max(maxEntities, entityCount);
+		entityTotal += entityCount;
+		candidateTotal += CollisionManager::GetInstance()->GetCandidateCount();
+		contactTotal += CollisionManager::GetInstance()->GetContacts().size();
+		floatingTotal += swimmerManager->GetSwimmerCount();
+		activeTotal += entityManager->GetActiveCount();
+		physicsTotal += swimmerManager->GetPhysics()->GetActiveCount();
+
+		if (previousState != GameState::GameOver && simulation->GetGameState() == GameState::GameOver)
+			gameOvers++;
+	}
+	unsigned long long totalBytes = allocationBytes - startBytes;
+	bool diverged = replaying && inputRecorder->GetDivergedStepCount() > 0;
+	inputRecorder->Stop();
+	frames = frame;
+	if (frames == 0)
+	{
+		printf("No frames were run\n");
+		return 1;
+	}
+
+	//Frame time report
+	std::vector<float> sortedTimes = frameTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+	double totalTime = 0;
+	for (size_t i = 0; i < frameTimes.size(); i++)
+	{
+		totalTime += frameTimes[i];
+	}
+
+	printf("\nFrame time (ms)\n");
+	printf("  mean   %.4f\n", totalTime / frames);
+	printf("  p50    %.4f\n", Percentile(sortedTimes, 50));
+	printf("  p90    %.4f\n", Percentile(sortedTimes, 90));
+	printf("  p99    %.4f\n", Percentile(sortedTimes, 99));
+	printf("  p99.9  %.4f\n", Percentile(sortedTimes, 99.9f));
+	printf("  max    %.4f\n", sortedTimes[sortedTimes.size() - 1]);
+
+	printf("\nUpdate phases (mean ms)\n");
+	const char* phaseNames[] = { "PrePhysics", "Physics", "PostPhysics", "Late" };
+	for (int p = 0; p < (int)UpdatePhase::Count; p++)
+	{
+		printf("  %-12s %.4f\n", phaseNames[p], phaseTotals[p] / frames);
+	}
+
+	//Entity report
+	printf("\nEntities\n");
+	printf("  min    %d\n", minEntities);
+	printf("  mean   %.1f\n", entityTotal / frames);
+	printf("  max    %d\n", maxEntities);
+	printf("  final  %d\n", entityManager->GetEntityCount());
+	printf("  awake (mean) %.1f\n", activeTotal / frames);
+	printf("  game overs %d\n", gameOvers);
+
+	//Swimmer report
+	printf("\nSwimmers\n");
+	printf("  floating (mean)        %.1f\n", floatingTotal / frames);
+	printf("  physics updates (mean) %.1f\n", physicsTotal / frames);
+	printf("  sinking (final)        %d\n", swimmerManager->GetLeavingCount());
+	printf("  pooled (final)         %d\n", swimmerManager->GetPooledCount());
+	printf("  spawns with no room    %d\n", swimmerManager->GetSpawnFailures());
+
+	//Closest two floating swimmers (spawns keep them apart)
+	float closestGap = FLT_MAX;
+	std::vector<Swimmer*> nearby;
+	for (int i = 0; i < swimmerManager->GetSwimmerCount(); i++)
+	{
+		Swimmer* swimmer = swimmerManager->GetSwimmer(i);
+		XMFLOAT3 position = swimmer->GetPosition();
+		swimmerManager->GetSwimmersNear(position, 5, nearby);
+		for (size_t j = 0; j < nearby.size(); j++)
+		{
+			if (nearby[j] == swimmer)
+				continue;
+			XMFLOAT3 other = nearby[j]->GetPosition();
+			float x = other.x - position.x;
+			float z = other.z - position.z;
+			closestGap = std::min(closestGap, sqrtf(x * x + z * z));
+		}
+	}
+	if (closestGap < FLT_MAX)
+		printf("  closest gap (final)    %.3f\n", closestGap);
+
+	//Collision report
+	printf("\nCollisions (mean per frame)\n");
+	printf("  candidate pairs %.1f\n", candidateTotal / frames);
+	printf("  contacts        %.1f\n", contactTotal / frames);
+
+	//Allocation report
+	unsigned long long totalAllocations = 0;
+	unsigned long long maxAllocations = 0;
+	for (size_t i = 0; i < frameAllocations.size(); i++)
+	{
+		totalAllocations += frameAllocations[i];
+		maxAllocations = std::max(maxAllocations, frameAllocations[i]);
+	}
+	printf("\nAllocations\n");
+	printf("  total          %llu (%llu bytes)\n", totalAllocations, totalBytes);
+	printf("  per frame mean %.2f\n", (double)totalAllocations / frames);
+	printf("  per frame max  %llu\n", maxAllocations);
+
+	delete simulation;
+	return diverged ? 2 : 0;
+}
+
+#endif
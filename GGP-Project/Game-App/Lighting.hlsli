@@ -5,7 +5,12 @@
 #define LIGHT_TYPE_DIRECTIONAL	0
 #define LIGHT_TYPE_POINT		1
 #define LIGHT_TYPE_SPOT			2
-#define MAX_LIGHTS 10
+#define MAX_SHADOW_VIEWS 16
+
+//Clusters the view is split into, across, down and by depth (matches LightClusters.h)
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
 
 struct Light
 {
@@ -19,7 +24,21 @@ struct Light
 	float3	Color;		// 48 bytes
 
 	float	SpotFalloff;
-	float3	Padding;	// 64 bytes
+	int		ShadowStart;	//First of the light's shadow views
+	int		ShadowCount;	//0 if the light has no shadows
+	float	Padding;	// 64 bytes
+};
+
+//A light's view into the shadow atlas (a directional light's cascade, or a point light's cube face)
+//AtlasRect is the uv of the tile's corner, the uv size of the tile and the uv size of a texel
+struct ShadowView
+{
+	matrix	ViewProjection;	// 64 bytes
+
+	float4	AtlasRect;	// 80 bytes
+
+	float	CascadeEnd;	//View depth a directional light's cascade ends at
+	float3	Padding;	// 96 bytes
 };
 
 struct AmbientLight
@@ -67,6 +86,78 @@ float Attenuate(Light light, float3 worldPos)
 }
 
 
+// === SHADOWS ======================================================
+
+// Which cube face of a point light's shadow covers a direction from the light (+X, -X, +Y, -Y, +Z, -Z)
+int ShadowCubeFace(float3 fromLight)
+{
+	float3 size = abs(fromLight);
+	if (size.x >= size.y && size.x >= size.z)
+		return fromLight.x >= 0 ? 0 : 1;
+	if (size.y >= size.z)
+		return fromLight.y >= 0 ? 2 : 3;
+	return fromLight.z >= 0 ? 4 : 5;
+}
+
+// How lit a spot is by a shadow view's tile of the atlas (0 is fully in shadow)
+float SampleShadow(Texture2D shadowAtlas, SamplerComparisonState samp, ShadowView view, float3 worldPos)
+{
+	float4 posForShadow = mul(float4(worldPos, 1.0f), view.ViewProjection);
+	float depthFromLight = posForShadow.z / posForShadow.w;
+	float2 shadowUV = posForShadow.xy / posForShadow.w * 0.5f + 0.5f;
+	shadowUV.y = 1.0f - shadowUV.y;
+
+	//Outside the view (or without a tile) is lit
+	if (view.AtlasRect.z == 0 || posForShadow.w <= 0 || depthFromLight > 1 || any(saturate(shadowUV) != shadowUV))
+		return 1.0f;
+
+	//Keep the filtering from reaching into the tiles next to this one
+	float halfTexel = view.AtlasRect.w * 0.5f;
+	float2 atlasUV = view.AtlasRect.xy + clamp(shadowUV * view.AtlasRect.z, halfTexel, view.AtlasRect.z - halfTexel);
+	return shadowAtlas.SampleCmpLevelZero(samp, atlasUV, depthFromLight);
+}
+
+// How lit a spot is by a light, going by the light's shadow views (0 is fully in shadow)
+//
+// viewDepth - the spot's depth in the camera's view (picks a directional light's cascade)
+float LightShadow(Light light, ShadowView views[MAX_SHADOW_VIEWS], Texture2D shadowAtlas, SamplerComparisonState samp,
+	float3 worldPos, float viewDepth)
+{
+	if (light.ShadowCount == 0)
+		return 1.0f;
+
+	//Pick the view that covers the spot
+	int view = 0;
+	if (light.Type == LIGHT_TYPE_DIRECTIONAL)
+	{
+		while (view < light.ShadowCount && viewDepth > views[light.ShadowStart + view].CascadeEnd)
+			view++;
+
+		//Past the last cascade
+		if (view == light.ShadowCount)
+			return 1.0f;
+	}
+	else if (light.Type == LIGHT_TYPE_POINT)
+		view = ShadowCubeFace(worldPos - light.Position);
+
+	return SampleShadow(shadowAtlas, samp, views[light.ShadowStart + view], worldPos);
+}
+
+
+// === CLUSTERS =====================================================
+
+// Which cluster of the camera's view a pixel is in (its lights are in that cluster's range of the light index list)
+//
+// screenPos - the pixel's position on the screen (SV_POSITION)
+// viewDepth - the pixel's depth in the camera's view
+// clusterGrid - clusters per pixel across and down, then the log depth scale and bias of the depth slices
+uint ClusterIndex(float2 screenPos, float viewDepth, float4 clusterGrid)
+{
+	uint2 tile = min(uint2(screenPos * clusterGrid.xy), uint2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+	uint slice = (uint)clamp(log(max(viewDepth, 0.0001f)) * clusterGrid.z + clusterGrid.w, 0, CLUSTER_COUNT_Z - 1);
+	return (slice * CLUSTER_COUNT_Y + tile.y) * CLUSTER_COUNT_X + tile.x;
+}
+
 
 // === BASIC LIGHTING ===============================================
 
@@ -1,5 +1,6 @@
 #include "MAT_PBRTexture.h"
 #include "LightManager.h"
+#include "Renderer.h"
 
 // Constructor - Set up a material
 MAT_PBRTexture::MAT_PBRTexture(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader,
@@ -27,23 +28,19 @@ MAT_PBRTexture::~MAT_PBRTexture()
 void MAT_PBRTexture::PrepareMaterialCombo(GameObject* entityObj, Camera* cam)
 {
 	LightManager* lightManager = LightManager::GetInstance();
-	std::vector<Light*> lights = LightManager::GetInstance()->GetShadowCastingLights();
 
 	// Vertex shader data
 	vertexShader->SetMatrix4x4("projection", cam->GetProjectionMatrix());
 	vertexShader->SetMatrix4x4("view", cam->GetViewMatrix());
 	vertexShader->SetFloat2("uvScale", uvScale);
-	vertexShader->SetMatrix4x4("shadowView", lights[0]->GetViewMatrix());
-	vertexShader->SetMatrix4x4("shadowProj", lights[0]->GetProjectionMatrix());
 
 	//Pixel shader data
 	pixelShader->SetFloat3("CameraPosition", cam->GetPosition());
-	//Set lights
-	int amnt = lightManager->GetLightAmnt();
-	LightStruct* arr = lightManager->GetLightStructArray();
-	pixelShader->SetData("Lights", (void*)arr,
-		sizeof(LightStruct) * MAX_LIGHTS);
-	pixelShader->SetInt("LightCount", amnt);
+	//Set lights (each pixel only looks at the lights in its cluster)
+	pixelShader->SetShaderResourceView("ClusterLights", lightManager->GetClusterLightSRV());
+	pixelShader->SetShaderResourceView("ClusterRanges", lightManager->GetClusterRangeSRV());
+	pixelShader->SetShaderResourceView("ClusterLightIndices", lightManager->GetClusterIndexSRV());
+	pixelShader->SetFloat4("ClusterGrid", lightManager->GetClusterGrid());
 	pixelShader->SetData("AmbLight", lightManager->GetAmbientLight(), sizeof(AmbientLightStruct));
 
 	//Set PBR vars
@@ -54,9 +51,11 @@ void MAT_PBRTexture::PrepareMaterialCombo(GameObject* entityObj, Camera* cam)
 	pixelShader->SetSamplerState("BasicSampler", sampler);
 
 	//Set shadow vars
-	ID3D11ShaderResourceView* shadowSRV = lights[0]->GetShadowSRV();
-	pixelShader->SetShaderResourceView("ShadowMap", shadowSRV);
+	pixelShader->SetShaderResourceView("ShadowAtlas", lightManager->GetShadowAtlasSRV());
 	pixelShader->SetSamplerState("ShadowSampler", shadowSampler);
+	pixelShader->SetData("ShadowViews", lightManager->GetShadowViewArray(),
+		sizeof(ShadowViewStruct) * MAX_SHADOW_VIEWS);
+	pixelShader->SetFloat3("CameraForward", cam->GetForwardAxis());
 
 	vertexShader->CopyBufferData("perCombo");
 	pixelShader->CopyBufferData("perCombo");
@@ -65,7 +64,8 @@ void MAT_PBRTexture::PrepareMaterialCombo(GameObject* entityObj, Camera* cam)
 // Prepare this material's shader's per object variables
 void MAT_PBRTexture::PrepareMaterialObject(GameObject* entityObj)
 {
-	vertexShader->SetMatrix4x4("world", entityObj->GetWorldMatrix());
-	vertexShader->SetMatrix4x4("worldInvTrans", entityObj->GetWorldInvTransMatrix());
+	float alpha = Renderer::GetInstance()->GetInterpolationAlpha();
+	vertexShader->SetMatrix4x4("world", entityObj->GetInterpolatedWorldMatrix(alpha));
+	vertexShader->SetMatrix4x4("worldInvTrans", entityObj->GetInterpolatedWorldInvTransMatrix(alpha));
 	vertexShader->CopyBufferData("perObject");
 }
\ No newline at end of file
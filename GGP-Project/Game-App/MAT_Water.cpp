@@ -1,4 +1,5 @@
 #include "MAT_Water.h"
+#include "WaterSurface.h"
 
 // Constructor - Set up a material
 MAT_Water::MAT_Water(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader,
@@ -23,6 +24,20 @@ void MAT_Water::PrepareMaterialCombo(GameObject* entityObj, Camera* cam)
 	pixelShader->SetShaderResourceView("ShineTexture", shineSRV);
 	//pixelShader->SetShaderResourceView("ShineTexture2", shineSRV);
 	MAT_Basic::PrepareMaterialCombo(entityObj, cam);
+
+	//Sends the waves to the vertex shader (the same ones the swimmers float on)
+	WaterSurface* waterSurface = WaterSurface::GetInstance();
+	vertexShader->SetData("Waves", waterSurface->GetWaveStructArray(), sizeof(WaterWaveStruct) * MAX_WATER_WAVES);
+	vertexShader->SetInt("WaveCount", waterSurface->GetWaveCount());
+
+	//The FFT ocean's and wakes' textures are bound by the Renderer
+	OceanFFT* ocean = waterSurface->GetOcean();
+	vertexShader->SetInt("OceanSize", ocean != nullptr ? ocean->GetSize() : 0);
+	vertexShader->SetFloat("OceanPatchLength", ocean != nullptr ? ocean->GetPatchLength() : 1.0f);
+	WakeField* wake = waterSurface->GetWake();
+	vertexShader->SetInt("WakeSize", wake != nullptr ? wake->GetSize() : 0);
+	vertexShader->SetFloat("WakeExtent", wake != nullptr ? wake->GetExtent() : 1.0f);
+	vertexShader->CopyBufferData("waves");
 }
 
 void MAT_Water::PrepareMaterialObject(GameObject * entityObj)
@@ -48,6 +48,16 @@ int WINAPI WinMain(
 	// the app handle we got from WinMain
 	Game dxGame(hInstance);
 
+	// Record or replay input from the command line
+	//  - "-record <file>" or "-replay <file>"
+	{
+		char logPath[1024] = {};
+		if (sscanf_s(lpCmdLine, "-record %1023s", logPath, (unsigned)_countof(logPath)) == 1)
+			dxGame.SetInputLog(logPath, false);
+		else if (sscanf_s(lpCmdLine, "-replay %1023s", logPath, (unsigned)_countof(logPath)) == 1)
+			dxGame.SetInputLog(logPath, true);
+	}
+
 	// Result variable for function calls below
 	HRESULT hr = S_OK;
 
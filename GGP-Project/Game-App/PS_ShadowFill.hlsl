@@ -0,0 +1,24 @@
+
+// Data for filling a tile of the shadow atlas
+cbuffer externalData : register(b0)
+{
+	int CopyCache; //copy the cache's depth, or clear to the far plane
+}
+
+// Defines the input to this pixel shader
+// - Should match the output of the full-screen triangle's vertex shader
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+};
+
+// Static casters' cached depth (in the same tiles as the atlas)
+Texture2D<float> CacheTexture	: register(t0);
+
+
+// Entry point for this pixel shader
+float main(VertexToPixel input) : SV_DEPTH
+{
+	//The position is in the atlas' texels, so the cache's texel is the one under it
+	return CopyCache ? CacheTexture.Load(int3(input.position.xy, 0)) : 1.0f;
+}
@@ -6,10 +6,13 @@
 //Data that changes once per MatMesh combo
 cbuffer perCombo : register(b0)
 {
-	Light Lights[MAX_LIGHTS]; //array of lights
-	int LightCount; //amount of lights
+	float4 ClusterGrid; //clusters per pixel across and down, then the depth slices' log scale and bias
 	float3 CameraPosition;
 	AmbientLight AmbLight;
+
+	//Shadows
+	ShadowView ShadowViews[MAX_SHADOW_VIEWS]; //every shadow casting light's views into the atlas
+	float3 CameraForward;
 }
 
 cbuffer perObject : register(b1)
@@ -26,7 +29,6 @@ struct VertexToPixel
 	float3 normal		: NORMAL;
 	float3 tangent		: TANGENT;
 	float3 worldPos		: POSITION; // The world position of this PIXEL
-	float4 posForShadow : SHADOW;
 };
 
 
@@ -38,10 +40,15 @@ Texture2D MetalTexture			: register(t3);
 SamplerState BasicSampler		: register(s0);
 
 // Shadow-related variables
-Texture2D ShadowMap						: register(t4);
+Texture2D ShadowAtlas					: register(t4);
 SamplerComparisonState ShadowSampler	: register(s1);
 Texture2D NormalTexture2				: register(t5);
 
+// Clustered lights (each cluster's range of the index list, and the lights it points at)
+StructuredBuffer<Light> ClusterLights			: register(t8);
+StructuredBuffer<uint2> ClusterRanges			: register(t9);
+StructuredBuffer<uint> ClusterLightIndices		: register(t10);
+
 // Entry point for this pixel shader
 float4 main(VertexToPixel input) : SV_TARGET
 {
@@ -67,12 +74,8 @@ float4 main(VertexToPixel input) : SV_TARGET
 	// Specular color - Assuming albedo texture is actually holding specular color if metal == 1
 	float3 specColor = lerp(F0_NON_METAL.rrr, surfaceColor.rgb, metal);
 
-	//Sample shadowmap
-	//Shadows are only on the singular directional light
-	float depthFromLight = input.posForShadow.z / input.posForShadow.w;
-	float2 shadowUV = input.posForShadow.xy / input.posForShadow.w * 0.5f + 0.5f;
-	shadowUV.y = 1.0f - shadowUV.y;
-	float shadowAmount = ShadowMap.SampleCmpLevelZero(ShadowSampler, shadowUV, depthFromLight);
+	//Depth in the camera's view (picks the pixel's cluster and the directional lights' shadow cascades)
+	float viewDepth = dot(input.worldPos - CameraPosition, CameraForward);
 
 	// Total color for this pixel
 	float3 totalColor = float3(0,0,0);
@@ -80,27 +83,33 @@ float4 main(VertexToPixel input) : SV_TARGET
 	//Add ambient light
 	totalColor += AmbLight.Color * AmbLight.Intensity * surfaceColor.rgb;
 
-	// Loop through all lights this frame
-	for (int i = 0; i < LightCount; i++)
+	// Loop through the lights in this pixel's cluster
+	uint2 cluster = ClusterRanges[ClusterIndex(input.position.xy, viewDepth, ClusterGrid)];
+	for (uint c = 0; c < cluster.y; c++)
 	{
+		Light light = ClusterLights[ClusterLightIndices[cluster.x + c]];
+
+		//How lit this pixel is, going by the light's shadows
+		float shadowAmount = LightShadow(light, ShadowViews, ShadowAtlas, ShadowSampler, input.worldPos, viewDepth);
+
 		// Which kind of light?
-		switch (Lights[i].Type)
+		switch (light.Type)
 		{
 		case LIGHT_TYPE_DIRECTIONAL:
-			float3 dL = DirLightPBR(Lights[i], input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
+			float3 dL = DirLightPBR(light, input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
 			dL *= shadowAmount;
 			totalColor += dL;
 			break;
 
 		case LIGHT_TYPE_POINT:
-			float3 pL = PointLightPBR(Lights[i], input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
-			//pL *= shadowAmount;
+			float3 pL = PointLightPBR(light, input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
+			pL *= shadowAmount;
 			totalColor += pL;
 			break;
 
 		case LIGHT_TYPE_SPOT:
-			float3 sL = SpotLightPBR(Lights[i], input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
-			//sL *= shadowAmount;
+			float3 sL = SpotLightPBR(light, input.normal, input.worldPos, CameraPosition, roughness, metal, surfaceColor.rgb, specColor);
+			sL *= shadowAmount;
 			totalColor += sL;
 			break;
 		}
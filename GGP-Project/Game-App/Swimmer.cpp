@@ -5,65 +5,61 @@
 #include <cmath>
 #include "EntityManager.h"
 
-//Buoyancy consts
-#define MASS 0.5f
-#define GRAVITY 9.81f
-#define FLUID_DENSITY 2.0f
-#define DRAG_COEFF 1.05f
-#define AIR_DENSITY 0.1225f
-#define SURFACE_Y 0
-
 using namespace DirectX;
 
+//Hitting lasts half a jump, the swimmer behind starts a quarter of the way in
+#define HIT_TIME (M_PI / 8)
+#define HIT_CHAIN_TIME (HIT_TIME / 4)
+
 //Snake follow logic from:
 //https://github.com/rimij405/ggp-smij/blob/Unity-Prototype/Prototype/Boat-Snake-Prototype/Assets/Scripts/BoatFollower.cs
 
 Swimmer::Swimmer(Mesh* mesh, Material* material, std::string name)
 	: Entity(mesh, material, name)
 {
-	//Create buffers
-	bufferLength = (int)ceil(lagSeconds * MAX_FPS);
-	positionBuffer = new XMFLOAT3[bufferLength];
-	timeBuffer = new float[bufferLength];
-
 	//Set default vals
 	swmrState = SwimmerState::Entering;
 	this->leader = nullptr;
-	positionBuffer[0] = positionBuffer[1] = DirectX::XMFLOAT3(0, 0, 0);
-	timeBuffer[0] = timeBuffer[1] = timer = 0;
-	hitTimer = 0;
+	leaderSwimmer = nullptr;
+	follower = nullptr;
+	trailHistory = nullptr;
+	trailDistance = 0;
+	hitStart = 0;
+	floatingIndex = -1;
+	flockVelocity = XMFLOAT2(0, 0);
 
 	//Buoyancy vals
-	velocity = 0;
-	acceleration = 0;
+	physics = nullptr;
+	physicsSlot = -1;
 	sinAmnt = 0;
 	gravityMult = 0;
 
-	oldestIndex = 0;
-	newestIndex = 1;
+	//Water physics run in a batch for every swimmer at once.
+	//Trail swimmers read their leader, so they run afterwards in order
+	UnregisterUpdatePhase(UpdatePhase::PrePhysics);
+	RegisterUpdatePhase(UpdatePhase::PostPhysics);
+
+	//Nothing to update until it joins a trail
+	Sleep();
 }
 
 Swimmer::~Swimmer()
 {
-	//Delete buffers
-	delete[] positionBuffer;
-	delete[] timeBuffer;
+	TimerWheel::GetInstance()->Cancel(hitTimer);
+	TimerWheel::GetInstance()->Cancel(chainTimer);
+	if (physics != nullptr)
+		physics->RemoveSwimmer(this);
 }
 
 //Update the swimmer every frame
-void Swimmer::Update(float deltaTime)
+void Swimmer::PhaseUpdate(UpdatePhase phase, float deltaTime)
 {
-	//Run the current state's behavior
+	if (phase != UpdatePhase::PostPhysics)
+		return;
+
+	//Trail states
 	switch (swmrState)
 	{
-		case SwimmerState::Entering:
-			Enter(deltaTime);
-			break;
-
-		case SwimmerState::Floating:
-			Float(deltaTime);
-			break;
-
 		case SwimmerState::Joining:
 			Join(deltaTime);
 			break;
@@ -72,141 +68,59 @@ void Swimmer::Update(float deltaTime)
 			Follow(deltaTime);
 			break;
 
-		case SwimmerState::Still:
-			if (leader->GetName() != "player" && ((Swimmer*)leader)->CheckHit())
-				swmrState = SwimmerState::Hitting;
-			break;
-
 		case SwimmerState::Hitting:
 			Hit(deltaTime);
 			break;
 
-		case SwimmerState::Nothing:
-			break;
-
-		case SwimmerState::Leaving:
-			Leave(deltaTime);
-			break;
-
 		default:
 			break;
 	}	
 }
 
 // --------------------------------------------------------
-// Run this swimmer's entering behaviour
-//---------------------------------------------------------
-void Swimmer::Enter(float deltaTime)
-{
-	ApplyWaterPhysics(deltaTime, true);
-	if (GetPosition().y > SURFACE_Y)
-		swmrState = SwimmerState::Floating;
-}
-
-// --------------------------------------------------------
-// Apply buoyancy to the swimmer
+// Move to the height the water physics found
 //---------------------------------------------------------
-void Swimmer::ApplyWaterPhysics(float deltaTime, bool applyBuoyancy)
+void Swimmer::WaterStep(float height, float deltaTime)
 {
-	Collider* col = GetCollider();
 	XMFLOAT3 position = GetPosition();
-	XMFLOAT3 halves = col->GetHalfSize();
-	
-	float buoyancy = 0;
-	float area = (2 * halves.x) * (2 * halves.z);
-	if (applyBuoyancy)
-	{
-		//Thanks Khan once again
-		//https://www.khanacademy.org/science/physics/fluids/buoyant-force-and-archimedes-principle/a/buoyant-force-and-archimedes-principle-article
-		//Calculate displaced volume and buoyancy
-		float hTop = position.y + halves.y > SURFACE_Y ? SURFACE_Y : position.y + halves.y;
-		float hBot = position.y - halves.y > SURFACE_Y ? SURFACE_Y : position.y - halves.y;
-		float watDisplaced = area * -(hBot - hTop);
-		buoyancy = FLUID_DENSITY * GRAVITY * watDisplaced;
-	}
+	position.y = height;
+	SetPosition(position);
 
-	//https://www.grc.nasa.gov/WWW/K-12/airplane/falling.html
-	float drag = 0;
-	if(position.y > SURFACE_Y)
-	{
-		//Calculate air drag if we are above the water
-		drag = DRAG_COEFF * AIR_DENSITY * ((velocity * velocity * area) / 2);
-	}
-	else
+	switch (swmrState)
 	{
-		//Calculate fluid drag if we are below the water
-		drag = DRAG_COEFF * FLUID_DENSITY * ((velocity * velocity * area) / 2);
-	}
-
-	//Apply bouyancy and gravity to acceleration
-	acceleration += buoyancy / MASS;
-	acceleration += -GRAVITY;
-
-	//Add acceleration to velocity
-	velocity += (acceleration * deltaTime);
-
-	//Add drag based on velocity's direction
-	if(velocity < 0)
-		velocity += (drag * deltaTime);
-	else velocity -= (drag * deltaTime);
+		case SwimmerState::Entering:
+			Enter(deltaTime);
+			break;
 
-	//Add velocity to position
-	position.y += velocity * deltaTime;
+		case SwimmerState::Floating:
+			Float(deltaTime);
+			break;
 
-	//Reset
-	acceleration = 0;
+		default:
+			break;
+	}
+}
 
-	SetPosition(position);
+// --------------------------------------------------------
+// Run this swimmer's entering behaviour
+//---------------------------------------------------------
+void Swimmer::Enter(float)
+{
+	if (GetPosition().y > SURFACE_Y)
+		SetSwimmerState(SwimmerState::Floating);
 }
 
 // Run this swimmer's floating behaviour
 void Swimmer::Float(float deltaTime)
 {
-	ApplyWaterPhysics(deltaTime, true);
-
 	// Rotate when idle.
 	Rotate(0, 5 * deltaTime, 0);
 }
 
-// Run this swimmer's leaving behaviour
-void Swimmer::Leave(float deltaTime)
+// Get this swimmer's spot on the trail's path
+XMFLOAT3 Swimmer::GetTrailPos()
 {
-	ApplyWaterPhysics(deltaTime, false);
-	if (GetPosition().y < -5)
-		EntityManager::GetInstance()->RemoveEntity(this);
-}
-
-// Update the swimmer's buffers for snake movement
-XMFLOAT3 Swimmer::GetTrailPos(float deltaTime)
-{
-	// Update internal timer.
-	timer += deltaTime;
-
-	// Insert newest position into our cache.
-	// If the cache is full, overwrite the latest sample.
-	int newIndex = (newestIndex + 1) % bufferLength;
-	if (newIndex != oldestIndex)
-		newestIndex = newIndex;
-
-	positionBuffer[newestIndex] = leader->GetPosition();
-	timeBuffer[newestIndex] = timer;
-
-	// Skip ahead in the buffer to the segment containing our target time.
-	float targetTime = timer - lagSeconds;
-	int nextIndex;
-	while (timeBuffer[nextIndex = (oldestIndex + 1) % bufferLength] < targetTime)
-		oldestIndex = nextIndex;
-	float span = timeBuffer[nextIndex] - timeBuffer[oldestIndex];
-	float progress = 0;
-	if (span > 0)
-	{
-		progress = (targetTime - timeBuffer[oldestIndex]) / span;
-	}
-
-	//Lerp to find the position
-	XMFLOAT3 lerp;
-	XMStoreFloat3(&lerp, XMVectorLerp(XMLoadFloat3(&(positionBuffer[oldestIndex])), XMLoadFloat3(&(positionBuffer[nextIndex])), progress));
-	return lerp;
+	return trailHistory->Sample(trailDistance);
 }
 
 // Get the rotation for following on the trail
@@ -240,7 +154,7 @@ void Swimmer::Join(float deltaTime)
 	SeekSurfaceY();
 
 	//Seek trail
-	XMFLOAT3 trailPos = GetTrailPos(deltaTime);
+	XMFLOAT3 trailPos = GetTrailPos();
 	XMFLOAT3 lerp;
 	XMStoreFloat3(&lerp, XMVectorScale(XMVector3Normalize(
 		XMLoadFloat3(&trailPos) - XMLoadFloat3(&GetPosition())), 5 * deltaTime)
@@ -249,10 +163,9 @@ void Swimmer::Join(float deltaTime)
 	SetRotation(GetTrailRotation(deltaTime));
 
 	float dist = ExtendedMath::DistanceFloat3(trailPos, GetPosition());
-	if (dist < 0.1f && (leader->GetName() != "swimmer"
-		|| (leader->GetName() == "swimmer" && ((Swimmer*)leader)->GetState() == SwimmerState::Following)))
+	if (dist < 0.1f && (leaderSwimmer == nullptr || leaderSwimmer->GetState() == SwimmerState::Following))
 	{
-		swmrState = SwimmerState::Following;
+		SetSwimmerState(SwimmerState::Following);
 	}
 }
 
@@ -262,56 +175,118 @@ void Swimmer::Follow(float deltaTime)
 	//Seek surface
 	SeekSurfaceY();
 
-	// Interpolate between the two samples on either side of our target time.
-	SetPosition(GetTrailPos(deltaTime));
+	// Interpolate between the two samples on either side of our spot.
+	SetPosition(GetTrailPos());
 	SetRotation(GetTrailRotation(deltaTime));
 }
 
 // Run this swimmer's hitting behaviour
 void Swimmer::Hit(float deltaTime)
 {
-	hitTimer += deltaTime;
+	//Do a little jump up (the timers end it)
+	float hitTime = (float)(TimerWheel::GetInstance()->GetTime() - hitStart);
+	XMFLOAT3 position = GetPosition();
+	position.y = 2 * sin(8 * hitTime);
+	SetPosition(position);
+}
 
+// Schedule the follower's hit and the end of this one
+void Swimmer::StartHit()
+{
+	TimerWheel* timerWheel = TimerWheel::GetInstance();
+	hitStart = timerWheel->GetTime();
+	chainTimer = timerWheel->Schedule(HIT_CHAIN_TIME, [this]() { HitFollower(); });
+	hitTimer = timerWheel->Schedule(HIT_TIME, [this]() { EndHit(); });
+}
+
+// Start the swimmer behind us
+void Swimmer::HitFollower()
+{
+	if (follower != nullptr && follower->leader == this && follower->GetState() == SwimmerState::Still)
+		follower->SetSwimmerState(SwimmerState::Hitting);
+}
+
+// Land and effectively "kill" the swimmer
+void Swimmer::EndHit()
+{
 	XMFLOAT3 position = GetPosition();
-	if (hitTimer < M_PI / 8)
-	{
-		//Do a little jump up
-		position.y = 2 * sin(8 * hitTimer);
-		SetPosition(position);
-	}
-	else
-	{
-		//Reset to 0 and effectively "kill" the swimmer
-		position.y = 0;
-		SetPosition(position);
-		swmrState = SwimmerState::Nothing;
-	}
+	position.y = 0;
+	SetPosition(position);
+	SetSwimmerState(SwimmerState::Nothing);
 }
 
 // Set Swimmer to follow a game object.
-void Swimmer::JoinTrail(Entity* newLeader)
+void Swimmer::JoinTrail(Entity* newLeader, TrailHistory* trailHistory)
 {
-	swmrState = SwimmerState::Joining;
+	SetSwimmerState(SwimmerState::Joining);
 	this->leader = newLeader;
-	positionBuffer[0] = positionBuffer[1] = leader->GetPosition();
+	this->trailHistory = trailHistory;
+
+	//Link up with the swimmer in front (if it isn't the boat)
+	leaderSwimmer = nullptr;
+	if (newLeader->GetName() == "swimmer")
+	{
+		leaderSwimmer = (Swimmer*)newLeader;
+		leaderSwimmer->follower = this;
+	}
+
+	//Make sure our leader updates before we read its rotation and state
+	EntityManager* entityManager = EntityManager::GetInstance();
+	entityManager->RemoveUpdateDependencies(this);
+	entityManager->AddUpdateDependency(this, newLeader);
+}
+
+// Put the swimmer back the way it spawned
+void Swimmer::ResetSwimmer()
+{
+	SetSwimmerState(SwimmerState::Entering);
+	leader = nullptr;
+	leaderSwimmer = nullptr;
+	follower = nullptr;
+	trailHistory = nullptr;
+	trailDistance = 0;
+	flockVelocity = XMFLOAT2(0, 0);
+	SetRotation(XMFLOAT4(0, 0, 0, 1));
+	if (physics != nullptr)
+		physics->SetVelocity(physicsSlot, 0);
+
+	//It doesn't follow anything anymore
+	EntityManager::GetInstance()->RemoveUpdateDependencies(this);
 }
 
 // Check if the swimmer is in the hitting state for the correct amount of time
 bool Swimmer::CheckHit()
 {
-	return (swmrState == SwimmerState::Hitting) && (hitTimer > (M_PI / 8) / 4);
+	return (swmrState == SwimmerState::Hitting)
+		&& (TimerWheel::GetInstance()->GetTime() - hitStart > HIT_CHAIN_TIME);
 }
 
 // Set Swimmer's state to a new state
 void Swimmer::SetSwimmerState(SwimmerState newState)
 {
+	//The hit's timers only matter while it's hitting
+	SwimmerState oldState = swmrState;
+	if (oldState == SwimmerState::Hitting && newState != SwimmerState::Hitting)
+	{
+		TimerWheel::GetInstance()->Cancel(hitTimer);
+		TimerWheel::GetInstance()->Cancel(chainTimer);
+	}
+
 	swmrState = newState;
+	if (oldState != SwimmerState::Hitting && newState == SwimmerState::Hitting)
+		StartHit();
+
+	//Only the trail states do anything in the update
+	if (newState == SwimmerState::Joining || newState == SwimmerState::Following
+		|| newState == SwimmerState::Hitting)
+		Wake();
+	else Sleep();
 }
 
-// Set Swimmer's lag seconds
-void Swimmer::SetLagSeconds(float lagSeconds)
+// Set how far behind the front of the trail the swimmer follows
+void Swimmer::SetTrailDistance(float trailDistance)
 {
-	this->lagSeconds = lagSeconds;
+	this->trailDistance = trailDistance;
 }
 
 // Get the state of the swimmer
@@ -1,6 +1,12 @@
 #pragma once
 #include <DirectXMath.h>
 #include "Entity.h"
+#include "TrailHistory.h"
+#include "SwimmerPhysics.h"
+
+//Collision layers
+#define LAYER_BOAT 0x2
+#define LAYER_SWIMMER 0x4
 
 //Enum for swimmer states
 enum class SwimmerState { Entering, Floating, Joining, Following, Still, Hitting, Nothing, Leaving };
@@ -12,34 +18,39 @@ private:
 
 	//Follow state vars
 	SwimmerState swmrState;
-	static const int MAX_FPS = 60;
 	Entity* leader;
-	float lagSeconds = 0.5f;
-	float hitTimer;
-
-	//Snake movement buffer vars
-	DirectX::XMFLOAT3* positionBuffer;
-	float* timeBuffer;
-	int bufferLength;
-	int oldestIndex;
-	int newestIndex;
-	float timer;
-
-	//Buoyancy vars
-	float velocity;
-	float acceleration;
+	Swimmer* leaderSwimmer;       //The leader, if it's a swimmer (nullptr for the boat)
+	Swimmer* follower;       //The swimmer right behind this one on the trail
+	double hitStart;       //Timer wheel time the hit started
+	TimerHandle hitTimer;       //Ends the hit
+	TimerHandle chainTimer;       //Starts the follower's hit
+	int floatingIndex;       //Spot in the swimmer manager's floating list (-1 if not floating)
+	DirectX::XMFLOAT2 flockVelocity;       //Velocity on the water's surface (x and z) from flocking
+
+	//Snake movement vars (the trail's shared path)
+	TrailHistory* trailHistory;
+	float trailDistance;       //Distance behind the front of the trail
+
+	//Buoyancy vars (the state is kept in the physics batch)
+	SwimmerPhysics* physics;
+	int physicsSlot;
 	float sinAmnt;
 	float gravityMult;
 
+	friend class SwimmerPhysics;
+	friend class SwimmerManager;
+	friend class SwimmerFlock;
+
 	// --------------------------------------------------------
 	// Run this swimmer's entering behaviour
 	//---------------------------------------------------------
 	void Enter(float deltaTime);
 
 	// --------------------------------------------------------
-	// Apply buoyancy to the swimmer
+	// Move to the height the water physics found and run
+	// the water state's behaviour
 	//---------------------------------------------------------
-	void ApplyWaterPhysics(float deltaTime, bool applyBuoyancy);
+	void WaterStep(float height, float deltaTime);
 
 	// --------------------------------------------------------
 	// Run this swimmer's floating behaviour
@@ -47,9 +58,9 @@ private:
 	void Float(float deltaTime);
 
 	// --------------------------------------------------------
-	// Update the swimmer's buffers for snake movement
+	// Get this swimmer's spot on the trail's path
 	// --------------------------------------------------------
-	DirectX::XMFLOAT3 GetTrailPos(float deltaTime);
+	DirectX::XMFLOAT3 GetTrailPos();
 
 	// --------------------------------------------------------
 	// Get the rotation for following on the trail
@@ -77,23 +88,45 @@ private:
 	void Hit(float deltaTime);
 
 	// --------------------------------------------------------
-	// Run this swimmer's leaving behaviour
+	// Schedule the follower's hit and the end of this one
+	// --------------------------------------------------------
+	void StartHit();
+
+	// --------------------------------------------------------
+	// Start the swimmer behind us (it was still, and asleep, until now)
 	// --------------------------------------------------------
-	void Leave(float deltaTime);
+	void HitFollower();
+
+	// --------------------------------------------------------
+	// Land and effectively "kill" the swimmer
+	// --------------------------------------------------------
+	void EndHit();
 
 public:
 	Swimmer(Mesh* mesh, Material* material, std::string name);
 	~Swimmer();
 
 	// --------------------------------------------------------
-	// Control which movement the swimmer is performing
+	// Control which movement the swimmer is performing.
+	// Water physics states are run by the SwimmerPhysics batch,
+	// trail states run after their leader in the PostPhysics phase.
+	// Only joining, following and hitting swimmers are awake, the
+	// rest sleep (a still swimmer is woken by the one in front of it)
 	// --------------------------------------------------------
-	void Update(float deltaTime);
+	void PhaseUpdate(UpdatePhase phase, float deltaTime) override;
 
 	// --------------------------------------------------------
 	// Set Swimmer to follow a game object.
+	//
+	// leader - the gameobject right in front of this swimmer
+	// trailHistory - the path the front of the trail has travelled
+	// --------------------------------------------------------
+	void JoinTrail(Entity* leader, TrailHistory* trailHistory);
+
+	// --------------------------------------------------------
+	// Put the swimmer back the way it spawned (for reusing it)
 	// --------------------------------------------------------
-	void JoinTrail(Entity* leader);
+	void ResetSwimmer();
 
 	// --------------------------------------------------------
 	// Check if the swimmer is in the hitting state for the correct amount of time	
@@ -101,14 +134,15 @@ public:
 	bool CheckHit();
 
 	// --------------------------------------------------------
-	// Set Swimmer's state to a new state
+	// Set Swimmer's state to a new state (and wake the swimmer up
+	// or put it to sleep to match)
 	// --------------------------------------------------------
 	void SetSwimmerState(SwimmerState newState);
 
 	// --------------------------------------------------------
-	// Set Swimmer's lag seconds
+	// Set how far behind the front of the trail the swimmer follows
 	// --------------------------------------------------------
-	void SetLagSeconds(float lagSeconds);
+	void SetTrailDistance(float trailDistance);
 
 	// --------------------------------------------------------
 	// Get the state of the swimmer
@@ -0,0 +1,300 @@
+#include "SwimmerFlock.h"
+#include "Swimmer.h"
+#include "JobSystem.h"
+#include <cmath>
+
+//Neighbourhood
+#define FLOCK_RADIUS 3.0f       //Swimmers closer than this are neighbours (and the grid's cell size)
+#define SEPARATION_RADIUS 1.5f       //Neighbours closer than this push apart
+
+//Steering weights
+#define SEPARATION_WEIGHT 1.5f
+#define ALIGNMENT_WEIGHT 0.5f
+#define COHESION_WEIGHT 0.2f
+#define FLEE_WEIGHT 4.0f
+#define FLEE_RADIUS 6.0f
+#define BOUNDS_WEIGHT 2.0f
+
+//Movement
+#define MAX_SPEED 1.0f
+#define DAMPING 0.5f       //Velocity lost per second (so still crowds settle)
+
+//Swimmers handed to a thread at a time
+#define FLOCK_CHUNK 256
+
+using namespace DirectX;
+
+// Set up an empty flock
+SwimmerFlock::SwimmerFlock()
+{
+	levelRadius = 0;
+	boatPosition = XMFLOAT3(0, 0, 0);
+	throttleInterval = 1;
+	fullRateDistanceSq = 0;
+	stepCount = 0;
+}
+
+// Set the radius swimmers stay inside of
+void SwimmerFlock::SetLevelRadius(float radius)
+{
+	levelRadius = radius;
+	grid.Resize(radius, FLOCK_RADIUS);
+}
+
+// Run a step of flocking
+void SwimmerFlock::Step(const std::vector<Swimmer*>& floating, XMFLOAT3 boatPosition, float deltaTime)
+{
+	Gather(floating, boatPosition, deltaTime);
+
+	//Steering only reads the old state, so chunks can run in parallel
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	jobSystem->ParallelFor((int)swimmers.size(), FLOCK_CHUNK, [&](int begin, int end)
+	{
+		Steer(begin, end);
+	});
+
+	//Every swimmer has its new velocity, now they can move
+	jobSystem->ParallelFor((int)swimmers.size(), FLOCK_CHUNK, [&](int begin, int end)
+	{
+		WriteBack(begin, end);
+	});
+	stepCount++;
+}
+
+// Copy the swimmers' state into the arrays
+void SwimmerFlock::Gather(const std::vector<Swimmer*>& floating, XMFLOAT3 boatPosition, float deltaTime)
+{
+	this->boatPosition = boatPosition;
+
+	//Only swimmers floating at the surface flock (not ones still rising)
+	swimmers.clear();
+	positionsX.clear();
+	positionsZ.clear();
+	velocitiesX.clear();
+	velocitiesZ.clear();
+	deltaTimes.clear();
+	for (size_t i = 0; i < floating.size(); i++)
+	{
+		Swimmer* swimmer = floating[i];
+		if (swimmer->GetState() != SwimmerState::Floating)
+			continue;
+
+		XMFLOAT3 position = swimmer->GetPosition();
+		swimmers.push_back(swimmer);
+		positionsX.push_back(position.x);
+		positionsZ.push_back(position.z);
+		velocitiesX.push_back(swimmer->flockVelocity.x);
+		velocitiesZ.push_back(swimmer->flockVelocity.y);
+
+		//Far away swimmers take turns, with a longer step
+		float stepTime = deltaTime;
+		float x = position.x - boatPosition.x;
+		float z = position.z - boatPosition.z;
+		if (throttleInterval > 1 && x * x + z * z > fullRateDistanceSq)
+		{
+			stepTime = ((unsigned int)swimmer->physicsSlot + stepCount) % throttleInterval == 0
+				? deltaTime * throttleInterval : 0;
+		}
+		deltaTimes.push_back(stepTime);
+	}
+	newVelocitiesX.resize(swimmers.size());
+	newVelocitiesZ.resize(swimmers.size());
+
+	grid.Build(positionsX.data(), positionsZ.data(), (int)swimmers.size());
+}
+
+// Find new velocities using the neighbour grid
+void SwimmerFlock::Steer(int begin, int end)
+{
+	const float radiusSq = FLOCK_RADIUS * FLOCK_RADIUS;
+	const float separationSq = SEPARATION_RADIUS * SEPARATION_RADIUS;
+	for (int i = begin; i < end; i++)
+	{
+		if (deltaTimes[i] == 0)
+			continue;
+
+		float x = positionsX[i];
+		float z = positionsZ[i];
+		float separationX = 0, separationZ = 0;
+		float sumVelocityX = 0, sumVelocityZ = 0;
+		float sumPositionX = 0, sumPositionZ = 0;
+		int neighbours = 0;
+
+		grid.ForEachNear(x, z, [&](int j)
+		{
+			float dx = x - positionsX[j];
+			float dz = z - positionsZ[j];
+			float distanceSq = dx * dx + dz * dz;
+			if (j == i || distanceSq >= radiusSq)
+				return;
+
+			//Push away harder the closer they are
+			if (distanceSq < separationSq && distanceSq > 0)
+			{
+				separationX += dx / distanceSq;
+				separationZ += dz / distanceSq;
+			}
+			sumVelocityX += velocitiesX[j];
+			sumVelocityZ += velocitiesZ[j];
+			sumPositionX += positionsX[j];
+			sumPositionZ += positionsZ[j];
+			neighbours++;
+		});
+
+		ApplySteering(i, separationX, separationZ, sumVelocityX, sumVelocityZ,
+			sumPositionX, sumPositionZ, neighbours);
+	}
+}
+
+// Find new velocities by checking every other swimmer
+void SwimmerFlock::SteerBruteForce(int begin, int end)
+{
+	const float radiusSq = FLOCK_RADIUS * FLOCK_RADIUS;
+	const float separationSq = SEPARATION_RADIUS * SEPARATION_RADIUS;
+	int count = (int)swimmers.size();
+	for (int i = begin; i < end; i++)
+	{
+		if (deltaTimes[i] == 0)
+			continue;
+
+		float x = positionsX[i];
+		float z = positionsZ[i];
+		float separationX = 0, separationZ = 0;
+		float sumVelocityX = 0, sumVelocityZ = 0;
+		float sumPositionX = 0, sumPositionZ = 0;
+		int neighbours = 0;
+
+		for (int j = 0; j < count; j++)
+		{
+			float dx = x - positionsX[j];
+			float dz = z - positionsZ[j];
+			float distanceSq = dx * dx + dz * dz;
+			if (j == i || distanceSq >= radiusSq)
+				continue;
+
+			if (distanceSq < separationSq && distanceSq > 0)
+			{
+				separationX += dx / distanceSq;
+				separationZ += dz / distanceSq;
+			}
+			sumVelocityX += velocitiesX[j];
+			sumVelocityZ += velocitiesZ[j];
+			sumPositionX += positionsX[j];
+			sumPositionZ += positionsZ[j];
+			neighbours++;
+		}
+
+		ApplySteering(i, separationX, separationZ, sumVelocityX, sumVelocityZ,
+			sumPositionX, sumPositionZ, neighbours);
+	}
+}
+
+// Steer a swimmer from the sums of its neighbours
+void SwimmerFlock::ApplySteering(int i, float separationX, float separationZ, float sumVelocityX, float sumVelocityZ,
+	float sumPositionX, float sumPositionZ, int neighbours)
+{
+	float deltaTime = deltaTimes[i];
+	float x = positionsX[i];
+	float z = positionsZ[i];
+	float velocityX = velocitiesX[i];
+	float velocityZ = velocitiesZ[i];
+
+	//Separation
+	float steerX = separationX * SEPARATION_WEIGHT;
+	float steerZ = separationZ * SEPARATION_WEIGHT;
+
+	//Alignment and cohesion
+	if (neighbours > 0)
+	{
+		float inverse = 1.0f / neighbours;
+		steerX += (sumVelocityX * inverse - velocityX) * ALIGNMENT_WEIGHT;
+		steerZ += (sumVelocityZ * inverse - velocityZ) * ALIGNMENT_WEIGHT;
+		steerX += (sumPositionX * inverse - x) * COHESION_WEIGHT;
+		steerZ += (sumPositionZ * inverse - z) * COHESION_WEIGHT;
+	}
+
+	//Flee from the boat, harder the closer it is
+	float boatX = x - boatPosition.x;
+	float boatZ = z - boatPosition.z;
+	float boatDistanceSq = boatX * boatX + boatZ * boatZ;
+	if (boatDistanceSq < FLEE_RADIUS * FLEE_RADIUS && boatDistanceSq > 0)
+	{
+		float boatDistance = sqrtf(boatDistanceSq);
+		float strength = (1 - boatDistance / FLEE_RADIUS) * FLEE_WEIGHT / boatDistance;
+		steerX += boatX * strength;
+		steerZ += boatZ * strength;
+	}
+
+	//Stay in the level
+	float centerDistanceSq = x * x + z * z;
+	if (centerDistanceSq > levelRadius * levelRadius)
+	{
+		float centerDistance = sqrtf(centerDistanceSq);
+		steerX -= x / centerDistance * BOUNDS_WEIGHT;
+		steerZ -= z / centerDistance * BOUNDS_WEIGHT;
+	}
+
+	//Accelerate, slow down a little, and cap the speed
+	velocityX = (velocityX + steerX * deltaTime) * (1 - DAMPING * deltaTime);
+	velocityZ = (velocityZ + steerZ * deltaTime) * (1 - DAMPING * deltaTime);
+	float speedSq = velocityX * velocityX + velocityZ * velocityZ;
+	if (speedSq > MAX_SPEED * MAX_SPEED)
+	{
+		float scale = MAX_SPEED / sqrtf(speedSq);
+		velocityX *= scale;
+		velocityZ *= scale;
+	}
+
+	newVelocitiesX[i] = velocityX;
+	newVelocitiesZ[i] = velocityZ;
+}
+
+// Move the swimmers with their new velocities
+void SwimmerFlock::WriteBack(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		float deltaTime = deltaTimes[i];
+		if (deltaTime == 0)
+			continue;
+
+		Swimmer* swimmer = swimmers[i];
+		swimmer->flockVelocity = XMFLOAT2(newVelocitiesX[i], newVelocitiesZ[i]);
+
+		XMFLOAT3 position = swimmer->GetPosition();
+		position.x = positionsX[i] + newVelocitiesX[i] * deltaTime;
+		position.z = positionsZ[i] + newVelocitiesZ[i] * deltaTime;
+		swimmer->SetPosition(position);
+	}
+}
+
+// Throttle swimmers far from the boat
+void SwimmerFlock::SetThrottle(int interval, float fullRateDistance)
+{
+	throttleInterval = interval > 1 ? interval : 1;
+	fullRateDistanceSq = fullRateDistance * fullRateDistance;
+}
+
+// Get the amount of swimmers in the last step
+int SwimmerFlock::GetCount()
+{
+	return (int)swimmers.size();
+}
+
+// Get the amount of swimmers that moved on the last step
+int SwimmerFlock::GetMovingCount()
+{
+	int count = 0;
+	for (size_t i = 0; i < deltaTimes.size(); i++)
+	{
+		if (deltaTimes[i] != 0)
+			count++;
+	}
+	return count;
+}
+
+// Get a swimmer's new velocity
+XMFLOAT2 SwimmerFlock::GetNewVelocity(int index)
+{
+	return XMFLOAT2(newVelocitiesX[index], newVelocitiesZ[index]);
+}
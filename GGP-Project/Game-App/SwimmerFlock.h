@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include "NeighbourGrid.h"
+
+class Swimmer;
+
+// --------------------------------------------------------
+// Flocking (boids) for floating swimmers: they keep apart,
+// line up with and drift towards the swimmers around them,
+// and swim away from the boat.
+//
+// Each step copies the swimmers' positions and velocities into
+// arrays, sorts them into a neighbour grid, steers every swimmer
+// from the old state (so the swimmers can be split across the job
+// system's threads and the result doesn't depend on the split)
+// and writes the new positions back. The cost is linear in the
+// amount of swimmers, not quadratic.
+//
+// Like the water physics, swimmers far from the boat can be
+// throttled to move every few steps, in turns, with a longer step
+// --------------------------------------------------------
+class SwimmerFlock
+{
+private:
+	std::vector<Swimmer*> swimmers;
+	std::vector<float> positionsX;
+	std::vector<float> positionsZ;
+	std::vector<float> velocitiesX;
+	std::vector<float> velocitiesZ;
+	std::vector<float> newVelocitiesX;
+	std::vector<float> newVelocitiesZ;
+	std::vector<float> deltaTimes;       //Time step of each swimmer this step (0 if it doesn't move)
+	NeighbourGrid grid;
+	float levelRadius;
+	DirectX::XMFLOAT3 boatPosition;
+
+	//Throttling
+	int throttleInterval;
+	float fullRateDistanceSq;
+	unsigned int stepCount;
+
+	// --------------------------------------------------------
+	// Steer a swimmer from the sums of its neighbours
+	// --------------------------------------------------------
+	void ApplySteering(int i, float separationX, float separationZ, float sumVelocityX, float sumVelocityZ,
+		float sumPositionX, float sumPositionZ, int neighbours);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty flock
+	// --------------------------------------------------------
+	SwimmerFlock();
+
+	// --------------------------------------------------------
+	// Set the radius swimmers stay inside of
+	// --------------------------------------------------------
+	void SetLevelRadius(float radius);
+
+	// --------------------------------------------------------
+	// Run a step of flocking for a list of floating swimmers.
+	// Main thread only
+	//
+	// boatPosition - where the boat is (swimmers swim away from it)
+	// --------------------------------------------------------
+	void Step(const std::vector<Swimmer*>& floating, DirectX::XMFLOAT3 boatPosition, float deltaTime);
+
+	// --------------------------------------------------------
+	// Copy the swimmers' positions and velocities into the arrays,
+	// pick which ones move this step (and by how much) and sort
+	// them into the neighbour grid
+	// --------------------------------------------------------
+	void Gather(const std::vector<Swimmer*>& floating, DirectX::XMFLOAT3 boatPosition, float deltaTime);
+
+	// --------------------------------------------------------
+	// Find the new velocities of the swimmers in [begin, end),
+	// using the neighbour grid
+	// --------------------------------------------------------
+	void Steer(int begin, int end);
+
+	// --------------------------------------------------------
+	// Find the new velocities of the swimmers in [begin, end) by
+	// checking every other swimmer (for checking and benchmarking)
+	// --------------------------------------------------------
+	void SteerBruteForce(int begin, int end);
+
+	// --------------------------------------------------------
+	// Move the swimmers in [begin, end) with their new velocities
+	// --------------------------------------------------------
+	void WriteBack(int begin, int end);
+
+	// --------------------------------------------------------
+	// Throttle swimmers far from the boat
+	//
+	// interval - far swimmers move once every this many steps (1 is off)
+	// fullRateDistance - swimmers closer than this always move
+	// --------------------------------------------------------
+	void SetThrottle(int interval, float fullRateDistance);
+
+	// --------------------------------------------------------
+	// Get the amount of swimmers in the last step
+	// --------------------------------------------------------
+	int GetCount();
+
+	// --------------------------------------------------------
+	// Get the amount of swimmers that moved on the last step
+	// --------------------------------------------------------
+	int GetMovingCount();
+
+	// --------------------------------------------------------
+	// Get a swimmer's new velocity (after steering)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT2 GetNewVelocity(int index);
+};
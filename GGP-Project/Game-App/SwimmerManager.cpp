@@ -1,6 +1,17 @@
 #include "SwimmerManager.h"
-#include "ResourceManager.h"
 #include "EntityManager.h"
+#include "CollisionManager.h"
+#include <algorithm>
+#include <random>
+
+//Swimmers that sink below this go back to the pool
+#define DESPAWN_Y -5
+
+//Spawn placement
+#define SPAWN_SEPARATION 1.5f       //Closest two swimmers in the water can spawn
+#define SNAKE_CLEARANCE 3.0f       //Closest a swimmer can spawn to the boat or its trail
+#define SPAWN_ATTEMPTS 30       //Random spots tried before giving up on a spawn
+#define RANDOM_BATCH 256
 
 using namespace DirectX;
 
@@ -9,18 +20,29 @@ SwimmerManager::SwimmerManager()
 {
 	// Seed the random.
 	std::random_device rseed;
-	rng = std::mt19937(rseed());
+	SetSeed(rseed());
 
 	maxSwimmerCount = 5;
-	currentTTS = 0;
+	spawnBatchSize = 1;
+	flocking = true;
+	snakeHead = nullptr;
+	snakePath = nullptr;
+	spawnFailures = 0;
+	swimmerMesh = nullptr;
+	swimmerMat = nullptr;
 	this->Reset();
 }
 
-// Remove swimmers.
+// Forget the swimmers (the EntityManager owns them, and may have
+// deleted them already, so they aren't touched here).
 SwimmerManager::~SwimmerManager()
 {
-	// Reset the manager.
-	Reset();
+	swimmers.clear();
+	pool.clear();
+	leaving.clear();
+
+	// The TimerWheel was made first (the constructor's Reset), so it's still around.
+	TimerWheel::GetInstance()->Cancel(spawnTimer);
 }
 
 // Set level radius
@@ -28,30 +50,147 @@ void SwimmerManager::SetLevelRadius(float radius)
 {
 	this->levelRadius = radius;
 
+	spawnGrid.Resize(radius, SPAWN_SEPARATION);
+	flock.SetLevelRadius(radius);
+}
+
+// Turn flocking on or off
+void SwimmerManager::SetFlocking(bool flocking)
+{
+	this->flocking = flocking;
+}
+
+// Get the flock the floating swimmers are in
+SwimmerFlock* SwimmerManager::GetFlock()
+{
+	return &flock;
+}
+
+// Get the water physics batch every swimmer is in
+SwimmerPhysics* SwimmerManager::GetPhysics()
+{
+	return &physics;
+}
+
+// Set the mesh and material new swimmers use
+void SwimmerManager::SetSwimmerAssets(Mesh* mesh, Material* material)
+{
+	swimmerMesh = mesh;
+	swimmerMat = material;
+}
+
+// Set the max amount of swimmers floating at once
+void SwimmerManager::SetMaxSwimmerCount(int count)
+{
+	maxSwimmerCount = count;
+}
+
+// Set the snake swimmers shouldn't spawn on
+void SwimmerManager::SetSnake(Entity* head, TrailHistory* path)
+{
+	snakeHead = head;
+	snakePath = path;
+}
+
+// Set how many swimmers spawn at once, and how often
+void SwimmerManager::SetSpawnBatch(int batchSize, float interval)
+{
+	spawnBatchSize = batchSize > 1 ? batchSize : 1;
+	maxTTS = interval;
+}
+
+// Restart the spawn randomness from a seed
+void SwimmerManager::SetSeed(unsigned int seed)
+{
+	this->seed = seed;
+	rng.Seed(seed);
+
+	// Throw away the numbers made from the old seed.
+	randomBatch.resize(RANDOM_BATCH);
+	randomCursor = RANDOM_BATCH;
+}
+
+// Get the seed the spawn randomness started from
+unsigned int SwimmerManager::GetSeed()
+{
+	return seed;
+}
+
+// Get the next random number from the batch.
+float SwimmerManager::NextRandom()
+{
+	if (randomCursor == RANDOM_BATCH)
+	{
+		rng.NextFloats(&randomBatch[0], RANDOM_BATCH);
+		randomCursor = 0;
+	}
+	return randomBatch[randomCursor++];
 }
 
 // Get next random position.
-DirectX::XMFLOAT3 SwimmerManager::GetNextPosition()
-{	// Create uniform distribution ranges.
-	std::uniform_real<float> angle(0, XM_2PI);
-	std::uniform_real<float> distR(0, levelRadius);
-	float theta = angle(rng);
-	float rad = distR(rng);
+bool SwimmerManager::GetNextPosition(XMFLOAT3* position)
+{
+	// Throw darts until one lands far enough from everything (Poisson-disk).
+	for (int i = 0; i < SPAWN_ATTEMPTS; i++)
+	{
+		// The square root spreads the spots evenly over the area, instead of bunching them in the middle.
+		float theta = NextRandom() * XM_2PI;
+		float rad = sqrtf(NextRandom()) * levelRadius;
+		float x = sin(theta) * rad;
+		float z = cos(theta) * rad;
+
+		if (spawnGrid.IsFree(x, z))
+		{
+			// Return the spot, centered on the swimmer manager's collider.
+			*position = XMFLOAT3(x, -5, z);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Fill the spawn grid with the swimmers in the water, and block the snake.
+void SwimmerManager::RebuildSpawnGrid()
+{
+	spawnGrid.Clear();
+	for (size_t i = 0; i < swimmers.size(); i++)
+	{
+		XMFLOAT3 position = swimmers[i]->GetPosition();
+		spawnGrid.Insert(position.x, position.z);
+	}
+	for (size_t i = 0; i < leaving.size(); i++)
+	{
+		XMFLOAT3 position = leaving[i]->GetPosition();
+		spawnGrid.Insert(position.x, position.z);
+	}
 
-	// Return next randomly generated position, centered on the swimmer manager's collider.
-	return DirectX::XMFLOAT3(
-		sin(theta) * rad, 
-		-5, 
-		cos(theta) * rad
-	);
+	spawnGrid.ClearBlocked();
+	if (snakeHead != nullptr)
+	{
+		XMFLOAT3 position = snakeHead->GetPosition();
+		spawnGrid.Block(position.x, position.z, SNAKE_CLEARANCE);
+	}
+	if (snakePath == nullptr)
+		return;
+
+	// Stamp circles along the path, overlapping so there are no gaps between them.
+	float spacing = SNAKE_CLEARANCE / 2;
+	float length = snakePath->GetLength();
+	for (float distance = 0; distance < length + spacing; distance += spacing)
+	{
+		XMFLOAT3 position = snakePath->Sample(std::min(distance, length));
+		spawnGrid.Block(position.x, position.z, SNAKE_CLEARANCE + spacing / 2);
+	}
 }
 
 // Randomize the swimmer spawn configuration.
-void SwimmerManager::RandomizeSwimmer(Swimmer* swimmer) 
+void SwimmerManager::RandomizeSwimmer(Swimmer* swimmer, XMFLOAT3 position)
 {
 	if (swimmer != nullptr) 
 	{
-		swimmer->SetPosition(this->GetNextPosition());
+		swimmer->SetPosition(position);
+		swimmer->SnapPreviousTransform();       //Don't draw it sliding over from where it was pooled
+		spawnGrid.Insert(position.x, position.z);
 	}
 }
 
@@ -60,20 +199,19 @@ bool SwimmerManager::IsReadyToSpawn()
 {
 	return (swimmers.size() == 0) ||
 		((swimmers.size() < maxSwimmerCount) // ...if there is still space,
-		&& (currentTTS >= maxTTS)); // ...and if the timer surpassed the delay amount. 
+		&& spawnDue); // ...and if the spawn timer ran out. 
 }
 
 // Reset the manager.
 void SwimmerManager::Reset() 
 {
-	EntityManager* entityManager = EntityManager::GetInstance();
-	for (int i = 0; i < swimmers.size(); i++)
+	// Send every floating swimmer away.
+	while (swimmers.size() > 0)
 	{
-		if (swimmers[i] != nullptr)
-			swimmers[i]->SetSwimmerState(SwimmerState::Leaving);
+		ReleaseSwimmer(swimmers.back());
 	}
-	swimmers.clear();
-	currentTTS = 0;
+	TimerWheel::GetInstance()->Cancel(spawnTimer);
+	spawnDue = false;
 }
 
 // Update swimmer state and spawn time.
@@ -82,45 +220,168 @@ void SwimmerManager::Update(float deltaTime)
 	// Check if the manager is enabled.
 	if (this->enabled) {
 
-		// Update the time till spawn.
-		currentTTS += deltaTime;
-
-		// Check if it's ready to spawn a new swimmer.
+		// Check if it's ready to spawn new swimmers.
 		if (IsReadyToSpawn()) 
 		{
-			// Spawn a new swimmer, if time permits.
-			SpawnSwimmer();
-			currentTTS = 0;
+			// Spawn a batch of swimmers, as far as there is space.
+			int count = std::min(spawnBatchSize, maxSwimmerCount - (int)swimmers.size());
+			RebuildSpawnGrid();
+			for (int i = 0; i < std::max(count, 1); i++)
+			{
+				if (SpawnSwimmer() == nullptr)
+					break;
+			}
+
+			// Wait for the next batch.
+			TimerWheel* timerWheel = TimerWheel::GetInstance();
+			timerWheel->Cancel(spawnTimer);
+			spawnDue = false;
+			spawnTimer = timerWheel->Schedule(maxTTS, [this]() { spawnDue = true; });
 		}
 	}
 }
 
-// Create a swimmer and spawn at a random position.
+// Run flocking and the water physics, then despawn the swimmers that sank.
+void SwimmerManager::UpdatePhysics(float deltaTime, XMFLOAT3 focus)
+{
+	if (flocking)
+		flock.Step(swimmers, focus, deltaTime);
+
+	physics.SetFocus(focus);
+	physics.Step(deltaTime);
+	DespawnSunkSwimmers();
+}
+
+// Spawn a swimmer at a random position.
 Swimmer* SwimmerManager::SpawnSwimmer()
 {
-		// To be refactored into the swimmer manager.
-		ResourceManager* resourceManager = ResourceManager::GetInstance();
+		// Find a spot with room.
+		XMFLOAT3 position;
+		if (!GetNextPosition(&position))
+		{
+			spawnFailures++;
+			return nullptr;
+		}
+
+		// Get a swimmer.
+		Swimmer* swimmer = TakeSwimmer();
+
+		// Instantiate the position and rotation.
+		this->RandomizeSwimmer(swimmer, position);
+
+		// Return the swimmer.
+		swimmer->floatingIndex = (int)swimmers.size();
+		swimmers.push_back(swimmer);
+		return swimmer;
+}
+
+// Take a swimmer from the pool, or create one.
+Swimmer* SwimmerManager::TakeSwimmer()
+{
+	if (pool.size() == 0)
+		return CreateSwimmer();
+
+	// Bring the last despawned swimmer back.
+	Swimmer* swimmer = pool.back();
+	pool.pop_back();
+	swimmer->ResetSwimmer();
+	swimmer->SetEnabled(true);
+	CollisionManager::GetInstance()->AddCollider(swimmer->GetCollider());
+	return swimmer;
+}
 
+// Create a swimmer without adding it to the floating swimmers.
+Swimmer* SwimmerManager::CreateSwimmer()
+{
 		// Create the swimmer.
-		Swimmer* swimmer = new Swimmer(
-			resourceManager->GetMesh(swimmerMesh),
-			resourceManager->GetMaterial(swimmerMat),
-			"swimmer"
-		);
+		Swimmer* swimmer = new Swimmer(swimmerMesh, swimmerMat, "swimmer");
 		swimmer->SetScale(0.05f, 0.05f, 0.05f);
 
 		// Add collider.
-		swimmer->AddCollider(DirectX::XMFLOAT3(0.9f, 0.9f, 0.9f), DirectX::XMFLOAT3(0, 0, 0));
+		swimmer->AddCollider(DirectX::XMFLOAT3(0.9f, 0.9f, 0.9f), DirectX::XMFLOAT3(0, 0, 0), ColliderShape::Sphere);
+		swimmer->GetCollider()->SetCollisionLayer(LAYER_SWIMMER, LAYER_BOAT); //Swimmers never test against each other
+		physics.AddSwimmer(swimmer);
 #if defined(DEBUG) || defined(_DEBUG)
 		swimmer->SetDebug(true);
 #endif
+		return swimmer;
+}
 
-		// Instantiate the position and rotation.
-		this->RandomizeSwimmer(swimmer);
+// Send a swimmer out of the level.
+void SwimmerManager::ReleaseSwimmer(Swimmer* swimmer)
+{
+	if (swimmer->floatingIndex >= 0)
+		RemoveFloatingSwimmer(swimmer);
 
-		// Return the swimmer.
-		swimmers.push_back(swimmer);
-		return swimmer;
+	if (swimmer->GetState() != SwimmerState::Leaving)
+	{
+		swimmer->SetSwimmerState(SwimmerState::Leaving);
+		leaving.push_back(swimmer);
+	}
+}
+
+// Put every swimmer that sank out of the level back in the pool.
+void SwimmerManager::DespawnSunkSwimmers()
+{
+	CollisionManager* collisionManager = CollisionManager::GetInstance();
+	for (size_t i = 0; i < leaving.size();)
+	{
+		Swimmer* swimmer = leaving[i];
+		if (swimmer->GetPosition().y >= DESPAWN_Y)
+		{
+			i++;
+			continue;
+		}
+
+		// Swap it for the last one.
+		leaving[i] = leaving.back();
+		leaving.pop_back();
+
+		// Hide it until it's reused.
+		swimmer->SetSwimmerState(SwimmerState::Nothing);
+		swimmer->SetEnabled(false);
+		collisionManager->RemoveCollider(swimmer->GetCollider());
+		pool.push_back(swimmer);
+	}
+}
+
+// Remove a swimmer from the floating swimmers.
+void SwimmerManager::RemoveFloatingSwimmer(Swimmer* swimmer)
+{
+	// Swap it for the last one.
+	int index = swimmer->floatingIndex;
+	swimmers[index] = swimmers.back();
+	swimmers[index]->floatingIndex = index;
+
+	// Pop the last one.
+	swimmers.pop_back();
+	swimmer->floatingIndex = -1;
+}
+
+// Find the floating swimmers near a point.
+void SwimmerManager::GetSwimmersNear(XMFLOAT3 center, float radius, std::vector<Swimmer*>& results)
+{
+	results.clear();
+
+	// Ask the spatial hash for the swimmers touching a sphere around the point.
+	Collider query(center, XMFLOAT3(radius * 2, radius * 2, radius * 2), XMFLOAT3(0, 0, 0), ColliderShape::Sphere);
+	query.SetCollisionLayer(LAYER_BOAT, LAYER_SWIMMER);
+	CollisionManager::GetInstance()->GetSpatialHash()->Query(&query, queryResults);
+
+	for (size_t i = 0; i < queryResults.size(); i++)
+	{
+		GameObject* owner = queryResults[i]->GetOwner();
+		if (owner == nullptr || owner->GetName() != "swimmer")
+			continue;
+
+		Swimmer* swimmer = (Swimmer*)owner;
+		XMFLOAT3 position = swimmer->GetPosition();
+		float x = position.x - center.x;
+		float y = position.y - center.y;
+		float z = position.z - center.z;
+		if (swimmer->floatingIndex >= 0 && x * x + y * y + z * z <= radius * radius)
+			results.push_back(swimmer);
+	}
 }
 
 // Retrieve swimmer.
@@ -130,21 +391,41 @@ Swimmer* SwimmerManager::GetSwimmer(int id)
 	return swimmers[id];
 }
 
+// Find the index of a floating swimmer.
+int SwimmerManager::GetSwimmerIndex(Swimmer* swimmer)
+{
+	return swimmer->floatingIndex;
+}
+
 // Get swimmer count
 int SwimmerManager::GetSwimmerCount()
 {
 	return (int)swimmers.size();
 }
 
+// Get the amount of swimmers sinking out of the level
+int SwimmerManager::GetLeavingCount()
+{
+	return (int)leaving.size();
+}
+
+// Get the amount of spawns that found no room
+int SwimmerManager::GetSpawnFailures()
+{
+	return spawnFailures;
+}
+
+// Get the amount of despawned swimmers waiting to be reused
+int SwimmerManager::GetPooledCount()
+{
+	return (int)pool.size();
+}
+
 // Attach swimmer to the input object.
-void SwimmerManager::AttachSwimmer(Swimmer* swimmer, Entity* leader, int index)
+void SwimmerManager::AttachSwimmer(Swimmer* swimmer, Entity* leader, TrailHistory* trailHistory, int index)
 {
-	swimmer->JoinTrail(leader);
+	swimmer->JoinTrail(leader, trailHistory);
 	
 	//Remove from the list of floating swimmers
-	//Swap it for the last one
-	std::swap(swimmers[index], swimmers[swimmers.size() - 1]);
-
-	//Pop the last one
-	swimmers.pop_back();
+	RemoveFloatingSwimmer(swimmers[index]);
 }
@@ -2,34 +2,76 @@
 #include <DirectXMath.h>
 #include "Entity.h"
 #include "Swimmer.h"
-#include <random>
+#include "SwimmerPhysics.h"
+#include "SwimmerFlock.h"
+#include "FastRandom.h"
+#include "OccupancyGrid.h"
+#include "TrailHistory.h"
 
 class SwimmerManager :
 	public GameObject
 {
 private: // PRIVATE ------------------------------------
 
-	float currentTTS = 0;
+	bool spawnDue = false;       //The spawn timer ran out
+	TimerHandle spawnTimer;
 	float maxTTS = 3;
 	int maxSwimmerCount;
-	const char* swimmerMesh = "Assets\\Models\\swimmer.obj";
-	const char* swimmerMat = "swimmer";
-	std::mt19937 rng;
+	int spawnBatchSize;
+	Mesh* swimmerMesh;
+	Material* swimmerMat;
+	FastRandom rng;
+	unsigned int seed;
 	float levelRadius;
 
+	//Spawn placement
+	OccupancyGrid spawnGrid;       //Swimmers in the water and the snake, rebuilt for each batch
+	Entity* snakeHead;
+	TrailHistory* snakePath;
+	std::vector<float> randomBatch;       //Random numbers are made in batches
+	int randomCursor;
+	int spawnFailures;
+
 	//Singleton
 	SwimmerManager();
 	~SwimmerManager();
 
-	// Generates random position that's in bounds.
-	DirectX::XMFLOAT3 GetNextPosition();
+	// Generates a random position that's in bounds and clear of
+	// everything else. Returns false if no spot was found.
+	bool GetNextPosition(DirectX::XMFLOAT3* position);
+
+	// Fill the spawn grid with the swimmers in the water (they move around),
+	// and block the area around the boat and its trail.
+	void RebuildSpawnGrid();
+
+	// Get the next random number in [0, 1) from the batch.
+	float NextRandom();
 	// DirectX::XMFLOAT3 GetNextRotation();
 	// DirectX::XMFLOAT3 GetNextScale();
 
 	// Randomizes swimmer configuration at spawn.
-	void RandomizeSwimmer(Swimmer* swimmer);
+	void RandomizeSwimmer(Swimmer* swimmer, DirectX::XMFLOAT3 position);
+
+	// Take a swimmer from the pool, or create one if the pool is empty.
+	Swimmer* TakeSwimmer();
+
+	// Remove a swimmer from the floating swimmers (the last one fills its spot).
+	void RemoveFloatingSwimmer(Swimmer* swimmer);
+
+	// Put every swimmer that sank out of the level back in the pool.
+	void DespawnSunkSwimmers();
+
+	std::vector<Swimmer*> swimmers;       //Floating swimmers (each one knows its index)
+	std::vector<Swimmer*> leaving;       //Swimmers sinking out of the level
+	std::vector<Swimmer*> pool;       //Despawned swimmers, disabled and ready to reuse
+
+	//Water physics for every swimmer created (floating or not)
+	SwimmerPhysics physics;
 
-	std::vector<Swimmer*> swimmers;
+	//Flocking for floating swimmers
+	SwimmerFlock flock;
+	bool flocking;
+	std::vector<Collider*> queryResults;
 
 public: // PUBLIC --------------------------------------
 
@@ -49,37 +91,139 @@ public: // PUBLIC --------------------------------------
 	bool IsReadyToSpawn();
 
 	// --------------------------------------------------------
-	// Reset manager.
+	// Reset manager. Call it while the swimmers' entities are still
+	// alive (the destructor doesn't touch them).
 	// --------------------------------------------------------
 	void Reset();
 
 	// --------------------------------------------------------
-	// Updates swimmers and spawn time.
+	// Spawns swimmers when they're due. The time till the next
+	// batch is a timer on the TimerWheel
 	// --------------------------------------------------------
 	void Update(float deltaTime);
 
 	// --------------------------------------------------------
-	// Create a swimmer and spawn at a random position.
+	// Run flocking for the floating swimmers (if it's on) and the water
+	// physics for every swimmer, then put the ones that sank out of the
+	// level back in the pool.
+	//
+	// focus - where the player is (swimmers flee it, and far swimmers can be throttled)
+	// --------------------------------------------------------
+	void UpdatePhysics(float deltaTime, DirectX::XMFLOAT3 focus);
+
+	// --------------------------------------------------------
+	// Spawn a swimmer at a random position (reusing a pooled one if there is one).
+	// The spot is always a minimum distance from every other swimmer in the
+	// water, and from the boat and its trail. Returns nullptr if there's no room
 	// --------------------------------------------------------
 	Swimmer* SpawnSwimmer();
 
+	// --------------------------------------------------------
+	// Create a swimmer without adding it to the floating swimmers.
+	// --------------------------------------------------------
+	Swimmer* CreateSwimmer();
+
+	// --------------------------------------------------------
+	// Send a swimmer out of the level. It sinks, and goes back
+	// to the pool once it's deep enough
+	// --------------------------------------------------------
+	void ReleaseSwimmer(Swimmer* swimmer);
+
+	// --------------------------------------------------------
+	// Find the floating swimmers within a distance of a point,
+	// using the collision world's spatial hash
+	//
+	// results - cleared and filled with the swimmers
+	// --------------------------------------------------------
+	void GetSwimmersNear(DirectX::XMFLOAT3 center, float radius, std::vector<Swimmer*>& results);
+
+	// --------------------------------------------------------
+	// Turn flocking for floating swimmers on or off (on by default)
+	// --------------------------------------------------------
+	void SetFlocking(bool flocking);
+
+	// --------------------------------------------------------
+	// Get the flock the floating swimmers are in
+	// --------------------------------------------------------
+	SwimmerFlock* GetFlock();
+
+	// --------------------------------------------------------
+	// Get the water physics batch every swimmer is in
+	// --------------------------------------------------------
+	SwimmerPhysics* GetPhysics();
+
+	// --------------------------------------------------------
+	// Set the mesh and material new swimmers use
+	// (nullptr for simulations that don't render).
+	// --------------------------------------------------------
+	void SetSwimmerAssets(Mesh* mesh, Material* material);
+
+	// --------------------------------------------------------
+	// Set the max amount of swimmers floating at once
+	// --------------------------------------------------------
+	void SetMaxSwimmerCount(int count);
+
+	// --------------------------------------------------------
+	// Set the snake swimmers shouldn't spawn on
+	//
+	// head - the boat
+	// path - the path its trail follows (as long as the trail)
+	// --------------------------------------------------------
+	void SetSnake(Entity* head, TrailHistory* path);
+
+	// --------------------------------------------------------
+	// Set how many swimmers spawn at once, and how often
+	// (1 every 3 seconds by default)
+	// --------------------------------------------------------
+	void SetSpawnBatch(int batchSize, float interval);
+
+	// --------------------------------------------------------
+	// Restart the spawn randomness from a seed
+	// --------------------------------------------------------
+	void SetSeed(unsigned int seed);
+
+	// --------------------------------------------------------
+	// Get the seed the spawn randomness started from
+	// --------------------------------------------------------
+	unsigned int GetSeed();
+
 	// --------------------------------------------------------
 	// Find swimmer based on swimmer count.
 	// --------------------------------------------------------
 	Swimmer* GetSwimmer(int index);
 
+	// --------------------------------------------------------
+	// Find the index of a floating swimmer (-1 if it isn't floating). O(1)
+	// --------------------------------------------------------
+	int GetSwimmerIndex(Swimmer* swimmer);
+
 	// --------------------------------------------------------
 	// Get swimmer count
 	// --------------------------------------------------------
 	int GetSwimmerCount();
 
+	// --------------------------------------------------------
+	// Get the amount of swimmers sinking out of the level
+	// --------------------------------------------------------
+	int GetLeavingCount();
+
+	// --------------------------------------------------------
+	// Get the amount of spawns that found no room
+	// --------------------------------------------------------
+	int GetSpawnFailures();
+
+	// --------------------------------------------------------
+	// Get the amount of despawned swimmers waiting to be reused
+	// --------------------------------------------------------
+	int GetPooledCount();
+
 	// --------------------------------------------------------
 	// Set level radius
 	// --------------------------------------------------------
 	void SetLevelRadius(float radius);
 		
 	// --------------------------------------------------------
-	// Attach swimmer to a leader.
+	// Attach swimmer to a leader, following the trail's path.
 	// --------------------------------------------------------
-	void AttachSwimmer(Swimmer* swimmer, Entity* leader, int index);
+	void AttachSwimmer(Swimmer* swimmer, Entity* leader, TrailHistory* trailHistory, int index);
 };
\ No newline at end of file
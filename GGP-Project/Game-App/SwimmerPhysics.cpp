@@ -0,0 +1,333 @@
+#include "SwimmerPhysics.h"
+#include "Swimmer.h"
+#include "SIMDLanes.h"
+#include "JobSystem.h"
+#include "WaterSurface.h"
+
+//Buoyancy consts
+#define MASS 0.5f
+#define GRAVITY 9.81f
+#define FLUID_DENSITY 2.0f
+#define DRAG_COEFF 1.05f
+#define AIR_DENSITY 0.1225f
+
+//Slots handed to a thread at a time (a multiple of the widest lane count)
+#define PHYSICS_CHUNK 256
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Buoyancy kernel - integrates L::Width slots at once against
+// the wave height under each slot.
+// Lanes that aren't in the water keep their height and velocity
+//
+// Thanks Khan once again
+// https://www.khanacademy.org/science/physics/fluids/buoyant-force-and-archimedes-principle/a/buoyant-force-and-archimedes-principle-article
+// https://www.grc.nasa.gov/WWW/K-12/airplane/falling.html
+// --------------------------------------------------------
+template<typename L>
+static void BuoyancyKernel(float* heights, float* velocities, const float* halfHeights, const float* areas,
+	const float* surfaces, const float* buoyant, const float* active, const float* deltaTimes)
+{
+	typedef typename L::F F;
+	F zero = L::Set(0);
+	F surface = L::Load(surfaces);
+	F dt = L::Load(deltaTimes);
+
+	F y = L::Load(heights);
+	F velocity = L::Load(velocities);
+	F half = L::Load(halfHeights);
+	F area = L::Load(areas);
+
+	//Calculate displaced volume and buoyancy
+	F hTop = L::Min(L::Add(y, half), surface);
+	F hBot = L::Min(L::Sub(y, half), surface);
+	F watDisplaced = L::Mul(area, L::Sub(hTop, hBot));
+	F buoyancy = L::Select(L::GreaterMask(L::Load(buoyant), zero),
+		L::Mul(L::Set(FLUID_DENSITY * GRAVITY), watDisplaced), zero);
+
+	//Air drag above the water, fluid drag below it
+	F dragCoeff = L::Select(L::GreaterMask(y, surface),
+		L::Set(DRAG_COEFF * AIR_DENSITY), L::Set(DRAG_COEFF * FLUID_DENSITY));
+	F drag = L::Mul(dragCoeff, L::Div(L::Mul(L::Mul(velocity, velocity), area), L::Set(2)));
+
+	//Apply bouyancy and gravity
+	F acceleration = L::Sub(L::Div(buoyancy, L::Set(MASS)), L::Set(GRAVITY));
+	F newVelocity = L::Add(velocity, L::Mul(acceleration, dt));
+
+	//Add drag based on velocity's direction
+	F dragStep = L::Mul(drag, dt);
+	newVelocity = L::Select(L::LessMask(newVelocity, zero),
+		L::Add(newVelocity, dragStep), L::Sub(newVelocity, dragStep));
+
+	//Add velocity to position
+	F newY = L::Add(y, L::Mul(newVelocity, dt));
+
+	F inWater = L::GreaterMask(L::Load(active), zero);
+	L::Store(heights, L::Select(inWater, newY, y));
+	L::Store(velocities, L::Select(inWater, newVelocity, velocity));
+}
+
+// Set up an empty batch
+SwimmerPhysics::SwimmerPhysics()
+{
+	throttleInterval = 1;
+	fullRateDistanceSq = 0;
+	focus = XMFLOAT3(0, 0, 0);
+	stepCount = 0;
+}
+
+// Let go of every swimmer
+SwimmerPhysics::~SwimmerPhysics()
+{
+	Clear();
+}
+
+// Add a swimmer to the batch
+void SwimmerPhysics::AddSwimmer(Swimmer* swimmer)
+{
+	if (swimmer->physics == this)
+		return;
+	if (swimmer->physics != nullptr)
+		swimmer->physics->RemoveSwimmer(swimmer);
+
+	XMFLOAT3 halves = swimmer->GetCollider()->GetHalfSize();
+	swimmer->physics = this;
+	swimmer->physicsSlot = (int)swimmers.size();
+
+	swimmers.push_back(swimmer);
+	heights.push_back(swimmer->GetPosition().y);
+	velocities.push_back(0);
+	halfHeights.push_back(halves.y);
+	areas.push_back((2 * halves.x) * (2 * halves.z));
+	buoyant.push_back(0);
+	active.push_back(0);
+	deltaTimes.push_back(0);
+	phases.push_back(swimmer->physicsSlot);
+	xs.push_back(0);
+	zs.push_back(0);
+	surfaces.push_back(SURFACE_Y);
+}
+
+// Remove a swimmer from the batch
+void SwimmerPhysics::RemoveSwimmer(Swimmer* swimmer)
+{
+	if (swimmer->physics != this)
+		return;
+
+	//Move the last slot into the hole
+	int slot = swimmer->physicsSlot;
+	int last = (int)swimmers.size() - 1;
+	swimmers[slot] = swimmers[last];
+	heights[slot] = heights[last];
+	velocities[slot] = velocities[last];
+	halfHeights[slot] = halfHeights[last];
+	areas[slot] = areas[last];
+	buoyant[slot] = buoyant[last];
+	active[slot] = active[last];
+	deltaTimes[slot] = deltaTimes[last];
+	phases[slot] = phases[last];
+	xs[slot] = xs[last];
+	zs[slot] = zs[last];
+	surfaces[slot] = surfaces[last];
+	swimmers[slot]->physicsSlot = slot;
+
+	swimmers.pop_back();
+	heights.pop_back();
+	velocities.pop_back();
+	halfHeights.pop_back();
+	areas.pop_back();
+	buoyant.pop_back();
+	active.pop_back();
+	deltaTimes.pop_back();
+	phases.pop_back();
+	xs.pop_back();
+	zs.pop_back();
+	surfaces.pop_back();
+
+	swimmer->physics = nullptr;
+	swimmer->physicsSlot = -1;
+}
+
+// Remove every swimmer from the batch
+void SwimmerPhysics::Clear()
+{
+	for (size_t i = 0; i < swimmers.size(); i++)
+	{
+		swimmers[i]->physics = nullptr;
+		swimmers[i]->physicsSlot = -1;
+	}
+	swimmers.clear();
+	heights.clear();
+	velocities.clear();
+	halfHeights.clear();
+	areas.clear();
+	buoyant.clear();
+	active.clear();
+	deltaTimes.clear();
+	phases.clear();
+	xs.clear();
+	zs.clear();
+	surfaces.clear();
+}
+
+// Run a step of water physics for every swimmer
+void SwimmerPhysics::Step(float deltaTime)
+{
+	//Swimmers only write to themselves, so chunks can run in parallel
+	JobSystem::GetInstance()->ParallelFor((int)swimmers.size(), PHYSICS_CHUNK,
+		[&](int begin, int end)
+	{
+		Gather(begin, end, deltaTime);
+		Integrate(begin, end);
+		WriteBack(begin, end);
+	});
+	stepCount++;
+}
+
+// Read the state and height of some swimmers
+void SwimmerPhysics::Gather(int begin, int end, float deltaTime)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Swimmer* swimmer = swimmers[i];
+		SwimmerState state = swimmer->swmrState;
+		bool inWater = swimmer->GetEnabled() && (state == SwimmerState::Entering
+			|| state == SwimmerState::Floating || state == SwimmerState::Leaving);
+		buoyant[i] = state != SwimmerState::Leaving ? 1.0f : 0.0f;
+		deltaTimes[i] = deltaTime;
+		if (!inWater)
+		{
+			active[i] = 0;
+			continue;
+		}
+
+		XMFLOAT3 position = swimmer->GetPosition();
+		heights[i] = position.y;
+		xs[i] = position.x;
+		zs[i] = position.z;
+		active[i] = 1;
+
+		//Far away floating swimmers take turns, with a longer step
+		if (throttleInterval > 1 && state == SwimmerState::Floating)
+		{
+			float x = position.x - focus.x;
+			float z = position.z - focus.z;
+			if (x * x + z * z > fullRateDistanceSq)
+			{
+				if ((phases[i] + stepCount) % throttleInterval != 0)
+					active[i] = 0;
+				deltaTimes[i] = deltaTime * throttleInterval;
+			}
+		}
+	}
+
+	//The waves' height under every slot, a batch at a time
+	WaterSurface::GetInstance()->SampleHeights(&xs[begin], &zs[begin], &surfaces[begin], end - begin);
+}
+
+// Integrate some slots with the widest lanes there are
+void SwimmerPhysics::Integrate(int begin, int end)
+{
+	int i = begin;
+
+#ifdef BATCH_AVX
+	for (; i + AVXLanes::Width <= end; i += AVXLanes::Width)
+	{
+		BuoyancyKernel<AVXLanes>(&heights[i], &velocities[i], &halfHeights[i], &areas[i],
+			&surfaces[i], &buoyant[i], &active[i], &deltaTimes[i]);
+	}
+#endif
+
+#ifdef BATCH_SSE
+	for (; i + SSELanes::Width <= end; i += SSELanes::Width)
+	{
+		BuoyancyKernel<SSELanes>(&heights[i], &velocities[i], &halfHeights[i], &areas[i],
+			&surfaces[i], &buoyant[i], &active[i], &deltaTimes[i]);
+	}
+#endif
+
+	//Leftovers
+	IntegrateScalar(i, end);
+}
+
+// Integrate some slots one at a time
+void SwimmerPhysics::IntegrateScalar(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		BuoyancyKernel<ScalarLanes>(&heights[i], &velocities[i], &halfHeights[i], &areas[i],
+			&surfaces[i], &buoyant[i], &active[i], &deltaTimes[i]);
+	}
+}
+
+// Move some swimmers to their new heights
+void SwimmerPhysics::WriteBack(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		if (active[i] != 0)
+			swimmers[i]->WaterStep(heights[i], deltaTimes[i]);
+	}
+}
+
+// Throttle floating swimmers far from the focus
+void SwimmerPhysics::SetThrottle(int interval, float fullRateDistance)
+{
+	throttleInterval = interval > 1 ? interval : 1;
+	fullRateDistanceSq = fullRateDistance * fullRateDistance;
+}
+
+// Set where the action is
+void SwimmerPhysics::SetFocus(XMFLOAT3 focus)
+{
+	this->focus = focus;
+}
+
+// Get the amount of swimmers that updated on the last step
+int SwimmerPhysics::GetActiveCount()
+{
+	int count = 0;
+	for (size_t i = 0; i < active.size(); i++)
+	{
+		if (active[i] != 0)
+			count++;
+	}
+	return count;
+}
+
+// Get the amount of swimmers in the batch
+int SwimmerPhysics::GetCount()
+{
+	return (int)swimmers.size();
+}
+
+// Get a slot's height
+float SwimmerPhysics::GetHeight(int slot)
+{
+	return heights[slot];
+}
+
+// Get a slot's vertical velocity
+float SwimmerPhysics::GetVelocity(int slot)
+{
+	return velocities[slot];
+}
+
+// Set a slot's vertical velocity
+void SwimmerPhysics::SetVelocity(int slot, float velocity)
+{
+	velocities[slot] = velocity;
+}
+
+// Get the amount of swimmers integrated at once
+int SwimmerPhysics::GetLaneCount()
+{
+#if defined(BATCH_AVX)
+	return AVXLanes::Width;
+#elif defined(BATCH_SSE)
+	return SSELanes::Width;
+#else
+	return ScalarLanes::Width;
+#endif
+}
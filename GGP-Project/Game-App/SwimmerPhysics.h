@@ -0,0 +1,150 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+//Height of the water's calm surface (the waves move around it)
+#define SURFACE_Y 0
+
+class Swimmer;
+
+// --------------------------------------------------------
+// Water physics (buoyancy, drag and gravity) for every swimmer.
+//
+// The state is stored as one array per value with a slot per
+// swimmer, so it's integrated 8 swimmers at a time with AVX
+// (4 with SSE). Each step reads the swimmers' heights, integrates
+// and writes the new heights back in one pass over a chunk of
+// slots, with the chunks split across the job system's threads.
+// Only swimmers in a water state (entering, floating or leaving)
+// are moved, the rest keep their velocity for when they're back.
+// Buoyancy is worked out against the WaterSurface's waves, sampled
+// under every slot in the same batches.
+//
+// Floating swimmers far from the focus (the player) can be throttled
+// to update every few steps with a longer time step, in turns,
+// so large crowds only pay for the swimmers near the action
+// --------------------------------------------------------
+class SwimmerPhysics
+{
+private:
+	//One slot per swimmer
+	std::vector<Swimmer*> swimmers;
+	std::vector<float> heights;
+	std::vector<float> velocities;
+	std::vector<float> halfHeights;
+	std::vector<float> areas;       //Area under the collider (for displacement and drag)
+	std::vector<float> buoyant;       //1 if buoyancy applies this step
+	std::vector<float> active;       //1 if the swimmer is in the water this step
+	std::vector<float> deltaTimes;       //Time step of each slot this step
+	std::vector<int> phases;       //Which step of the throttle interval the slot updates on
+	std::vector<float> xs;       //Where the slot is on the water (for the wave height)
+	std::vector<float> zs;
+	std::vector<float> surfaces;       //Height of the waves over the slot this step
+
+	//Throttling
+	int throttleInterval;
+	float fullRateDistanceSq;
+	DirectX::XMFLOAT3 focus;
+	unsigned int stepCount;
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty batch
+	// --------------------------------------------------------
+	SwimmerPhysics();
+
+	// --------------------------------------------------------
+	// Destructor - Let go of every swimmer
+	// --------------------------------------------------------
+	~SwimmerPhysics();
+
+	// --------------------------------------------------------
+	// Add a swimmer to the batch. The swimmer needs its collider,
+	// its half extents are read once here
+	// --------------------------------------------------------
+	void AddSwimmer(Swimmer* swimmer);
+
+	// --------------------------------------------------------
+	// Remove a swimmer from the batch (the last slot fills the hole).
+	// Swimmers remove themselves when they're deleted
+	// --------------------------------------------------------
+	void RemoveSwimmer(Swimmer* swimmer);
+
+	// --------------------------------------------------------
+	// Remove every swimmer from the batch
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Run a step of water physics for every swimmer and write
+	// the results back to their transforms. Main thread only
+	// --------------------------------------------------------
+	void Step(float deltaTime);
+
+	// --------------------------------------------------------
+	// Read the state and position of the swimmers in [begin, end),
+	// pick which ones update this step (and by how much), and
+	// sample the waves' height under them
+	// --------------------------------------------------------
+	void Gather(int begin, int end, float deltaTime);
+
+	// --------------------------------------------------------
+	// Integrate the slots in [begin, end) with the widest lanes there are
+	// --------------------------------------------------------
+	void Integrate(int begin, int end);
+
+	// --------------------------------------------------------
+	// Integrate the slots in [begin, end) one at a time
+	// (for checking and benchmarking the SIMD path)
+	// --------------------------------------------------------
+	void IntegrateScalar(int begin, int end);
+
+	// --------------------------------------------------------
+	// Move the swimmers in [begin, end) to their new heights and
+	// run their water state's behaviour
+	// --------------------------------------------------------
+	void WriteBack(int begin, int end);
+
+	// --------------------------------------------------------
+	// Throttle floating swimmers far from the focus
+	//
+	// interval - far swimmers update once every this many steps (1 is off)
+	// fullRateDistance - swimmers closer than this always update
+	// --------------------------------------------------------
+	void SetThrottle(int interval, float fullRateDistance);
+
+	// --------------------------------------------------------
+	// Set where the action is (swimmers near it are never throttled)
+	// --------------------------------------------------------
+	void SetFocus(DirectX::XMFLOAT3 focus);
+
+	// --------------------------------------------------------
+	// Get the amount of swimmers that updated on the last step
+	// --------------------------------------------------------
+	int GetActiveCount();
+
+	// --------------------------------------------------------
+	// Get the amount of swimmers in the batch
+	// --------------------------------------------------------
+	int GetCount();
+
+	// --------------------------------------------------------
+	// Get a slot's height (as of the last gather or integration)
+	// --------------------------------------------------------
+	float GetHeight(int slot);
+
+	// --------------------------------------------------------
+	// Get a slot's vertical velocity
+	// --------------------------------------------------------
+	float GetVelocity(int slot);
+
+	// --------------------------------------------------------
+	// Set a slot's vertical velocity
+	// --------------------------------------------------------
+	void SetVelocity(int slot, float velocity);
+
+	// --------------------------------------------------------
+	// Get the amount of swimmers integrated at once
+	// --------------------------------------------------------
+	static int GetLaneCount();
+};
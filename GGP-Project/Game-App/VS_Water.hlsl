@@ -0,0 +1,176 @@
+
+// Most waves there can be (matches MAX_WATER_WAVES in WaterSurface.h)
+#define MAX_WATER_WAVES 4
+
+// World units the water's textures stretch over (before the uv scale)
+#define WATER_UV_SIZE 26.0f
+
+// A Gerstner wave (matches WaterWaveStruct in WaterSurface.h)
+struct GerstnerWave
+{
+	float2	Direction;
+	float	Frequency;	// 16 bytes (with amplitude)
+	float	Amplitude;
+
+	float	Steepness;
+	float	Phase;
+	float2	Padding;	// 32 bytes
+};
+
+//Data that changes once per MatMesh combo
+cbuffer perCombo : register(b0)
+{
+	matrix view;
+	matrix projection;
+	float2 uvScale;
+}
+
+//Data that changes once per MatMesh combo
+cbuffer perObject : register(b1)
+{
+	matrix world;
+	matrix worldInvTrans;
+}
+
+//The waves the CPU samples for buoyancy
+cbuffer waves : register(b2)
+{
+	GerstnerWave Waves[MAX_WATER_WAVES];
+	int WaveCount;
+	float OceanPatchLength;
+	int OceanSize;		// 0 when there's no FFT ocean
+	float WakeExtent;
+	int WakeSize;		// 0 when there's no wake field
+}
+
+//FFT ocean displacement (x, height, z), rows along z (OceanFFT)
+Texture2D OceanDisplacement		: register(t0);
+
+//Wake slopes and height (slope x, height, slope z), rows along z (WakeField)
+Texture2D WakeTexture			: register(t1);
+
+// Struct representing a single vertex worth of data
+struct VertexShaderInput
+{
+	float3 position		: POSITION;	     // XYZ position
+	float2 uv			: TEXCOORD;		 // XY uv
+	float3 normal		: NORMAL;        // XYZ normal
+	float3 tangent		: TANGENT;
+};
+
+// Struct representing the data we're sending down the pipeline
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;	 // XYZW position (System Value Position)
+	float2 uv			: TEXCOORD;		 // XY uv
+	float3 normal		: NORMAL;        // XYZ normal
+	float3 tangent		: TANGENT;
+	float3 worldPos		: POSITION;		 // world position of the vertex
+};
+
+// --------------------------------------------------------
+// Displacement of the FFT ocean at a spot on the calm surface,
+// between texels the same way the CPU samples it (the patch tiles)
+// --------------------------------------------------------
+float3 SampleOcean(float2 xz)
+{
+	float2 texel = xz / OceanPatchLength * OceanSize;
+	float2 corner = floor(texel);
+	float2 f = texel - corner;
+	int2 c0 = int2(corner) & (OceanSize - 1);
+	int2 c1 = (c0 + 1) & (OceanSize - 1);
+
+	float3 top = lerp(OceanDisplacement.Load(int3(c0.x, c0.y, 0)).xyz,
+		OceanDisplacement.Load(int3(c1.x, c0.y, 0)).xyz, f.x);
+	float3 bottom = lerp(OceanDisplacement.Load(int3(c0.x, c1.y, 0)).xyz,
+		OceanDisplacement.Load(int3(c1.x, c1.y, 0)).xyz, f.x);
+	return lerp(top, bottom, f.y);
+}
+
+// --------------------------------------------------------
+// Slopes and height of the wakes at a spot on the calm surface
+// (slope x, height, slope z), flat outside the wake field
+// --------------------------------------------------------
+float3 SampleWake(float2 xz)
+{
+	float2 texel = (xz / WakeExtent + 0.5f) * (WakeSize - 1);
+	if (any(texel < 0) || any(texel >= WakeSize - 1))
+		return float3(0, 0, 0);
+
+	int2 c0 = int2(texel);
+	float2 f = texel - c0;
+	float3 top = lerp(WakeTexture.Load(int3(c0.x, c0.y, 0)).xyz,
+		WakeTexture.Load(int3(c0.x + 1, c0.y, 0)).xyz, f.x);
+	float3 bottom = lerp(WakeTexture.Load(int3(c0.x, c0.y + 1, 0)).xyz,
+		WakeTexture.Load(int3(c0.x + 1, c0.y + 1, 0)).xyz, f.x);
+	return lerp(top, bottom, f.y);
+}
+
+// --------------------------------------------------------
+// Vertex shader for the water's surface. Moves the vertices
+// with the same Gerstner waves the WaterSurface samples on the
+// CPU (GPU Gems 1, chapter 1), so swimmers float on what's drawn
+// --------------------------------------------------------
+VertexToPixel main(VertexShaderInput input)
+{
+	VertexToPixel output;
+
+	//Sum the waves at the vertex's spot on the calm surface
+	float3 worldPos = mul(float4(input.position, 1.0f), world).xyz;
+	float3 displaced = worldPos;
+	float3 normal = float3(0, 1, 0);
+	float3 tangent = float3(1, 0, 0);
+	for (int i = 0; i < WaveCount; i++)
+	{
+		GerstnerWave wave = Waves[i];
+		float theta = wave.Frequency * dot(wave.Direction, worldPos.xz) + wave.Phase;
+		float s = sin(theta);
+		float c = cos(theta);
+		float slope = wave.Frequency * wave.Amplitude;
+
+		displaced.xz += wave.Steepness * wave.Amplitude * wave.Direction * c;
+		displaced.y += wave.Amplitude * s;
+
+		normal.xz -= wave.Direction * slope * c;
+		normal.y -= wave.Steepness * slope * s;
+
+		tangent.x -= wave.Steepness * wave.Direction.x * wave.Direction.x * slope * s;
+		tangent.y += wave.Direction.x * slope * c;
+		tangent.z -= wave.Steepness * wave.Direction.x * wave.Direction.y * slope * s;
+	}
+
+	//Lay the FFT ocean's chop on top, with normals from the neighbouring texels
+	if (OceanSize > 0)
+	{
+		float step = OceanPatchLength / OceanSize;
+		displaced += SampleOcean(worldPos.xz);
+
+		float3 alongX = float3(2 * step, 0, 0) + SampleOcean(worldPos.xz + float2(step, 0)) - SampleOcean(worldPos.xz - float2(step, 0));
+		float3 alongZ = float3(0, 0, 2 * step) + SampleOcean(worldPos.xz + float2(0, step)) - SampleOcean(worldPos.xz - float2(0, step));
+		float3 oceanNormal = cross(alongZ, alongX);
+
+		//Slopes add
+		normal = float3(normal.x / normal.y + oceanNormal.x / oceanNormal.y, 1,
+			normal.z / normal.y + oceanNormal.z / oceanNormal.y);
+		tangent.y += tangent.x * alongX.y / alongX.x;
+	}
+
+	//And the ripples the boat and swimmers left
+	if (WakeSize > 0)
+	{
+		float3 wake = SampleWake(worldPos.xz);
+		displaced.y += wake.y;
+		normal = float3(normal.x / normal.y - wake.x, 1, normal.z / normal.y - wake.z);
+		tangent.y += tangent.x * wake.x;
+	}
+
+	matrix viewProj = mul(view, projection);
+	output.position = mul(float4(displaced, 1.0f), viewProj);
+	output.worldPos = displaced;
+	output.normal = normalize(normal);
+	output.tangent = normalize(tangent);
+	//The grid follows the camera, so the textures are laid on the calm surface instead
+	output.uv = worldPos.xz / WATER_UV_SIZE * uvScale;
+
+	return output;
+}
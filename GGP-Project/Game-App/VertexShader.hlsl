@@ -5,8 +5,6 @@ cbuffer perCombo : register(b0)
 	matrix view;
 	matrix projection;
 	float2 uvScale;
-	matrix shadowView;
-	matrix shadowProj;
 }
 
 //Data that changes once per MatMesh combo
@@ -51,7 +49,6 @@ struct VertexToPixel
 	float3 normal		: NORMAL;        // XYZ normal
 	float3 tangent		: TANGENT;
 	float3 worldPos		: POSITION;		 // world position of the vertex
-	float4 posForShadow : SHADOW;
 };
 
 // --------------------------------------------------------
@@ -75,10 +72,6 @@ VertexToPixel main(VertexShaderInput input )
 	// all of those transformations (world to view to projection space)
 	matrix worldViewProj = mul(mul(world, view), projection);
 
-	// Calculate shadow map position
-	matrix shadowWVP = mul(mul(world, shadowView), shadowProj);
-	output.posForShadow = mul(float4(input.position, 1.0f), shadowWVP);
-
 	// Then we convert our 3-component position vector to a 4-component vector
 	// and multiply it by our final 4x4 matrix.
 	//
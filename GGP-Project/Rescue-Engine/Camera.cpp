@@ -8,6 +8,9 @@ Camera::Camera()
 	//Default transformation values
 	up = XMFLOAT3(0, 1, 0);
 	CreateViewMatrix();
+
+	//Default projection values
+	CreateProjectionMatrix(0.25f * XM_PI, 1, 0.1f, 100.0f);
 }
 
 // Destructor for when an instance is deleted
@@ -51,10 +54,39 @@ void Camera::CreateProjectionMatrix(float fov, float aspectRatio,
 		nearClip,		// Near clip plane distance
 		farClip);		// Far clip plane distance
 	XMStoreFloat4x4(&projection, XMMatrixTranspose(P)); // Transpose for HLSL!
+
+	this->fov = fov;
+	this->aspectRatio = aspectRatio;
+	this->nearClip = nearClip;
+	this->farClip = farClip;
 }
 
 // Get the camera's projection matrix
 XMFLOAT4X4 Camera::GetProjectionMatrix()
 {
 	return projection;
+}
+
+// Get the camera's vertical field of view
+float Camera::GetFOV()
+{
+	return fov;
+}
+
+// Get the camera's aspect ratio
+float Camera::GetAspectRatio()
+{
+	return aspectRatio;
+}
+
+// Get the camera's near clip plane distance
+float Camera::GetNearClip()
+{
+	return nearClip;
+}
+
+// Get the camera's far clip plane distance
+float Camera::GetFarClip()
+{
+	return farClip;
 }
\ No newline at end of file
@@ -15,6 +15,12 @@ private:
 	//Transformation data
 	DirectX::XMFLOAT3 up;
 
+	//Projection data
+	float fov;
+	float aspectRatio;
+	float nearClip;
+	float farClip;
+
 public:
 	// --------------------------------------------------------
 	// Constructor - Set up the camera
@@ -59,5 +65,25 @@ public:
 	// Get the camera's projection matrix
 	// --------------------------------------------------------
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
+
+	// --------------------------------------------------------
+	// Get the camera's vertical field of view
+	// --------------------------------------------------------
+	float GetFOV();
+
+	// --------------------------------------------------------
+	// Get the camera's aspect ratio (width / height)
+	// --------------------------------------------------------
+	float GetAspectRatio();
+
+	// --------------------------------------------------------
+	// Get the camera's near clip plane distance
+	// --------------------------------------------------------
+	float GetNearClip();
+
+	// --------------------------------------------------------
+	// Get the camera's far clip plane distance
+	// --------------------------------------------------------
+	float GetFarClip();
 };
 
@@ -1,8 +1,124 @@
 #include "Collider.h"
-#include "ResourceManager.h"
+#include "SpatialHash.h"
+#include "ColliderBatch.h"
+#include "CollisionManager.h"
+#include "ExtendedMath.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
 
 using namespace DirectX;
 
+unsigned int Collider::nextId = 0;
+
+// Dot product of two float3s
+static float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Difference of two float3s
+static XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+// Squared distance from a point to an oriented box (0 if it's inside)
+static float PointBoxDistanceSq(const XMFLOAT3& point, const OrientedBox& box)
+{
+	XMFLOAT3 rel = Sub(point, box.center);
+	const float* half = &box.half.x;
+	float distSq = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		float local = Dot(rel, box.axes[i]);
+		float excess = fabsf(local) - half[i];
+		if (excess > 0)
+			distSq += excess * excess;
+	}
+	return distSq;
+}
+
+// Squared distance from a line segment to an oriented box (0 if it touches it).
+// The distance is a quadratic in t between the points where the segment crosses
+// one of the box's face planes, so each piece is minimized exactly. Segments
+// clearly further than radius away return a (larger) rough distance
+static float SegmentBoxDistanceSq(const XMFLOAT3& start, const XMFLOAT3& end, const OrientedBox& box, float radius)
+{
+	//Quick out against the box's bounding sphere
+	float reach = radius + sqrtf(Dot(box.half, box.half));
+	float centerDistSq = ExtendedMath::PointSegmentDistanceSq(box.center, start, end);
+	if (centerDistSq > reach * reach)
+		return centerDistSq;
+
+	//Segment in the box's space
+	XMFLOAT3 rel = Sub(start, box.center);
+	XMFLOAT3 dir = Sub(end, start);
+	const float* half = &box.half.x;
+	float p[3];
+	float d[3];
+	for (int i = 0; i < 3; i++)
+	{
+		p[i] = Dot(rel, box.axes[i]);
+		d[i] = Dot(dir, box.axes[i]);
+	}
+
+	//Where the segment crosses each face plane (sorted)
+	float ts[8] = { 0, 1 };
+	int count = 2;
+	for (int i = 0; i < 3; i++)
+	{
+		if (d[i] == 0)
+			continue;
+		for (int side = -1; side <= 1; side += 2)
+		{
+			float t = (side * half[i] - p[i]) / d[i];
+			if (t > 0 && t < 1)
+				ts[count++] = t;
+		}
+	}
+	std::sort(ts, ts + count);
+
+	//Minimize each piece
+	float best = FLT_MAX;
+	for (int k = 0; k + 1 < count; k++)
+	{
+		float t0 = ts[k];
+		float t1 = ts[k + 1];
+		float mid = (t0 + t1) * 0.5f;
+
+		//Faces the segment is outside of along this piece
+		float target[3];
+		bool outside[3];
+		float numerator = 0;
+		float denominator = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float x = p[i] + mid * d[i];
+			outside[i] = x > half[i] || x < -half[i];
+			if (!outside[i])
+				continue;
+			target[i] = x > half[i] ? half[i] : -half[i];
+			numerator -= d[i] * (p[i] - target[i]);
+			denominator += d[i] * d[i];
+		}
+
+		float t = denominator > 0 ? std::max(t0, std::min(t1, numerator / denominator)) : t0;
+		float distSq = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			if (!outside[i])
+				continue;
+			float excess = p[i] + t * d[i] - target[i];
+			distSq += excess * excess;
+		}
+		best = std::min(best, distSq);
+		if (best <= 0)
+			break;
+	}
+	return best;
+}
+
 // Create an empty collider.
 Collider::Collider(XMFLOAT3 position)
 {
@@ -10,9 +126,11 @@ Collider::Collider(XMFLOAT3 position)
 	this->rotation = XMFLOAT4(0, 0, 0, 0);
 	this->size = XMFLOAT3();
 	this->offset = XMFLOAT3();
+	this->shape = ColliderShape::Box;
 	this->worldMatrix = XMFLOAT4X4();
 
 	worldDirty = true;
+	InitBroadphase();
 }
 
 // Create a collider from a position and size.
@@ -20,8 +138,8 @@ Collider::Collider(XMFLOAT3 position, XMFLOAT3 size)
 	: Collider(position, size, XMFLOAT3(0, 0, 0))
 { }
 
-// Create a collider from a position, size, and offset.
-Collider::Collider(XMFLOAT3 position, XMFLOAT3 size, XMFLOAT3 offset)
+// Create a collider from a position, size, offset and shape.
+Collider::Collider(XMFLOAT3 position, XMFLOAT3 size, XMFLOAT3 offset, ColliderShape shape)
 {
 	XMStoreFloat3(&this->position, XMLoadFloat3(&position) + XMLoadFloat3(&offset));
 
@@ -29,13 +147,52 @@ Collider::Collider(XMFLOAT3 position, XMFLOAT3 size, XMFLOAT3 offset)
 
 	this->size = size;
 	this->offset = offset;
+	this->shape = shape;
 	this->worldMatrix = XMFLOAT4X4();
 
 	worldDirty = true;
+	InitBroadphase();
 }
 
 // Release resources.
-Collider::~Collider() {}
+Collider::~Collider()
+{
+	if (inCollisionWorld)
+		CollisionManager::GetInstance()->RemoveCollider(this);
+	if (spatialHash != nullptr)
+		spatialHash->Remove(this);
+}
+
+// Set the default broadphase values
+void Collider::InitBroadphase()
+{
+	owner = nullptr;
+	id = nextId++;
+	layer = COLLISION_LAYER_DEFAULT;
+	mask = COLLISION_MASK_ALL;
+	inCollisionWorld = false;
+	spatialHash = nullptr;
+	hashDirty = false;
+	boxDirty = true;
+	boundsMin = boundsMax = position;
+	for (int i = 0; i < 3; i++)
+	{
+		cellMin[i] = cellMax[i] = 0;
+	}
+}
+
+// Tell this collider's spatial hash (if any) that it moved
+void Collider::MarkMoved()
+{
+	boxDirty = true;
+
+	//Only queue once per refresh
+	if (spatialHash != nullptr && !hashDirty)
+	{
+		hashDirty = true;
+		spatialHash->MarkDirty(this);
+	}
+}
 
 // Construct this collider's world matrix
 void Collider::ConstructWorldMatrix()
@@ -84,6 +241,151 @@ DirectX::XMFLOAT3 Collider::GetHalfSize() const
 	return DirectX::XMFLOAT3(size.x / 2, size.y / 2, size.z / 2);
 }
 
+// Return the shape.
+ColliderShape Collider::GetShape() const
+{
+	return shape;
+}
+
+// Return the sphere/capsule radius.
+float Collider::GetRadius() const
+{
+	return size.x / 2;
+}
+
+// Get the world space line a capsule is swept along
+void Collider::GetSegment(DirectX::XMFLOAT3* start, DirectX::XMFLOAT3* end)
+{
+	if (shape != ColliderShape::Capsule)
+	{
+		*start = *end = position;
+		return;
+	}
+
+	//Local z (from the cached box), minus the rounded ends
+	const OrientedBox& box = GetOrientedBox();
+	float halfLength = GetCapsuleHalfLength();
+	XMFLOAT3 axis = XMFLOAT3(box.axes[2].x * halfLength, box.axes[2].y * halfLength, box.axes[2].z * halfLength);
+
+	*start = XMFLOAT3(position.x - axis.x, position.y - axis.y, position.z - axis.z);
+	*end = XMFLOAT3(position.x + axis.x, position.y + axis.y, position.z + axis.z);
+}
+
+// Get half the length of a capsule's segment
+float Collider::GetCapsuleHalfLength() const
+{
+	return std::max(size.z / 2 - GetRadius(), 0.0f);
+}
+
+// Get the collider's box in world space
+const OrientedBox& Collider::GetOrientedBox()
+{
+	if (boxDirty)
+	{
+		XMFLOAT3X3 rot;
+		XMStoreFloat3x3(&rot, XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)));
+
+		box.center = position;
+		box.axes[0] = XMFLOAT3(rot._11, rot._12, rot._13);
+		box.axes[1] = XMFLOAT3(rot._21, rot._22, rot._23);
+		box.axes[2] = XMFLOAT3(rot._31, rot._32, rot._33);
+		box.half = GetHalfSize();
+		boxDirty = false;
+	}
+
+	return box;
+}
+
+// Get the world space axis aligned box around the collider
+void Collider::GetBounds(DirectX::XMFLOAT3* min, DirectX::XMFLOAT3* max) const
+{
+	XMFLOAT3X3 rot;
+	XMStoreFloat3x3(&rot, XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)));
+
+	//Spheres and capsules are their segment (along local z) grown by the radius
+	if (shape != ColliderShape::Box)
+	{
+		float halfLength = shape == ColliderShape::Capsule ? GetCapsuleHalfLength() : 0;
+		float radius = GetRadius();
+		XMFLOAT3 extents = XMFLOAT3(
+			fabsf(rot._31) * halfLength + radius,
+			fabsf(rot._32) * halfLength + radius,
+			fabsf(rot._33) * halfLength + radius);
+
+		*min = XMFLOAT3(position.x - extents.x, position.y - extents.y, position.z - extents.z);
+		*max = XMFLOAT3(position.x + extents.x, position.y + extents.y, position.z + extents.z);
+		return;
+	}
+
+	XMFLOAT3 half = GetHalfSize();
+
+	//Project the rotated half size onto each world axis
+	XMFLOAT3 extents = XMFLOAT3(
+		fabsf(rot._11) * half.x + fabsf(rot._21) * half.y + fabsf(rot._31) * half.z,
+		fabsf(rot._12) * half.x + fabsf(rot._22) * half.y + fabsf(rot._32) * half.z,
+		fabsf(rot._13) * half.x + fabsf(rot._23) * half.y + fabsf(rot._33) * half.z);
+
+	*min = XMFLOAT3(position.x - extents.x, position.y - extents.y, position.z - extents.z);
+	*max = XMFLOAT3(position.x + extents.x, position.y + extents.y, position.z + extents.z);
+}
+
+// Get the gameobject this collider is on
+GameObject* Collider::GetOwner() const
+{
+	return owner;
+}
+
+// Set the gameobject this collider is on
+void Collider::SetOwner(GameObject* owner)
+{
+	this->owner = owner;
+}
+
+// Get the spatial hash this collider is in
+SpatialHash* Collider::GetSpatialHash() const
+{
+	return spatialHash;
+}
+
+// Get this collider's id
+unsigned int Collider::GetId() const
+{
+	return id;
+}
+
+// Set the collision layer this collider is on and the layers it collides with
+void Collider::SetCollisionLayer(unsigned int layer, unsigned int mask)
+{
+	this->layer = layer;
+	this->mask = mask;
+
+	//The hash keeps track of the layers in each cell
+	if (spatialHash != nullptr)
+	{
+		SpatialHash* hash = spatialHash;
+		hash->Remove(this);
+		hash->Insert(this);
+	}
+}
+
+// Get the collision layer this collider is on
+unsigned int Collider::GetCollisionLayer() const
+{
+	return layer;
+}
+
+// Get the layers this collider collides with
+unsigned int Collider::GetCollisionMask() const
+{
+	return mask;
+}
+
+// Check if the layers of two colliders let them collide
+bool Collider::CanCollideWith(const Collider* other) const
+{
+	return (layer & other->mask) != 0 && (other->layer & mask) != 0;
+}
+
 DirectX::XMVECTOR Collider::GetNormal(DirectX::XMFLOAT4 axis)
 {
 	//return worldMatrix * axis
@@ -111,12 +413,14 @@ void Collider::SetPosition(DirectX::XMFLOAT3 newPosition)
 	XMVECTOR off = XMLoadFloat3(&offset);
 	XMStoreFloat3(&position, XMVectorAdd(newPos, off));
 	worldDirty = true;
+	MarkMoved();
 }
 
 void Collider::SetRotation(DirectX::XMFLOAT4 newRotation)
 {
 	rotation = newRotation;
 	worldDirty = true;
+	MarkMoved();
 }
 
 // Set the collider size.
@@ -125,6 +429,7 @@ void Collider::SetSize(DirectX::XMFLOAT3 newSize)
 	XMVECTOR newDimensions = XMLoadFloat3(&newSize);
 	XMStoreFloat3(&size, newDimensions);
 	worldDirty = true;
+	MarkMoved();
 }
 
 // Check if a collision has occured.
@@ -146,7 +451,50 @@ bool Collider::Collides(Collider* other)
 		position.z - size.z <= otherPosition.z + otherSize.z && position.z + size.z >= otherPosition.z - otherSize.z
 		);*/
 
-	return SAT(other);
+	//Order the pair from simplest shape to box, so each pair of shapes has one test
+	Collider* a = this;
+	Collider* b = other;
+	if (a->shape > b->shape)
+		std::swap(a, b);
+
+	if (b->shape == ColliderShape::Box)
+	{
+		switch (a->shape)
+		{
+		case ColliderShape::Sphere:
+			return PointBoxDistanceSq(a->position, b->GetOrientedBox()) <= a->GetRadius() * a->GetRadius();
+
+		case ColliderShape::Capsule:
+		{
+			XMFLOAT3 start;
+			XMFLOAT3 end;
+			a->GetSegment(&start, &end);
+			return SegmentBoxDistanceSq(start, end, b->GetOrientedBox(), a->GetRadius()) <= a->GetRadius() * a->GetRadius();
+		}
+
+		default:
+			return a->SAT(b);
+		}
+	}
+
+	//Spheres and capsules are both a segment with a radius
+	float radius = a->GetRadius() + b->GetRadius();
+	if (a->shape == ColliderShape::Sphere && b->shape == ColliderShape::Sphere)
+	{
+		XMFLOAT3 diff = Sub(a->position, b->position);
+		return Dot(diff, diff) <= radius * radius;
+	}
+
+	XMFLOAT3 startB;
+	XMFLOAT3 endB;
+	b->GetSegment(&startB, &endB);
+	if (a->shape == ColliderShape::Sphere)
+		return ExtendedMath::PointSegmentDistanceSq(a->position, startB, endB) <= radius * radius;
+
+	XMFLOAT3 startA;
+	XMFLOAT3 endA;
+	a->GetSegment(&startA, &endA);
+	return ExtendedMath::SegmentSegmentDistanceSq(startA, endA, startB, endB) <= radius * radius;
 
 	//Circle Collision
 	/*XMVECTOR thisPos = XMLoadFloat3(&position);
@@ -164,105 +512,9 @@ bool Collider::Collides(Collider* other)
 
 }
 
+// Check if the collider collides with another (OBB separating axis test)
 bool Collider::SAT(Collider* other)
 {
-	//SAT
-	//variables for switching between axes to check
-	float ra;
-	float rb;
-
-	XMFLOAT3X3 rotAinB; //rotation matrix expressing rigidbody B (other) in a's vector space
-	XMFLOAT3X3 subexpressions; //absolute value of rotAinB plus epsilon constant
-
-	//xyz axes for each rigidbody
-	XMVECTOR axesA[3];
-	XMVECTOR axesB[3];
-
-	//Populates axis arrays using helper functions
-	axesA[0] = GetNormal(XMFLOAT4(1, 0, 0, 0)); //x
-	axesA[1] = GetNormal(XMFLOAT4(0, 1, 0, 0)); //y
-	axesA[2] = GetNormal(XMFLOAT4(0, 0, 1, 0)); //z
-	axesB[0] = other->GetNormal(XMFLOAT4(1, 0, 0, 0)); //x
-	axesB[1] = other->GetNormal(XMFLOAT4(0, 1, 0, 0)); //y
-	axesB[2] = other->GetNormal(XMFLOAT4(0, 0, 1, 0)); //z
-
-	//Populates rotAinB
-	for (int i = 0; i < 3; i++)
-		for (int j = 0; j < 3; j++)
-			rotAinB.m[i][j] = XMVectorGetX(XMVector3Dot(axesA[i], axesB[j]));
-
-	//Vector between rigidbodies
-	XMVECTOR translation = XMLoadFloat3(&other->GetPosition()) - XMLoadFloat3(&GetPosition());
-	//Converted into A's vector space
-	float tx = XMVectorGetX(XMVector3Dot(translation, axesA[0]));
-	float ty = XMVectorGetX(XMVector3Dot(translation, axesA[1]));
-	float tz = XMVectorGetX(XMVector3Dot(translation, axesA[2]));
-	translation = XMLoadFloat3(&XMFLOAT3(tx, ty, tz));
-
-	//Populates subexpressions
-	for (int i = 0; i < 3; i++)
-		for (int j = 0; j < 3; j++)
-			subexpressions.m[i][j] = abs(rotAinB.m[i][j]) + std::numeric_limits<float>::epsilon();
-
-	XMVECTOR thisHalf = XMLoadFloat3(&GetHalfSize()); //half size of this collider
-	XMVECTOR otherHalf = XMLoadFloat3(&other->GetHalfSize()); //half size of other collider
-
-	//Checks first three axes (A's xyz)
-	for (int i = 0; i < 3; i++)
-	{
-		ra = XMVectorGetByIndex(thisHalf, i);
-		rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[i][0] + XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[i][1] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[i][2];
-		if (abs(XMVectorGetByIndex(translation, i)) > ra + rb) return false;
-	}
-
-	//Checks next three axes (B's xyz)
-	for (int i = 0; i < 3; i++)
-	{
-		ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[0][i] + XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[1][i] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[2][i];
-		rb = XMVectorGetByIndex(otherHalf, i);
-		if (abs(XMVectorGetByIndex(translation, 0) * rotAinB.m[0][i] + XMVectorGetByIndex(translation, 1) * rotAinB.m[1][i] + XMVectorGetByIndex(translation, 2) * rotAinB.m[2][i]) > ra + rb) return false;
-	}
-
-	//Tests nine more axes
-	//Each axis is the crossproduct of a combination
-	//of two axes from the first six tests
-
-	// Test axis L = A0 x B0
-	ra = XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[2][0] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[1][0];
-	rb = XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[0][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[0][1];
-	if (abs(XMVectorGetByIndex(translation, 2) * rotAinB.m[1][0] - XMVectorGetByIndex(translation, 1) * rotAinB.m[2][0]) > ra + rb) return false;
-	// Test axis L = A0 x B1
-	ra = XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[2][1] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[1][1];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[0][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[0][0];
-	if (abs(XMVectorGetByIndex(translation, 2) * rotAinB.m[1][1] - XMVectorGetByIndex(translation, 1) * rotAinB.m[2][1]) > ra + rb) return false;
-	// Test axis L = A0 x B2
-	ra = XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[2][2] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[1][2];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[0][1] + XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[0][0];
-	if (abs(XMVectorGetByIndex(translation, 2) * rotAinB.m[1][2] - XMVectorGetByIndex(translation, 1) * rotAinB.m[2][2]) > ra + rb) return false;
-	// Test axis L = A1 x B0
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[2][0] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[0][0];
-	rb = XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[1][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[1][1];
-	if (abs(XMVectorGetByIndex(translation, 0) * rotAinB.m[2][0] - XMVectorGetByIndex(translation, 2) * rotAinB.m[0][0]) > ra + rb) return false;
-	// Test axis L = A1 x B1
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[2][1] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[0][1];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[1][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[1][0];
-	if (abs(XMVectorGetByIndex(translation, 0) * rotAinB.m[2][1] - XMVectorGetByIndex(translation, 2) * rotAinB.m[0][1]) > ra + rb) return false;
-	// Test axis L = A1 x B2
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[2][2] + XMVectorGetByIndex(thisHalf, 2) * subexpressions.m[0][2];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[1][1] + XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[1][0];
-	if (abs(XMVectorGetByIndex(translation, 0) * rotAinB.m[2][2] - XMVectorGetByIndex(translation, 2) * rotAinB.m[0][2]) > ra + rb) return false;
-	// Test axis L = A2 x B0
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[1][0] + XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[0][0];
-	rb = XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[2][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[2][1];
-	if (abs(XMVectorGetByIndex(translation, 1) * rotAinB.m[0][0] - XMVectorGetByIndex(translation, 0) * rotAinB.m[1][0]) > ra + rb) return false;
-	// Test axis L = A2 x B1
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[1][1] + XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[0][1];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[2][2] + XMVectorGetByIndex(otherHalf, 2) * subexpressions.m[2][0];
-	if (abs(XMVectorGetByIndex(translation, 1) * rotAinB.m[0][1] - XMVectorGetByIndex(translation, 0) * rotAinB.m[1][1]) > ra + rb) return false;
-	// Test axis L = A2 x B2
-	ra = XMVectorGetByIndex(thisHalf, 0) * subexpressions.m[1][2] + XMVectorGetByIndex(thisHalf, 1) * subexpressions.m[0][2];
-	rb = XMVectorGetByIndex(otherHalf, 0) * subexpressions.m[2][1] + XMVectorGetByIndex(otherHalf, 1) * subexpressions.m[2][0];
-	if (abs(XMVectorGetByIndex(translation, 1) * rotAinB.m[0][2] - XMVectorGetByIndex(translation, 0) * rotAinB.m[1][2]) > ra + rb) return false;
-
-	return true;
+	//Shares the kernel with ColliderBatch so single and batched tests always agree
+	return ColliderBatch::FindSeparatingAxis(GetOrientedBox(), other->GetOrientedBox()) < 0;
 }
@@ -1,24 +1,87 @@
 #pragma once
 #include <DirectXMath.h>
 
+class GameObject;
+class SpatialHash;
+class CollisionManager;
+
+//Collision layers (bitfield). Colliders only collide if each one's
+//layer is in the other's mask
+#define COLLISION_LAYER_DEFAULT 0x1
+#define COLLISION_MASK_ALL 0xFFFFFFFF
+
+//Shapes a collider can have. Spheres and capsules fit inside the
+//collider's size (radius = size.x / 2, capsules run along local z)
+enum class ColliderShape { Sphere, Capsule, Box };
+
+//A collider's box in world space (what SAT tests)
+struct OrientedBox
+{
+	DirectX::XMFLOAT3 center;
+	DirectX::XMFLOAT3 axes[3]; //unit x, y and z axes
+	DirectX::XMFLOAT3 half;
+};
+
 class Collider
 {
+	//Spatial hashes and the collision world keep their bookkeeping on the collider
+	friend class SpatialHash;
+	friend class CollisionManager;
+
 private:
 	//Transform vars
 	DirectX::XMFLOAT3 position; //center
 	DirectX::XMFLOAT4 rotation;
 	DirectX::XMFLOAT3 offset; //(0,0,0) if not given
 	DirectX::XMFLOAT3 size; //xyz = width, height, length
+	ColliderShape shape;
 
 	//World matrices
 	bool worldDirty;
 	DirectX::XMFLOAT4X4 worldMatrix;
 
+	//World space box
+	bool boxDirty;
+	OrientedBox box;
+
+	//The gameobject this collider is on (nullptr if none)
+	GameObject* owner;
+
+	//Collision world vars
+	unsigned int id;       //Order colliders were created in (for sorting contacts)
+	unsigned int layer;
+	unsigned int mask;
+	bool inCollisionWorld;
+	static unsigned int nextId;
+
+	//Broadphase vars
+	SpatialHash* spatialHash;
+	bool hashDirty;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+	int cellMin[3];
+	int cellMax[3];
+
 	// --------------------------------------------------------
 	// Construct this collider's world matrix
 	// --------------------------------------------------------
 	void ConstructWorldMatrix();
 
+	// --------------------------------------------------------
+	// Get half the length of a capsule's segment (without the rounded ends)
+	// --------------------------------------------------------
+	float GetCapsuleHalfLength() const;
+
+	// --------------------------------------------------------
+	// Set the default broadphase values
+	// --------------------------------------------------------
+	void InitBroadphase();
+
+	// --------------------------------------------------------
+	// Tell this collider's spatial hash (if any) that it moved
+	// --------------------------------------------------------
+	void MarkMoved();
+
 public:
 	//Constructors
 
@@ -43,8 +106,10 @@ public:
 	// position - position of the gameobject this collider is attatched to
 	// size - size of the collider
 	// offset - the offset from the center of the gameobject this collider is on
+	// shape - the shape of the collider (fits inside size)
 	// --------------------------------------------------------
-	Collider(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset); //optional center offset
+	Collider(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset,
+		ColliderShape shape = ColliderShape::Box); //optional center offset
 
 	~Collider();
 
@@ -68,6 +133,75 @@ public:
 	// --------------------------------------------------------
 	DirectX::XMFLOAT3 GetHalfSize() const;
 
+	// --------------------------------------------------------
+	// Get the shape of the collider
+	// --------------------------------------------------------
+	ColliderShape GetShape() const;
+
+	// --------------------------------------------------------
+	// Get the radius of a sphere or capsule collider (size.x / 2)
+	// --------------------------------------------------------
+	float GetRadius() const;
+
+	// --------------------------------------------------------
+	// Get the world space line a capsule is swept along
+	// (both ends are the center for spheres and boxes)
+	// --------------------------------------------------------
+	void GetSegment(DirectX::XMFLOAT3* start, DirectX::XMFLOAT3* end);
+
+	// --------------------------------------------------------
+	// Get the collider's box in world space
+	// --------------------------------------------------------
+	const OrientedBox& GetOrientedBox();
+
+	// --------------------------------------------------------
+	// Get the world space axis aligned box around the collider
+	// --------------------------------------------------------
+	void GetBounds(DirectX::XMFLOAT3* min, DirectX::XMFLOAT3* max) const;
+
+	// --------------------------------------------------------
+	// Get the gameobject this collider is on (nullptr if none)
+	// --------------------------------------------------------
+	GameObject* GetOwner() const;
+
+	// --------------------------------------------------------
+	// Set the gameobject this collider is on
+	// --------------------------------------------------------
+	void SetOwner(GameObject* owner);
+
+	// --------------------------------------------------------
+	// Get the spatial hash this collider is in (nullptr if none)
+	// --------------------------------------------------------
+	SpatialHash* GetSpatialHash() const;
+
+	// --------------------------------------------------------
+	// Get this collider's id (colliders created later have higher ids)
+	// --------------------------------------------------------
+	unsigned int GetId() const;
+
+	// --------------------------------------------------------
+	// Set the collision layer this collider is on and the layers it collides with
+	//
+	// layer - bit(s) for this collider's layer
+	// mask - bits of the layers this collider collides with
+	// --------------------------------------------------------
+	void SetCollisionLayer(unsigned int layer, unsigned int mask = COLLISION_MASK_ALL);
+
+	// --------------------------------------------------------
+	// Get the collision layer this collider is on
+	// --------------------------------------------------------
+	unsigned int GetCollisionLayer() const;
+
+	// --------------------------------------------------------
+	// Get the layers this collider collides with
+	// --------------------------------------------------------
+	unsigned int GetCollisionMask() const;
+
+	// --------------------------------------------------------
+	// Check if the layers of two colliders let them collide
+	// --------------------------------------------------------
+	bool CanCollideWith(const Collider* other) const;
+
 	DirectX::XMVECTOR GetNormal(DirectX::XMFLOAT4 axis);
 
 	DirectX::XMVECTOR GetCenterGlobal();
@@ -88,10 +222,15 @@ public:
 	void SetSize(DirectX::XMFLOAT3 newSize);
 
 	// --------------------------------------------------------
-	// Check if the collider collides with another (AABB)
+	// Check if the collider collides with another, using the cheapest
+	// test for the two shapes (closed form for spheres and capsules,
+	// SAT for two boxes)
 	// --------------------------------------------------------
-	bool Collides(Collider* other); //AABB for now
+	bool Collides(Collider* other);
 
+	// --------------------------------------------------------
+	// Check if the collider collides with another (OBB separating axis test)
+	// --------------------------------------------------------
 	bool SAT(Collider* other);
 
 
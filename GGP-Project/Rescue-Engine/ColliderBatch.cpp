@@ -0,0 +1,324 @@
+#include "ColliderBatch.h"
+#include "SIMDLanes.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+//Widest lane count, batches are padded to a multiple of this
+#define MAX_LANES 8
+
+//Starting capacity of a batch
+#define DEFAULT_BATCH_CAPACITY 64
+
+#define FIELD(f) ((int)BatchField::f)
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// SAT kernel - tests box a against L::Width boxes at once.
+// Based on the OBB test in Real-Time Collision Detection (Ericson)
+//
+// a - the box to test
+// b - the first field of the boxes to test against
+// stride - distance between fields of b
+// separatingAxes - filled with L::Width results
+// --------------------------------------------------------
+template<typename L>
+static void SATKernel(const OrientedBox& a, const float* b, size_t stride, int* separatingAxes)
+{
+	typedef typename L::F F;
+	const int allLanes = (1 << L::Width) - 1;
+
+	for (int lane = 0; lane < L::Width; lane++)
+	{
+		separatingAxes[lane] = -1;
+	}
+
+	//Box b's values
+	F bAxes[3][3];
+	F bHalf[3];
+	for (int j = 0; j < 3; j++)
+	{
+		bAxes[j][0] = L::Load(b + (FIELD(Axis0X) + j * 3) * stride);
+		bAxes[j][1] = L::Load(b + (FIELD(Axis0Y) + j * 3) * stride);
+		bAxes[j][2] = L::Load(b + (FIELD(Axis0Z) + j * 3) * stride);
+		bHalf[j] = L::Load(b + (FIELD(HalfX) + j) * stride);
+	}
+
+	//Rotation expressing b in a's space, and its absolute value
+	//(plus epsilon for when two axes are near parallel)
+	const float* aAxes[3] = { &a.axes[0].x, &a.axes[1].x, &a.axes[2].x };
+	F rot[3][3];
+	F absRot[3][3];
+	F epsilon = L::Set(FLT_EPSILON);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+		{
+			rot[i][j] = L::Add(L::Add(
+				L::Mul(L::Set(aAxes[i][0]), bAxes[j][0]),
+				L::Mul(L::Set(aAxes[i][1]), bAxes[j][1])),
+				L::Mul(L::Set(aAxes[i][2]), bAxes[j][2]));
+			absRot[i][j] = L::Add(L::Abs(rot[i][j]), epsilon);
+		}
+
+	//Vector between the boxes in a's space
+	F dist[3] = {
+		L::Sub(L::Load(b + FIELD(CenterX) * stride), L::Set(a.center.x)),
+		L::Sub(L::Load(b + FIELD(CenterY) * stride), L::Set(a.center.y)),
+		L::Sub(L::Load(b + FIELD(CenterZ) * stride), L::Set(a.center.z)) };
+	F t[3];
+	for (int i = 0; i < 3; i++)
+	{
+		t[i] = L::Add(L::Add(
+			L::Mul(dist[0], L::Set(aAxes[i][0])),
+			L::Mul(dist[1], L::Set(aAxes[i][1]))),
+			L::Mul(dist[2], L::Set(aAxes[i][2])));
+	}
+
+	F aHalf[3] = { L::Set(a.half.x), L::Set(a.half.y), L::Set(a.half.z) };
+
+	//Mark the lanes an axis separates, returns true once every lane is separated
+	int separated = 0;
+	auto separates = [&](int axis, F distance, F ra, F rb)
+	{
+		int newlySeparated = L::Greater(L::Abs(distance), L::Add(ra, rb)) & ~separated;
+		if (newlySeparated != 0)
+		{
+			for (int lane = 0; lane < L::Width; lane++)
+			{
+				if (newlySeparated & (1 << lane))
+					separatingAxes[lane] = axis;
+			}
+			separated |= newlySeparated;
+		}
+		return separated == allLanes;
+	};
+
+	//Check a's axes
+	for (int i = 0; i < 3; i++)
+	{
+		F rb = L::Add(L::Add(
+			L::Mul(bHalf[0], absRot[i][0]),
+			L::Mul(bHalf[1], absRot[i][1])),
+			L::Mul(bHalf[2], absRot[i][2]));
+		if (separates(i, t[i], aHalf[i], rb)) return;
+	}
+
+	//Check b's axes
+	for (int j = 0; j < 3; j++)
+	{
+		F ra = L::Add(L::Add(
+			L::Mul(aHalf[0], absRot[0][j]),
+			L::Mul(aHalf[1], absRot[1][j])),
+			L::Mul(aHalf[2], absRot[2][j]));
+		F distance = L::Add(L::Add(
+			L::Mul(t[0], rot[0][j]),
+			L::Mul(t[1], rot[1][j])),
+			L::Mul(t[2], rot[2][j]));
+		if (separates(3 + j, distance, ra, bHalf[j])) return;
+	}
+
+	//Check the cross products of a's and b's axes
+	for (int i = 0; i < 3; i++)
+	{
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++)
+		{
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+			F ra = L::Add(L::Mul(aHalf[i1], absRot[i2][j]), L::Mul(aHalf[i2], absRot[i1][j]));
+			F rb = L::Add(L::Mul(bHalf[j1], absRot[i][j2]), L::Mul(bHalf[j2], absRot[i][j1]));
+			F distance = L::Sub(L::Mul(t[i2], rot[i1][j]), L::Mul(t[i1], rot[i2][j]));
+			if (separates(6 + i * 3 + j, distance, ra, rb)) return;
+		}
+	}
+}
+
+// Write a box's fields at a stride
+static void StoreBox(const OrientedBox& box, float* fields, size_t stride)
+{
+	const float values[(int)BatchField::Count] = {
+		box.center.x, box.center.y, box.center.z,
+		box.axes[0].x, box.axes[0].y, box.axes[0].z,
+		box.axes[1].x, box.axes[1].y, box.axes[1].z,
+		box.axes[2].x, box.axes[2].y, box.axes[2].z,
+		box.half.x, box.half.y, box.half.z };
+
+	for (int f = 0; f < (int)BatchField::Count; f++)
+	{
+		fields[f * stride] = values[f];
+	}
+}
+
+// Set up an empty batch
+ColliderBatch::ColliderBatch()
+{
+	count = 0;
+	capacity = DEFAULT_BATCH_CAPACITY;
+	fields.resize((int)BatchField::Count * capacity);
+}
+
+// Remove every box from the batch (keeps the memory)
+void ColliderBatch::Clear()
+{
+	count = 0;
+	colliders.clear();
+}
+
+// Add a collider's box to the batch
+void ColliderBatch::Add(Collider* collider)
+{
+	Add(collider->GetOrientedBox());
+	colliders[count - 1] = collider;
+}
+
+// Add a box that isn't on a collider to the batch
+void ColliderBatch::Add(const OrientedBox& box)
+{
+	//Grow, keeping room for a full set of lanes past the end
+	if (count + MAX_LANES > capacity)
+	{
+		int newCapacity = capacity * 2;
+		std::vector<float> newFields((int)BatchField::Count * newCapacity);
+		for (int f = 0; f < (int)BatchField::Count; f++)
+		{
+			std::copy(fields.begin() + f * capacity, fields.begin() + f * capacity + count,
+				newFields.begin() + f * newCapacity);
+		}
+		fields.swap(newFields);
+		capacity = newCapacity;
+	}
+
+	StoreBox(box, fields.data() + count, capacity);
+	colliders.push_back(nullptr);
+	count++;
+}
+
+// Get the amount of boxes in the batch
+int ColliderBatch::GetCount()
+{
+	return count;
+}
+
+// Get the collider a box came from
+Collider* ColliderBatch::GetCollider(int index)
+{
+	return colliders[index];
+}
+
+// Test a box against every box in the batch with SIMD
+void ColliderBatch::Test(const OrientedBox& box, int* separatingAxes)
+{
+	int i = 0;
+
+#ifdef BATCH_AVX
+	for (; i + AVXLanes::Width <= count; i += AVXLanes::Width)
+	{
+		SATKernel<AVXLanes>(box, fields.data() + i, capacity, separatingAxes + i);
+	}
+#endif
+
+#ifdef BATCH_SSE
+	//The last partial set reads into the padding and ignores it
+	int lanes[SSELanes::Width];
+	for (; i < count; i += SSELanes::Width)
+	{
+		SATKernel<SSELanes>(box, fields.data() + i, capacity, lanes);
+		std::copy(lanes, lanes + std::min(SSELanes::Width, count - i), separatingAxes + i);
+	}
+#else
+	TestScalar(box, separatingAxes);
+#endif
+}
+
+// Test a box against every box in the batch one at a time
+void ColliderBatch::TestScalar(const OrientedBox& box, int* separatingAxes)
+{
+	for (int i = 0; i < count; i++)
+	{
+		SATKernel<ScalarLanes>(box, fields.data() + i, capacity, separatingAxes + i);
+	}
+}
+
+// Get the first of the 15 SAT axes that separates two boxes
+int ColliderBatch::FindSeparatingAxis(const OrientedBox& a, const OrientedBox& b)
+{
+	float fields[(int)BatchField::Count];
+	StoreBox(b, fields, 1);
+
+	int separatingAxis;
+	SATKernel<ScalarLanes>(a, fields, 1, &separatingAxis);
+	return separatingAxis;
+}
+
+// Check if a single SAT axis separates two boxes
+bool ColliderBatch::SeparatesOnAxis(const OrientedBox& a, const OrientedBox& b, int axis)
+{
+	//Same operations in the same order as SATKernel, but only
+	//working out the parts of the rotation this axis needs
+	const float* aAxes[3] = { &a.axes[0].x, &a.axes[1].x, &a.axes[2].x };
+	const float* bAxes[3] = { &b.axes[0].x, &b.axes[1].x, &b.axes[2].x };
+	const float aHalf[3] = { a.half.x, a.half.y, a.half.z };
+	const float bHalf[3] = { b.half.x, b.half.y, b.half.z };
+	const float dist[3] = { b.center.x - a.center.x, b.center.y - a.center.y, b.center.z - a.center.z };
+
+	auto rot = [&](int i, int j)
+	{
+		return aAxes[i][0] * bAxes[j][0] + aAxes[i][1] * bAxes[j][1] + aAxes[i][2] * bAxes[j][2];
+	};
+	auto absRot = [&](int i, int j)
+	{
+		return fabsf(rot(i, j)) + FLT_EPSILON;
+	};
+	auto t = [&](int i)
+	{
+		return dist[0] * aAxes[i][0] + dist[1] * aAxes[i][1] + dist[2] * aAxes[i][2];
+	};
+
+	float distance;
+	float ra;
+	float rb;
+	if (axis < 3)
+	{
+		//One of a's axes
+		ra = aHalf[axis];
+		rb = bHalf[0] * absRot(axis, 0) + bHalf[1] * absRot(axis, 1) + bHalf[2] * absRot(axis, 2);
+		distance = t(axis);
+	}
+	else if (axis < 6)
+	{
+		//One of b's axes
+		int j = axis - 3;
+		ra = aHalf[0] * absRot(0, j) + aHalf[1] * absRot(1, j) + aHalf[2] * absRot(2, j);
+		rb = bHalf[j];
+		distance = t(0) * rot(0, j) + t(1) * rot(1, j) + t(2) * rot(2, j);
+	}
+	else
+	{
+		//The cross product of a's axis i and b's axis j
+		int i = (axis - 6) / 3;
+		int j = (axis - 6) % 3;
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		int j1 = (j + 1) % 3;
+		int j2 = (j + 2) % 3;
+		ra = aHalf[i1] * absRot(i2, j) + aHalf[i2] * absRot(i1, j);
+		rb = bHalf[j1] * absRot(i, j2) + bHalf[j2] * absRot(i, j1);
+		distance = t(i2) * rot(i1, j) - t(i1) * rot(i2, j);
+	}
+
+	return fabsf(distance) > ra + rb;
+}
+
+// Get the widest lane count Test() runs with
+int ColliderBatch::GetLaneCount()
+{
+#if defined(BATCH_AVX)
+	return AVXLanes::Width;
+#elif defined(BATCH_SSE)
+	return SSELanes::Width;
+#else
+	return ScalarLanes::Width;
+#endif
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include "Collider.h"
+
+//Amount of axes the OBB separating axis test checks
+//(3 for each box and 9 cross products)
+#define SAT_AXIS_COUNT 15
+
+//Fields of a box stored in a collider batch
+enum class BatchField
+{
+	CenterX, CenterY, CenterZ,
+	Axis0X, Axis0Y, Axis0Z,
+	Axis1X, Axis1Y, Axis1Z,
+	Axis2X, Axis2Y, Axis2Z,
+	HalfX, HalfY, HalfZ,
+	Count
+};
+
+// --------------------------------------------------------
+// A structure of arrays of oriented boxes for testing one box
+// against many with SIMD.
+//
+// The SAT kernel is written once and run on single floats
+// (the scalar path Collider::SAT uses), 4 lanes (SSE) or
+// 8 lanes (AVX, when compiled with it). Every lane does the same
+// operations in the same order as the scalar path, so the results
+// are bit-for-bit the same
+// --------------------------------------------------------
+class ColliderBatch
+{
+private:
+	//Every field's array back to back (field f starts at f * capacity),
+	//with room past the end so the last lanes can always be loaded
+	std::vector<float> fields;
+	std::vector<Collider*> colliders;
+	int count;
+	int capacity;
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty batch
+	// --------------------------------------------------------
+	ColliderBatch();
+
+	// --------------------------------------------------------
+	// Remove every box from the batch (keeps the memory)
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Add a collider's box to the batch
+	// --------------------------------------------------------
+	void Add(Collider* collider);
+
+	// --------------------------------------------------------
+	// Add a box that isn't on a collider to the batch
+	// --------------------------------------------------------
+	void Add(const OrientedBox& box);
+
+	// --------------------------------------------------------
+	// Get the amount of boxes in the batch
+	// --------------------------------------------------------
+	int GetCount();
+
+	// --------------------------------------------------------
+	// Get the collider a box came from (nullptr if it wasn't added from one)
+	// --------------------------------------------------------
+	Collider* GetCollider(int index);
+
+	// --------------------------------------------------------
+	// Test a box against every box in the batch with SIMD
+	//
+	// box - the box to test
+	// separatingAxes - filled with GetCount() results, the index (0-14)
+	//					of the first axis that separates the boxes or
+	//					-1 if they collide
+	// --------------------------------------------------------
+	void Test(const OrientedBox& box, int* separatingAxes);
+
+	// --------------------------------------------------------
+	// Test a box against every box in the batch one at a time
+	// (for checking and benchmarking the SIMD path)
+	// --------------------------------------------------------
+	void TestScalar(const OrientedBox& box, int* separatingAxes);
+
+	// --------------------------------------------------------
+	// Get the first of the 15 SAT axes that separates two boxes
+	// (-1 if they collide)
+	// --------------------------------------------------------
+	static int FindSeparatingAxis(const OrientedBox& a, const OrientedBox& b);
+
+	// --------------------------------------------------------
+	// Check if a single SAT axis (0-14) separates two boxes.
+	// Only works out what that axis needs, so it's much cheaper
+	// than a full test
+	// --------------------------------------------------------
+	static bool SeparatesOnAxis(const OrientedBox& a, const OrientedBox& b, int axis);
+
+	// --------------------------------------------------------
+	// Get the widest lane count Test() runs with
+	// --------------------------------------------------------
+	static int GetLaneCount();
+};
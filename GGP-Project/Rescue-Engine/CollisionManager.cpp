@@ -0,0 +1,176 @@
+#include "CollisionManager.h"
+#include "GameObject.h"
+#include <algorithm>
+
+// Check if a contact comes before another (by collider ids)
+static bool ContactLess(const ContactPair& a, const ContactPair& b)
+{
+	if (a.a->GetId() != b.a->GetId())
+		return a.a->GetId() < b.a->GetId();
+	return a.b->GetId() < b.b->GetId();
+}
+
+// Check if the gameobjects on both colliders of a contact are enabled
+static bool ContactEnabled(const ContactPair& contact)
+{
+	GameObject* ownerA = contact.a->GetOwner();
+	GameObject* ownerB = contact.b->GetOwner();
+	return ownerA != nullptr && ownerB != nullptr && ownerA->GetEnabled() && ownerB->GetEnabled();
+}
+
+// Set up the singleton instance of the collision world
+CollisionManager::CollisionManager()
+{
+	candidateCount = 0;
+}
+
+// Add a collider to the world
+void CollisionManager::AddCollider(Collider* collider)
+{
+	if (collider->inCollisionWorld)
+		return;
+
+	spatialHash.Insert(collider);
+	collider->inCollisionWorld = true;
+}
+
+// Remove a collider from the world
+void CollisionManager::RemoveCollider(Collider* collider)
+{
+	if (!collider->inCollisionWorld)
+		return;
+
+	spatialHash.Remove(collider);
+	collider->inCollisionWorld = false;
+
+	//Forget its contacts so no events are sent to it later
+	auto touches = [collider](const ContactPair& contact) { return contact.a == collider || contact.b == collider; };
+	contacts.erase(std::remove_if(contacts.begin(), contacts.end(), touches), contacts.end());
+	previousContacts.erase(std::remove_if(previousContacts.begin(), previousContacts.end(), touches), previousContacts.end());
+}
+
+// Run the broadphase and narrowphase to fill the contact list
+void CollisionManager::FindContacts()
+{
+	contacts.clear();
+
+	//Broadphase (already filtered by layer), lower id first.
+	//Disabled gameobjects don't collide
+	spatialHash.QueryPairs(candidatePairs);
+	candidateCount = (int)candidatePairs.size();
+	for (size_t i = 0; i < candidatePairs.size(); i++)
+	{
+		ContactPair pair = { candidatePairs[i].a, candidatePairs[i].b };
+		if (!ContactEnabled(pair))
+			continue;
+		if (pair.a->GetId() > pair.b->GetId())
+			std::swap(pair.a, pair.b);
+		contacts.push_back(pair);
+	}
+
+	//Sort so the results don't depend on where colliders are in memory
+	std::sort(contacts.begin(), contacts.end(), ContactLess);
+
+	//Narrowphase. Spheres and capsules have closed form tests, and each
+	//box is tested against all the boxes it might touch at once
+	size_t kept = 0;
+	touching.resize(contacts.size());
+	for (size_t start = 0; start < contacts.size(); )
+	{
+		Collider* a = contacts[start].a;
+		size_t end = start;
+		boxBatch.Clear();
+		boxIndices.clear();
+		while (end < contacts.size() && contacts[end].a == a)
+		{
+			Collider* b = contacts[end].b;
+			if (a->GetShape() != ColliderShape::Box || b->GetShape() != ColliderShape::Box)
+				touching[end] = a->Collides(b);
+			else
+			{
+				boxBatch.Add(b);
+				boxIndices.push_back(end);
+			}
+			end++;
+		}
+
+		if (boxBatch.GetCount() > 0)
+		{
+			separatingAxes.resize(boxBatch.GetCount());
+			boxBatch.Test(a->GetOrientedBox(), separatingAxes.data());
+			for (size_t i = 0; i < boxIndices.size(); i++)
+			{
+				touching[boxIndices[i]] = separatingAxes[i] < 0;
+			}
+		}
+
+		for (size_t i = start; i < end; i++)
+		{
+			if (touching[i])
+				contacts[kept++] = contacts[i];
+		}
+		start = end;
+	}
+	contacts.resize(kept);
+}
+
+// Compare this tick's contacts to last tick's and send events
+void CollisionManager::DispatchEvents()
+{
+	//Both lists are sorted, so walk them together
+	size_t current = 0;
+	size_t previous = 0;
+	while (current < contacts.size() || previous < previousContacts.size())
+	{
+		//Only in the last tick
+		if (current == contacts.size() ||
+			(previous < previousContacts.size() && ContactLess(previousContacts[previous], contacts[current])))
+		{
+			const ContactPair& contact = previousContacts[previous++];
+			contact.a->GetOwner()->OnCollisionExit(contact.b->GetOwner());
+			contact.b->GetOwner()->OnCollisionExit(contact.a->GetOwner());
+			continue;
+		}
+
+		//In both ticks
+		const ContactPair& contact = contacts[current++];
+		if (previous < previousContacts.size() && !ContactLess(contact, previousContacts[previous]))
+		{
+			previous++;
+			contact.a->GetOwner()->OnCollisionStay(contact.b->GetOwner());
+			contact.b->GetOwner()->OnCollisionStay(contact.a->GetOwner());
+		}
+		//Only in this tick
+		else
+		{
+			contact.a->GetOwner()->OnCollisionEnter(contact.b->GetOwner());
+			contact.b->GetOwner()->OnCollisionEnter(contact.a->GetOwner());
+		}
+	}
+}
+
+// Find every touching pair and send collision events
+void CollisionManager::Update()
+{
+	std::swap(contacts, previousContacts);
+	FindContacts();
+	DispatchEvents();
+}
+
+// Get the pairs that were touching during the last update
+const std::vector<ContactPair>& CollisionManager::GetContacts()
+{
+	return contacts;
+}
+
+// Get the amount of pairs the broadphase found last update
+int CollisionManager::GetCandidateCount()
+{
+	return candidateCount;
+}
+
+// Get the broadphase every collider in the world is in
+SpatialHash* CollisionManager::GetSpatialHash()
+{
+	return &spatialHash;
+}
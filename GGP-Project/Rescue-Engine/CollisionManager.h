@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include "Collider.h"
+#include "SpatialHash.h"
+#include "ColliderBatch.h"
+
+//Two colliders touching during a tick (a has the lower id)
+struct ContactPair
+{
+	Collider* a;
+	Collider* b;
+};
+
+// --------------------------------------------------------
+// Singleton
+//
+// The collision world. Every gameobject collider is registered
+// here, and once per tick the world finds every touching pair
+// (broadphase, then the shape tests) and sends the gameobjects
+// involved OnCollisionEnter/Stay/Exit events.
+//
+// Pairs are only tested if each collider's layer is in the
+// other's mask, and only if both gameobjects are enabled.
+// Contacts are sorted by collider id, so events are sent in
+// the same order every run
+// --------------------------------------------------------
+class CollisionManager
+{
+private:
+	//Broadphase and narrowphase
+	SpatialHash spatialHash;
+	ColliderBatch boxBatch;
+	std::vector<ColliderPair> candidatePairs;
+	std::vector<size_t> boxIndices;
+	std::vector<int> separatingAxes;
+	std::vector<char> touching;
+
+	//Touching pairs this tick and last tick (sorted by collider id)
+	std::vector<ContactPair> contacts;
+	std::vector<ContactPair> previousContacts;
+
+	//Stats for the last tick
+	int candidateCount;
+
+	// --------------------------------------------------------
+	// Singleton Constructor - Set up the singleton instance of the collision world
+	// --------------------------------------------------------
+	CollisionManager();
+	~CollisionManager() { }
+
+	// --------------------------------------------------------
+	// Run the broadphase and narrowphase to fill the contact list
+	// --------------------------------------------------------
+	void FindContacts();
+
+	// --------------------------------------------------------
+	// Compare this tick's contacts to last tick's and send events
+	// --------------------------------------------------------
+	void DispatchEvents();
+
+public:
+	// --------------------------------------------------------
+	// Get the singleton instance of the collision world
+	// --------------------------------------------------------
+	static CollisionManager* GetInstance()
+	{
+		static CollisionManager instance;
+
+		return &instance;
+	}
+
+	//Delete this
+	CollisionManager(CollisionManager const&) = delete;
+	void operator=(CollisionManager const&) = delete;
+
+	// --------------------------------------------------------
+	// Add a collider to the world
+	// --------------------------------------------------------
+	void AddCollider(Collider* collider);
+
+	// --------------------------------------------------------
+	// Remove a collider from the world (no exit events are sent for it)
+	// --------------------------------------------------------
+	void RemoveCollider(Collider* collider);
+
+	// --------------------------------------------------------
+	// Find every touching pair and send collision events.
+	// Call once per simulation step, after everything has moved.
+	// Colliders can't be deleted from inside an event
+	// --------------------------------------------------------
+	void Update();
+
+	// --------------------------------------------------------
+	// Get the pairs that were touching during the last update
+	// (sorted by collider id)
+	// --------------------------------------------------------
+	const std::vector<ContactPair>& GetContacts();
+
+	// --------------------------------------------------------
+	// Get the amount of pairs the broadphase found last update
+	// --------------------------------------------------------
+	int GetCandidateCount();
+
+	// --------------------------------------------------------
+	// Get the broadphase every collider in the world is in
+	// --------------------------------------------------------
+	SpatialHash* GetSpatialHash();
+};
@@ -1,5 +1,8 @@
-#include "Renderer.h"
+#include "Entity.h"
 #include "EntityManager.h"
+#ifndef HEADLESS
+#include "Renderer.h"
+#endif
 #include <sstream> 
 
 // For the DirectX Math library
@@ -20,8 +23,13 @@ Entity::Entity(Mesh* mesh, Material* material)
 	std::string temp = ss.str();
 	identifier = ss.str();
 
+	awake = true;
+	inUpdateLists = false;
+	isStatic = false;
 
+#ifndef HEADLESS
 	Renderer::GetInstance()->AddEntityToRenderer(this);
+#endif
 	EntityManager::GetInstance()->AddEntity(this);
 }
 
@@ -35,7 +43,63 @@ Entity::Entity(Mesh * mesh, Material * material, std::string name)
 // Destructor for when an instance is deleted
 Entity::~Entity()
 { 
+#ifndef HEADLESS
 	Renderer::GetInstance()->RemoveEntityFromRenderer(this);
+#endif
+	TimerWheel::GetInstance()->Cancel(wakeTimer);
+}
+
+// Put this entity to sleep
+void Entity::Sleep(float wakeAfter)
+{
+	//Already asleep with no timer to set
+	if (!awake && wakeAfter < 0)
+		return;
+
+	//A new sleep replaces the last one's timer
+	TimerWheel::GetInstance()->Cancel(wakeTimer);
+	if (wakeAfter >= 0)
+		wakeTimer = TimerWheel::GetInstance()->Schedule(wakeAfter, [this]() { Wake(); });
+
+	if (!awake)
+		return;
+	awake = false;
+	EntityManager::GetInstance()->OnSleep(this);
+}
+
+// Wake this entity up
+void Entity::Wake()
+{
+	TimerWheel::GetInstance()->Cancel(wakeTimer);
+	if (awake)
+		return;
+
+	awake = true;
+	EntityManager::GetInstance()->OnWake(this);
+}
+
+// Check if this entity is awake
+bool Entity::IsAwake()
+{
+	return awake;
+}
+
+// Set whether this entity never moves
+void Entity::SetStatic(bool isStatic)
+{
+#ifndef HEADLESS
+	//The cached shadows have to be redrawn with (or without) this entity
+	bool wasStatic = this->isStatic;
+	if (wasStatic || isStatic)
+		Renderer::GetInstance()->InvalidateStaticShadows();
+#endif
+	this->isStatic = isStatic;
+}
+
+// Check if this entity never moves
+bool Entity::IsStatic()
+{
+	return isStatic;
 }
 
 // Get the material this entity uses
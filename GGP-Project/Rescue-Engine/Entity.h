@@ -1,8 +1,11 @@
 #pragma once
 
 #include <DirectXMath.h>
-#include "Mesh.h"
-#include "Material.h"
+#include "GameObject.h"
+#include "TimerWheel.h"
+
+class Mesh;
+class Material;
 
 // --------------------------------------------------------
 // A entity definition.
@@ -16,6 +19,13 @@ private:
 	Mesh* mesh;
 	Material* material;
 	std::string identifier;
+	bool isStatic;       //Never moves, so its shadows can be cached
+
+	//Activity
+	bool awake;
+	bool inUpdateLists;       //Whether the EntityManager's phase lists have this entity
+	TimerHandle wakeTimer;       //Wakes the entity up on its own
+	friend class EntityManager;
 
 public:
 	// --------------------------------------------------------
@@ -42,6 +52,39 @@ public:
 	// --------------------------------------------------------
 	~Entity();
 
+	// --------------------------------------------------------
+	// Put this entity to sleep. Sleeping entities are taken out of
+	// the EntityManager's update lists (at the start of its next
+	// update), so they cost nothing per frame until they're woken
+	//
+	// wakeAfter - seconds until it wakes up on its own (negative to
+	//			   sleep until Wake is called)
+	// --------------------------------------------------------
+	void Sleep(float wakeAfter = -1);
+
+	// --------------------------------------------------------
+	// Wake this entity up. It's updated again from the
+	// EntityManager's next update
+	// --------------------------------------------------------
+	void Wake();
+
+	// --------------------------------------------------------
+	// Check if this entity is awake
+	// --------------------------------------------------------
+	bool IsAwake();
+
+	// --------------------------------------------------------
+	// Set whether this entity never moves. Static entities' shadows
+	// are drawn once and cached, so move them before this is set
+	// (or set it again after)
+	// --------------------------------------------------------
+	void SetStatic(bool isStatic);
+
+	// --------------------------------------------------------
+	// Check if this entity never moves
+	// --------------------------------------------------------
+	bool IsStatic();
+
 	// --------------------------------------------------------
 	// Get the material this entity uses
 	// --------------------------------------------------------
@@ -1,11 +1,33 @@
 #include "EntityManager.h"
+#include "JobSystem.h"
+#include "CollisionManager.h"
+#include "TimerWheel.h"
+#include <chrono>
+#include <algorithm>
+
+//Amount of entities handed to a worker thread at a time
+#define PARALLEL_UPDATE_CHUNK 64
+
+//FNV-1a hashing
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+//Sets up the Entity Manager.
+EntityManager::EntityManager()
+{
+	//Make sure the collision world outlives the entities whose colliders are in it
+	CollisionManager::GetInstance();
+
+	//...and the timer wheel their wake timers are on
+	TimerWheel::GetInstance();
+}
 
 //Releases the entities in the Entity Manager.
 EntityManager::~EntityManager()
 {
 	for (auto i = 0; i < entities.size(); i++)
 	{
-		if (entities[i]) { delete[] entities[i]; }
+		if (entities[i]) { delete entities[i]; }
 	}
 }
 
@@ -21,6 +43,44 @@ void EntityManager::AddEntity(Entity* e)
 
 	//Add to the list
 	entities.push_back(e);
+	updateListsDirty = true;
+}
+
+//Gets the amount of entities in the Entity Manager
+int EntityManager::GetEntityCount()
+{
+	return (int)entities.size();
+}
+
+//Hash the transform and enabled state of every entity (in order)
+unsigned long long EntityManager::GetWorldChecksum()
+{
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+	};
+
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		Entity* e = entities[i];
+		DirectX::XMFLOAT3 position = e->GetPosition();
+		DirectX::XMFLOAT4 rotation = e->GetRotation();
+		DirectX::XMFLOAT3 scale = e->GetScale();
+		bool enabled = e->GetEnabled();
+
+		hashBytes(&position, sizeof(position));
+		hashBytes(&rotation, sizeof(rotation));
+		hashBytes(&scale, sizeof(scale));
+		hashBytes(&enabled, sizeof(enabled));
+	}
+
+	return hash;
 }
 
 //Gets an entity from the Entity Manager with a certain name.
@@ -44,6 +104,17 @@ void EntityManager::RemoveEntityFromList(Entity* entity, bool release)
 
 	//Erase entity
 	entities.erase(it);
+	RemoveUpdateDependencies(entity);
+	for (auto& pair : dependencies)
+	{
+		std::vector<Entity*>& list = pair.second;
+		list.erase(std::remove(list.begin(), list.end(), entity), list.end());
+	}
+	updateListsDirty = true;
+
+	//Forget its activity
+	wokenEntities.erase(std::remove(wokenEntities.begin(), wokenEntities.end(), entity), wokenEntities.end());
+	TimerWheel::GetInstance()->Cancel(entity->wakeTimer);
 
 	//Delete instance if user wants to
 	if (release)
@@ -60,6 +131,7 @@ void EntityManager::RemoveEntity(std::string name, bool deleteEntity)
 		if (entities[i]->GetName() == name)
 		{
 			entities[i]->SetEnabled(false);
+			std::lock_guard<std::mutex> lock(removeMutex);
 			remove_entities.push_back(EntityRemoval{ entities[i], deleteEntity });
 			return;
 		}
@@ -80,27 +152,290 @@ void EntityManager::RemoveEntity(Entity* entity, bool deleteEntity)
 	}
 
 	entity->SetEnabled(false);
+	std::lock_guard<std::mutex> lock(removeMutex);
 	remove_entities.push_back(EntityRemoval{entity, deleteEntity});
 	return;
 }
 
-// Run Update() for all entities in the manager
-void EntityManager::Update(float deltaTime)
+// Declare that an entity reads from another entity during its update
+void EntityManager::AddUpdateDependency(Entity* entity, Entity* dependsOn)
+{
+	if (entity == dependsOn)
+		return;
+
+	std::vector<Entity*>& list = dependencies[entity];
+	if (std::find(list.begin(), list.end(), dependsOn) != list.end())
+		return;
+
+	list.push_back(dependsOn);
+	updateListsDirty = true;
+}
+
+// Remove all of an entity's update dependencies
+void EntityManager::RemoveUpdateDependencies(Entity* entity)
+{
+	if (dependencies.erase(entity) > 0)
+		updateListsDirty = true;
+}
+
+// Tell the manager to rebuild its phase lists before the next update
+void EntityManager::MarkUpdateListsDirty()
+{
+	updateListsDirty = true;
+}
+
+// Called by an entity when it falls asleep
+void EntityManager::OnSleep(Entity* entity)
+{
+	std::lock_guard<std::mutex> lock(activityMutex);
+	if (entity->inUpdateLists)
+		sleepersInLists = true;
+}
+
+// Called by an entity when it wakes up
+void EntityManager::OnWake(Entity* entity)
+{
+	std::lock_guard<std::mutex> lock(activityMutex);
+	if (!entity->inUpdateLists)
+		wokenEntities.push_back(entity);
+}
+
+// Get the amount of entities in the update lists
+int EntityManager::GetActiveCount()
+{
+	return activeCount;
+}
+
+// Get the time (in milliseconds) spent in a phase last update
+float EntityManager::GetPhaseTime(UpdatePhase phase)
+{
+	return phaseTimes[(int)phase];
+}
+
+// Rebuild the serial and parallel lists for every phase
+void EntityManager::RebuildUpdateLists()
 {
-	//Update entities
 	for (size_t i = 0; i < entities.size(); i++)
 	{
-		if (entities[i] && entities[i]->GetEnabled())
+		entities[i]->inUpdateLists = false;
+	}
+
+	for (int p = 0; p < (int)UpdatePhase::Count; p++)
+	{
+		UpdatePhase phase = (UpdatePhase)p;
+		serialLists[p].clear();
+		parallelLists[p].clear();
+
+		//0 = unvisited, 1 = visiting, 2 = sorted
+		std::unordered_map<Entity*, int> visitState;
+		for (size_t i = 0; i < entities.size(); i++)
 		{
-			entities[i]->GameObject::Update(deltaTime);
-			entities[i]->Update(deltaTime);
+			Entity* e = entities[i];
+			if (!e->RunsInPhase(phase) || !e->awake)
+				continue;
+
+			//Only entities that don't read from others can run in parallel
+			auto deps = dependencies.find(e);
+			bool hasDependencies = deps != dependencies.end() && deps->second.size() > 0;
+			if (e->IsParallelInPhase(phase) && !hasDependencies)
+				parallelLists[p].push_back(e);
+			else SortIntoSerialList(e, phase, visitState);
 		}
 	}
 
+	MarkListedEntities();
+	wokenEntities.clear();
+	sleepersInLists = false;
+	updateListsDirty = false;
+}
+
+// Check if an entity updates in a phase and can run in parallel
+bool EntityManager::IsParallelEntity(Entity* entity, UpdatePhase phase)
+{
+	auto deps = dependencies.find(entity);
+	bool hasDependencies = deps != dependencies.end() && deps->second.size() > 0;
+	return entity->IsParallelInPhase(phase) && !hasDependencies;
+}
+
+// Update which entities are in the update lists
+void EntityManager::UpdateActivity()
+{
+	//Woken entities in a serial list have to be sorted after their dependencies
+	for (size_t i = 0; i < wokenEntities.size() && !updateListsDirty; i++)
+	{
+		Entity* e = wokenEntities[i];
+		for (int p = 0; p < (int)UpdatePhase::Count; p++)
+		{
+			if (e->awake && e->RunsInPhase((UpdatePhase)p) && !IsParallelEntity(e, (UpdatePhase)p))
+				updateListsDirty = true;
+		}
+	}
+	if (updateListsDirty)
+	{
+		RebuildUpdateLists();
+		return;
+	}
+
+	bool listsChanged = sleepersInLists || wokenEntities.size() > 0;
+
+	//Take sleeping entities out (this only walks the awake ones)
+	if (sleepersInLists)
+	{
+		for (int p = 0; p < (int)UpdatePhase::Count; p++)
+		{
+			auto asleep = [](Entity* e)
+			{
+				if (e->awake)
+					return false;
+				e->inUpdateLists = false;
+				return true;
+			};
+			std::vector<Entity*>& serial = serialLists[p];
+			std::vector<Entity*>& parallel = parallelLists[p];
+			serial.erase(std::remove_if(serial.begin(), serial.end(), asleep), serial.end());
+			parallel.erase(std::remove_if(parallel.begin(), parallel.end(), asleep), parallel.end());
+		}
+		sleepersInLists = false;
+	}
+
+	//Put woken entities in (they're only in parallel lists, so the order doesn't matter)
+	for (size_t i = 0; i < wokenEntities.size(); i++)
+	{
+		Entity* e = wokenEntities[i];
+		if (!e->awake || e->inUpdateLists)
+			continue;
+
+		for (int p = 0; p < (int)UpdatePhase::Count; p++)
+		{
+			if (e->RunsInPhase((UpdatePhase)p))
+				parallelLists[p].push_back(e);
+		}
+		e->inUpdateLists = true;
+	}
+	wokenEntities.clear();
+
+	if (listsChanged)
+		MarkListedEntities();
+}
+
+// Flag the entities in the update lists and count them
+void EntityManager::MarkListedEntities()
+{
+	for (int p = 0; p < (int)UpdatePhase::Count; p++)
+	{
+		for (size_t i = 0; i < serialLists[p].size(); i++)
+			serialLists[p][i]->inUpdateLists = false;
+		for (size_t i = 0; i < parallelLists[p].size(); i++)
+			parallelLists[p][i]->inUpdateLists = false;
+	}
+
+	//An entity can be in more than one phase, but only counts once
+	activeCount = 0;
+	for (int p = 0; p < (int)UpdatePhase::Count; p++)
+	{
+		for (size_t i = 0; i < serialLists[p].size(); i++)
+		{
+			if (!serialLists[p][i]->inUpdateLists)
+				activeCount++;
+			serialLists[p][i]->inUpdateLists = true;
+		}
+		for (size_t i = 0; i < parallelLists[p].size(); i++)
+		{
+			if (!parallelLists[p][i]->inUpdateLists)
+				activeCount++;
+			parallelLists[p][i]->inUpdateLists = true;
+		}
+	}
+}
+
+// Add an entity (after its dependencies) to a phase's serial list
+void EntityManager::SortIntoSerialList(Entity* entity, UpdatePhase phase,
+	std::unordered_map<Entity*, int>& visitState)
+{
+	int& state = visitState[entity];
+	if (state == 2)
+		return;
+	if (state == 1)
+	{
+		printf("Update dependency cycle found at entity %s\n", entity->GetName().c_str());
+		return;
+	}
+	state = 1;
+
+	//Sort dependencies that also run in this phase serially first
+	//(parallel entities always run before the serial list)
+	auto deps = dependencies.find(entity);
+	if (deps != dependencies.end())
+	{
+		std::vector<Entity*> list = deps->second;
+		for (size_t i = 0; i < list.size(); i++)
+		{
+			auto leaderDeps = dependencies.find(list[i]);
+			bool leaderParallel = list[i]->IsParallelInPhase(phase) &&
+				(leaderDeps == dependencies.end() || leaderDeps->second.size() == 0);
+			if (list[i]->RunsInPhase(phase) && !leaderParallel)
+				SortIntoSerialList(list[i], phase, visitState);
+		}
+	}
+
+	visitState[entity] = 2;
+	serialLists[(int)phase].push_back(entity);
+}
+
+// Run all entities registered to a phase
+void EntityManager::UpdatePhaseLists(UpdatePhase phase, float deltaTime)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//Independent entities are split across the worker threads
+	std::vector<Entity*>& parallel = parallelLists[(int)phase];
+	JobSystem::GetInstance()->ParallelFor((int)parallel.size(), PARALLEL_UPDATE_CHUNK,
+		[&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (parallel[i]->GetEnabled() && parallel[i]->awake)
+				parallel[i]->PhaseUpdate(phase, deltaTime);
+		}
+	});
+
+	//Then everything else in dependency order
+	std::vector<Entity*>& serial = serialLists[(int)phase];
+	for (size_t i = 0; i < serial.size(); i++)
+	{
+		if (serial[i]->GetEnabled() && serial[i]->awake)
+			serial[i]->PhaseUpdate(phase, deltaTime);
+	}
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	phaseTimes[(int)phase] = elapsed.count();
+}
+
+// Run every update phase for all entities in the manager
+void EntityManager::Update(float deltaTime)
+{
+	//Sleeping entities leave the lists, woken ones join them
+	UpdateActivity();
+
+	//Update entities
+	for (int p = 0; p < (int)UpdatePhase::Count; p++)
+	{
+		UpdatePhaseLists((UpdatePhase)p, deltaTime);
+	}
+
 	//Remove entities
 	for (size_t i = 0; i < remove_entities.size(); i++)
 	{
 		RemoveEntityFromList(remove_entities[i].e, remove_entities[i].release);
 	}
 	remove_entities.clear();
+}
+
+// Save every entity's transform so the renderer can interpolate from it
+void EntityManager::StorePreviousTransforms()
+{
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		entities[i]->StorePreviousTransform();
+	}
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <unordered_map>
+#include <mutex>
 #include <Entity.h>
 #include <string>
 
@@ -14,17 +16,64 @@ private:
 	// --------------------------------------------------------
 	// Singleton Constructor - Set up the singleton instance of the EntityManager
 	// --------------------------------------------------------
-	EntityManager() { }
+	EntityManager();
 	~EntityManager();
 
 	std::vector<Entity*> entities;       //A vector of entities
 	std::vector<EntityRemoval> remove_entities;       //A vector of entities
+	std::mutex removeMutex;       //Entities can be removed from worker threads
+
+	//Phase update lists
+	std::vector<Entity*> serialLists[(int)UpdatePhase::Count];       //Sorted so dependencies update first
+	std::vector<Entity*> parallelLists[(int)UpdatePhase::Count];       //Updated on worker threads
+	std::unordered_map<Entity*, std::vector<Entity*>> dependencies;       //Entity -> entities it reads from
+	bool updateListsDirty = true;
+	float phaseTimes[(int)UpdatePhase::Count] = {};       //Milliseconds spent in each phase last update
+
+	//Activity
+	std::vector<Entity*> wokenEntities;       //Woken since the last update, not in the lists yet
+	bool sleepersInLists = false;       //Some entities in the lists fell asleep
+	int activeCount = 0;       //Entities in the update lists
+	std::mutex activityMutex;       //Entities can fall asleep or wake up on worker threads
 
 	// --------------------------------------------------------
 	// Remove an entity by its object
 	// --------------------------------------------------------
 	void RemoveEntityFromList(Entity* entity, bool release);
 
+	// --------------------------------------------------------
+	// Rebuild the serial and parallel lists for every phase
+	// --------------------------------------------------------
+	void RebuildUpdateLists();
+
+	// --------------------------------------------------------
+	// Add an entity (after its dependencies) to a phase's serial list
+	// --------------------------------------------------------
+	void SortIntoSerialList(Entity* entity, UpdatePhase phase,
+		std::unordered_map<Entity*, int>& visitState);
+
+	// --------------------------------------------------------
+	// Check if an entity updates in a phase and can run in parallel
+	// --------------------------------------------------------
+	bool IsParallelEntity(Entity* entity, UpdatePhase phase);
+
+	// --------------------------------------------------------
+	// Take sleeping entities out of the update lists and put woken
+	// ones in (wake timers fire on the TimerWheel before this).
+	// Only touches the entities in the lists and the ones that changed
+	// --------------------------------------------------------
+	void UpdateActivity();
+
+	// --------------------------------------------------------
+	// Flag the entities in the update lists and count them
+	// --------------------------------------------------------
+	void MarkListedEntities();
+
+	// --------------------------------------------------------
+	// Run all entities registered to a phase
+	// --------------------------------------------------------
+	void UpdatePhaseLists(UpdatePhase phase, float deltaTime);
+
 public:
 
 	// Returns an Entity Manager Instance ---
@@ -51,6 +100,17 @@ public:
 	// --------------------------------------------------------
 	Entity* GetEntity(std::string name);
 
+	// --------------------------------------------------------
+	// Get the amount of entities in the manager
+	// --------------------------------------------------------
+	int GetEntityCount();
+
+	// --------------------------------------------------------
+	// Hash the transform and enabled state of every entity (in order).
+	// Used to check that replays match their recording
+	// --------------------------------------------------------
+	unsigned long long GetWorldChecksum();
+
 	// --------------------------------------------------------
 	// Remove an entity by its name
 	// --------------------------------------------------------
@@ -61,10 +121,54 @@ public:
 	// --------------------------------------------------------
 	void RemoveEntity(Entity* entity, bool deleteEntity = true);
 
+	// --------------------------------------------------------
+	// Declare that an entity reads from another entity during its update,
+	// so the other entity is always updated first within a phase.
+	// Entities with dependencies are never updated in parallel
+	// --------------------------------------------------------
+	void AddUpdateDependency(Entity* entity, Entity* dependsOn);
+
+	// --------------------------------------------------------
+	// Remove all of an entity's update dependencies
+	// --------------------------------------------------------
+	void RemoveUpdateDependencies(Entity* entity);
+
+	// --------------------------------------------------------
+	// Tell the manager to rebuild its phase lists before the next update
+	// --------------------------------------------------------
+	void MarkUpdateListsDirty();
+
+	// --------------------------------------------------------
+	// Called by an entity when it falls asleep (use Entity::Sleep)
+	// --------------------------------------------------------
+	void OnSleep(Entity* entity);
+
+	// --------------------------------------------------------
+	// Called by an entity when it wakes up (use Entity::Wake)
+	// --------------------------------------------------------
+	void OnWake(Entity* entity);
+
+	// --------------------------------------------------------
+	// Get the amount of entities in the update lists (awake
+	// and updated in at least one phase) as of the last update
+	// --------------------------------------------------------
+	int GetActiveCount();
+
+	// --------------------------------------------------------
+	// Get the time (in milliseconds) spent in a phase last update
+	// --------------------------------------------------------
+	float GetPhaseTime(UpdatePhase phase);
+
 	// --------------------------------------
 
 	// --------------------------------------------------------
-	// Run Update() for all entities in the manager
+	// Run every update phase for all entities in the manager
 	// --------------------------------------------------------
 	void Update(float deltaTime);
+
+	// --------------------------------------------------------
+	// Save every entity's transform so the renderer can interpolate
+	// from it. Call once at the start of each simulation step
+	// --------------------------------------------------------
+	void StorePreviousTransforms();
 };
\ No newline at end of file
@@ -45,6 +45,97 @@ public:
 		return DirectX::XMVectorGetX(dist);
 	}
 
+	//Squared distance from a point to a line segment
+	static float PointSegmentDistanceSq(const DirectX::XMFLOAT3& point,
+		const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& end)
+	{
+		DirectX::XMFLOAT3 dir = DirectX::XMFLOAT3(end.x - start.x, end.y - start.y, end.z - start.z);
+		DirectX::XMFLOAT3 rel = DirectX::XMFLOAT3(point.x - start.x, point.y - start.y, point.z - start.z);
+		float lengthSq = dir.x * dir.x + dir.y * dir.y + dir.z * dir.z;
+		float t = 0;
+		if (lengthSq > 0)
+			t = Clamp((rel.x * dir.x + rel.y * dir.y + rel.z * dir.z) / lengthSq, 0, 1);
+
+		DirectX::XMFLOAT3 diff = DirectX::XMFLOAT3(rel.x - dir.x * t, rel.y - dir.y * t, rel.z - dir.z * t);
+		return diff.x * diff.x + diff.y * diff.y + diff.z * diff.z;
+	}
+
+	//Squared distance between the closest points of two line segments
+	//(Real-Time Collision Detection, Ericson, 5.1.9)
+	static float SegmentSegmentDistanceSq(const DirectX::XMFLOAT3& start1, const DirectX::XMFLOAT3& end1,
+		const DirectX::XMFLOAT3& start2, const DirectX::XMFLOAT3& end2)
+	{
+		DirectX::XMFLOAT3 d1 = DirectX::XMFLOAT3(end1.x - start1.x, end1.y - start1.y, end1.z - start1.z);
+		DirectX::XMFLOAT3 d2 = DirectX::XMFLOAT3(end2.x - start2.x, end2.y - start2.y, end2.z - start2.z);
+		DirectX::XMFLOAT3 r = DirectX::XMFLOAT3(start1.x - start2.x, start1.y - start2.y, start1.z - start2.z);
+		float a = d1.x * d1.x + d1.y * d1.y + d1.z * d1.z;
+		float e = d2.x * d2.x + d2.y * d2.y + d2.z * d2.z;
+		float f = d2.x * r.x + d2.y * r.y + d2.z * r.z;
+
+		//Either segment is a point
+		if (a <= 0)
+			return PointSegmentDistanceSq(start1, start2, end2);
+		if (e <= 0)
+			return PointSegmentDistanceSq(start2, start1, end1);
+
+		float c = d1.x * r.x + d1.y * r.y + d1.z * r.z;
+		float b = d1.x * d2.x + d1.y * d2.y + d1.z * d2.z;
+		float denom = a * e - b * b;
+
+		//Closest point on the first line to the second (any point if they're parallel)
+		float s = denom > 0 ? Clamp((b * f - c * e) / denom, 0, 1) : 0;
+		float t = (b * s + f) / e;
+
+		//Clamp to the second segment and redo the first
+		if (t < 0)
+		{
+			t = 0;
+			s = Clamp(-c / a, 0, 1);
+		}
+		else if (t > 1)
+		{
+			t = 1;
+			s = Clamp((b - c) / a, 0, 1);
+		}
+
+		DirectX::XMFLOAT3 diff = DirectX::XMFLOAT3(
+			r.x + d1.x * s - d2.x * t,
+			r.y + d1.y * s - d2.y * t,
+			r.z + d1.z * s - d2.z * t);
+		return diff.x * diff.x + diff.y * diff.y + diff.z * diff.z;
+	}
+
+	//Extract the 6 planes of a view frustum from a (row vector, untransposed)
+	//view * projection matrix, pointing inwards as (normal, distance)
+	//(Fast Extraction of Viewing Frustum Planes, Gribb and Hartmann)
+	static void FrustumPlanes(const DirectX::XMFLOAT4X4& viewProj, DirectX::XMFLOAT4 planes[6])
+	{
+		const DirectX::XMFLOAT4X4& m = viewProj;
+		planes[0] = DirectX::XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);	//Left
+		planes[1] = DirectX::XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);	//Right
+		planes[2] = DirectX::XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);	//Bottom
+		planes[3] = DirectX::XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);	//Top
+		planes[4] = DirectX::XMFLOAT4(m._13, m._23, m._33, m._43);									//Near (D3D depth starts at 0)
+		planes[5] = DirectX::XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);	//Far
+	}
+
+	//Returns whether an axis aligned box is at least partly inside frustum planes
+	//(can say yes for boxes just outside a corner, which is fine for culling)
+	static bool BoxInFrustum(const DirectX::XMFLOAT4 planes[6], DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			//The corner furthest along the plane's normal
+			const DirectX::XMFLOAT4& p = planes[i];
+			float x = p.x > 0 ? max.x : min.x;
+			float y = p.y > 0 ? max.y : min.y;
+			float z = p.z > 0 ? max.z : min.z;
+			if (p.x * x + p.y * y + p.z * z + p.w < 0)
+				return false;
+		}
+		return true;
+	}
+
 	//Extract a quaternion from a rotation matrix
 	//https://forum.unity.com/threads/how-to-assign-matrix4x4-to-transform.121966/
 	static DirectX::XMFLOAT4 MatrixToQuaternion(DirectX::XMFLOAT4X4 m)
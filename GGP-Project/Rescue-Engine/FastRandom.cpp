@@ -0,0 +1,63 @@
+#include "FastRandom.h"
+
+// Rotate the bits of a word left
+static uint32_t RotateLeft(uint32_t x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+// Start from a seed
+FastRandom::FastRandom(uint32_t seed)
+{
+	Seed(seed);
+}
+
+// Restart from a seed
+void FastRandom::Seed(uint32_t seed)
+{
+	//Spread the seed over the state with splitmix64,
+	//so the state is never all zeroes
+	uint64_t x = seed;
+	for (int i = 0; i < 4; i += 2)
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		uint64_t z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z = z ^ (z >> 31);
+		state[i] = (uint32_t)z;
+		state[i + 1] = (uint32_t)(z >> 32);
+	}
+}
+
+// Get the next 32 random bits
+uint32_t FastRandom::Next()
+{
+	uint32_t result = state[0] + state[3];
+	uint32_t t = state[1] << 9;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = RotateLeft(state[3], 11);
+
+	return result;
+}
+
+// Get a random float in [0, 1)
+float FastRandom::NextFloat()
+{
+	//The top 24 bits are the best ones, and fit a float's mantissa exactly
+	return (Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Fill a buffer with random floats in [0, 1)
+void FastRandom::NextFloats(float* values, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		values[i] = NextFloat();
+	}
+}
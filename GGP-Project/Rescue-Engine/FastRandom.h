@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+// --------------------------------------------------------
+// A small, fast random number generator (xoshiro128+).
+//
+// The whole state is four 32 bit words, and each number is a
+// few adds, shifts and xors, so filling a buffer with thousands
+// of floats costs next to nothing. It can also be used with the
+// standard distributions (it's a uniform random bit generator)
+//
+// http://prng.di.unimi.it/
+// --------------------------------------------------------
+class FastRandom
+{
+private:
+	uint32_t state[4];
+
+public:
+	typedef uint32_t result_type;
+
+	// --------------------------------------------------------
+	// Constructor - Start from a seed
+	// --------------------------------------------------------
+	FastRandom(uint32_t seed = 1);
+
+	// --------------------------------------------------------
+	// Restart from a seed (any seed works, even 0)
+	// --------------------------------------------------------
+	void Seed(uint32_t seed);
+
+	// --------------------------------------------------------
+	// Get the next 32 random bits
+	// --------------------------------------------------------
+	uint32_t Next();
+
+	// --------------------------------------------------------
+	// Get a random float in [0, 1)
+	// --------------------------------------------------------
+	float NextFloat();
+
+	// --------------------------------------------------------
+	// Fill a buffer with random floats in [0, 1)
+	// --------------------------------------------------------
+	void NextFloats(float* values, int count);
+
+	// --------------------------------------------------------
+	// Uniform random bit generator interface
+	// --------------------------------------------------------
+	static constexpr uint32_t min() { return 0; }
+	static constexpr uint32_t max() { return UINT32_MAX; }
+	uint32_t operator()() { return Next(); }
+};
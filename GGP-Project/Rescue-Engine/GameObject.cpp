@@ -1,5 +1,9 @@
 #include "GameObject.h"
+#include "EntityManager.h"
+#include "CollisionManager.h"
+#ifndef HEADLESS
 #include "Renderer.h"
+#endif
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -16,6 +20,10 @@ GameObject::GameObject()
 	worldDirty = false;
 	RebuildWorld();
 	debug = false;
+	hasPrevTransform = false;
+
+	updatePhases = 1 << (int)UpdatePhase::PrePhysics;
+	parallelPhases = 0;
 
 	enabled = true;
 	name = "GameObject";
@@ -62,6 +70,58 @@ std::string GameObject::GetName()
 void GameObject::Update(float deltaTime)
 { }
 
+// Update this entity during one of the EntityManager's phases
+void GameObject::PhaseUpdate(UpdatePhase phase, float deltaTime)
+{
+	Update(deltaTime);
+}
+
+// Called when this gameobject's collider starts touching another's
+void GameObject::OnCollisionEnter(GameObject* other)
+{ }
+
+// Called every step this gameobject's collider keeps touching another's
+void GameObject::OnCollisionStay(GameObject* other)
+{ }
+
+// Called when this gameobject's collider stops touching another's
+void GameObject::OnCollisionExit(GameObject* other)
+{ }
+
+// Register this gameobject to be updated in a phase
+void GameObject::RegisterUpdatePhase(UpdatePhase phase, bool parallel)
+{
+	unsigned int bit = 1 << (int)phase;
+	updatePhases |= bit;
+	if (parallel)
+		parallelPhases |= bit;
+	else parallelPhases &= ~bit;
+
+	EntityManager::GetInstance()->MarkUpdateListsDirty();
+}
+
+// Stop updating this gameobject in a phase
+void GameObject::UnregisterUpdatePhase(UpdatePhase phase)
+{
+	unsigned int bit = 1 << (int)phase;
+	updatePhases &= ~bit;
+	parallelPhases &= ~bit;
+
+	EntityManager::GetInstance()->MarkUpdateListsDirty();
+}
+
+// Check if this gameobject is updated in a phase
+bool GameObject::RunsInPhase(UpdatePhase phase)
+{
+	return (updatePhases & (1 << (int)phase)) != 0;
+}
+
+// Check if this gameobject can be updated on a worker thread in a phase
+bool GameObject::IsParallelInPhase(UpdatePhase phase)
+{
+	return (parallelPhases & (1 << (int)phase)) != 0;
+}
+
 // Get the world matrix for this GameObject (rebuilding if necessary)
 XMFLOAT4X4 GameObject::GetWorldMatrix()
 {
@@ -70,8 +130,10 @@ XMFLOAT4X4 GameObject::GetWorldMatrix()
 		RebuildWorld();
 
 	//Add collider to render list
+#ifndef HEADLESS
 	if (collider != nullptr && IsDebug())
 		Renderer::GetInstance()->AddDebugCubeToThisFrame(collider->GetWorldMatrix());
+#endif
 
 	return world;
 }
@@ -108,12 +170,97 @@ void GameObject::RebuildWorld()
 	worldDirty = false;
 }
 
+// Save the current transform as the previous transform
+void GameObject::StorePreviousTransform()
+{
+	prevPosition = position;
+	prevRotationQuat = rotationQuat;
+	prevScale = scale;
+	hasPrevTransform = true;
+}
+
+// Drop the previous transform (after a teleport)
+void GameObject::SnapPreviousTransform()
+{
+	StorePreviousTransform();
+}
+
+// Build the (untransposed) world matrix between the previous and current transforms
+XMMATRIX GameObject::BuildInterpolatedWorld(float alpha)
+{
+	XMVECTOR pos = XMVectorLerp(XMLoadFloat3(&prevPosition), XMLoadFloat3(&position), alpha);
+	XMVECTOR rot = XMQuaternionSlerp(XMLoadFloat4(&prevRotationQuat), XMLoadFloat4(&rotationQuat), alpha);
+	XMVECTOR scl = XMVectorLerp(XMLoadFloat3(&prevScale), XMLoadFloat3(&scale), alpha);
+
+	return XMMatrixScalingFromVector(scl) * XMMatrixRotationQuaternion(rot) * XMMatrixTranslationFromVector(pos);
+}
+
+// Check if the transform changed since the last simulation step
+bool GameObject::MovedThisStep()
+{
+	return prevPosition.x != position.x || prevPosition.y != position.y || prevPosition.z != position.z
+		|| prevRotationQuat.x != rotationQuat.x || prevRotationQuat.y != rotationQuat.y
+		|| prevRotationQuat.z != rotationQuat.z || prevRotationQuat.w != rotationQuat.w
+		|| prevScale.x != scale.x || prevScale.y != scale.y || prevScale.z != scale.z;
+}
+
+// Get the world matrix blended between the previous and current simulation steps
+XMFLOAT4X4 GameObject::GetInterpolatedWorldMatrix(float alpha)
+{
+	//Nothing to blend, use the cached matrix
+	if (!hasPrevTransform || alpha >= 1.0f || !MovedThisStep())
+		return GetWorldMatrix();
+
+	//Add collider to render list
+#ifndef HEADLESS
+	if (collider != nullptr && IsDebug())
+		Renderer::GetInstance()->AddDebugCubeToThisFrame(collider->GetWorldMatrix());
+#endif
+
+	XMFLOAT4X4 blended;
+	XMStoreFloat4x4(&blended, XMMatrixTranspose(BuildInterpolatedWorld(alpha)));
+	return blended;
+}
+
+// Get the inverse transpose of the world matrix blended between the previous and current simulation steps
+XMFLOAT4X4 GameObject::GetInterpolatedWorldInvTransMatrix(float alpha)
+{
+	//Nothing to blend, use the cached matrix
+	if (!hasPrevTransform || alpha >= 1.0f || !MovedThisStep())
+		return GetWorldInvTransMatrix();
+
+	XMFLOAT4X4 blended;
+	XMVECTOR determinant;
+	XMStoreFloat4x4(&blended, XMMatrixInverse(&determinant, BuildInterpolatedWorld(alpha)));
+	return blended;
+}
+
 // Get the position for this GameObject
 XMFLOAT3 GameObject::GetPosition()
 {
 	return position;
 }
 
+// Get the position at the start of the simulation step
+XMFLOAT3 GameObject::GetPreviousPosition()
+{
+	//Nothing's been stored yet, so it hasn't moved
+	if (!hasPrevTransform)
+		return position;
+	return prevPosition;
+}
+
+// Get the position blended between the previous and current simulation steps
+XMFLOAT3 GameObject::GetInterpolatedPosition(float alpha)
+{
+	if (!hasPrevTransform || alpha >= 1.0f)
+		return position;
+
+	XMFLOAT3 blended;
+	XMStoreFloat3(&blended, XMVectorLerp(XMLoadFloat3(&prevPosition), XMLoadFloat3(&position), alpha));
+	return blended;
+}
+
 // Set the position for this GameObject
 void GameObject::SetPosition(XMFLOAT3 newPosition)
 {
@@ -297,11 +444,14 @@ Collider* GameObject::GetCollider()
 }
 
 // Add a collider to this object if it has none
-void GameObject::AddCollider(DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset)
+void GameObject::AddCollider(DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset, ColliderShape shape)
 {
 	if (collider == nullptr)
 	{
-		collider = new Collider(position, size, offset);
+		collider = new Collider(position, size, offset, shape);
+		collider->SetRotation(rotationQuat);
+		collider->SetOwner(this);
+		CollisionManager::GetInstance()->AddCollider(collider);
 	}
 }
 
@@ -3,6 +3,11 @@
 #include "Collider.h"
 #include <string>
 
+// --------------------------------------------------------
+// The phases the EntityManager updates entities in (in order)
+// --------------------------------------------------------
+enum class UpdatePhase { PrePhysics, Physics, PostPhysics, Late, Count };
+
 // --------------------------------------------------------
 // A GameObject definition.
 //
@@ -26,6 +31,16 @@ private:
 	bool worldDirty;
 	bool debug;
 
+	//Transform at the start of the last simulation step (for interpolation)
+	DirectX::XMFLOAT3 prevPosition;
+	DirectX::XMFLOAT4 prevRotationQuat;
+	DirectX::XMFLOAT3 prevScale;
+	bool hasPrevTransform;
+
+	//Update phases (bitmasks of UpdatePhase)
+	unsigned int updatePhases;
+	unsigned int parallelPhases;
+
 	//Other data
 	Collider* collider;
 
@@ -34,6 +49,17 @@ private:
 	// --------------------------------------------------------
 	void CalculateAxis();
 
+	// --------------------------------------------------------
+	// Build the (untransposed) world matrix between the previous
+	// and current transforms
+	// --------------------------------------------------------
+	DirectX::XMMATRIX BuildInterpolatedWorld(float alpha);
+
+	// --------------------------------------------------------
+	// Check if the transform changed since the last simulation step
+	// --------------------------------------------------------
+	bool MovedThisStep();
+
 protected:
 	bool enabled;
 	std::string name;
@@ -91,6 +117,57 @@ public:
 	// --------------------------------------------------------
 	virtual void Update(float deltaTime);
 
+	// --------------------------------------------------------
+	// Update this entity during one of the EntityManager's phases.
+	// Calls Update() by default, so objects that register more than
+	// one phase should override this
+	// --------------------------------------------------------
+	virtual void PhaseUpdate(UpdatePhase phase, float deltaTime);
+
+	// --------------------------------------------------------
+	// Called by the CollisionManager when this gameobject's collider
+	// starts touching another gameobject's collider
+	// --------------------------------------------------------
+	virtual void OnCollisionEnter(GameObject* other);
+
+	// --------------------------------------------------------
+	// Called by the CollisionManager every step this gameobject's
+	// collider keeps touching another gameobject's collider
+	// --------------------------------------------------------
+	virtual void OnCollisionStay(GameObject* other);
+
+	// --------------------------------------------------------
+	// Called by the CollisionManager when this gameobject's collider
+	// stops touching another gameobject's collider
+	// --------------------------------------------------------
+	virtual void OnCollisionExit(GameObject* other);
+
+	// --------------------------------------------------------
+	// Register this gameobject to be updated in a phase
+	// (objects are registered to PrePhysics by default)
+	//
+	// phase - the phase to be updated in
+	// parallel - whether this object can be updated on a worker thread
+	//			  in this phase. Only use this if the object never writes
+	//			  to other objects during the phase
+	// --------------------------------------------------------
+	void RegisterUpdatePhase(UpdatePhase phase, bool parallel = false);
+
+	// --------------------------------------------------------
+	// Stop updating this gameobject in a phase
+	// --------------------------------------------------------
+	void UnregisterUpdatePhase(UpdatePhase phase);
+
+	// --------------------------------------------------------
+	// Check if this gameobject is updated in a phase
+	// --------------------------------------------------------
+	bool RunsInPhase(UpdatePhase phase);
+
+	// --------------------------------------------------------
+	// Check if this gameobject can be updated on a worker thread in a phase
+	// --------------------------------------------------------
+	bool IsParallelInPhase(UpdatePhase phase);
+
 	// --------------------------------------------------------
 	// Get the world matrix for this GameObject (rebuilding if necessary)
 	// --------------------------------------------------------
@@ -107,11 +184,53 @@ public:
 	// --------------------------------------------------------
 	void RebuildWorld();
 
+	// --------------------------------------------------------
+	// Save the current transform as the previous transform.
+	// Called at the start of every simulation step
+	// --------------------------------------------------------
+	void StorePreviousTransform();
+
+	// --------------------------------------------------------
+	// Drop the previous transform, so the object isn't blended
+	// from where it was. Call after teleporting it mid step
+	// --------------------------------------------------------
+	void SnapPreviousTransform();
+
+	// --------------------------------------------------------
+	// Get the world matrix blended between the previous and current
+	// simulation steps
+	//
+	// alpha - 0 for the previous step, 1 for the current step
+	// --------------------------------------------------------
+	DirectX::XMFLOAT4X4 GetInterpolatedWorldMatrix(float alpha);
+
+	// --------------------------------------------------------
+	// Get the inverse transpose of the world matrix blended between
+	// the previous and current simulation steps
+	//
+	// alpha - 0 for the previous step, 1 for the current step
+	// --------------------------------------------------------
+	DirectX::XMFLOAT4X4 GetInterpolatedWorldInvTransMatrix(float alpha);
+
 	// --------------------------------------------------------
 	// Get the position for this GameObject
 	// --------------------------------------------------------
 	DirectX::XMFLOAT3 GetPosition();
 
+	// --------------------------------------------------------
+	// Get the position this GameObject had at the start of the
+	// simulation step (its position if it's new)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3 GetPreviousPosition();
+
+	// --------------------------------------------------------
+	// Get the position blended between the previous and current
+	// simulation steps
+	//
+	// alpha - 0 for the previous step, 1 for the current step
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3 GetInterpolatedPosition(float alpha);
+
 	// --------------------------------------------------------
 	// Set the position for this GameObject
 	//
@@ -231,11 +350,15 @@ public:
 
 	// --------------------------------------------------------
 	// Add a collider to this object if it has none
+	// (and add it to the CollisionManager)
 	//
 	// size - dimensions of bounding box
 	// offset - offset of collider from position of game object
+	// shape - shape of the collider (spheres and capsules have a radius
+	//		   of size.x / 2, capsules run along the object's forward axis)
 	// --------------------------------------------------------
-	void AddCollider(DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset = DirectX::XMFLOAT3());
+	void AddCollider(DirectX::XMFLOAT3 size, DirectX::XMFLOAT3 offset = DirectX::XMFLOAT3(),
+		ColliderShape shape = ColliderShape::Box);
 
 	// --------------------------------------------------------
 	// Check if the collider is in debug mode (draw outline)
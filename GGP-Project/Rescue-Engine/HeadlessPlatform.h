@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+
+// --------------------------------------------------------
+// Stand-ins for the few Win32 types and calls the engine uses
+// outside of rendering, so gameplay code can be built without
+// Windows (HEADLESS builds).
+//
+// There is no window or keyboard, so every query reports nothing.
+// Input has to come from InputManager's scripted input.
+// --------------------------------------------------------
+#ifdef HEADLESS
+
+typedef void* HWND;
+typedef unsigned long long WPARAM;
+typedef int BOOL;
+
+struct POINT { long x; long y; };
+struct RECT { long left; long top; long right; long bottom; };
+
+//Virtual key codes used by the game
+#define VK_SPACE	0x20
+#define VK_LEFT		0x25
+#define VK_UP		0x26
+#define VK_RIGHT	0x27
+#define VK_DOWN		0x28
+#define VK_ESCAPE	0x1B
+
+inline short GetAsyncKeyState(int) { return 0; }
+inline BOOL GetCursorPos(POINT* point) { point->x = 0; point->y = 0; return 1; }
+inline HWND GetFocus() { return nullptr; }
+inline HWND SetCapture(HWND) { return nullptr; }
+inline BOOL ReleaseCapture() { return 1; }
+inline BOOL GetWindowRect(HWND, RECT* rect) { *rect = RECT(); return 1; }
+
+#endif
@@ -6,6 +6,8 @@ void InputManager::Init(HWND hWnd)
 	this->hWnd = hWnd;
 
 	winRequireFocus = true;
+	scriptedInput = false;
+	keysCaptured = false;
 	mb_L_Down = false;
 	mb_R_Down = false;
 	mb_M_Down = false;
@@ -24,6 +26,13 @@ InputManager::~InputManager()
 //Update the focus state of the window
 void InputManager::UpdateFocus()
 {
+	//Scripted input has no window to lose focus
+	if (scriptedInput)
+	{
+		windowFocused = true;
+		return;
+	}
+
 	if (GetFocus() == hWnd)
 	{
 		windowFocused = true;
@@ -71,6 +80,10 @@ bool InputManager::IsWindowFocused()
 // --------------------------------------------------------
 void InputManager::OnMouseDown(WPARAM buttonState, int x, int y)
 {
+	//The script owns the buttons
+	if (scriptedInput)
+		return;
+
 	// Save the previous mouse position, so we have it for the future
 	//prevMousePos.x = x;
 	//prevMousePos.y = y;
@@ -91,6 +104,10 @@ void InputManager::OnMouseDown(WPARAM buttonState, int x, int y)
 // --------------------------------------------------------
 void InputManager::OnMouseUp(WPARAM buttonState, int x, int y, int button)
 {
+	//The script owns the buttons
+	if (scriptedInput)
+		return;
+
 	//Find what button was released
 	if (button & 0x0001) { mb_L_Down = false; }
 	else if (button & 0x0002) { mb_R_Down = false; }
@@ -127,6 +144,13 @@ void InputManager::OnMouseWheel(float wheelDelta, int x, int y)
 //Returns true while the inputted key is held down
 bool InputManager::GetKey(char key)
 {
+	//Read from the script or the last capture
+	if (scriptedInput || keysCaptured)
+	{
+		auto it = pressedKeys.find(key);
+		return it != pressedKeys.end() && it->second;
+	}
+
 	//Early return if we need focus and we don't have it
 	if (winRequireFocus && !windowFocused)
 		return false;
@@ -134,6 +158,71 @@ bool InputManager::GetKey(char key)
 	return GetAsyncKeyState(key) & 0x8000;
 }
 
+// Take key input from SetScriptedKey() instead of the keyboard
+void InputManager::SetScriptedInput(bool scripted)
+{
+	scriptedInput = scripted;
+	keysCaptured = false;
+	pressedKeys.clear();
+
+	//Start with nothing held
+	mb_L_Down = false;
+	mb_R_Down = false;
+	mb_M_Down = false;
+	if (scripted)
+		windowFocused = true;
+}
+
+// Check if key input comes from SetScriptedKey()
+bool InputManager::IsScriptedInput()
+{
+	return scriptedInput;
+}
+
+// Press or release a key while using scripted input
+void InputManager::SetScriptedKey(char key, bool down)
+{
+	pressedKeys[key] = down;
+}
+
+// Press or release a mouse button while using scripted input
+void InputManager::SetScriptedMouseButton(MouseButtons button, bool down)
+{
+	switch (button)
+	{
+		case MouseButtons::L: mb_L_Down = down; break;
+		case MouseButtons::R: mb_R_Down = down; break;
+		case MouseButtons::M: mb_M_Down = down; break;
+		default: break;
+	}
+}
+
+// Poll every key once and have GetKey() return those states until the next capture
+void InputManager::CaptureKeys()
+{
+	if (scriptedInput)
+		return;
+
+	bool focused = !winRequireFocus || windowFocused;
+	for (int key = 0; key < 256; key++)
+	{
+		pressedKeys[(char)key] = focused && (GetAsyncKeyState(key) & 0x8000);
+	}
+	keysCaptured = true;
+}
+
+// Get whether a mouse button is currently down
+bool InputManager::GetMouseButtonState(MouseButtons button)
+{
+	switch (button)
+	{
+		case MouseButtons::L: return mb_L_Down;
+		case MouseButtons::R: return mb_R_Down;
+		case MouseButtons::M: return mb_M_Down;
+		default: return false;
+	}
+}
+
 //TODO: Implement keyboard states
 
 /*
@@ -1,5 +1,9 @@
 #pragma once
+#ifdef HEADLESS
+#include "HeadlessPlatform.h"
+#else
 #include "Windows.h"
+#endif
 #include <DirectXMath.h>
 #include <map>
 
@@ -38,6 +42,10 @@ private:
 	bool winRequireFocus;
 	bool windowFocused;
 
+	//Scripted input (keys come from pressedKeys instead of the keyboard)
+	bool scriptedInput;
+	bool keysCaptured;
+
 	// --------------------------------------------------------
 	// Singleton Constructor - Set up the singleton instance of the input manager
 	// --------------------------------------------------------
@@ -114,7 +122,7 @@ public:
 	// --------------------------------------------------------
 	//Update the focus state of the window
 	// --------------------------------------------------------
-	void InputManager::UpdateFocus();
+	void UpdateFocus();
 
 	// --------------------------------------------------------
 	// Update the input manager's key/button states (only call ONCE PER FRAME!)
@@ -131,6 +139,40 @@ public:
 	// --------------------------------------------------------
 	bool GetKey(char key);
 
+	// --------------------------------------------------------
+	// Take key input from SetScriptedKey() instead of the keyboard.
+	// Scripted input ignores window focus
+	// --------------------------------------------------------
+	void SetScriptedInput(bool scripted);
+
+	// --------------------------------------------------------
+	// Check if key input comes from SetScriptedKey()
+	// --------------------------------------------------------
+	bool IsScriptedInput();
+
+	// --------------------------------------------------------
+	// Press or release a key while using scripted input
+	// --------------------------------------------------------
+	void SetScriptedKey(char key, bool down);
+
+	// --------------------------------------------------------
+	// Press or release a mouse button while using scripted input
+	// --------------------------------------------------------
+	void SetScriptedMouseButton(MouseButtons button, bool down);
+
+	// --------------------------------------------------------
+	// Poll every key once and have GetKey() return those states
+	// until the next capture, so a whole simulation step sees
+	// (and records) the same input
+	// --------------------------------------------------------
+	void CaptureKeys();
+
+	// --------------------------------------------------------
+	// Get whether a mouse button is currently down
+	// (ignores window focus and the previous frame)
+	// --------------------------------------------------------
+	bool GetMouseButtonState(MouseButtons button);
+
 	//TODO: Implement key states
 
 	/*
@@ -0,0 +1,312 @@
+#include "InputRecorder.h"
+#include "InputManager.h"
+#include <cstring>
+
+#define RECORDING_VERSION 1
+
+// Singleton Constructor - Set up the singleton instance of the recorder
+InputRecorder::InputRecorder()
+{
+	mode = RecorderMode::Off;
+	seed = 0;
+	recordFile = nullptr;
+	replayPos = 0;
+	expectedChecksum = 0;
+	divergedSteps = 0;
+	firstDivergedStep = -1;
+	mouseStates = 0;
+	stepCount = 0;
+	memset(keyStates, 0, sizeof(keyStates));
+}
+
+// Destructor - Finish any recording
+InputRecorder::~InputRecorder()
+{
+	Stop();
+}
+
+// Start recording to a log file
+bool InputRecorder::StartRecording(const char* path, unsigned int seed)
+{
+	Stop();
+
+	recordFile = fopen(path, "wb");
+	if (recordFile == nullptr)
+	{
+		printf("Could not open %s for recording\n", path);
+		return false;
+	}
+
+	this->seed = seed;
+	stepCount = 0;
+	mouseStates = 0;
+	memset(keyStates, 0, sizeof(keyStates));
+
+	//Header
+	stepBuffer.clear();
+	stepBuffer.push_back('S');
+	stepBuffer.push_back('O');
+	stepBuffer.push_back('T');
+	stepBuffer.push_back('W');
+	WriteU32(RECORDING_VERSION);
+	WriteU32(seed);
+	fwrite(stepBuffer.data(), 1, stepBuffer.size(), recordFile);
+
+	mode = RecorderMode::Recording;
+	printf("Recording input to %s (seed %u)\n", path, seed);
+	return true;
+}
+
+// Start replaying a log file
+bool InputRecorder::StartReplay(const char* path)
+{
+	Stop();
+
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr)
+	{
+		printf("Could not open %s for replay\n", path);
+		return false;
+	}
+
+	//Read the whole log so replaying never touches the disk
+	replayData.clear();
+	unsigned char chunk[4096];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		replayData.insert(replayData.end(), chunk, chunk + read);
+	}
+	fclose(file);
+
+	//Check the header
+	replayPos = 0;
+	char magic[4];
+	unsigned int version;
+	if (!ReadBytes(magic, 4) || memcmp(magic, "SOTW", 4) != 0 ||
+		!ReadU32(&version) || version != RECORDING_VERSION || !ReadU32(&seed))
+	{
+		printf("%s is not a valid input recording\n", path);
+		replayData.clear();
+		return false;
+	}
+
+	stepCount = 0;
+	divergedSteps = 0;
+	firstDivergedStep = -1;
+	mouseStates = 0;
+	memset(keyStates, 0, sizeof(keyStates));
+	InputManager::GetInstance()->SetScriptedInput(true);
+
+	mode = RecorderMode::Replaying;
+	printf("Replaying input from %s (seed %u)\n", path, seed);
+	return true;
+}
+
+// Stop recording or replaying
+void InputRecorder::Stop()
+{
+	if (mode == RecorderMode::Recording)
+	{
+		fclose(recordFile);
+		recordFile = nullptr;
+		printf("Recorded %d steps\n", stepCount);
+
+		//Stop holding captured keys
+		InputManager::GetInstance()->SetScriptedInput(false);
+	}
+	else if (mode == RecorderMode::Replaying)
+	{
+		//Give input back to the keyboard
+		InputManager::GetInstance()->SetScriptedInput(false);
+		replayData.clear();
+
+		if (divergedSteps == 0)
+			printf("Replayed %d steps, no divergence\n", stepCount);
+		else printf("Replayed %d steps, %u diverged (first at step %d)\n", stepCount, divergedSteps, firstDivergedStep);
+	}
+
+	mode = RecorderMode::Off;
+}
+
+// Get what the recorder is doing
+RecorderMode InputRecorder::GetMode()
+{
+	return mode;
+}
+
+// Get the RNG seed of the current recording or replay
+unsigned int InputRecorder::GetSeed()
+{
+	return seed;
+}
+
+// Check if the replay has steps left
+bool InputRecorder::HasReplaySteps()
+{
+	return mode == RecorderMode::Replaying && replayPos < replayData.size();
+}
+
+// Recording - write a finished step
+void InputRecorder::RecordStep(float deltaTime, unsigned long long checksum)
+{
+	if (mode != RecorderMode::Recording)
+		return;
+
+	InputManager* inputManager = InputManager::GetInstance();
+	stepBuffer.clear();
+
+	unsigned int timeBits;
+	memcpy(&timeBits, &deltaTime, sizeof(timeBits));
+	WriteU32(timeBits);
+
+	mouseStates = GetMouseStates();
+	stepBuffer.push_back(mouseStates);
+
+	//Only the keys that changed since the last step are stored
+	size_t countIndex = stepBuffer.size();
+	stepBuffer.push_back(0);
+	for (int key = 0; key < 256; key++)
+	{
+		bool down = inputManager->GetKey((char)key);
+		if (down != keyStates[key])
+		{
+			keyStates[key] = down;
+			stepBuffer.push_back((unsigned char)key);
+			stepBuffer.push_back(down ? 1 : 0);
+			stepBuffer[countIndex]++;
+
+			//Count is a byte, the rest will show up as changed next step
+			if (stepBuffer[countIndex] == 255)
+				break;
+		}
+	}
+
+	WriteU64(checksum);
+	fwrite(stepBuffer.data(), 1, stepBuffer.size(), recordFile);
+	stepCount++;
+}
+
+// Replaying - apply the next step's input and get its delta time
+bool InputRecorder::ReplayStep(float* deltaTime)
+{
+	if (mode != RecorderMode::Replaying)
+		return false;
+
+	unsigned int timeBits;
+	unsigned char changedKeys;
+	if (!ReadU32(&timeBits) || !ReadBytes(&mouseStates, 1) || !ReadBytes(&changedKeys, 1))
+		return false;
+
+	memcpy(deltaTime, &timeBits, sizeof(timeBits));
+
+	//Apply the input
+	InputManager* inputManager = InputManager::GetInstance();
+	inputManager->SetScriptedMouseButton(MouseButtons::L, (mouseStates & 1) != 0);
+	inputManager->SetScriptedMouseButton(MouseButtons::R, (mouseStates & 2) != 0);
+	inputManager->SetScriptedMouseButton(MouseButtons::M, (mouseStates & 4) != 0);
+	for (int i = 0; i < changedKeys; i++)
+	{
+		unsigned char key[2];
+		if (!ReadBytes(key, 2))
+			return false;
+
+		keyStates[key[0]] = key[1] != 0;
+		inputManager->SetScriptedKey((char)key[0], key[1] != 0);
+	}
+
+	return ReadU64(&expectedChecksum);
+}
+
+// Replaying - compare the world checksum after a step with the recorded one
+bool InputRecorder::CheckStep(unsigned long long checksum)
+{
+	if (mode != RecorderMode::Replaying)
+		return true;
+
+	bool matches = checksum == expectedChecksum;
+	if (!matches)
+	{
+		if (divergedSteps == 0)
+		{
+			firstDivergedStep = stepCount;
+			printf("Replay diverged at step %d\n", stepCount);
+		}
+		divergedSteps++;
+	}
+
+	stepCount++;
+	return matches;
+}
+
+// Get the amount of steps recorded or replayed so far
+int InputRecorder::GetStepCount()
+{
+	return stepCount;
+}
+
+// Get the amount of replayed steps that did not match the log
+unsigned int InputRecorder::GetDivergedStepCount()
+{
+	return divergedSteps;
+}
+
+// Read bytes from the replay log
+bool InputRecorder::ReadBytes(void* out, size_t count)
+{
+	if (replayPos + count > replayData.size())
+		return false;
+
+	memcpy(out, &replayData[replayPos], count);
+	replayPos += count;
+	return true;
+}
+
+// Read a little endian u32 from the replay log
+bool InputRecorder::ReadU32(unsigned int* out)
+{
+	unsigned char bytes[4];
+	if (!ReadBytes(bytes, 4))
+		return false;
+
+	*out = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+	return true;
+}
+
+// Read a little endian u64 from the replay log
+bool InputRecorder::ReadU64(unsigned long long* out)
+{
+	unsigned int low, high;
+	if (!ReadU32(&low) || !ReadU32(&high))
+		return false;
+
+	*out = ((unsigned long long)high << 32) | low;
+	return true;
+}
+
+// Write a little endian u32 to the step buffer
+void InputRecorder::WriteU32(unsigned int value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		stepBuffer.push_back((unsigned char)(value >> (i * 8)));
+	}
+}
+
+// Write a little endian u64 to the step buffer
+void InputRecorder::WriteU64(unsigned long long value)
+{
+	WriteU32((unsigned int)value);
+	WriteU32((unsigned int)(value >> 32));
+}
+
+// Pack the InputManager's mouse buttons into bits
+unsigned char InputRecorder::GetMouseStates()
+{
+	InputManager* inputManager = InputManager::GetInstance();
+	unsigned char states = 0;
+	if (inputManager->GetMouseButtonState(MouseButtons::L)) states |= 1;
+	if (inputManager->GetMouseButtonState(MouseButtons::R)) states |= 2;
+	if (inputManager->GetMouseButtonState(MouseButtons::M)) states |= 4;
+	return states;
+}
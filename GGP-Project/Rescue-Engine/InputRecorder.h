@@ -0,0 +1,151 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+
+//What the recorder is doing
+enum class RecorderMode { Off, Recording, Replaying };
+
+// --------------------------------------------------------
+// Singleton
+//
+// Records the input, delta time and world checksum of every
+// simulation step to a binary log, and feeds a log back into
+// the InputManager so a session can be replayed exactly.
+//
+// Log layout (little endian):
+//   header - "SOTW", version (u32), RNG seed (u32)
+//   step   - delta time (f32), mouse buttons (u8),
+//            changed key count (u8), changed keys (u8 key, u8 down)...,
+//            world checksum (u64)
+// --------------------------------------------------------
+class InputRecorder
+{
+private:
+	RecorderMode mode;
+	unsigned int seed;
+
+	//Recording
+	FILE* recordFile;
+	std::vector<unsigned char> stepBuffer;
+
+	//Replaying (the whole log is read up front)
+	std::vector<unsigned char> replayData;
+	size_t replayPos;
+	unsigned long long expectedChecksum;
+	unsigned int divergedSteps;
+	int firstDivergedStep;
+
+	//Shared
+	bool keyStates[256];
+	unsigned char mouseStates;
+	int stepCount;
+
+	// --------------------------------------------------------
+	// Singleton Constructor - Set up the singleton instance of the recorder
+	// --------------------------------------------------------
+	InputRecorder();
+
+	// --------------------------------------------------------
+	// Destructor - Finish any recording
+	// --------------------------------------------------------
+	~InputRecorder();
+
+	// --------------------------------------------------------
+	// Read values from the replay log
+	// --------------------------------------------------------
+	bool ReadBytes(void* out, size_t count);
+	bool ReadU32(unsigned int* out);
+	bool ReadU64(unsigned long long* out);
+
+	// --------------------------------------------------------
+	// Write values to the step buffer
+	// --------------------------------------------------------
+	void WriteU32(unsigned int value);
+	void WriteU64(unsigned long long value);
+
+	// --------------------------------------------------------
+	// Pack the InputManager's mouse buttons into bits
+	// --------------------------------------------------------
+	unsigned char GetMouseStates();
+
+public:
+	// --------------------------------------------------------
+	// Get the singleton instance of the recorder
+	// --------------------------------------------------------
+	static InputRecorder* GetInstance()
+	{
+		static InputRecorder instance;
+
+		return &instance;
+	}
+
+	//Delete this
+	InputRecorder(InputRecorder const&) = delete;
+	void operator=(InputRecorder const&) = delete;
+
+	// --------------------------------------------------------
+	// Start recording to a log file.
+	// Call before the first simulation step
+	//
+	// path - the file to write
+	// seed - the RNG seed the simulation was started with
+	// --------------------------------------------------------
+	bool StartRecording(const char* path, unsigned int seed);
+
+	// --------------------------------------------------------
+	// Start replaying a log file. Puts the InputManager in scripted
+	// input mode. Call before the first simulation step and seed
+	// the simulation with GetSeed()
+	// --------------------------------------------------------
+	bool StartReplay(const char* path);
+
+	// --------------------------------------------------------
+	// Stop recording or replaying
+	// --------------------------------------------------------
+	void Stop();
+
+	// --------------------------------------------------------
+	// Get what the recorder is doing
+	// --------------------------------------------------------
+	RecorderMode GetMode();
+
+	// --------------------------------------------------------
+	// Get the RNG seed of the current recording or replay
+	// --------------------------------------------------------
+	unsigned int GetSeed();
+
+	// --------------------------------------------------------
+	// Check if the replay has steps left
+	// --------------------------------------------------------
+	bool HasReplaySteps();
+
+	// --------------------------------------------------------
+	// Recording - write a finished step
+	//
+	// deltaTime - the step's delta time
+	// checksum - the world checksum after the step
+	// --------------------------------------------------------
+	void RecordStep(float deltaTime, unsigned long long checksum);
+
+	// --------------------------------------------------------
+	// Replaying - apply the next step's input to the InputManager
+	// and get its delta time. Returns false if the log has ended
+	// --------------------------------------------------------
+	bool ReplayStep(float* deltaTime);
+
+	// --------------------------------------------------------
+	// Replaying - compare the world checksum after a step with
+	// the recorded one. Returns false if the world diverged
+	// --------------------------------------------------------
+	bool CheckStep(unsigned long long checksum);
+
+	// --------------------------------------------------------
+	// Get the amount of steps recorded or replayed so far
+	// --------------------------------------------------------
+	int GetStepCount();
+
+	// --------------------------------------------------------
+	// Get the amount of replayed steps that did not match the log
+	// --------------------------------------------------------
+	unsigned int GetDivergedStepCount();
+};
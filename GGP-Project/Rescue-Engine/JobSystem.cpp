@@ -0,0 +1,118 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// Singleton Constructor - Start the worker threads
+JobSystem::JobSystem()
+{
+	shuttingDown = false;
+	job = nullptr;
+	jobCount = 0;
+	jobChunkSize = 1;
+	nextChunk = 0;
+	busyWorkers = 0;
+	jobGeneration = 0;
+
+	//Leave a core for the main thread
+	unsigned int cores = std::thread::hardware_concurrency();
+	int workerCount = cores > 1 ? (int)cores - 1 : 0;
+	for (int i = 0; i < workerCount; i++)
+	{
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this));
+	}
+}
+
+// Destructor - Stop and join the worker threads
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	wakeCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (workers[i].joinable())
+			workers[i].join();
+	}
+}
+
+// Loop run by every worker thread
+void JobSystem::WorkerLoop()
+{
+	unsigned long long seenGeneration = 0;
+	while (true)
+	{
+		//Wait for a new job
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [&] { return shuttingDown || jobGeneration != seenGeneration; });
+			if (shuttingDown)
+				return;
+			seenGeneration = jobGeneration;
+		}
+
+		RunChunks();
+
+		//Tell the caller we are done
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+			if (busyWorkers == 0)
+				doneCondition.notify_one();
+		}
+	}
+}
+
+// Grab chunks of the current job until there are none left
+void JobSystem::RunChunks()
+{
+	int chunk;
+	while ((chunk = nextChunk.fetch_add(1)) * jobChunkSize < jobCount)
+	{
+		int begin = chunk * jobChunkSize;
+		int end = (std::min)(begin + jobChunkSize, jobCount);
+		(*job)(begin, end);
+	}
+}
+
+// Get the amount of worker threads (not counting the caller)
+int JobSystem::GetWorkerCount()
+{
+	return (int)workers.size();
+}
+
+// Run a job over [0, count) split into chunks, and wait for it to finish.
+void JobSystem::ParallelFor(int count, int chunkSize, const std::function<void(int begin, int end)>& job)
+{
+	if (count <= 0)
+		return;
+	if (chunkSize < 1)
+		chunkSize = 1;
+
+	//Not worth waking anyone up
+	if (workers.size() == 0 || count <= chunkSize)
+	{
+		job(0, count);
+		return;
+	}
+
+	//Hand the job to the workers
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		jobCount = count;
+		jobChunkSize = chunkSize;
+		nextChunk = 0;
+		busyWorkers = (int)workers.size();
+		jobGeneration++;
+	}
+	wakeCondition.notify_all();
+
+	//Help out, then wait for everyone to finish
+	RunChunks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [&] { return busyWorkers == 0; });
+	this->job = nullptr;
+}
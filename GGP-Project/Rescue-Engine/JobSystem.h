@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// --------------------------------------------------------
+// Singleton
+//
+// Owns a pool of worker threads and splits loops across them
+// --------------------------------------------------------
+class JobSystem
+{
+private:
+	//Worker threads
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	bool shuttingDown;
+
+	//Current job
+	const std::function<void(int, int)>* job;
+	int jobCount;
+	int jobChunkSize;
+	std::atomic<int> nextChunk;
+	int busyWorkers;
+	unsigned long long jobGeneration;
+
+	// --------------------------------------------------------
+	// Singleton Constructor - Start the worker threads
+	// --------------------------------------------------------
+	JobSystem();
+
+	// --------------------------------------------------------
+	// Destructor - Stop and join the worker threads
+	// --------------------------------------------------------
+	~JobSystem();
+
+	// --------------------------------------------------------
+	// Loop run by every worker thread
+	// --------------------------------------------------------
+	void WorkerLoop();
+
+	// --------------------------------------------------------
+	// Grab chunks of the current job until there are none left
+	// --------------------------------------------------------
+	void RunChunks();
+
+public:
+	// --------------------------------------------------------
+	// Get the singleton instance of the JobSystem
+	// --------------------------------------------------------
+	static JobSystem* GetInstance()
+	{
+		static JobSystem instance;
+
+		return &instance;
+	}
+
+	//Delete this
+	JobSystem(JobSystem const&) = delete;
+	void operator=(JobSystem const&) = delete;
+
+	// --------------------------------------------------------
+	// Get the amount of worker threads (not counting the caller)
+	// --------------------------------------------------------
+	int GetWorkerCount();
+
+	// --------------------------------------------------------
+	// Run a job over [0, count) split into chunks, and wait for it to finish.
+	// The calling thread helps out. Only call from the main thread
+	// (jobs can not start other jobs)
+	//
+	// count - the amount of items to process
+	// chunkSize - the amount of items handed to a thread at a time
+	// job - function that processes the items in [begin, end)
+	// --------------------------------------------------------
+	void ParallelFor(int count, int chunkSize, const std::function<void(int begin, int end)>& job);
+};
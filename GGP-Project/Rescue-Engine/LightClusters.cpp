@@ -0,0 +1,403 @@
+#include "LightClusters.h"
+#include "SIMDLanes.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <algorithm>
+
+//Widest lane count, a slice's lights are padded to a multiple of this
+#define MAX_LANES 8
+
+//Depth slices each job works through
+#define CLUSTER_SLICES_PER_JOB 1
+
+//Spot lights wider than this (cosine of the half angle) are culled as spheres
+#define MIN_CONE_COS 0.0001f
+
+#define FIELD(f) ((int)ClusterField::f)
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// A cluster's box and the sphere around it (view space)
+// --------------------------------------------------------
+struct ClusterBox
+{
+	XMFLOAT3 centre;
+	XMFLOAT3 half;
+	float radius;
+};
+
+// --------------------------------------------------------
+// Cluster kernel - tests L::Width lights against a cluster,
+// returns a bit for each light that reaches it
+//
+// lights - the first field of the lights to test
+// stride - distance between fields of the lights
+// --------------------------------------------------------
+template<typename L>
+static int ClusterKernel(const ClusterBox& box, const float* lights, size_t stride)
+{
+	typedef typename L::F F;
+	const int allLanes = (1 << L::Width) - 1;
+	F zero = L::Set(0);
+
+	//Sphere against the box: how far the sphere's centre is outside the box along each axis
+	F dx = L::Max(L::Sub(L::Abs(L::Sub(L::Load(lights + FIELD(CentreX) * stride), L::Set(box.centre.x))),
+		L::Set(box.half.x)), zero);
+	F dy = L::Max(L::Sub(L::Abs(L::Sub(L::Load(lights + FIELD(CentreY) * stride), L::Set(box.centre.y))),
+		L::Set(box.half.y)), zero);
+	F dz = L::Max(L::Sub(L::Abs(L::Sub(L::Load(lights + FIELD(CentreZ) * stride), L::Set(box.centre.z))),
+		L::Set(box.half.z)), zero);
+	F distanceSq = L::Add(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), L::Mul(dz, dz));
+	F radius = L::Load(lights + FIELD(Radius) * stride);
+	int outside = L::Greater(distanceSq, L::Mul(radius, radius));
+
+	//Cone against the sphere around the box (Wronski, "Cull that cone!")
+	F vx = L::Sub(L::Set(box.centre.x), L::Load(lights + FIELD(ApexX) * stride));
+	F vy = L::Sub(L::Set(box.centre.y), L::Load(lights + FIELD(ApexY) * stride));
+	F vz = L::Sub(L::Set(box.centre.z), L::Load(lights + FIELD(ApexZ) * stride));
+	F lengthSq = L::Add(L::Add(L::Mul(vx, vx), L::Mul(vy, vy)), L::Mul(vz, vz));
+	F along = L::Add(L::Add(
+		L::Mul(vx, L::Load(lights + FIELD(AxisX) * stride)),
+		L::Mul(vy, L::Load(lights + FIELD(AxisY) * stride))),
+		L::Mul(vz, L::Load(lights + FIELD(AxisZ) * stride)));
+	F sideways = L::Sqrt(L::Max(L::Sub(lengthSq, L::Mul(along, along)), zero));
+	F toSide = L::Sub(L::Mul(L::Load(lights + FIELD(ConeCos) * stride), sideways),
+		L::Mul(along, L::Load(lights + FIELD(ConeSin) * stride)));
+	F boxRadius = L::Set(box.radius);
+	outside |= L::Greater(toSide, boxRadius);
+	outside |= L::Greater(along, L::Add(boxRadius, L::Load(lights + FIELD(ConeRange) * stride)));
+	outside |= L::Greater(L::Sub(zero, boxRadius), along);
+
+	return ~outside & allLanes;
+}
+
+// Set up an empty set of clusters
+LightClusters::LightClusters()
+{
+	lightCount = 0;
+	tanHalfFovX = 1;
+	tanHalfFovY = 1;
+	depthScale = 0;
+	depthBias = 0;
+	for (int i = 0; i <= CLUSTER_COUNT_Z; i++)
+	{
+		sliceDepths[i] = 0;
+	}
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		slices[z].count = 0;
+		slices[z].capacity = 0;
+	}
+	clusterRanges.resize(CLUSTER_COUNT, { 0, 0 });
+}
+
+// Destructor
+LightClusters::~LightClusters()
+{
+}
+
+// Forget every light
+void LightClusters::Clear()
+{
+	lightCount = 0;
+	globalLights.clear();
+	localLights.clear();
+	positions.clear();
+	directions.clear();
+	ranges.clear();
+	cosAngles.clear();
+}
+
+// Add a light that reaches everywhere
+void LightClusters::AddGlobalLight()
+{
+	globalLights.push_back(lightCount++);
+}
+
+// Add a light that reaches a sphere
+void LightClusters::AddPointLight(XMFLOAT3 position, float range)
+{
+	localLights.push_back(lightCount++);
+	positions.push_back(position);
+	directions.push_back(XMFLOAT3(0, 0, 0));
+	ranges.push_back(range);
+	cosAngles.push_back(-1);
+}
+
+// Add a light that reaches a cone
+void LightClusters::AddSpotLight(XMFLOAT3 position, XMFLOAT3 direction, float range, float cosAngle)
+{
+	localLights.push_back(lightCount++);
+	positions.push_back(position);
+	directions.push_back(direction);
+	ranges.push_back(range);
+	cosAngles.push_back(cosAngle);
+}
+
+// Move the lights into the camera's view and split its depth
+void LightClusters::SetView(XMFLOAT3 cameraPosition, XMFLOAT3 cameraForward, XMFLOAT3 cameraUp,
+	float fov, float aspectRatio, float nearClip, float farClip)
+{
+	//Same view as the camera's
+	XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&cameraPosition), XMLoadFloat3(&cameraForward), XMLoadFloat3(&cameraUp));
+	tanHalfFovY = tanf(fov * 0.5f);
+	tanHalfFovX = tanHalfFovY * aspectRatio;
+
+	//Slices get logarithmically deeper, so a slice = log(depth) * scale + bias
+	nearClip = std::max(nearClip, 0.0001f);
+	farClip = std::max(farClip, nearClip * 2);
+	float logRatio = logf(farClip / nearClip);
+	for (int i = 0; i <= CLUSTER_COUNT_Z; i++)
+	{
+		sliceDepths[i] = nearClip * powf(farClip / nearClip, (float)i / CLUSTER_COUNT_Z);
+	}
+	depthScale = CLUSTER_COUNT_Z / logRatio;
+	depthBias = -CLUSTER_COUNT_Z * logf(nearClip) / logRatio;
+
+	viewSpheres.resize(localLights.size());
+	viewApexes.resize(localLights.size());
+	viewAxes.resize(localLights.size());
+	for (size_t i = 0; i < localLights.size(); i++)
+	{
+		XMVECTOR apex = XMVector3TransformCoord(XMLoadFloat3(&positions[i]), view);
+		XMStoreFloat3(&viewApexes[i], apex);
+		float range = ranges[i];
+		float cosAngle = std::min(cosAngles[i], 1.0f);
+
+		//Point lights (and spot lights too wide for their cone to help) are their sphere
+		if (cosAngle < MIN_CONE_COS)
+		{
+			viewSpheres[i] = XMFLOAT4(viewApexes[i].x, viewApexes[i].y, viewApexes[i].z, range);
+			viewAxes[i] = XMFLOAT3(0, 0, 0);
+			continue;
+		}
+
+		//The smallest sphere around the cone and the cap on its end
+		XMVECTOR axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&directions[i]), view));
+		XMStoreFloat3(&viewAxes[i], axis);
+		float sinAngle = sqrtf(1 - cosAngle * cosAngle);
+		float along;
+		float radius;
+		if (cosAngle < 0.70710678f)
+		{
+			along = range * cosAngle;
+			radius = range * sinAngle;
+		}
+		else
+		{
+			along = range / (2 * cosAngle);
+			radius = along;
+		}
+		XMFLOAT3 centre;
+		XMStoreFloat3(&centre, XMVectorAdd(apex, XMVectorScale(axis, along)));
+		viewSpheres[i] = XMFLOAT4(centre.x, centre.y, centre.z, radius);
+	}
+}
+
+// Fill a depth slice's clusters' light lists
+void LightClusters::BuildSlice(int z, bool simd)
+{
+	SliceLights& slice = slices[z];
+	float nearDepth = sliceDepths[z];
+	float farDepth = sliceDepths[z + 1];
+
+	//Gather the lights that reach the slice's depths
+	slice.lights.clear();
+	for (size_t i = 0; i < localLights.size(); i++)
+	{
+		XMFLOAT4 sphere = viewSpheres[i];
+		if (sphere.z + sphere.w >= nearDepth && sphere.z - sphere.w <= farDepth)
+			slice.lights.push_back((int)i);
+	}
+	slice.count = (int)slice.lights.size();
+	slice.capacity = (slice.count + MAX_LANES - 1) / MAX_LANES * MAX_LANES;
+
+	//Lay them out a field at a time (the padding is masked off)
+	slice.fields.assign((size_t)FIELD(Count) * slice.capacity, 0.0f);
+	float* fields = slice.fields.data();
+	size_t stride = slice.capacity;
+	for (int l = 0; l < slice.count; l++)
+	{
+		int i = slice.lights[l];
+		bool cone = viewAxes[i].x != 0 || viewAxes[i].y != 0 || viewAxes[i].z != 0;
+		float cosAngle = cone ? std::min(cosAngles[i], 1.0f) : -1.0f;
+		fields[FIELD(CentreX) * stride + l] = viewSpheres[i].x;
+		fields[FIELD(CentreY) * stride + l] = viewSpheres[i].y;
+		fields[FIELD(CentreZ) * stride + l] = viewSpheres[i].z;
+		fields[FIELD(Radius) * stride + l] = viewSpheres[i].w;
+		fields[FIELD(ApexX) * stride + l] = viewApexes[i].x;
+		fields[FIELD(ApexY) * stride + l] = viewApexes[i].y;
+		fields[FIELD(ApexZ) * stride + l] = viewApexes[i].z;
+		fields[FIELD(AxisX) * stride + l] = viewAxes[i].x;
+		fields[FIELD(AxisY) * stride + l] = viewAxes[i].y;
+		fields[FIELD(AxisZ) * stride + l] = viewAxes[i].z;
+		fields[FIELD(ConeCos) * stride + l] = cosAngle;
+		fields[FIELD(ConeSin) * stride + l] = cone ? sqrtf(1 - cosAngle * cosAngle) : 0.0f;
+		fields[FIELD(ConeRange) * stride + l] = ranges[i];
+	}
+
+	//Test them against every cluster in the slice
+	slice.indices.clear();
+	for (int y = 0; y < CLUSTER_COUNT_Y; y++)
+	{
+		//Rows go down the screen
+		float top = 1 - 2.0f * y / CLUSTER_COUNT_Y;
+		float bottom = 1 - 2.0f * (y + 1) / CLUSTER_COUNT_Y;
+		float minY = std::min(bottom * tanHalfFovY * nearDepth, bottom * tanHalfFovY * farDepth);
+		float maxY = std::max(top * tanHalfFovY * nearDepth, top * tanHalfFovY * farDepth);
+
+		for (int x = 0; x < CLUSTER_COUNT_X; x++)
+		{
+			float left = -1 + 2.0f * x / CLUSTER_COUNT_X;
+			float right = -1 + 2.0f * (x + 1) / CLUSTER_COUNT_X;
+			float minX = std::min(left * tanHalfFovX * nearDepth, left * tanHalfFovX * farDepth);
+			float maxX = std::max(right * tanHalfFovX * nearDepth, right * tanHalfFovX * farDepth);
+
+			ClusterBox box;
+			box.centre = XMFLOAT3((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, (nearDepth + farDepth) * 0.5f);
+			box.half = XMFLOAT3((maxX - minX) * 0.5f, (maxY - minY) * 0.5f, (farDepth - nearDepth) * 0.5f);
+			box.radius = sqrtf(box.half.x * box.half.x + box.half.y * box.half.y + box.half.z * box.half.z);
+
+			ClusterRange& range = clusterRanges[GetClusterIndex(x, y, z)];
+			range.offset = (unsigned int)slice.indices.size();
+			slice.indices.insert(slice.indices.end(), globalLights.begin(), globalLights.end());
+
+			//Keep the lanes that reach the cluster (and aren't padding)
+			auto keep = [&](int first, int mask)
+			{
+				mask &= (1 << std::min(slice.count - first, 31)) - 1;
+				for (; mask != 0; mask &= mask - 1)
+				{
+					int lane = 0;
+					while (!(mask & (1 << lane)))
+						lane++;
+					slice.indices.push_back(localLights[slice.lights[first + lane]]);
+				}
+			};
+
+			int i = 0;
+			if (simd)
+			{
+#ifdef BATCH_AVX
+				for (; i + AVXLanes::Width <= slice.count; i += AVXLanes::Width)
+					keep(i, ClusterKernel<AVXLanes>(box, fields + i, stride));
+#endif
+#ifdef BATCH_SSE
+				//The last partial set reads into the padding and ignores it
+				for (; i < slice.count; i += SSELanes::Width)
+					keep(i, ClusterKernel<SSELanes>(box, fields + i, stride));
+#endif
+			}
+			for (; i < slice.count; i++)
+				keep(i, ClusterKernel<ScalarLanes>(box, fields + i, stride));
+
+			range.count = (unsigned int)slice.indices.size() - range.offset;
+		}
+	}
+}
+
+// Join the slices' lists into one
+void LightClusters::JoinSlices()
+{
+	lightIndices.clear();
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		unsigned int base = (unsigned int)lightIndices.size();
+		for (int i = GetClusterIndex(0, 0, z); i < GetClusterIndex(0, 0, z + 1); i++)
+		{
+			clusterRanges[i].offset += base;
+		}
+		lightIndices.insert(lightIndices.end(), slices[z].indices.begin(), slices[z].indices.end());
+	}
+}
+
+// Fill every cluster's light list for a camera
+void LightClusters::Build(XMFLOAT3 cameraPosition, XMFLOAT3 cameraForward, XMFLOAT3 cameraUp,
+	float fov, float aspectRatio, float nearClip, float farClip)
+{
+	SetView(cameraPosition, cameraForward, cameraUp, fov, aspectRatio, nearClip, farClip);
+
+	//Slices only write their own clusters, so they can run in parallel
+	JobSystem::GetInstance()->ParallelFor(CLUSTER_COUNT_Z, CLUSTER_SLICES_PER_JOB, [&](int begin, int end)
+	{
+		for (int z = begin; z < end; z++)
+			BuildSlice(z, true);
+	});
+
+	JoinSlices();
+}
+
+// Fill every cluster's light list one light and one slice at a time
+void LightClusters::BuildScalar(XMFLOAT3 cameraPosition, XMFLOAT3 cameraForward, XMFLOAT3 cameraUp,
+	float fov, float aspectRatio, float nearClip, float farClip)
+{
+	SetView(cameraPosition, cameraForward, cameraUp, fov, aspectRatio, nearClip, farClip);
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++)
+		BuildSlice(z, false);
+
+	JoinSlices();
+}
+
+// Get the index of a cluster
+int LightClusters::GetClusterIndex(int x, int y, int z)
+{
+	return (z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x;
+}
+
+// Get the depth slice a view depth is in
+int LightClusters::GetSlice(float depth)
+{
+	if (depth <= 0)
+		return 0;
+	int slice = (int)floorf(logf(depth) * depthScale + depthBias);
+	return std::min(std::max(slice, 0), CLUSTER_COUNT_Z - 1);
+}
+
+// Get where each cluster's lights are in the light index list
+const ClusterRange* LightClusters::GetClusterRanges()
+{
+	return clusterRanges.data();
+}
+
+// Get every cluster's lights, one cluster after another
+const unsigned int* LightClusters::GetLightIndices()
+{
+	return lightIndices.data();
+}
+
+// Get the length of the light index list
+int LightClusters::GetLightIndexCount()
+{
+	return (int)lightIndices.size();
+}
+
+// Get the amount of lights added since the last Clear
+int LightClusters::GetLightCount()
+{
+	return lightCount;
+}
+
+// Get what a log view depth is multiplied by to get its slice
+float LightClusters::GetDepthScale()
+{
+	return depthScale;
+}
+
+// Get what's added to a scaled log view depth to get its slice
+float LightClusters::GetDepthBias()
+{
+	return depthBias;
+}
+
+// Get the widest lane count Build() tests with
+int LightClusters::GetLaneCount()
+{
+#if defined(BATCH_AVX)
+	return AVXLanes::Width;
+#elif defined(BATCH_SSE)
+	return SSELanes::Width;
+#else
+	return ScalarLanes::Width;
+#endif
+}
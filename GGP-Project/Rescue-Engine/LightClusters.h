@@ -0,0 +1,210 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+//Clusters the view is split into, across, down and by depth (matches Lighting.hlsli)
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define CLUSTER_COUNT (CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z)
+
+// --------------------------------------------------------
+// Where a cluster's lights are in the light index list
+// (matches the uint2 in Lighting.hlsli)
+// --------------------------------------------------------
+struct ClusterRange
+{
+	unsigned int offset;
+	unsigned int count;
+};
+
+// --------------------------------------------------------
+// A light's value the cluster tests use, in view space (one
+// array per field, so the lights can be tested a lane each)
+// --------------------------------------------------------
+enum class ClusterField
+{
+	CentreX, CentreY, CentreZ, Radius,       //Bounding sphere
+	ApexX, ApexY, ApexZ,       //Cone (a point light has no axis,
+	AxisX, AxisY, AxisZ,       //so its cone reaches everything)
+	ConeCos, ConeSin, ConeRange,
+	Count
+};
+
+// --------------------------------------------------------
+// Clustered light culling.
+//
+// The camera's view frustum is split into clusters: tiles of the
+// screen, sliced by depth (logarithmically, so far clusters are
+// about as deep as they are wide). Every frame, each cluster gets
+// a list of the lights that reach it, so a pixel only has to be
+// lit by its cluster's lights, however many lights there are.
+//
+// Each depth slice is a job on the JobSystem. A slice gathers the
+// lights that reach its depths, then tests them against each of its
+// clusters with SIMD, a light per lane: spheres against the
+// cluster's box, and spot lights' cones against the sphere around
+// it. Lights that reach everywhere (directional lights) are in
+// every cluster.
+//
+// Only does the math (no D3D), so it can be checked on the CPU
+// --------------------------------------------------------
+class LightClusters
+{
+private:
+	// --------------------------------------------------------
+	// The lights that reach a depth slice, laid out for the kernel
+	// --------------------------------------------------------
+	struct SliceLights
+	{
+		int count;
+		int capacity;       //Lights the fields have room for (a multiple of the widest lanes)
+		std::vector<float> fields;       //Each ClusterField of every light, one field after another
+		std::vector<int> lights;       //Light index of each lane
+
+		std::vector<unsigned int> indices;       //The slice's clusters' lights, one cluster after another
+	};
+
+	//Lights added since the last Clear (world space)
+	int lightCount;
+	std::vector<int> globalLights;       //Lights in every cluster
+	std::vector<int> localLights;       //Lights with a position and range
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> directions;       //0 for point lights
+	std::vector<float> ranges;
+	std::vector<float> cosAngles;       //Cosine of a spot light's half angle
+
+	//Local lights moved into the camera's view (bounding spheres and cones)
+	std::vector<DirectX::XMFLOAT4> viewSpheres;
+	std::vector<DirectX::XMFLOAT3> viewApexes;
+	std::vector<DirectX::XMFLOAT3> viewAxes;
+
+	//Grid
+	float tanHalfFovX;
+	float tanHalfFovY;
+	float sliceDepths[CLUSTER_COUNT_Z + 1];       //View depth each slice starts at (and the last one ends at)
+	float depthScale;       //Slice = log(depth) * depthScale + depthBias
+	float depthBias;
+
+	//Results
+	SliceLights slices[CLUSTER_COUNT_Z];
+	std::vector<ClusterRange> clusterRanges;
+	std::vector<unsigned int> lightIndices;
+
+	// --------------------------------------------------------
+	// Move the lights into the camera's view and split its depth
+	// --------------------------------------------------------
+	void SetView(DirectX::XMFLOAT3 cameraPosition, DirectX::XMFLOAT3 cameraForward, DirectX::XMFLOAT3 cameraUp,
+		float fov, float aspectRatio, float nearClip, float farClip);
+
+	// --------------------------------------------------------
+	// Fill a depth slice's clusters' light lists
+	//
+	// simd - test with the widest lanes there are (or one light at a time)
+	// --------------------------------------------------------
+	void BuildSlice(int z, bool simd);
+
+	// --------------------------------------------------------
+	// Join the slices' lists into one
+	// --------------------------------------------------------
+	void JoinSlices();
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty set of clusters
+	// --------------------------------------------------------
+	LightClusters();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~LightClusters();
+
+	// --------------------------------------------------------
+	// Forget every light (lights are numbered in the order
+	// they're added after this)
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Add a light that reaches everywhere (a directional light)
+	// --------------------------------------------------------
+	void AddGlobalLight();
+
+	// --------------------------------------------------------
+	// Add a light that reaches a sphere
+	// --------------------------------------------------------
+	void AddPointLight(DirectX::XMFLOAT3 position, float range);
+
+	// --------------------------------------------------------
+	// Add a light that reaches a cone
+	//
+	// direction - the way the cone points (normalized)
+	// range - length of the cone's sides
+	// cosAngle - cosine of the angle between its sides and its direction
+	// --------------------------------------------------------
+	void AddSpotLight(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction, float range, float cosAngle);
+
+	// --------------------------------------------------------
+	// Fill every cluster's light list for a camera. Call from the
+	// main thread (it uses the JobSystem)
+	//
+	// fov - vertical field of view (radians)
+	// aspectRatio - width / height
+	// --------------------------------------------------------
+	void Build(DirectX::XMFLOAT3 cameraPosition, DirectX::XMFLOAT3 cameraForward, DirectX::XMFLOAT3 cameraUp,
+		float fov, float aspectRatio, float nearClip, float farClip);
+
+	// --------------------------------------------------------
+	// Fill every cluster's light list one light and one slice at a time
+	// (for checking and benchmarking the SIMD path)
+	// --------------------------------------------------------
+	void BuildScalar(DirectX::XMFLOAT3 cameraPosition, DirectX::XMFLOAT3 cameraForward, DirectX::XMFLOAT3 cameraUp,
+		float fov, float aspectRatio, float nearClip, float farClip);
+
+	// --------------------------------------------------------
+	// Get the index of a cluster (x across and y down the screen)
+	// --------------------------------------------------------
+	static int GetClusterIndex(int x, int y, int z);
+
+	// --------------------------------------------------------
+	// Get the depth slice a view depth is in
+	// --------------------------------------------------------
+	int GetSlice(float depth);
+
+	// --------------------------------------------------------
+	// Get where each cluster's lights are in the light index list
+	// (CLUSTER_COUNT long)
+	// --------------------------------------------------------
+	const ClusterRange* GetClusterRanges();
+
+	// --------------------------------------------------------
+	// Get every cluster's lights, one cluster after another
+	// --------------------------------------------------------
+	const unsigned int* GetLightIndices();
+
+	// --------------------------------------------------------
+	// Get the length of the light index list
+	// --------------------------------------------------------
+	int GetLightIndexCount();
+
+	// --------------------------------------------------------
+	// Get the amount of lights added since the last Clear
+	// --------------------------------------------------------
+	int GetLightCount();
+
+	// --------------------------------------------------------
+	// Get what a log view depth is multiplied by to get its slice
+	// --------------------------------------------------------
+	float GetDepthScale();
+
+	// --------------------------------------------------------
+	// Get what's added to a scaled log view depth to get its slice
+	// --------------------------------------------------------
+	float GetDepthBias();
+
+	// --------------------------------------------------------
+	// Get the widest lane count Build() tests with
+	// --------------------------------------------------------
+	static int GetLaneCount();
+};
@@ -1,5 +1,6 @@
 #include "LightManager.h"
 #include <algorithm>
+#include <cstring>
 
 using namespace DirectX;
 
@@ -11,6 +12,21 @@ LightManager::~LightManager()
 		if (lightList[i]) { delete lightList[i]; }
 	}
 	if (lightStructArr) { delete[] lightStructArr; }
+	if (shadowViewArr) { delete[] shadowViewArr; }
+
+	if (shadowAtlasDSV) { shadowAtlasDSV->Release(); }
+	if (shadowAtlasSRV) { shadowAtlasSRV->Release(); }
+	if (shadowAtlasTexture) { shadowAtlasTexture->Release(); }
+	if (staticShadowAtlasDSV) { staticShadowAtlasDSV->Release(); }
+	if (staticShadowAtlasSRV) { staticShadowAtlasSRV->Release(); }
+	if (staticShadowAtlasTexture) { staticShadowAtlasTexture->Release(); }
+
+	if (clusterLightSRV) { clusterLightSRV->Release(); }
+	if (clusterLightBuffer) { clusterLightBuffer->Release(); }
+	if (clusterRangeSRV) { clusterRangeSRV->Release(); }
+	if (clusterRangeBuffer) { clusterRangeBuffer->Release(); }
+	if (clusterIndexSRV) { clusterIndexSRV->Release(); }
+	if (clusterIndexBuffer) { clusterIndexBuffer->Release(); }
 }
 
 // Initialize values in the LightManager
@@ -21,32 +37,29 @@ void LightManager::Init()
 	ambientLight->Color = XMFLOAT3(0, 0, 0);
 	ambientLight->Intensity = 1;
 
-	// Create the desc for the actual texture that will be the shadow map
-	shadowTexDesc = {};
-	shadowTexDesc.Width = SHADOW_MAP_SIZE;
-	shadowTexDesc.Height = SHADOW_MAP_SIZE;
-	shadowTexDesc.ArraySize = 1;
-	shadowTexDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
-	shadowTexDesc.CPUAccessFlags = 0;
-	shadowTexDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-	shadowTexDesc.MipLevels = 1;
-	shadowTexDesc.MiscFlags = 0;
-	shadowTexDesc.SampleDesc.Count = 1;
-	shadowTexDesc.SampleDesc.Quality = 0;
-	shadowTexDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	// Create the depth/stencil desc
-	shadowDSDesc = {};
-	shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
-	shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	shadowDSDesc.Texture2D.MipSlice = 0;
-
-	// Create the desc for shadow map creation
-	shadowSRVDesc = {};
-	shadowSRVDesc.Format = DXGI_FORMAT_R32_FLOAT;
-	shadowSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	shadowSRVDesc.Texture2D.MipLevels = 1;
-	shadowSRVDesc.Texture2D.MostDetailedMip = 0;
+	//The shadow atlas' textures are made when there's something to draw into them
+	shadowAtlas.Init(SHADOW_ATLAS_SIZE, SHADOW_MIN_TILE_SIZE);
+	shadowAtlasDirty = true;
+	shadowAtlasTexture = nullptr;
+	shadowAtlasDSV = nullptr;
+	shadowAtlasSRV = nullptr;
+	staticShadowAtlasTexture = nullptr;
+	staticShadowAtlasDSV = nullptr;
+	staticShadowAtlasSRV = nullptr;
+
+	shadowViewArr = new ShadowViewStruct[MAX_SHADOW_VIEWS]();
+	shadowViewCount = 0;
+
+	//The clusters' buffers are made the first time they're updated
+	lightStructArr = new LightStruct[MAX_LIGHTS]();
+	clusterGrid = XMFLOAT4(0, 0, 0, 0);
+	clusterLightBuffer = nullptr;
+	clusterLightSRV = nullptr;
+	clusterRangeBuffer = nullptr;
+	clusterRangeSRV = nullptr;
+	clusterIndexBuffer = nullptr;
+	clusterIndexSRV = nullptr;
+	clusterIndexCapacity = 0;
 }
 
 // Create a new directional light and add it to the light manager
@@ -252,11 +265,7 @@ void LightManager::RebuildLightLists()
 // Rebuild the light struct array from all lights in the lightList
 void LightManager::RebuildLightStructArray()
 {
-	//Reset array
-	if (lightStructArr) { delete lightStructArr; }
-	lightStructArr = new LightStruct[MAX_LIGHTS];
-
-	//Rebuild
+	//Rebuild (the array is MAX_LIGHTS long, so it's made once)
 	for (size_t i = 0; i < lightList.size(); i++)
 	{
 		lightStructArr[i] = *(lightList[i]->GetLightStruct());
@@ -280,31 +289,310 @@ std::vector<Light*> LightManager::GetShadowCastingLights()
 	return shadowLightList;
 }
 
-// Get the shadow texture description for creating shadowTexs
-D3D11_TEXTURE2D_DESC* LightManager::GetShadowTexDesc()
+// Get the shadow casting lights that have views in the atlas
+std::vector<Light*> LightManager::GetShadowAtlasLights()
 {
-	return &shadowTexDesc;
+	return shadowAtlasLights;
 }
 
-// Get the shadow depth/stencil description for creating shadowDSs
-D3D11_DEPTH_STENCIL_VIEW_DESC* LightManager::GetShadowDSDesc()
+// Create the shadow atlas and its static casters' cache
+void LightManager::InitShadowAtlas(ID3D11Device* device)
 {
-	return &shadowDSDesc;
+	if (shadowAtlasTexture != nullptr)
+		return;
+
+	// Create the desc for the actual texture that will be the shadow atlas
+	D3D11_TEXTURE2D_DESC shadowTexDesc = {};
+	shadowTexDesc.Width = SHADOW_ATLAS_SIZE;
+	shadowTexDesc.Height = SHADOW_ATLAS_SIZE;
+	shadowTexDesc.ArraySize = 1;
+	shadowTexDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	shadowTexDesc.CPUAccessFlags = 0;
+	shadowTexDesc.Format = DXGI_FORMAT_R16_TYPELESS;       //16 bits is plenty for a tile's depth range
+	shadowTexDesc.MipLevels = 1;
+	shadowTexDesc.MiscFlags = 0;
+	shadowTexDesc.SampleDesc.Count = 1;
+	shadowTexDesc.SampleDesc.Quality = 0;
+	shadowTexDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	// Create the depth/stencil desc
+	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
+	shadowDSDesc.Format = DXGI_FORMAT_D16_UNORM;
+	shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	shadowDSDesc.Texture2D.MipSlice = 0;
+
+	// Create the desc for the shadow atlas' SRV
+	D3D11_SHADER_RESOURCE_VIEW_DESC shadowSRVDesc = {};
+	shadowSRVDesc.Format = DXGI_FORMAT_R16_UNORM;
+	shadowSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	shadowSRVDesc.Texture2D.MipLevels = 1;
+	shadowSRVDesc.Texture2D.MostDetailedMip = 0;
+
+	//The static casters' cache has the same tiles, and is read when copying it into the atlas
+	device->CreateTexture2D(&shadowTexDesc, 0, &shadowAtlasTexture);
+	device->CreateDepthStencilView(shadowAtlasTexture, &shadowDSDesc, &shadowAtlasDSV);
+	device->CreateShaderResourceView(shadowAtlasTexture, &shadowSRVDesc, &shadowAtlasSRV);
+	device->CreateTexture2D(&shadowTexDesc, 0, &staticShadowAtlasTexture);
+	device->CreateDepthStencilView(staticShadowAtlasTexture, &shadowDSDesc, &staticShadowAtlasDSV);
+	device->CreateShaderResourceView(staticShadowAtlasTexture, &shadowSRVDesc, &staticShadowAtlasSRV);
 }
 
-// Get the shadow resource view description for creating shadowSRVs
-D3D11_SHADER_RESOURCE_VIEW_DESC* LightManager::GetShadowSRVDesc()
+// Give every shadow casting light's views a tile in the atlas
+void LightManager::PackShadowAtlas(Camera* camera)
 {
-	return &shadowSRVDesc;
+	//Lights that cover more of the screen go first (and get bigger tiles)
+	std::vector<Light*> lights = shadowLightList;
+	std::vector<float> importances(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		importances[i] = lights[i]->GetShadowImportance(camera);
+	}
+	std::vector<int> order(lights.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = (int)i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&importances](int a, int b) { return importances[a] > importances[b]; });
+
+	//Only as many views as the shaders have room for
+	shadowAtlasLights.clear();
+	std::vector<int> sizes;
+	for (int i : order)
+	{
+		int count = lights[i]->GetShadowViewCount();
+		if (sizes.size() + count > MAX_SHADOW_VIEWS)
+		{
+			printf("Can't fit light of type %d's shadows. MAX_SHADOW_VIEWS (%d) reached", lights[i]->GetType(), MAX_SHADOW_VIEWS);
+			continue;
+		}
+
+		//Every view of a light gets the same size tile
+		int size = ShadowAtlas::GetTileSize(importances[i], SHADOW_MIN_TILE_SIZE, SHADOW_MAX_TILE_SIZE);
+		sizes.insert(sizes.end(), count, size);
+		shadowAtlasLights.push_back(lights[i]);
+	}
+	std::vector<ShadowAtlasRect> rects(sizes.size());
+	shadowAtlas.Pack(sizes.data(), (int)sizes.size(), rects.data());
+
+	//Hand out the tiles
+	for (auto light : lightList)
+	{
+		light->SetShadowViewRange(0, 0);
+	}
+	shadowViewCount = 0;
+	for (auto light : shadowAtlasLights)
+	{
+		int count = light->GetShadowViewCount();
+		int tileSize = 0;
+		for (int v = 0; v < count; v++)
+		{
+			ShadowAtlasRect rect = rects[shadowViewCount + v];
+			light->SetShadowRect(v, rect);
+			if (rect.size > 0)
+				tileSize = tileSize == 0 ? rect.size : std::min(tileSize, rect.size);
+		}
+
+		//Views snapped to the smallest tile's texels are snapped to the bigger ones' too
+		light->SetShadowTileSize(tileSize == 0 ? SHADOW_MIN_TILE_SIZE : tileSize);
+		light->SetShadowViewRange(shadowViewCount, count);
+		shadowViewCount += count;
+	}
+
+	//The lights' structs point to their views now
+	RebuildLightStructArray();
+}
+
+// Get the shadow views ready to be drawn and sampled this frame
+void LightManager::UpdateShadowViews(Camera* camera)
+{
+	if (listDirty)
+		RebuildLightLists();
+
+	//Only repack when lights are added or removed, so the tiles (and their cached static casters) stay put
+	if (shadowAtlasDirty)
+	{
+		PackShadowAtlas(camera);
+		shadowAtlasDirty = false;
+	}
+
+	int view = 0;
+	for (auto light : shadowAtlasLights)
+	{
+		light->FitShadowViews(camera);
+		for (int v = 0; v < light->GetShadowViewCount(); v++)
+		{
+			shadowViewArr[view++] = light->GetShadowViewData(v, SHADOW_ATLAS_SIZE);
+		}
+	}
+}
+
+// Get the array of shadow view structs for sending to a shader
+ShadowViewStruct* LightManager::GetShadowViewArray()
+{
+	return shadowViewArr;
+}
+
+// Get texels along each side of the shadow atlas
+int LightManager::GetShadowAtlasSize()
+{
+	return SHADOW_ATLAS_SIZE;
+}
+
+// Get the depth/stencil view of the shadow atlas
+ID3D11DepthStencilView* LightManager::GetShadowAtlasDSV()
+{
+	return shadowAtlasDSV;
+}
+
+// Get the shadow atlas' SRV for sampling the shadows
+ID3D11ShaderResourceView* LightManager::GetShadowAtlasSRV()
+{
+	return shadowAtlasSRV;
+}
+
+// Get the depth/stencil view of the static casters' cache
+ID3D11DepthStencilView* LightManager::GetStaticShadowAtlasDSV()
+{
+	return staticShadowAtlasDSV;
+}
+
+// Get the static casters' cache's SRV for copying it into the atlas
+ID3D11ShaderResourceView* LightManager::GetStaticShadowAtlasSRV()
+{
+	return staticShadowAtlasSRV;
 }
 
 // Rebuild the shadow light list
 void LightManager::RebuildShadowLightList()
 {
+	std::vector<Light*> lastShadowLightList = shadowLightList;
 	shadowLightList.clear();
 	for (auto light : lightList)
 	{
 		if (light->GetCastsShadows())
 			shadowLightList.push_back(light);
 	}
-}
\ No newline at end of file
+
+	//Repack the atlas if shadow casting lights were added or removed
+	if (shadowLightList != lastShadowLightList)
+		shadowAtlasDirty = true;
+}
+// Bin every light into the clusters of the camera's view and upload them for the pixel shaders
+void LightManager::UpdateLightClusters(ID3D11Device* device, ID3D11DeviceContext* context, Camera* camera,
+	UINT width, UINT height)
+{
+	if (listDirty)
+		RebuildLightLists();
+
+	//Lights can move without telling the manager, so their structs are refreshed every frame
+	RebuildLightStructArray();
+
+	lightClusters.Clear();
+	for (auto light : lightList)
+	{
+		LightStruct* lightStruct = light->GetLightStruct();
+		switch (light->GetType())
+		{
+		case LightType::DirectionalLight:
+			lightClusters.AddGlobalLight();
+			break;
+
+		case LightType::PointLight:
+			lightClusters.AddPointLight(lightStruct->Position, lightStruct->Range);
+			break;
+
+		case LightType::SpotLight:
+			lightClusters.AddSpotLight(lightStruct->Position, lightStruct->Direction, lightStruct->Range,
+				((SpotLight*)light)->GetConeCos());
+			break;
+		}
+	}
+	lightClusters.Build(camera->GetPosition(), camera->GetForwardAxis(), camera->GetUpAxis(),
+		camera->GetFOV(), camera->GetAspectRatio(), camera->GetNearClip(), camera->GetFarClip());
+	clusterGrid = XMFLOAT4((float)CLUSTER_COUNT_X / width, (float)CLUSTER_COUNT_Y / height,
+		lightClusters.GetDepthScale(), lightClusters.GetDepthBias());
+
+	//Make the buffers, and grow the light index buffer if the lists don't fit
+	if (clusterLightBuffer == nullptr)
+	{
+		CreateClusterBuffer(device, sizeof(LightStruct), MAX_LIGHTS, &clusterLightBuffer, &clusterLightSRV);
+		CreateClusterBuffer(device, sizeof(ClusterRange), CLUSTER_COUNT, &clusterRangeBuffer, &clusterRangeSRV);
+	}
+	int indexCount = lightClusters.GetLightIndexCount();
+	if (indexCount > clusterIndexCapacity || clusterIndexBuffer == nullptr)
+	{
+		if (clusterIndexSRV) { clusterIndexSRV->Release(); }
+		if (clusterIndexBuffer) { clusterIndexBuffer->Release(); }
+		clusterIndexCapacity = std::max(std::max(indexCount, clusterIndexCapacity * 2), CLUSTER_COUNT * CLUSTER_START_LIGHTS);
+		CreateClusterBuffer(device, sizeof(unsigned int), clusterIndexCapacity, &clusterIndexBuffer, &clusterIndexSRV);
+	}
+
+	UploadClusterBuffer(context, clusterLightBuffer, lightStructArr, sizeof(LightStruct) * lightList.size());
+	UploadClusterBuffer(context, clusterRangeBuffer, lightClusters.GetClusterRanges(), sizeof(ClusterRange) * CLUSTER_COUNT);
+	UploadClusterBuffer(context, clusterIndexBuffer, lightClusters.GetLightIndices(), sizeof(unsigned int) * indexCount);
+}
+
+// Create a dynamic structured buffer and its SRV
+void LightManager::CreateClusterBuffer(ID3D11Device* device, UINT stride, UINT count,
+	ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv)
+{
+	// Create the desc for a buffer the CPU rewrites every frame
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = stride * count;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bufferDesc.StructureByteStride = stride;
+
+	// Create the desc for its SRV
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = count;
+
+	if (FAILED(device->CreateBuffer(&bufferDesc, 0, buffer)))
+	{
+		printf("Failed to create a light cluster buffer of %u elements", count);
+		*buffer = nullptr;
+		*srv = nullptr;
+		return;
+	}
+	device->CreateShaderResourceView(*buffer, &srvDesc, srv);
+}
+
+// Copy data into a dynamic buffer
+void LightManager::UploadClusterBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const void* data, size_t size)
+{
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (buffer != nullptr && SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+	{
+		memcpy(mapped.pData, data, size);
+		context->Unmap(buffer, 0);
+	}
+}
+
+// Get the SRV of every light's struct
+ID3D11ShaderResourceView* LightManager::GetClusterLightSRV()
+{
+	return clusterLightSRV;
+}
+
+// Get the SRV of where each cluster's lights are in the light index buffer
+ID3D11ShaderResourceView* LightManager::GetClusterRangeSRV()
+{
+	return clusterRangeSRV;
+}
+
+// Get the SRV of every cluster's lights
+ID3D11ShaderResourceView* LightManager::GetClusterIndexSRV()
+{
+	return clusterIndexSRV;
+}
+
+// Get what the pixel shaders need to find their cluster
+XMFLOAT4 LightManager::GetClusterGrid()
+{
+	return clusterGrid;
+}
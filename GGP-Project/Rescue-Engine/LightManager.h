@@ -1,8 +1,15 @@
 #pragma once
 #include "Lights.h"
+#include "LightClusters.h"
 #include <vector>
 
-#define SHADOW_MAP_SIZE 2048
+//Every shadow is drawn into one atlas, in square tiles sized by how much of the screen the light covers
+#define SHADOW_ATLAS_SIZE 4096
+#define SHADOW_MIN_TILE_SIZE 128
+#define SHADOW_MAX_TILE_SIZE 2048
+
+//Room for this many of each cluster's lights in the light index buffer at first (it grows when it runs out)
+#define CLUSTER_START_LIGHTS 4
 
 class LightManager
 {
@@ -22,15 +29,38 @@ private:
 	AmbientLightStruct* ambientLight;
 	std::vector<Light*> lightList;
 	std::vector<Light*> shadowLightList;
+	std::vector<Light*> shadowAtlasLights;       //Shadow casting lights with views in the atlas, in view order
 
 	//Light struct array helpers
 	bool listDirty;
 	LightStruct* lightStructArr;
 
-	//Shadow descs
-	D3D11_TEXTURE2D_DESC shadowTexDesc;
-	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc;
-	D3D11_SHADER_RESOURCE_VIEW_DESC shadowSRVDesc;
+	//Shadow atlas (every shadow casting light's views, in tiles)
+	ShadowAtlas shadowAtlas;
+	bool shadowAtlasDirty;       //The shadow casting lights changed since it was packed
+	ID3D11Texture2D* shadowAtlasTexture;
+	ID3D11DepthStencilView* shadowAtlasDSV;
+	ID3D11ShaderResourceView* shadowAtlasSRV;
+
+	//Static casters' depth, cached in the same tiles and copied into the shadow atlas every frame
+	ID3D11Texture2D* staticShadowAtlasTexture;
+	ID3D11DepthStencilView* staticShadowAtlasDSV;
+	ID3D11ShaderResourceView* staticShadowAtlasSRV;
+
+	//Shadow view array helpers
+	ShadowViewStruct* shadowViewArr;
+	int shadowViewCount;
+
+	//Clustered lights (every light's struct, and the lights that reach each cluster of the camera's view)
+	LightClusters lightClusters;
+	DirectX::XMFLOAT4 clusterGrid;       //Clusters per pixel across and down, and the depth slices' scale and bias
+	ID3D11Buffer* clusterLightBuffer;
+	ID3D11ShaderResourceView* clusterLightSRV;
+	ID3D11Buffer* clusterRangeBuffer;
+	ID3D11ShaderResourceView* clusterRangeSRV;
+	ID3D11Buffer* clusterIndexBuffer;
+	ID3D11ShaderResourceView* clusterIndexSRV;
+	int clusterIndexCapacity;
 
 	// --------------------------------------------------------
 	//Set the light manager's light list to dirty
@@ -54,6 +84,25 @@ private:
 	// --------------------------------------------------------
 	void RebuildLightStructArray();
 
+	// --------------------------------------------------------
+	// Give every shadow casting light's views a tile in the atlas
+	// --------------------------------------------------------
+	void PackShadowAtlas(Camera* camera);
+
+	// --------------------------------------------------------
+	// Create a dynamic structured buffer and its SRV
+	//
+	// stride - bytes per element
+	// count - elements in the buffer
+	// --------------------------------------------------------
+	void CreateClusterBuffer(ID3D11Device* device, UINT stride, UINT count,
+		ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv);
+
+	// --------------------------------------------------------
+	// Copy data into a dynamic buffer
+	// --------------------------------------------------------
+	void UploadClusterBuffer(ID3D11DeviceContext* context, ID3D11Buffer* buffer, const void* data, size_t size);
+
 public:
 	// --------------------------------------------------------
 	// Get the singleton instance of the LightManager
@@ -168,18 +217,85 @@ public:
 	std::vector<Light*> GetShadowCastingLights();
 
 	// --------------------------------------------------------
-	// Get the shadow texture description for creating shadowTexs
+	// Get the shadow casting lights that have views in the atlas
+	// (in the order of their views)
+	// --------------------------------------------------------
+	std::vector<Light*> GetShadowAtlasLights();
+
+	// --------------------------------------------------------
+	// Create the shadow atlas and its static casters' cache
+	// (if they don't exist yet)
+	// --------------------------------------------------------
+	void InitShadowAtlas(ID3D11Device* device);
+
+	// --------------------------------------------------------
+	// Get the shadow views ready to be drawn and sampled this frame:
+	// repack the atlas if the shadow casting lights changed, fit the
+	// lights' views to the camera and rebuild the shadow view array
+	// --------------------------------------------------------
+	void UpdateShadowViews(Camera* camera);
+
+	// --------------------------------------------------------
+	// Get the array of shadow view structs for sending to a shader
+	// (MAX_SHADOW_VIEWS long)
+	// --------------------------------------------------------
+	ShadowViewStruct* GetShadowViewArray();
+
+	// --------------------------------------------------------
+	// Get texels along each side of the shadow atlas
+	// --------------------------------------------------------
+	int GetShadowAtlasSize();
+
+	// --------------------------------------------------------
+	// Get the depth/stencil view of the shadow atlas
+	// --------------------------------------------------------
+	ID3D11DepthStencilView* GetShadowAtlasDSV();
+
+	// --------------------------------------------------------
+	// Get the shadow atlas' SRV for sampling the shadows
+	// --------------------------------------------------------
+	ID3D11ShaderResourceView* GetShadowAtlasSRV();
+
+	// --------------------------------------------------------
+	// Get the depth/stencil view of the static casters' cache
+	// --------------------------------------------------------
+	ID3D11DepthStencilView* GetStaticShadowAtlasDSV();
+
+	// --------------------------------------------------------
+	// Get the static casters' cache's SRV for copying it into the atlas
+	// --------------------------------------------------------
+	ID3D11ShaderResourceView* GetStaticShadowAtlasSRV();
+
+	// --------------------------------------------------------
+	// Bin every light into the clusters of the camera's view and
+	// upload them for the pixel shaders (lights can move every
+	// frame, so call once a frame before drawing)
+	//
+	// width, height - size of the screen in pixels
+	// --------------------------------------------------------
+	void UpdateLightClusters(ID3D11Device* device, ID3D11DeviceContext* context, Camera* camera,
+		UINT width, UINT height);
+
+	// --------------------------------------------------------
+	// Get the SRV of every light's struct (MAX_LIGHTS long)
+	// --------------------------------------------------------
+	ID3D11ShaderResourceView* GetClusterLightSRV();
+
+	// --------------------------------------------------------
+	// Get the SRV of where each cluster's lights are in the light
+	// index buffer (CLUSTER_COUNT long)
 	// --------------------------------------------------------
-	D3D11_TEXTURE2D_DESC* GetShadowTexDesc();
+	ID3D11ShaderResourceView* GetClusterRangeSRV();
 
 	// --------------------------------------------------------
-	// Get the shadow depth/stencil description for creating shadowDSs
+	// Get the SRV of every cluster's lights, one cluster after another
 	// --------------------------------------------------------
-	D3D11_DEPTH_STENCIL_VIEW_DESC* GetShadowDSDesc();
+	ID3D11ShaderResourceView* GetClusterIndexSRV();
 
 	// --------------------------------------------------------
-	// Get the shadow resource view description for creating shadowSRVs
+	// Get what the pixel shaders need to find their cluster: clusters
+	// per pixel across and down, and the depth slices' scale and bias
 	// --------------------------------------------------------
-	D3D11_SHADER_RESOURCE_VIEW_DESC* GetShadowSRVDesc();
+	DirectX::XMFLOAT4 GetClusterGrid();
 };
 
@@ -1,4 +1,20 @@
 #include "LightManager.h"
+#include <cfloat>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+//Directional lights' shadow cascades (each gets a tile of the shadow atlas)
+#define SHADOW_CASCADE_COUNT 2
+#define SHADOW_SPLIT_LAMBDA 0.5f
+#define SHADOW_DISTANCE 60.0f
+
+//Closest to a point or spot light its shadows are drawn from
+#define SHADOW_NEAR_CLIP 0.1f
+
+//Narrowest and widest a spot light's shadow frustum gets (degrees)
+#define SPOT_SHADOW_MIN_FOV 10.0f
+#define SPOT_SHADOW_MAX_FOV 120.0f
 
 using namespace DirectX;
 
@@ -12,8 +28,12 @@ Light::Light(LightType type, bool castShadows)
 {
 	inLightManager = false;
 	SetCastsShadows(castShadows);
-	shadowDSV = nullptr;
-	shadowSRV = nullptr;
+	for (int i = 0; i < MAX_LIGHT_SHADOW_VIEWS; i++)
+	{
+		shadowRects[i] = { 0, 0, 0 };
+		staticShadowRects[i] = { 0, 0, 0 };
+		staticShadowVersions[i] = 0;
+	}
 
 	lightStruct = new LightStruct();
 	lightStruct->Type = (int)type;
@@ -24,7 +44,9 @@ Light::Light(LightType type, bool castShadows)
 	lightStruct->Color = XMFLOAT3(0.5f, 0.5f, 0.5f);
 
 	lightStruct->SpotFalloff = 0;
-	lightStruct->Padding = XMFLOAT3();
+	lightStruct->ShadowStart = 0;
+	lightStruct->ShadowCount = 0;
+	lightStruct->Padding = 0;
 }
 
 // Constructor - Set up a light
@@ -32,8 +54,12 @@ Light::Light(LightType type, bool castShadows, XMFLOAT3 color, float intensity)
 {
 	inLightManager = false;
 	SetCastsShadows(castShadows);
-	shadowDSV = nullptr;
-	shadowSRV = nullptr;
+	for (int i = 0; i < MAX_LIGHT_SHADOW_VIEWS; i++)
+	{
+		shadowRects[i] = { 0, 0, 0 };
+		staticShadowRects[i] = { 0, 0, 0 };
+		staticShadowVersions[i] = 0;
+	}
 
 	lightStruct = new LightStruct();
 	lightStruct->Type = (int)type;
@@ -46,12 +72,6 @@ Light::~Light()
 {
 	if (lightStruct)
 		delete lightStruct;
-
-	if (shadowDSV != nullptr)
-		shadowDSV->Release();
-
-	if (shadowSRV != nullptr)
-		shadowSRV->Release();
 }
 
 // Get the light struct to pass to the shader
@@ -120,42 +140,124 @@ bool Light::GetCastsShadows()
 // Set whether this light casts shadows or not
 void Light::SetCastsShadows(bool castShadows)
 {
+	if (inLightManager)
+		SetLightListDirty(LightManager::GetInstance());
+
 	castsShadows = castShadows;
 }
 
-// Get the shadow depth/stencil for this light
-ID3D11DepthStencilView * Light::GetShadowDSV()
+// Set where a shadow view is drawn in the shadow atlas
+void Light::SetShadowRect(int view, ShadowAtlasRect rect)
+{
+	shadowRects[view] = rect;
+}
+
+// Get where a shadow view is drawn in the shadow atlas
+ShadowAtlasRect Light::GetShadowRect(int view)
+{
+	return shadowRects[view];
+}
+
+// Set where this light's shadow views start in the shadow view array
+void Light::SetShadowViewRange(int start, int count)
+{
+	lightStruct->ShadowStart = start;
+	lightStruct->ShadowCount = count;
+}
+
+// Check if a view's cached static casters can be used
+bool Light::IsStaticShadowCurrent(int view, unsigned int staticVersion)
+{
+	if (staticShadowVersions[view] != staticVersion)
+		return false;
+
+	//Repacking the atlas moves the tile
+	ShadowAtlasRect rect = shadowRects[view];
+	ShadowAtlasRect staticRect = staticShadowRects[view];
+	if (rect.x != staticRect.x || rect.y != staticRect.y || rect.size != staticRect.size)
+		return false;
+
+	//The light moving or turning, or the cascade moving, changes its matrices
+	XMFLOAT4X4 viewMatrix = GetShadowViewMatrix(view);
+	XMFLOAT4X4 projection = GetShadowProjectionMatrix(view);
+	return memcmp(&viewMatrix, &staticShadowViews[view], sizeof(XMFLOAT4X4)) == 0 &&
+		memcmp(&projection, &staticShadowProjections[view], sizeof(XMFLOAT4X4)) == 0;
+}
+
+// Mark a view's static casters as drawn with its current matrices
+void Light::SetStaticShadowCurrent(int view, unsigned int staticVersion)
+{
+	staticShadowVersions[view] = staticVersion;
+	staticShadowViews[view] = GetShadowViewMatrix(view);
+	staticShadowProjections[view] = GetShadowProjectionMatrix(view);
+	staticShadowRects[view] = shadowRects[view];
+}
+
+// Get how much of the screen this light's shadows cover
+float Light::GetShadowImportance(Camera* camera)
+{
+	return 1;
+}
+
+// Tell this light the smallest tile its views got in the atlas
+void Light::SetShadowTileSize(int size)
+{
+}
+
+// Fit this light's shadow views to a camera
+void Light::FitShadowViews(Camera* camera)
+{
+}
+
+// Get the amount of views this light's shadows are drawn from
+int Light::GetShadowViewCount()
+{
+	return 1;
+}
+
+// Get a shadow view's view matrix
+XMFLOAT4X4 Light::GetShadowViewMatrix(int view)
 {
-	return shadowDSV;
+	return GetViewMatrix();
 }
 
-// Get the shadow SRV for this light
-ID3D11ShaderResourceView* Light::GetShadowSRV()
+// Get a shadow view's projection matrix
+XMFLOAT4X4 Light::GetShadowProjectionMatrix(int view)
 {
-	return shadowSRV;
+	return GetProjectionMatrix();
 }
 
-// Create the SRV for this light's shadow map
-void Light::InitShadowMap(ID3D11Device* device)
+// Get the view depth a shadow view stops being used at
+float Light::GetShadowViewEnd(int view)
 {
-	if (shadowSRV != nullptr)
-		return;
+	return FLT_MAX;
+}
 
-	//Create the shadow texture
-	D3D11_TEXTURE2D_DESC shadowTexDesc = *(LightManager::GetInstance()->GetShadowTexDesc());
-	ID3D11Texture2D* shadowTexture;
-	device->CreateTexture2D(&shadowTexDesc, 0, &shadowTexture);
+// Get what the pixel shaders need to sample a shadow view
+ShadowViewStruct Light::GetShadowViewData(int view, int atlasSize)
+{
+	ShadowViewStruct data = {};
 
-	// Create the depth/stencil
-	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = *(LightManager::GetInstance()->GetShadowDSDesc());
-	device->CreateDepthStencilView(shadowTexture, &shadowDSDesc, &shadowDSV);
+	//The matrices are transposed, so they multiply the other way around
+	XMFLOAT4X4 viewMatrix = GetShadowViewMatrix(view);
+	XMFLOAT4X4 projection = GetShadowProjectionMatrix(view);
+	XMStoreFloat4x4(&data.ViewProjection, XMMatrixMultiply(XMLoadFloat4x4(&projection), XMLoadFloat4x4(&viewMatrix)));
 
-	// Create the SRV for the shadow map
-	D3D11_SHADER_RESOURCE_VIEW_DESC shadowSRVDesc = *(LightManager::GetInstance()->GetShadowSRVDesc());
-	device->CreateShaderResourceView(shadowTexture, &shadowSRVDesc, &shadowSRV);
+	float texel = 1.0f / atlasSize;
+	ShadowAtlasRect rect = shadowRects[view];
+	data.AtlasRect = XMFLOAT4(rect.x * texel, rect.y * texel, rect.size * texel, texel);
+	data.CascadeEnd = GetShadowViewEnd(view);
+	return data;
+}
 
-	// Release the texture reference since we don't need it
-	shadowTexture->Release();
+// How much of the screen a sphere covers (1 if the camera is in it)
+static float GetSphereImportance(Camera* camera, XMFLOAT3 centre, float radius)
+{
+	XMFLOAT3 cameraPosition = camera->GetPosition();
+	float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&centre), XMLoadFloat3(&cameraPosition))));
+	if (distance <= radius)
+		return 1;
+	return std::min(radius / (distance * tanf(camera->GetFOV() * 0.5f)), 1.0f);
 }
 
 #pragma endregion
@@ -170,6 +272,7 @@ void Light::InitShadowMap(ID3D11Device* device)
 // White ambient and diffuse color.
 DirectionalLight::DirectionalLight(bool castShadows) : Light::Light(LightType::DirectionalLight, castShadows)
 { 
+	cascades.Init(SHADOW_CASCADE_COUNT, SHADOW_MAX_TILE_SIZE, SHADOW_SPLIT_LAMBDA, SHADOW_DISTANCE);
 	CalculateViewMatrix();
 	CalculateProjMatrix();
 }
@@ -178,6 +281,7 @@ DirectionalLight::DirectionalLight(bool castShadows) : Light::Light(LightType::D
 DirectionalLight::DirectionalLight(bool castShadows, XMFLOAT3 color, float intensity) :
 	Light::Light(LightType::DirectionalLight, castShadows, color, intensity)
 { 
+	cascades.Init(SHADOW_CASCADE_COUNT, SHADOW_MAX_TILE_SIZE, SHADOW_SPLIT_LAMBDA, SHADOW_DISTANCE);
 	CalculateViewMatrix();
 	CalculateProjMatrix();
 }
@@ -228,6 +332,56 @@ DirectX::XMFLOAT4X4 DirectionalLight::GetProjectionMatrix()
 	CalculateProjMatrix();
 	return shadowProj;
 }
+
+// Only fit the shadow cascades to what's in a box
+void DirectionalLight::SetShadowBounds(XMFLOAT3 min, XMFLOAT3 max)
+{
+	cascades.SetSceneBounds(min, max);
+}
+
+// Get how much of the screen this light's shadows cover
+float DirectionalLight::GetShadowImportance(Camera* camera)
+{
+	return 1;
+}
+
+// Snap the cascades to the texels of the tiles they got
+void DirectionalLight::SetShadowTileSize(int size)
+{
+	cascades.SetMapSize(size);
+}
+
+// Fit this light's shadow cascades to a camera
+void DirectionalLight::FitShadowViews(Camera* camera)
+{
+	cascades.Fit(camera->GetPosition(), camera->GetForwardAxis(), camera->GetUpAxis(),
+		camera->GetFOV(), camera->GetAspectRatio(), camera->GetNearClip(), camera->GetFarClip(),
+		GetForwardAxis());
+}
+
+// Get the amount of cascades this light's shadows have
+int DirectionalLight::GetShadowViewCount()
+{
+	return cascades.GetCount();
+}
+
+// Get a cascade's view matrix
+XMFLOAT4X4 DirectionalLight::GetShadowViewMatrix(int view)
+{
+	return cascades.GetViewMatrix(view);
+}
+
+// Get a cascade's projection matrix
+XMFLOAT4X4 DirectionalLight::GetShadowProjectionMatrix(int view)
+{
+	return cascades.GetProjectionMatrix(view);
+}
+
+// Get the view depth a cascade ends at
+float DirectionalLight::GetShadowViewEnd(int view)
+{
+	return cascades.GetSplit(view + 1);
+}
 #pragma endregion
 
 
@@ -268,37 +422,71 @@ float PointLight::GetRadius()
 	return lightStruct->Range;
 }
 
-// Calculate view for shadow rendering
+// Calculate view for shadow rendering (a view down each axis)
 void PointLight::CalculateViewMatrix()
 {
-	//TODO: Implement point light shadow maps
-	printf("Point light shadow maps are not supported (yet)");
-}
-
-// Calculate projection for shadow rendering
+	XMVECTOR position = XMLoadFloat3(&GetPosition());
+	XMVECTOR directions[6] = {
+		XMVectorSet(1, 0, 0, 0), XMVectorSet(-1, 0, 0, 0),
+		XMVectorSet(0, 1, 0, 0), XMVectorSet(0, -1, 0, 0),
+		XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, -1, 0) };
+	XMVECTOR ups[6] = {
+		XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 1, 0, 0),
+		XMVectorSet(0, 0, -1, 0), XMVectorSet(0, 0, 1, 0),
+		XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 1, 0, 0) };
+	for (int i = 0; i < 6; i++)
+	{
+		XMStoreFloat4x4(&faceViews[i], XMMatrixTranspose(XMMatrixLookToLH(position, directions[i], ups[i])));
+	}
+	shadowView = faceViews[0];
+}
+
+// Calculate projection for shadow rendering (a cube face out to the radius)
 void PointLight::CalculateProjMatrix()
 {
-	//TODO: Implement point light shadow maps
-	printf("Point light shadow maps are not supported (yet)");
+	XMMATRIX proj = XMMatrixTranspose(XMMatrixPerspectiveFovLH(
+		XM_PIDIV2,
+		1,
+		SHADOW_NEAR_CLIP,
+		std::max(lightStruct->Range, SHADOW_NEAR_CLIP * 2)));
+	XMStoreFloat4x4(&shadowProj, proj);
 }
 
 // Get this light's view matrix (for shadows)
 DirectX::XMFLOAT4X4 PointLight::GetViewMatrix()
 {
-	//TODO: Calculate view for point lights
 	//TODO: Calculate matrices only when light changes
-	printf("Point light shadow maps are not supported (yet)");
+	CalculateViewMatrix();
 	return shadowView;
 }
 
 // Get this light's projection matrix (for shadows)
 DirectX::XMFLOAT4X4 PointLight::GetProjectionMatrix()
 {
-	//TODO: Calculate proj for point lights
 	//TODO: Calculate matrices only when light changes
-	printf("Point light shadow maps are not supported (yet)");
+	CalculateProjMatrix();
 	return shadowProj;
 }
+
+// Get how much of the screen this light's sphere covers
+float PointLight::GetShadowImportance(Camera* camera)
+{
+	return GetSphereImportance(camera, GetPosition(), lightStruct->Range);
+}
+
+// Get the amount of cube faces this light's shadows are drawn from
+int PointLight::GetShadowViewCount()
+{
+	return 6;
+}
+
+// Get a cube face's view matrix
+XMFLOAT4X4 PointLight::GetShadowViewMatrix(int view)
+{
+	//TODO: Calculate matrices only when light changes
+	CalculateViewMatrix();
+	return faceViews[view];
+}
 #pragma endregion
 
 
@@ -353,7 +541,7 @@ void SpotLight::SetRange(float spotRadius)
 // Get the spot radius of this light
 float SpotLight::GetRange()
 {
-	return lightStruct->SpotFalloff;
+	return lightStruct->Range;
 }
 
 // Get the direction of this light
@@ -362,37 +550,60 @@ XMFLOAT3 SpotLight::GetDirection()
 	return GetForwardAxis();
 }
 
+// Get the cosine of the angle the cone reaches out to
+float SpotLight::GetConeCos()
+{
+	return powf(0.01f, 1.0f / std::max(lightStruct->SpotFalloff, 0.01f));
+}
+
 // Calculate view for shadow rendering
 void SpotLight::CalculateViewMatrix()
 {
-	//TODO: Implement Spot light shadow maps
-	printf("Spot light shadow maps are not supported (yet)");
+	XMVECTOR forward = XMLoadFloat3(&GetForwardAxis());
+	XMVECTOR up = fabsf(XMVectorGetY(forward)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+	XMMATRIX view = XMMatrixTranspose(XMMatrixLookToLH(XMLoadFloat3(&GetPosition()), forward, up));
+	XMStoreFloat4x4(&shadowView, view);
 }
 
 // Calculate projection for shadow rendering
 void SpotLight::CalculateProjMatrix()
 {
-	//TODO: Implement Spot light shadow maps
-	printf("Spot light shadow maps are not supported (yet)");
+	//Cover the cone out to where the falloff leaves 1% of the light
+	float fov = std::min(std::max(2 * acosf(GetConeCos()), XMConvertToRadians(SPOT_SHADOW_MIN_FOV)),
+		XMConvertToRadians(SPOT_SHADOW_MAX_FOV));
+	XMMATRIX proj = XMMatrixTranspose(XMMatrixPerspectiveFovLH(
+		fov,
+		1,
+		SHADOW_NEAR_CLIP,
+		std::max(lightStruct->Range, SHADOW_NEAR_CLIP * 2)));
+	XMStoreFloat4x4(&shadowProj, proj);
 }
 
 // Get this light's view matrix (for shadows)
 DirectX::XMFLOAT4X4 SpotLight::GetViewMatrix()
 {
-	//TODO: Calculate view for Spot lights
 	//TODO: Calculate matrices only when light changes
-	printf("Spot light shadow maps are not supported (yet)");
+	CalculateViewMatrix();
 	return shadowView;
 }
 
 // Get this light's projection matrix (for shadows)
 DirectX::XMFLOAT4X4 SpotLight::GetProjectionMatrix()
 {
-	//TODO: Calculate proj for point lights
 	//TODO: Calculate matrices only when light changes
-	printf("Spot light shadow maps are not supported (yet)");
+	CalculateProjMatrix();
 	return shadowProj;
 }
+
+// Get how much of the screen this light's range covers
+float SpotLight::GetShadowImportance(Camera* camera)
+{
+	//The sphere around the cone's length
+	XMFLOAT3 centre;
+	XMStoreFloat3(&centre, XMVectorAdd(XMLoadFloat3(&GetPosition()),
+		XMVectorScale(XMLoadFloat3(&GetForwardAxis()), lightStruct->Range * 0.5f)));
+	return GetSphereImportance(camera, centre, lightStruct->Range * 0.5f);
+}
 #pragma endregion
 
 //Set the light manager's light list to dirty
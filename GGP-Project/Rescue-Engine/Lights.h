@@ -2,10 +2,20 @@
 #include <DirectXMath.h>
 #include <d3d11.h>
 #include "GameObject.h"
+#include "Camera.h"
+#include "ShadowCascades.h"
+#include "ShadowAtlas.h"
 
 enum class LightType { DirectionalLight = 0, PointLight = 1, SpotLight = 2};
 
-#define MAX_LIGHTS 10
+//Most lights the light manager holds (the size of the clustered lights' buffer)
+#define MAX_LIGHTS 1024
+
+//Most shadow views (cascades or cube faces) of all lights together (matches MAX_SHADOW_VIEWS in Lighting.hlsli)
+#define MAX_SHADOW_VIEWS 16
+
+//Most shadow views one light has (a point light's cube faces)
+#define MAX_LIGHT_SHADOW_VIEWS 6
 
 // --------------------------------------------------------
 // A light struct definition
@@ -24,7 +34,29 @@ struct LightStruct
 	DirectX::XMFLOAT3	Color;		// 48 bytes
 
 	float				SpotFalloff;
-	DirectX::XMFLOAT3	Padding;	// 64 bytes
+	int					ShadowStart;	//First of the light's shadow views
+	int					ShadowCount;	//0 if the light has no shadows
+	float				Padding;	// 64 bytes
+};
+
+// --------------------------------------------------------
+// A shadow view struct definition
+//
+// One of a light's views into the shadow atlas, to be passed
+// to shaders (lights point to theirs with ShadowStart).
+//
+// AtlasRect is the uv of the tile's corner, the uv size of the
+// tile and the uv size of a texel (the tile's size is 0 if it
+// didn't fit in the atlas)
+// --------------------------------------------------------
+struct ShadowViewStruct
+{
+	DirectX::XMFLOAT4X4	ViewProjection;	// 64 bytes
+
+	DirectX::XMFLOAT4	AtlasRect;	// 80 bytes
+
+	float				CascadeEnd;	//View depth a directional light's cascade ends at
+	DirectX::XMFLOAT3	Padding;	// 96 bytes
 };
 
 // --------------------------------------------------------
@@ -54,8 +86,15 @@ private:
 	// --------------------------------------------------------
 	friend void SetInLightManager(Light* light, bool val);
 	bool castsShadows;
-	ID3D11DepthStencilView* shadowDSV;
-	ID3D11ShaderResourceView* shadowSRV;
+
+	//Where each shadow view is drawn in the shadow atlas
+	ShadowAtlasRect shadowRects[MAX_LIGHT_SHADOW_VIEWS];
+
+	//What each view's static casters were cached with (in the static shadow atlas)
+	unsigned int staticShadowVersions[MAX_LIGHT_SHADOW_VIEWS];       //Renderer's static version each view was drawn at
+	DirectX::XMFLOAT4X4 staticShadowViews[MAX_LIGHT_SHADOW_VIEWS];       //Matrices each view was drawn with
+	DirectX::XMFLOAT4X4 staticShadowProjections[MAX_LIGHT_SHADOW_VIEWS];
+	ShadowAtlasRect staticShadowRects[MAX_LIGHT_SHADOW_VIEWS];       //Tile each view was drawn into
 
 protected:
 	bool inLightManager;
@@ -146,19 +185,33 @@ public:
 	void SetCastsShadows(bool castShadows);
 
 	// --------------------------------------------------------
-	// Get the shadow depth/stencil view for this light
+	// Set where a shadow view is drawn in the shadow atlas
+	// --------------------------------------------------------
+	void SetShadowRect(int view, ShadowAtlasRect rect);
+
+	// --------------------------------------------------------
+	// Get where a shadow view is drawn in the shadow atlas
 	// --------------------------------------------------------
-	ID3D11DepthStencilView* GetShadowDSV();
+	ShadowAtlasRect GetShadowRect(int view);
 
 	// --------------------------------------------------------
-	// Get the shadow SRV for this light
+	// Set where this light's shadow views start in the shadow
+	// view array (count is 0 if it has none)
 	// --------------------------------------------------------
-	ID3D11ShaderResourceView* GetShadowSRV();
+	void SetShadowViewRange(int start, int count);
 
 	// --------------------------------------------------------
-	// Create the SRV for this light's shadow map
+	// Check if a view's cached static casters can be used (it
+	// hasn't moved, and they haven't changed since they were drawn)
+	//
+	// staticVersion - the Renderer's current static version
 	// --------------------------------------------------------
-	void InitShadowMap(ID3D11Device* device);
+	bool IsStaticShadowCurrent(int view, unsigned int staticVersion);
+
+	// --------------------------------------------------------
+	// Mark a view's static casters as drawn with its current matrices
+	// --------------------------------------------------------
+	void SetStaticShadowCurrent(int view, unsigned int staticVersion);
 
 	// --------------------------------------------------------
 	// Get this light's view matrix (for shadows)
@@ -170,6 +223,50 @@ public:
 	// --------------------------------------------------------
 	virtual DirectX::XMFLOAT4X4 GetProjectionMatrix() = 0;
 
+	// --------------------------------------------------------
+	// Get how much of the screen this light's shadows cover
+	// (0 to 1), to size its tiles in the shadow atlas
+	// --------------------------------------------------------
+	virtual float GetShadowImportance(Camera* camera);
+
+	// --------------------------------------------------------
+	// Tell this light the smallest tile its views got in the atlas
+	// --------------------------------------------------------
+	virtual void SetShadowTileSize(int size);
+
+	// --------------------------------------------------------
+	// Fit this light's shadow views to a camera
+	// (lights without cascades have views that don't move)
+	// --------------------------------------------------------
+	virtual void FitShadowViews(Camera* camera);
+
+	// --------------------------------------------------------
+	// Get the amount of views this light's shadows are drawn from
+	// --------------------------------------------------------
+	virtual int GetShadowViewCount();
+
+	// --------------------------------------------------------
+	// Get a shadow view's view matrix
+	// --------------------------------------------------------
+	virtual DirectX::XMFLOAT4X4 GetShadowViewMatrix(int view);
+
+	// --------------------------------------------------------
+	// Get a shadow view's projection matrix
+	// --------------------------------------------------------
+	virtual DirectX::XMFLOAT4X4 GetShadowProjectionMatrix(int view);
+
+	// --------------------------------------------------------
+	// Get what the pixel shaders need to sample a shadow view
+	//
+	// atlasSize - texels along each side of the shadow atlas
+	// --------------------------------------------------------
+	ShadowViewStruct GetShadowViewData(int view, int atlasSize);
+
+protected:
+	// --------------------------------------------------------
+	// Get the view depth a shadow view stops being used at
+	// --------------------------------------------------------
+	virtual float GetShadowViewEnd(int view);
 };
 
 // --------------------------------------------------------
@@ -179,6 +276,9 @@ public:
 // --------------------------------------------------------
 class DirectionalLight : public Light
 {
+private:
+	ShadowCascades cascades;
+
 protected:
 	// --------------------------------------------------------
 	// Calculate view for shadow rendering
@@ -223,6 +323,49 @@ public:
 	// Get this light's projection matrix (for shadows)
 	// --------------------------------------------------------
 	virtual DirectX::XMFLOAT4X4 GetProjectionMatrix();
+
+	// --------------------------------------------------------
+	// Only fit the shadow cascades to what's in a box (the scene
+	// that casts and receives shadows)
+	// --------------------------------------------------------
+	void SetShadowBounds(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max);
+
+	// --------------------------------------------------------
+	// Get how much of the screen this light's shadows cover
+	// (all of it)
+	// --------------------------------------------------------
+	virtual float GetShadowImportance(Camera* camera);
+
+	// --------------------------------------------------------
+	// Snap the cascades to the texels of the tiles they got
+	// --------------------------------------------------------
+	virtual void SetShadowTileSize(int size);
+
+	// --------------------------------------------------------
+	// Fit this light's shadow cascades to a camera
+	// --------------------------------------------------------
+	virtual void FitShadowViews(Camera* camera);
+
+	// --------------------------------------------------------
+	// Get the amount of cascades this light's shadows have
+	// --------------------------------------------------------
+	virtual int GetShadowViewCount();
+
+	// --------------------------------------------------------
+	// Get a cascade's view matrix
+	// --------------------------------------------------------
+	virtual DirectX::XMFLOAT4X4 GetShadowViewMatrix(int view);
+
+	// --------------------------------------------------------
+	// Get a cascade's projection matrix
+	// --------------------------------------------------------
+	virtual DirectX::XMFLOAT4X4 GetShadowProjectionMatrix(int view);
+
+protected:
+	// --------------------------------------------------------
+	// Get the view depth a cascade ends at
+	// --------------------------------------------------------
+	virtual float GetShadowViewEnd(int view);
 };
 
 // --------------------------------------------------------
@@ -232,6 +375,9 @@ public:
 // --------------------------------------------------------
 class PointLight : public Light
 {
+private:
+	DirectX::XMFLOAT4X4 faceViews[6];       //+X, -X, +Y, -Y, +Z, -Z (transposed)
+
 protected:
 	// --------------------------------------------------------
 	// Calculate view for shadow rendering
@@ -282,6 +428,21 @@ public:
 	// Get this light's projection matrix (for shadows)
 	// --------------------------------------------------------
 	virtual DirectX::XMFLOAT4X4 GetProjectionMatrix();
+
+	// --------------------------------------------------------
+	// Get how much of the screen this light's sphere covers
+	// --------------------------------------------------------
+	virtual float GetShadowImportance(Camera* camera);
+
+	// --------------------------------------------------------
+	// Get the amount of cube faces this light's shadows are drawn from
+	// --------------------------------------------------------
+	virtual int GetShadowViewCount();
+
+	// --------------------------------------------------------
+	// Get a cube face's view matrix
+	// --------------------------------------------------------
+	virtual DirectX::XMFLOAT4X4 GetShadowViewMatrix(int view);
 };
 
 // --------------------------------------------------------
@@ -348,6 +509,12 @@ public:
 	// --------------------------------------------------------
 	DirectX::XMFLOAT3 SpotLight::GetDirection();
 
+	// --------------------------------------------------------
+	// Get the cosine of the angle the cone reaches out to
+	// (where the falloff leaves 1% of the light)
+	// --------------------------------------------------------
+	float GetConeCos();
+
 	// --------------------------------------------------------
 	// Get this light's view matrix (for shadows)
 	// --------------------------------------------------------
@@ -357,4 +524,9 @@ public:
 	// Get this light's projection matrix (for shadows)
 	// --------------------------------------------------------
 	virtual DirectX::XMFLOAT4X4 GetProjectionMatrix();
+
+	// --------------------------------------------------------
+	// Get how much of the screen this light's range covers
+	// --------------------------------------------------------
+	virtual float GetShadowImportance(Camera* camera);
 };
\ No newline at end of file
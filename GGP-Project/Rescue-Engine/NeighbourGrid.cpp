@@ -0,0 +1,68 @@
+#include "NeighbourGrid.h"
+#include <algorithm>
+#include <cmath>
+
+// Set up an empty grid
+NeighbourGrid::NeighbourGrid()
+{
+	resolution = 0;
+	extent = 0;
+	cellSize = 1;
+}
+
+// Make the grid cover an area
+void NeighbourGrid::Resize(float extent, float cellSize)
+{
+	this->extent = extent;
+	this->cellSize = cellSize;
+	resolution = std::max(1, (int)ceilf(2 * extent / cellSize));
+	cellStarts.assign((size_t)resolution * resolution + 1, 0);
+	cellCursors.resize((size_t)resolution * resolution);
+	sortedPoints.clear();
+}
+
+// Get the cell coordinate a position is in
+int NeighbourGrid::GetCellCoord(float value) const
+{
+	int coord = (int)floorf((value + extent) / cellSize);
+	return std::min(std::max(coord, 0), resolution - 1);
+}
+
+// Sort points into the grid
+void NeighbourGrid::Build(const float* xs, const float* zs, int count)
+{
+	if (resolution == 0)
+		return;
+
+	pointCells.resize(count);
+	sortedPoints.resize(count);
+	std::fill(cellStarts.begin(), cellStarts.end(), 0);
+
+	//Count the points in each cell
+	for (int i = 0; i < count; i++)
+	{
+		int cell = GetCellCoord(zs[i]) * resolution + GetCellCoord(xs[i]);
+		pointCells[i] = cell;
+		cellStarts[cell + 1]++;
+	}
+
+	//Each cell starts where the one before it ends
+	int cellCount = resolution * resolution;
+	for (int c = 0; c < cellCount; c++)
+	{
+		cellStarts[c + 1] += cellStarts[c];
+		cellCursors[c] = cellStarts[c];
+	}
+
+	//Drop the points in (in index order, so the result is always the same)
+	for (int i = 0; i < count; i++)
+	{
+		sortedPoints[cellCursors[pointCells[i]]++] = i;
+	}
+}
+
+// Get the amount of cells per side
+int NeighbourGrid::GetResolution()
+{
+	return resolution;
+}
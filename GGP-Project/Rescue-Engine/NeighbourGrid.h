@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// A uniform grid (on the XZ plane) for finding the points near
+// other points, rebuilt from scratch every step.
+//
+// Building is a counting sort: count the points in each cell,
+// turn the counts into where each cell starts, then drop every
+// point into its cell's range. That's O(n) with no allocations
+// once the buffers are big enough, and the points in a cell end
+// up next to each other in memory. With cells as wide as the
+// query radius, a point's neighbours are all in the 3x3 cells
+// around it, so a query doesn't depend on the total point count
+// --------------------------------------------------------
+class NeighbourGrid
+{
+private:
+	std::vector<int> cellStarts;       //Where each cell's points start in sortedPoints (one extra at the end)
+	std::vector<int> cellCursors;
+	std::vector<int> pointCells;
+	std::vector<int> sortedPoints;       //Point indices, sorted by cell
+	int resolution;       //Cells per side
+	float extent;       //The grid covers [-extent, extent] on both axes (points outside go in the edge cells)
+	float cellSize;
+
+	// --------------------------------------------------------
+	// Get the cell coordinate a position is in (clamped to the grid)
+	// --------------------------------------------------------
+	int GetCellCoord(float value) const;
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty grid
+	// --------------------------------------------------------
+	NeighbourGrid();
+
+	// --------------------------------------------------------
+	// Make the grid cover an area with cells of a size (the query radius)
+	// --------------------------------------------------------
+	void Resize(float extent, float cellSize);
+
+	// --------------------------------------------------------
+	// Sort points into the grid
+	//
+	// xs, zs - the points' positions
+	// count - the amount of points
+	// --------------------------------------------------------
+	void Build(const float* xs, const float* zs, int count);
+
+	// --------------------------------------------------------
+	// Call a function with the index of every point in the 3x3
+	// cells around a position (including the point itself, if
+	// it's one of them). Read only, so it's safe from many threads
+	// --------------------------------------------------------
+	template<typename Fn>
+	void ForEachNear(float x, float z, Fn fn) const
+	{
+		if (resolution == 0)
+			return;
+
+		int cellX = GetCellCoord(x);
+		int cellZ = GetCellCoord(z);
+		int minX = cellX > 0 ? cellX - 1 : 0;
+		int maxX = cellX < resolution - 1 ? cellX + 1 : resolution - 1;
+		int minZ = cellZ > 0 ? cellZ - 1 : 0;
+		int maxZ = cellZ < resolution - 1 ? cellZ + 1 : resolution - 1;
+		for (int j = minZ; j <= maxZ; j++)
+		{
+			//The cells of a row are next to each other, so it's one range
+			int begin = cellStarts[j * resolution + minX];
+			int end = cellStarts[j * resolution + maxX + 1];
+			for (int k = begin; k < end; k++)
+			{
+				fn(sortedPoints[k]);
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// Get the amount of cells per side
+	// --------------------------------------------------------
+	int GetResolution();
+};
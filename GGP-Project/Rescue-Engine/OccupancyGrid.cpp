@@ -0,0 +1,146 @@
+#include "OccupancyGrid.h"
+#include <algorithm>
+#include <cmath>
+
+//Cells checked on each side of a spot (2 cells of minDistance / sqrt(2) cover minDistance)
+#define NEIGHBOUR_RANGE 2
+
+// Set up an empty grid
+OccupancyGrid::OccupancyGrid()
+{
+	resolution = 0;
+	extent = 0;
+	cellSize = 1;
+	minDistanceSq = 0;
+	round = 1;
+	count = 0;
+}
+
+// Make the grid cover an area
+void OccupancyGrid::Resize(float extent, float minDistance)
+{
+	this->extent = extent;
+	cellSize = minDistance / sqrtf(2.0f);
+	minDistanceSq = minDistance * minDistance;
+	resolution = std::max(1, (int)ceilf(2 * extent / cellSize));
+	cells.assign((size_t)resolution * resolution, { 0, 0, false, 0 });
+	round = 1;
+	count = 0;
+}
+
+// Remove every point and unblock every cell
+void OccupancyGrid::Clear()
+{
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		cells[i].occupied = false;
+		cells[i].blockedRound = 0;
+	}
+	round = 1;
+	count = 0;
+}
+
+// Get the cell coordinate a position is in
+int OccupancyGrid::GetCellCoord(float value)
+{
+	int coord = (int)floorf((value + extent) / cellSize);
+	return std::min(std::max(coord, 0), resolution - 1);
+}
+
+// Check if a point can go at a position
+bool OccupancyGrid::IsFree(float x, float z)
+{
+	if (resolution == 0 || fabsf(x) >= extent || fabsf(z) >= extent)
+		return false;
+
+	int cellX = GetCellCoord(x);
+	int cellZ = GetCellCoord(z);
+	const OccupancyCell& cell = cells[cellZ * resolution + cellX];
+	if (cell.occupied || cell.blockedRound == round)
+		return false;
+
+	//Only the cells around it can hold a point that's too close
+	int minX = std::max(cellX - NEIGHBOUR_RANGE, 0);
+	int maxX = std::min(cellX + NEIGHBOUR_RANGE, resolution - 1);
+	int minZ = std::max(cellZ - NEIGHBOUR_RANGE, 0);
+	int maxZ = std::min(cellZ + NEIGHBOUR_RANGE, resolution - 1);
+	for (int j = minZ; j <= maxZ; j++)
+	{
+		for (int i = minX; i <= maxX; i++)
+		{
+			const OccupancyCell& other = cells[j * resolution + i];
+			if (!other.occupied)
+				continue;
+
+			float dx = other.x - x;
+			float dz = other.z - z;
+			if (dx * dx + dz * dz < minDistanceSq)
+				return false;
+		}
+	}
+	return true;
+}
+
+// Add a point
+int OccupancyGrid::Insert(float x, float z)
+{
+	if (resolution == 0 || fabsf(x) >= extent || fabsf(z) >= extent)
+		return -1;
+
+	int index = GetCellCoord(z) * resolution + GetCellCoord(x);
+	OccupancyCell& cell = cells[index];
+	if (!cell.occupied)
+		count++;
+	cell.x = x;
+	cell.z = z;
+	cell.occupied = true;
+	return index;
+}
+
+// Remove the point in a cell
+void OccupancyGrid::Remove(int cell)
+{
+	if (cell < 0 || cell >= (int)cells.size() || !cells[cell].occupied)
+		return;
+
+	cells[cell].occupied = false;
+	count--;
+}
+
+// Unblock every cell
+void OccupancyGrid::ClearBlocked()
+{
+	round++;
+}
+
+// Block every cell that overlaps a circle
+void OccupancyGrid::Block(float x, float z, float radius)
+{
+	if (resolution == 0)
+		return;
+
+	int minX = GetCellCoord(x - radius);
+	int maxX = GetCellCoord(x + radius);
+	int minZ = GetCellCoord(z - radius);
+	int maxZ = GetCellCoord(z + radius);
+	float radiusSq = radius * radius;
+	for (int j = minZ; j <= maxZ; j++)
+	{
+		for (int i = minX; i <= maxX; i++)
+		{
+			//Closest point of the cell to the circle's center
+			float cellMinX = i * cellSize - extent;
+			float cellMinZ = j * cellSize - extent;
+			float dx = std::max(std::max(cellMinX - x, x - (cellMinX + cellSize)), 0.0f);
+			float dz = std::max(std::max(cellMinZ - z, z - (cellMinZ + cellSize)), 0.0f);
+			if (dx * dx + dz * dz <= radiusSq)
+				cells[j * resolution + i].blockedRound = round;
+		}
+	}
+}
+
+// Get the amount of points in the grid
+int OccupancyGrid::GetCount()
+{
+	return count;
+}
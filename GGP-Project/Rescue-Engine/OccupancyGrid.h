@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+
+//A cell of an occupancy grid
+struct OccupancyCell
+{
+	float x;
+	float z;
+	bool occupied;
+	unsigned int blockedRound;       //Round the cell was last blocked in
+};
+
+// --------------------------------------------------------
+// A 2D grid (on the XZ plane) for placing points a minimum
+// distance apart, like Poisson-disk sampling.
+//
+// Cells are minDistance / sqrt(2) wide, so a cell can only ever
+// hold one point, and checking a spot only has to look at the
+// 5x5 cells around it: O(1) no matter how many points there are.
+//
+// Areas can also be blocked for a round (like things that move
+// around), and blocking is cleared by starting a new round
+// instead of touching every cell
+// --------------------------------------------------------
+class OccupancyGrid
+{
+private:
+	std::vector<OccupancyCell> cells;
+	int resolution;       //Cells per side
+	float extent;       //The grid covers [-extent, extent] on both axes
+	float cellSize;
+	float minDistanceSq;
+	unsigned int round;
+	int count;
+
+	// --------------------------------------------------------
+	// Get the cell coordinate a position is in (clamped to the grid)
+	// --------------------------------------------------------
+	int GetCellCoord(float value);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty grid
+	// --------------------------------------------------------
+	OccupancyGrid();
+
+	// --------------------------------------------------------
+	// Make the grid cover an area, and set how far apart points
+	// have to be. Removes every point
+	// --------------------------------------------------------
+	void Resize(float extent, float minDistance);
+
+	// --------------------------------------------------------
+	// Remove every point and unblock every cell
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Check if a point can go at a position (it's in the grid,
+	// not blocked, and far enough from every other point)
+	// --------------------------------------------------------
+	bool IsFree(float x, float z);
+
+	// --------------------------------------------------------
+	// Add a point. Returns the cell it's in, for removing it later
+	// (-1 if it's outside the grid)
+	// --------------------------------------------------------
+	int Insert(float x, float z);
+
+	// --------------------------------------------------------
+	// Remove the point in a cell
+	// --------------------------------------------------------
+	void Remove(int cell);
+
+	// --------------------------------------------------------
+	// Unblock every cell (starts a new round)
+	// --------------------------------------------------------
+	void ClearBlocked();
+
+	// --------------------------------------------------------
+	// Block every cell that overlaps a circle until the next round
+	// --------------------------------------------------------
+	void Block(float x, float z, float radius);
+
+	// --------------------------------------------------------
+	// Get the amount of points in the grid
+	// --------------------------------------------------------
+	int GetCount();
+};
@@ -0,0 +1,621 @@
+#include "OceanFFT.h"
+#include "SIMDLanes.h"
+#include "JobSystem.h"
+#include "FastRandom.h"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#define GRAVITY 9.81f
+#define TWO_PI 6.28318530717959f
+
+//Wave frequencies are rounded so the whole ocean loops after this many seconds
+//(keeps the phases precise however long the game runs)
+#define OCEAN_REPEAT_TIME 200.0
+
+//Waves shorter than this fraction of the biggest wave are damped out
+#define SMALL_WAVE_FRACTION 0.001f
+
+//How much of waves travelling against the wind are kept
+#define AGAINST_WIND_SCALE 0.07f
+
+//Times the height queries step back by the sideways displacement
+#define HEIGHT_ITERATIONS 2
+
+//Rows and columns each job works through (columns have to be a multiple of the SIMD width)
+#define OCEAN_ROWS_PER_JOB 8
+#define OCEAN_COLUMNS_PER_JOB 32
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// A row of the spectrum, laid out for the kernel
+// --------------------------------------------------------
+struct SpectrumRow
+{
+	const float* h0Real;
+	const float* h0Imag;
+	const float* h0MinusReal;
+	const float* h0MinusImag;
+	const float* omegaTurns;
+	const float* inverseK;
+	const float* kzs;
+	float kx;
+	float* fieldReal[3];
+	float* fieldImag[3];
+};
+
+// --------------------------------------------------------
+// Spectrum kernel - moves L::Width waves to a time and packs
+// them into the three fields
+// --------------------------------------------------------
+template<typename L>
+static void SpectrumKernel(const SpectrumRow& r, int i, float time)
+{
+	typedef typename L::F F;
+	F turns = L::Mul(L::Load(&r.omegaTurns[i]), L::Set(time));
+	F s = SinTurns<L>(turns);
+	F c = SinTurns<L>(L::Add(turns, L::Set(0.25f)));
+
+	//h(k, t) = h0(k) * e^(iwt) + conj(h0(-k)) * e^(-iwt)
+	F a = L::Load(&r.h0Real[i]);
+	F b = L::Load(&r.h0Imag[i]);
+	F p = L::Load(&r.h0MinusReal[i]);
+	F q = L::Load(&r.h0MinusImag[i]);
+	F hr = L::Add(L::Mul(L::Add(a, p), c), L::Mul(L::Sub(q, b), s));
+	F hi = L::Add(L::Mul(L::Add(b, q), c), L::Mul(L::Sub(a, p), s));
+
+	F kx = L::Set(r.kx);
+	F kz = L::Load(&r.kzs[i]);
+	F inverseK = L::Load(&r.inverseK[i]);
+	F unitX = L::Mul(kx, inverseK);
+	F unitZ = L::Mul(kz, inverseK);
+
+	//Height + i * displacement x, where displacement x = -i * (kx / k) * h
+	F scale = L::Add(L::Set(1), unitX);
+	L::Store(&r.fieldReal[0][i], L::Mul(scale, hr));
+	L::Store(&r.fieldImag[0][i], L::Mul(scale, hi));
+
+	//Displacement z + i * slope x, where slope x = i * kx * h
+	L::Store(&r.fieldReal[1][i], L::Sub(L::Mul(unitZ, hi), L::Mul(kx, hr)));
+	L::Store(&r.fieldImag[1][i], L::Sub(L::Set(0), L::Add(L::Mul(unitZ, hr), L::Mul(kx, hi))));
+
+	//Slope z
+	L::Store(&r.fieldReal[2][i], L::Sub(L::Set(0), L::Mul(kz, hi)));
+	L::Store(&r.fieldImag[2][i], L::Mul(kz, hr));
+}
+
+// --------------------------------------------------------
+// Butterfly kernel - combines L::Width columns of two rows
+// (a + w * b and a - w * b)
+// --------------------------------------------------------
+template<typename L>
+static void ButterflyKernel(float* ar, float* ai, float* br, float* bi, float wr, float wi)
+{
+	typedef typename L::F F;
+	F bReal = L::Load(br);
+	F bImag = L::Load(bi);
+	F tr = L::Sub(L::Mul(bReal, L::Set(wr)), L::Mul(bImag, L::Set(wi)));
+	F ti = L::Add(L::Mul(bReal, L::Set(wi)), L::Mul(bImag, L::Set(wr)));
+	F aReal = L::Load(ar);
+	F aImag = L::Load(ai);
+	L::Store(ar, L::Add(aReal, tr));
+	L::Store(ai, L::Add(aImag, ti));
+	L::Store(br, L::Sub(aReal, tr));
+	L::Store(bi, L::Sub(aImag, ti));
+}
+
+// --------------------------------------------------------
+// A row of the output maps, laid out for the kernel
+// --------------------------------------------------------
+struct UnpackRow
+{
+	const float* fieldReal[3];
+	const float* fieldImag[3];
+	const float* signs;
+	float rowSign;
+	float choppiness;
+	float* heights;
+	float* displacementX;
+	float* displacementZ;
+	float* slopeX;
+	float* slopeZ;
+};
+
+// --------------------------------------------------------
+// Unpack kernel - splits L::Width texels of the fields into
+// the output maps
+// --------------------------------------------------------
+template<typename L>
+static void UnpackKernel(const UnpackRow& r, int i)
+{
+	typedef typename L::F F;
+	F sign = L::Mul(L::Load(&r.signs[i]), L::Set(r.rowSign));
+
+	//Crests are pulled towards each other, so displacement goes against D
+	F chop = L::Mul(sign, L::Set(-r.choppiness));
+	L::Store(&r.heights[i], L::Mul(sign, L::Load(&r.fieldReal[0][i])));
+	L::Store(&r.displacementX[i], L::Mul(chop, L::Load(&r.fieldImag[0][i])));
+	L::Store(&r.displacementZ[i], L::Mul(chop, L::Load(&r.fieldReal[1][i])));
+	L::Store(&r.slopeX[i], L::Mul(sign, L::Load(&r.fieldImag[1][i])));
+	L::Store(&r.slopeZ[i], L::Mul(sign, L::Load(&r.fieldReal[2][i])));
+}
+
+// --------------------------------------------------------
+// Combine a run of columns of two rows
+// --------------------------------------------------------
+static void ButterflyRows(float* ar, float* ai, float* br, float* bi, float wr, float wi, int count)
+{
+	int i = 0;
+
+#ifdef BATCH_AVX
+	for (; i + AVXLanes::Width <= count; i += AVXLanes::Width)
+	{
+		ButterflyKernel<AVXLanes>(&ar[i], &ai[i], &br[i], &bi[i], wr, wi);
+	}
+#endif
+
+#ifdef BATCH_SSE
+	for (; i + SSELanes::Width <= count; i += SSELanes::Width)
+	{
+		ButterflyKernel<SSELanes>(&ar[i], &ai[i], &br[i], &bi[i], wr, wi);
+	}
+#endif
+
+	//Leftovers
+	for (; i < count; i++)
+	{
+		ButterflyKernel<ScalarLanes>(&ar[i], &ai[i], &br[i], &bi[i], wr, wi);
+	}
+}
+
+// Set up an empty ocean
+OceanFFT::OceanFFT()
+{
+	size = 0;
+	logSize = 0;
+	patchLength = 1;
+	choppiness = 0;
+	updateCount = 0;
+}
+
+// Destructor
+OceanFFT::~OceanFFT()
+{
+}
+
+// Fill the starting spectrum
+bool OceanFFT::Init(int size, float patchLength, XMFLOAT2 wind, float rmsHeight, float choppiness, unsigned int seed)
+{
+	if (patchLength <= 0)
+		return false;
+	if (size < MIN_OCEAN_SIZE || size > MAX_OCEAN_SIZE || (size & (size - 1)) != 0)
+	{
+		printf("Ocean size must be a power of 2 from %d to %d\n", MIN_OCEAN_SIZE, MAX_OCEAN_SIZE);
+		return false;
+	}
+
+	this->size = size;
+	this->patchLength = patchLength;
+	this->choppiness = choppiness;
+	logSize = 0;
+	while ((1 << logSize) < size)
+		logSize++;
+
+	int texels = size * size;
+	h0Real.assign(texels, 0);
+	h0Imag.assign(texels, 0);
+	h0MinusReal.assign(texels, 0);
+	h0MinusImag.assign(texels, 0);
+	omegaTurns.assign(texels, 0);
+	inverseK.assign(texels, 0);
+	kxs.resize(size);
+	kzs.resize(size);
+	for (int f = 0; f < 3; f++)
+	{
+		fieldReal[f].assign(texels, 0);
+		fieldImag[f].assign(texels, 0);
+		scratchReal[f].assign(texels, 0);
+		scratchImag[f].assign(texels, 0);
+	}
+	heights.assign(texels, 0);
+	displacementX.assign(texels, 0);
+	displacementZ.assign(texels, 0);
+	slopeX.assign(texels, 0);
+	slopeZ.assign(texels, 0);
+
+	//Wave numbers are centred, so index size / 2 is the constant term
+	for (int i = 0; i < size; i++)
+	{
+		kxs[i] = TWO_PI * (i - size / 2) / patchLength;
+		kzs[i] = kxs[i];
+	}
+
+	//Phillips spectrum: the largest waves the wind can make are windSpeed^2 / g long
+	float windSpeed = sqrtf(wind.x * wind.x + wind.y * wind.y);
+	float windX = windSpeed > 0 ? wind.x / windSpeed : 1;
+	float windZ = windSpeed > 0 ? wind.y / windSpeed : 0;
+	float largest = windSpeed * windSpeed / GRAVITY;
+	float smallest = largest * SMALL_WAVE_FRACTION;
+	double omegaStep = TWO_PI / OCEAN_REPEAT_TIME;
+
+	FastRandom random(seed);
+	double power = 0;
+	for (int n = 0; n < size; n++)
+	{
+		for (int m = 0; m < size; m++)
+		{
+			int index = n * size + m;
+			float kx = kxs[n];
+			float kz = kzs[m];
+			float k = sqrtf(kx * kx + kz * kz);
+
+			//The first row and column have no opposite wave, so they're left out
+			//(this keeps every field's spectrum symmetric, so the FFTs come out real)
+			if (n == 0 || m == 0 || k <= 0 || largest <= 0)
+				continue;
+
+			inverseK[index] = 1 / k;
+			omegaTurns[index] = (float)(floor(sqrt(GRAVITY * k) / omegaStep) / OCEAN_REPEAT_TIME);
+
+			float along = (kx * windX + kz * windZ) / k;
+			float phillips = expf(-1 / (k * largest * k * largest)) / (k * k * k * k)
+				* along * along * expf(-k * k * smallest * smallest);
+			if (along < 0)
+				phillips *= AGAINST_WIND_SCALE;
+
+			//Gaussian random amplitude and phase (Box-Muller)
+			float radius = sqrtf(-2 * logf(1 - random.NextFloat()));
+			float angle = TWO_PI * random.NextFloat();
+			float amplitude = sqrtf(phillips * 0.5f);
+			h0Real[index] = radius * cosf(angle) * amplitude;
+			h0Imag[index] = radius * sinf(angle) * amplitude;
+			power += h0Real[index] * h0Real[index] + h0Imag[index] * h0Imag[index];
+		}
+	}
+
+	//Each wave and its opposite add to the mean square height
+	float scale = power > 0 ? (float)(rmsHeight / sqrt(2 * power)) : 0;
+	for (int n = 0; n < size; n++)
+	{
+		for (int m = 0; m < size; m++)
+		{
+			int index = n * size + m;
+			h0Real[index] *= scale;
+			h0Imag[index] *= scale;
+		}
+	}
+	for (int n = 0; n < size; n++)
+	{
+		for (int m = 0; m < size; m++)
+		{
+			int opposite = ((size - n) & (size - 1)) * size + ((size - m) & (size - 1));
+			h0MinusReal[n * size + m] = h0Real[opposite];
+			h0MinusImag[n * size + m] = -h0Imag[opposite];
+		}
+	}
+
+	//Inverse FFT tables
+	twiddleReal.resize(size / 2);
+	twiddleImag.resize(size / 2);
+	for (int i = 0; i < size / 2; i++)
+	{
+		twiddleReal[i] = cosf(TWO_PI * i / size);
+		twiddleImag[i] = sinf(TWO_PI * i / size);
+	}
+	bitReverse.resize(size);
+	signs.resize(size);
+	for (int i = 0; i < size; i++)
+	{
+		int reversed = 0;
+		for (int b = 0; b < logSize; b++)
+		{
+			if (i & (1 << b))
+				reversed |= 1 << (logSize - 1 - b);
+		}
+		bitReverse[i] = reversed;
+		signs[i] = (i & 1) ? -1.0f : 1.0f;
+	}
+
+	Update(0);
+	return true;
+}
+
+// Move every wave in the spectrum to a time and pack the three fields
+void OceanFFT::EvaluateSpectrum(double time)
+{
+	float loopTime = (float)fmod(time, OCEAN_REPEAT_TIME);
+	JobSystem::GetInstance()->ParallelFor(size, OCEAN_ROWS_PER_JOB, [&](int begin, int end)
+	{
+		for (int n = begin; n < end; n++)
+		{
+			int offset = n * size;
+			SpectrumRow r;
+			r.h0Real = &h0Real[offset];
+			r.h0Imag = &h0Imag[offset];
+			r.h0MinusReal = &h0MinusReal[offset];
+			r.h0MinusImag = &h0MinusImag[offset];
+			r.omegaTurns = &omegaTurns[offset];
+			r.inverseK = &inverseK[offset];
+			r.kzs = kzs.data();
+			r.kx = kxs[n];
+			for (int f = 0; f < 3; f++)
+			{
+				r.fieldReal[f] = &fieldReal[f][offset];
+				r.fieldImag[f] = &fieldImag[f][offset];
+			}
+
+			int i = 0;
+#ifdef BATCH_AVX
+			for (; i + AVXLanes::Width <= size; i += AVXLanes::Width)
+				SpectrumKernel<AVXLanes>(r, i, loopTime);
+#endif
+#ifdef BATCH_SSE
+			for (; i + SSELanes::Width <= size; i += SSELanes::Width)
+				SpectrumKernel<SSELanes>(r, i, loopTime);
+#endif
+			for (; i < size; i++)
+				SpectrumKernel<ScalarLanes>(r, i, loopTime);
+		}
+	});
+}
+
+// Inverse FFT the fields down their columns
+void OceanFFT::TransformColumns()
+{
+	//Each job takes a strip of columns of one field through every pass
+	int stripsPerField = size / OCEAN_COLUMNS_PER_JOB;
+	JobSystem::GetInstance()->ParallelFor(3 * stripsPerField, 1, [&](int begin, int end)
+	{
+		for (int job = begin; job < end; job++)
+		{
+			float* real = fieldReal[job / stripsPerField].data() + (job % stripsPerField) * OCEAN_COLUMNS_PER_JOB;
+			float* imag = fieldImag[job / stripsPerField].data() + (job % stripsPerField) * OCEAN_COLUMNS_PER_JOB;
+
+			//Put the rows in bit reversed order
+			for (int i = 0; i < size; i++)
+			{
+				int j = bitReverse[i];
+				if (j <= i)
+					continue;
+				std::swap_ranges(&real[i * size], &real[i * size] + OCEAN_COLUMNS_PER_JOB, &real[j * size]);
+				std::swap_ranges(&imag[i * size], &imag[i * size] + OCEAN_COLUMNS_PER_JOB, &imag[j * size]);
+			}
+
+			//Combine pairs of rows into bigger and bigger transforms
+			for (int length = 2; length <= size; length <<= 1)
+			{
+				int half = length / 2;
+				int twiddleStep = size / length;
+				for (int start = 0; start < size; start += length)
+				{
+					for (int j = 0; j < half; j++)
+					{
+						int a = (start + j) * size;
+						int b = (start + j + half) * size;
+						ButterflyRows(&real[a], &imag[a], &real[b], &imag[b],
+							twiddleReal[j * twiddleStep], twiddleImag[j * twiddleStep], OCEAN_COLUMNS_PER_JOB);
+					}
+				}
+			}
+		}
+	});
+}
+
+// Swap the fields' rows and columns
+void OceanFFT::Transpose()
+{
+	JobSystem::GetInstance()->ParallelFor(size, OCEAN_ROWS_PER_JOB, [&](int begin, int end)
+	{
+		for (int f = 0; f < 3; f++)
+		{
+			const float* real = fieldReal[f].data();
+			const float* imag = fieldImag[f].data();
+			for (int row = begin; row < end; row++)
+			{
+				float* toReal = &scratchReal[f][row * size];
+				float* toImag = &scratchImag[f][row * size];
+				for (int column = 0; column < size; column++)
+				{
+					toReal[column] = real[column * size + row];
+					toImag[column] = imag[column * size + row];
+				}
+			}
+		}
+	});
+
+	for (int f = 0; f < 3; f++)
+	{
+		fieldReal[f].swap(scratchReal[f]);
+		fieldImag[f].swap(scratchImag[f]);
+	}
+}
+
+// Unpack the fields into the output maps
+void OceanFFT::Unpack()
+{
+	JobSystem::GetInstance()->ParallelFor(size, OCEAN_ROWS_PER_JOB, [&](int begin, int end)
+	{
+		for (int z = begin; z < end; z++)
+		{
+			int offset = z * size;
+			UnpackRow r;
+			for (int f = 0; f < 3; f++)
+			{
+				r.fieldReal[f] = &fieldReal[f][offset];
+				r.fieldImag[f] = &fieldImag[f][offset];
+			}
+			r.signs = signs.data();
+			r.rowSign = signs[z];
+			r.choppiness = choppiness;
+			r.heights = &heights[offset];
+			r.displacementX = &displacementX[offset];
+			r.displacementZ = &displacementZ[offset];
+			r.slopeX = &slopeX[offset];
+			r.slopeZ = &slopeZ[offset];
+
+			int i = 0;
+#ifdef BATCH_AVX
+			for (; i + AVXLanes::Width <= size; i += AVXLanes::Width)
+				UnpackKernel<AVXLanes>(r, i);
+#endif
+#ifdef BATCH_SSE
+			for (; i + SSELanes::Width <= size; i += SSELanes::Width)
+				UnpackKernel<SSELanes>(r, i);
+#endif
+			for (; i < size; i++)
+				UnpackKernel<ScalarLanes>(r, i);
+		}
+	});
+}
+
+// Simulate the ocean at a time
+void OceanFFT::Update(double time)
+{
+	if (size == 0)
+		return;
+
+	//The spectrum's rows are along kx, so the first pass gives rows along x,
+	//and after transposing the second pass gives rows along z
+	EvaluateSpectrum(time);
+	TransformColumns();
+	Transpose();
+	TransformColumns();
+	Unpack();
+	updateCount++;
+}
+
+// Sample a map between texels at a world position
+float OceanFFT::SampleMap(const std::vector<float>& map, float x, float z)
+{
+	float u = x / patchLength * size;
+	float v = z / patchLength * size;
+	float floorU = floorf(u);
+	float floorV = floorf(v);
+	float fu = u - floorU;
+	float fv = v - floorV;
+
+	//The patch tiles
+	int x0 = (int)floorU & (size - 1);
+	int z0 = (int)floorV & (size - 1);
+	int x1 = (x0 + 1) & (size - 1);
+	int z1 = (z0 + 1) & (size - 1);
+
+	float top = map[z0 * size + x0] + (map[z0 * size + x1] - map[z0 * size + x0]) * fu;
+	float bottom = map[z1 * size + x0] + (map[z1 * size + x1] - map[z1 * size + x0]) * fu;
+	return top + (bottom - top) * fv;
+}
+
+// Find the point on the calm surface the ocean moves over a point
+void OceanFFT::FindUndisplaced(float x, float z, float* px, float* pz)
+{
+	*px = x;
+	*pz = z;
+	for (int i = 0; i < HEIGHT_ITERATIONS; i++)
+	{
+		float dx = SampleMap(displacementX, *px, *pz);
+		float dz = SampleMap(displacementZ, *px, *pz);
+		*px = x - dx;
+		*pz = z - dz;
+	}
+}
+
+// Add the ocean's height under some points to the heights
+void OceanFFT::AddHeights(const float* xs, const float* zs, float* heights, int count)
+{
+	if (size == 0)
+		return;
+
+	for (int i = 0; i < count; i++)
+	{
+		float px, pz;
+		FindUndisplaced(xs[i], zs[i], &px, &pz);
+		heights[i] += SampleMap(this->heights, px, pz);
+	}
+}
+
+// Tilt normals by the ocean's slopes under some points
+void OceanFFT::TiltNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count)
+{
+	if (size == 0)
+		return;
+
+	for (int i = 0; i < count; i++)
+	{
+		float px, pz;
+		FindUndisplaced(xs[i], zs[i], &px, &pz);
+
+		//A normal is (-slope x, 1, -slope z), so slopes just add
+		float nx = nxs[i] / nys[i] - SampleMap(slopeX, px, pz);
+		float nz = nzs[i] / nys[i] - SampleMap(slopeZ, px, pz);
+		float length = sqrtf(nx * nx + 1 + nz * nz);
+		nxs[i] = nx / length;
+		nys[i] = 1 / length;
+		nzs[i] = nz / length;
+	}
+}
+
+// Sum the height at a texel straight from the spectrum
+double OceanFFT::GetReferenceHeight(double time, int x, int z)
+{
+	double loopTime = fmod(time, OCEAN_REPEAT_TIME);
+	double worldX = (double)x * patchLength / size;
+	double worldZ = (double)z * patchLength / size;
+	double height = 0;
+	for (int n = 0; n < size; n++)
+	{
+		for (int m = 0; m < size; m++)
+		{
+			int index = n * size + m;
+			double wave = TWO_PI * (double)omegaTurns[index] * loopTime;
+			double c = cos(wave);
+			double s = sin(wave);
+			double hr = (h0Real[index] + h0MinusReal[index]) * c + (h0MinusImag[index] - h0Imag[index]) * s;
+			double hi = (h0Imag[index] + h0MinusImag[index]) * c + (h0Real[index] - h0MinusReal[index]) * s;
+			double angle = kxs[n] * worldX + kzs[m] * worldZ;
+			height += hr * cos(angle) - hi * sin(angle);
+		}
+	}
+	return height;
+}
+
+// Fill RGBA texels with the displacement and height
+void OceanFFT::FillDisplacementTexels(float* texels, int rowPitch)
+{
+	for (int z = 0; z < size; z++)
+	{
+		float* row = &texels[z * rowPitch];
+		for (int x = 0; x < size; x++)
+		{
+			int index = z * size + x;
+			row[x * 4 + 0] = displacementX[index];
+			row[x * 4 + 1] = heights[index];
+			row[x * 4 + 2] = displacementZ[index];
+			row[x * 4 + 3] = 0;
+		}
+	}
+}
+
+// Get the height map
+const float* OceanFFT::GetHeights()
+{
+	return heights.data();
+}
+
+// Get the texels along each side of the maps
+int OceanFFT::GetSize()
+{
+	return size;
+}
+
+// Get the world units along each side of the patch
+float OceanFFT::GetPatchLength()
+{
+	return patchLength;
+}
+
+// Get how many times the maps have been updated
+unsigned int OceanFFT::GetUpdateCount()
+{
+	return updateCount;
+}
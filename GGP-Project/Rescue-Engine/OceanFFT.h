@@ -0,0 +1,160 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+//Smallest and largest grids the ocean can be simulated on
+#define MIN_OCEAN_SIZE 64
+#define MAX_OCEAN_SIZE 256
+
+// --------------------------------------------------------
+// A patch of open ocean simulated with FFTs (Tessendorf,
+// "Simulating Ocean Water").
+//
+// The waves start from a Phillips spectrum blown by the wind,
+// and each update moves every wave in the spectrum forward and
+// turns the spectrum back into heights, sideways displacements
+// and slopes with an inverse FFT. The FFTs work on whole rows
+// at a time with SIMD and are spread over the JobSystem.
+//
+// Three complex FFTs give all five maps, since each map is
+// real: height + i * displacement x, displacement z + i * slope x
+// and slope z. The patch tiles, so the maps can be sampled
+// anywhere on the XZ plane (by the CPU for buoyancy, or from a
+// texture by the water's vertex shader)
+// --------------------------------------------------------
+class OceanFFT
+{
+private:
+	int size;       //Texels along each side (a power of 2)
+	int logSize;
+	float patchLength;       //World units along each side
+	float choppiness;
+	unsigned int updateCount;
+
+	//Starting spectrum, h0(k) and conj(h0(-k)), with rows along kx
+	std::vector<float> h0Real, h0Imag;
+	std::vector<float> h0MinusReal, h0MinusImag;
+	std::vector<float> omegaTurns;       //Turns each wave moves per second
+	std::vector<float> inverseK;       //1 / |k| (0 for the constant term)
+	std::vector<float> kzs;       //kz of each column
+	std::vector<float> kxs;       //kx of each row
+
+	//The three fields being transformed, and space to transpose them into
+	std::vector<float> fieldReal[3], fieldImag[3];
+	std::vector<float> scratchReal[3], scratchImag[3];
+
+	//FFT tables
+	std::vector<float> twiddleReal, twiddleImag;
+	std::vector<int> bitReverse;
+	std::vector<float> signs;       //(-1)^x, undoes the spectrum being centred
+
+	//Output maps, with rows along z
+	std::vector<float> heights;
+	std::vector<float> displacementX, displacementZ;
+	std::vector<float> slopeX, slopeZ;
+
+	// --------------------------------------------------------
+	// Move every wave in the spectrum to a time and pack the
+	// three fields
+	// --------------------------------------------------------
+	void EvaluateSpectrum(double time);
+
+	// --------------------------------------------------------
+	// Inverse FFT the fields down their columns
+	// --------------------------------------------------------
+	void TransformColumns();
+
+	// --------------------------------------------------------
+	// Swap the fields' rows and columns
+	// --------------------------------------------------------
+	void Transpose();
+
+	// --------------------------------------------------------
+	// Unpack the fields into the output maps
+	// --------------------------------------------------------
+	void Unpack();
+
+	// --------------------------------------------------------
+	// Sample a map between texels at a world position
+	// --------------------------------------------------------
+	float SampleMap(const std::vector<float>& map, float x, float z);
+
+	// --------------------------------------------------------
+	// Find the point on the calm surface the ocean moves over a
+	// point (so the height there is the one under it)
+	// --------------------------------------------------------
+	void FindUndisplaced(float x, float z, float* px, float* pz);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty ocean (call Init before using it)
+	// --------------------------------------------------------
+	OceanFFT();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~OceanFFT();
+
+	// --------------------------------------------------------
+	// Fill the starting spectrum. Returns false if the size isn't
+	// a power of 2 from MIN_OCEAN_SIZE to MAX_OCEAN_SIZE
+	//
+	// size - texels along each side of the maps
+	// patchLength - world units along each side of the patch
+	// wind - wind velocity on the XZ plane (faster makes longer waves)
+	// rmsHeight - root mean square height of the surface
+	// choppiness - how far crests are pulled together (0 is smooth)
+	// seed - seed for the random wave phases
+	// --------------------------------------------------------
+	bool Init(int size, float patchLength, DirectX::XMFLOAT2 wind, float rmsHeight, float choppiness, unsigned int seed);
+
+	// --------------------------------------------------------
+	// Simulate the ocean at a time (in seconds).
+	// Call from the main thread (it uses the JobSystem)
+	// --------------------------------------------------------
+	void Update(double time);
+
+	// --------------------------------------------------------
+	// Add the ocean's height under some points to the heights
+	// --------------------------------------------------------
+	void AddHeights(const float* xs, const float* zs, float* heights, int count);
+
+	// --------------------------------------------------------
+	// Tilt normals by the ocean's slopes under some points
+	// --------------------------------------------------------
+	void TiltNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count);
+
+	// --------------------------------------------------------
+	// Sum the height at a texel straight from the spectrum, one
+	// wave at a time (slow, for checking the FFT)
+	// --------------------------------------------------------
+	double GetReferenceHeight(double time, int x, int z);
+
+	// --------------------------------------------------------
+	// Fill RGBA texels with displacement x, height, displacement z
+	// and 0 (rowPitch is in floats)
+	// --------------------------------------------------------
+	void FillDisplacementTexels(float* texels, int rowPitch);
+
+	// --------------------------------------------------------
+	// Get the height map (rows along z)
+	// --------------------------------------------------------
+	const float* GetHeights();
+
+	// --------------------------------------------------------
+	// Get the texels along each side of the maps
+	// --------------------------------------------------------
+	int GetSize();
+
+	// --------------------------------------------------------
+	// Get the world units along each side of the patch
+	// --------------------------------------------------------
+	float GetPatchLength();
+
+	// --------------------------------------------------------
+	// Get how many times the maps have been updated
+	// (so copies of them know when they're stale)
+	// --------------------------------------------------------
+	unsigned int GetUpdateCount();
+};
@@ -1,12 +1,20 @@
 #include "Renderer.h"
 #include "LightManager.h"
 #include "ResourceManager.h"
+#include "WaterSurface.h"
+#include "ExtendedMath.h"
 #include <algorithm>
 
 #define FXAA_ENABLED 1
 #define FXAA_PRESET 5
 #define FXAA_DEBUG 0
 
+//Water grid (rings around the camera, each with cells twice as big as the last)
+#define WATER_GRID_RINGS 5
+#define WATER_GRID_CELLS 64
+#define WATER_GRID_CELL_SIZE 0.25f
+#define WATER_GRID_MAX_DISPLACEMENT 2.0f
+
 using namespace DirectX;
 
 // Initialize values in the renderer
@@ -14,6 +22,7 @@ void Renderer::Init(ID3D11Device* device, UINT width, UINT height)
 {
 	// Assign default clear color. We should pull this in from Game at some point.
 	this->SetClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	interpolationAlpha = 1.0f;
 
 	// --------------------------------------------------------
 	// Get collider shader information
@@ -64,27 +73,46 @@ void Renderer::Init(ID3D11Device* device, UINT width, UINT height)
 	bd.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 	device->CreateBlendState(&bd, &waterBlendState);
 
-	//DEBUG water
-	water = new Entity(
-		ResourceManager::GetInstance()->GetMesh("Assets\\Models\\cube.obj"),
+	//The water is a grid that follows the camera around
+	waterGrid = new WaterGrid(WATER_GRID_RINGS, WATER_GRID_CELLS, WATER_GRID_CELL_SIZE,
+		WATER_GRID_MAX_DISPLACEMENT, device);
+	water = new Entity(waterGrid->GetMesh(),
 		ResourceManager::GetInstance()->GetMaterial("water"), "water"
 	);
-	water->SetScale(26, 0.1f, 26);
+
+	//The ocean's and wakes' textures are made when there's something to copy
+	oceanTexture = nullptr;
+	oceanSRV = nullptr;
+	oceanTextureSize = 0;
+	oceanTextureUpdate = 0;
+	wakeTexture = nullptr;
+	wakeSRV = nullptr;
+	wakeTextureSize = 0;
+	wakeTextureUpdate = 0;
 
 	// --------------------------------------------------------
 	//Get shadow information
 	shadowVS = ResourceManager::GetInstance()->GetVertexShader("VS_Shadow.cso");
+	staticShadowVersion = 1;
 
 	// Create a rasterizer state
 	D3D11_RASTERIZER_DESC shadowRastDesc = {};
 	shadowRastDesc.FillMode = D3D11_FILL_SOLID;
 	shadowRastDesc.CullMode = D3D11_CULL_BACK;
 	shadowRastDesc.DepthClipEnable = true;
-	shadowRastDesc.DepthBias = 1000; // Multiplied by (smallest possible value > 0 in depth buffer)
+	shadowRastDesc.DepthBias = 8; // Multiplied by (smallest possible value > 0 in depth buffer, 1/65535 for 16 bits)
 	shadowRastDesc.DepthBiasClamp = 0.0f;
 	shadowRastDesc.SlopeScaledDepthBias = 1.0f;
 	device->CreateRasterizerState(&shadowRastDesc, &shadowRasterizer);
 
+	//Tiles of the atlas are cleared and copied into by writing their depth with a full-screen triangle
+	shadowFillPS = ResourceManager::GetInstance()->GetPixelShader("PS_ShadowFill.cso");
+	D3D11_DEPTH_STENCIL_DESC shadowFillDS = {};
+	shadowFillDS.DepthEnable = true;
+	shadowFillDS.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	shadowFillDS.DepthFunc = D3D11_COMPARISON_ALWAYS;
+	device->CreateDepthStencilState(&shadowFillDS, &shadowFillDepthState);
+
 
 	// --------------------------------------------------------
 	// Set up the FXAA settings.
@@ -137,10 +165,16 @@ Renderer::~Renderer()
 	//Clean up water
 	waterBlendState->Release();
 	if(waterDepthState != nullptr) waterDepthState->Release();
+	if (oceanSRV != nullptr) oceanSRV->Release();
+	if (oceanTexture != nullptr) oceanTexture->Release();
+	if (wakeSRV != nullptr) wakeSRV->Release();
+	if (wakeTexture != nullptr) wakeTexture->Release();
 	//delete water;
+	delete waterGrid;
 
 	//Clean up shadow map
 	shadowRasterizer->Release();
+	shadowFillDepthState->Release();
 
 	// Clean up post process.
 	fxaaRTV->Release();
@@ -167,14 +201,21 @@ void Renderer::Draw(ID3D11DeviceContext* context,
 		1.0f,
 		0);
 
+	PlaceWater(camera);
+
 	RenderShadowMaps(context, device, camera, backBufferRTV, depthStencilView, width, height);
 
+	//Bin the lights into the clusters of the camera's view
+	LightManager::GetInstance()->UpdateLightClusters(device, context, camera, width, height);
+
 	PreparePostProcess(context, fxaaRTV, depthStencilView);
 
 	DrawOpaqueObjects(context, camera);
 
 	DrawSky(context, camera);
 
+	UpdateWaterTextures(context, device);
+
 	DrawWater(context, camera);
 
 	ApplyPostProcess(context, backBufferRTV, depthStencilView, fxaaRTV, fxaaSRV, sampler, width, height);
@@ -209,81 +250,136 @@ void Renderer::RenderShadowMaps(ID3D11DeviceContext* context,
 	ID3D11DepthStencilView* depthStencilView,
 	UINT width, UINT height)
 {
-	std::vector<Light*> lights = LightManager::GetInstance()->GetShadowCastingLights();
+	//Pack (if lights changed) and fit the lights' views
+	LightManager* lightManager = LightManager::GetInstance();
+	lightManager->InitShadowAtlas(device);
+	lightManager->UpdateShadowViews(camera);
+	std::vector<Light*> lights = lightManager->GetShadowAtlasLights();
+	ID3D11DepthStencilView* shadowDSV = lightManager->GetShadowAtlasDSV();
+	ID3D11DepthStencilView* staticDSV = lightManager->GetStaticShadowAtlasDSV();
 	context->RSSetState(shadowRasterizer);
-	context->PSSetShader(0, 0, 0); // Turns OFF the pixel shader
 
-	// SET A VIEWPORT!!!
 	D3D11_VIEWPORT vp = {};
-	vp.TopLeftX = 0;
-	vp.TopLeftY = 0;
-	vp.Width = (float)SHADOW_MAP_SIZE;
-	vp.Height = (float)SHADOW_MAP_SIZE;
 	vp.MinDepth = 0.0f;
 	vp.MaxDepth = 1.0f;
-	context->RSSetViewports(1, &vp);
 
-	//Loop through all lights that cast shadows and draw to their textures
+	//Loop through all lights that cast shadows and draw into their tiles of the atlas
 	for (auto l : lights)
 	{
-		//Create shadow SRV if it does not exist
-		if (l->GetShadowSRV() == nullptr)
-			l->InitShadowMap(device);
-
-		ID3D11DepthStencilView* shadowDSV = l->GetShadowDSV();
-		ID3D11ShaderResourceView* shadowSRV = l->GetShadowSRV();
-
-		// Initial setup - No RTV necessary - Clear shadow map
-		context->OMSetRenderTargets(0, 0, shadowDSV);
-		context->ClearDepthStencilView(shadowDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-		// Set up the shaders
-		shadowVS->SetShader();
-		shadowVS->SetMatrix4x4("view", l->GetViewMatrix());
-		shadowVS->SetMatrix4x4("projection", l->GetProjectionMatrix());
-		shadowVS->CopyBufferData("once");
-
-		//Loop through entities (simplified. Look at DrawOpaqueObjects for better documentation)
-		for (auto const& mapPair : renderMap)
+		for (int v = 0; v < l->GetShadowViewCount(); v++)
 		{
-			if (mapPair.second.size() < 1)
-				return;
-
-			std::vector<Entity*> list = mapPair.second;
-
-			Mesh* mesh = list[0]->GetMesh();
+			//Skip views that didn't fit in the atlas
+			ShadowAtlasRect rect = l->GetShadowRect(v);
+			if (rect.size == 0)
+				continue;
 
-			// Set buffers in the input assembler
-			UINT stride = sizeof(Vertex);
-			UINT offset = 0;
-			ID3D11Buffer* vertexBuffer = mesh->GetVertexBuffer();
-			ID3D11Buffer* indexBuffer = mesh->GetIndexBuffer();
-			context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-			context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+			//Only draw into the view's tile
+			vp.TopLeftX = (float)rect.x;
+			vp.TopLeftY = (float)rect.y;
+			vp.Width = (float)rect.size;
+			vp.Height = (float)rect.size;
+			context->RSSetViewports(1, &vp);
 
-			//Loop through each entity in the list
-			for (size_t i = 0; i < list.size(); i++)
+			//Only redraw the static casters if the view moved, the tile moved or they changed
+			if (!l->IsStaticShadowCurrent(v, staticShadowVersion))
 			{
-				// Grab the data from the first entity's mesh
-				Entity* e = list[i];
-
-				shadowVS->SetMatrix4x4("world", e->GetWorldMatrix());
-				shadowVS->CopyBufferData("perObject");
-
-				// Finally do the actual drawing
-				context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
+				context->OMSetRenderTargets(0, 0, staticDSV);
+				FillShadowTile(context, nullptr);
+				SetShadowView(l, v);
+				DrawShadowCasters(context, true);
+				l->SetStaticShadowCurrent(v, staticShadowVersion);
 			}
+
+			// No RTV necessary - Start from the static casters
+			context->OMSetRenderTargets(0, 0, shadowDSV);
+			FillShadowTile(context, lightManager->GetStaticShadowAtlasSRV());
+			SetShadowView(l, v);
+			DrawShadowCasters(context, false);
 		}
 	}
 
 	// Revert to original pipeline state
 	context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
+	vp.TopLeftX = 0;
+	vp.TopLeftY = 0;
 	vp.Width = (float)width;
 	vp.Height = (float)height;
 	context->RSSetViewports(1, &vp);
 	context->RSSetState(0);
 }
 
+// Fill the bound tile of a shadow atlas with a cache's depth, or clear it
+void Renderer::FillShadowTile(ID3D11DeviceContext* context, ID3D11ShaderResourceView* cacheSRV)
+{
+	//A full-screen triangle covers the viewport (the tile), and writes the depth no matter what's there
+	fxaaVS->SetShader();
+	shadowFillPS->SetShader();
+	shadowFillPS->SetInt("CopyCache", cacheSRV != nullptr);
+	shadowFillPS->CopyAllBufferData();
+	shadowFillPS->SetShaderResourceView("CacheTexture", cacheSRV);
+	context->OMSetDepthStencilState(shadowFillDepthState, 0);
+
+	// Deactivate vertex and index buffers.
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	ID3D11Buffer* nothing = 0;
+	context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
+	context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
+	context->Draw(3, 0);
+
+	//Unbind the cache (so it can be drawn into again), and go back to only writing depth
+	shadowFillPS->SetShaderResourceView("CacheTexture", 0);
+	context->OMSetDepthStencilState(0, 0);
+	context->PSSetShader(0, 0, 0);
+}
+
+// Set up the shadow vertex shader to draw a light's shadow view
+void Renderer::SetShadowView(Light* light, int view)
+{
+	shadowVS->SetShader();
+	shadowVS->SetMatrix4x4("view", light->GetShadowViewMatrix(view));
+	shadowVS->SetMatrix4x4("projection", light->GetShadowProjectionMatrix(view));
+	shadowVS->CopyBufferData("once");
+}
+
+// Draw either the static or the dynamic entities into the bound shadow map
+void Renderer::DrawShadowCasters(ID3D11DeviceContext* context, bool staticCasters)
+{
+	//Loop through entities (simplified. Look at DrawOpaqueObjects for better documentation)
+	for (auto const& mapPair : renderMap)
+	{
+		if (mapPair.second.size() < 1)
+			continue;
+
+		std::vector<Entity*> list = mapPair.second;
+
+		Mesh* mesh = list[0]->GetMesh();
+
+		// Set buffers in the input assembler
+		UINT stride = sizeof(Vertex);
+		UINT offset = 0;
+		ID3D11Buffer* vertexBuffer = mesh->GetVertexBuffer();
+		ID3D11Buffer* indexBuffer = mesh->GetIndexBuffer();
+		context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+		//Loop through each entity in the list
+		for (size_t i = 0; i < list.size(); i++)
+		{
+			// Grab the data from the first entity's mesh
+			Entity* e = list[i];
+			if (e->IsStatic() != staticCasters)
+				continue;
+
+			shadowVS->SetMatrix4x4("world", e->GetInterpolatedWorldMatrix(interpolationAlpha));
+			shadowVS->CopyBufferData("perObject");
+
+			// Finally do the actual drawing
+			context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
+		}
+	}
+}
+
 // Draw opaque objects
 void Renderer::DrawOpaqueObjects(ID3D11DeviceContext* context, Camera* camera)
 {
@@ -346,8 +442,105 @@ void Renderer::DrawOpaqueObjects(ID3D11DeviceContext* context, Camera* camera)
 	context->OMSetDepthStencilState(0, 0);
 }
 
+// (Re)make a dynamic texture for the water's vertex shader
+bool Renderer::MakeWaterTexture(ID3D11Device* device, int size,
+	ID3D11Texture2D** texture, ID3D11ShaderResourceView** srv)
+{
+	if (*srv != nullptr) (*srv)->Release();
+	if (*texture != nullptr) (*texture)->Release();
+	*srv = nullptr;
+	*texture = nullptr;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = size;
+	desc.Height = size;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	if (FAILED(device->CreateTexture2D(&desc, 0, texture)))
+	{
+		*texture = nullptr;
+		return false;
+	}
+	device->CreateShaderResourceView(*texture, 0, srv);
+	return true;
+}
+
+// Copy the FFT ocean and the wakes into their textures
+void Renderer::UpdateWaterTextures(ID3D11DeviceContext* context, ID3D11Device* device)
+{
+	WaterSurface* waterSurface = WaterSurface::GetInstance();
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+
+	//Only copy when the simulation has moved them on
+	OceanFFT* ocean = waterSurface->GetOcean();
+	if (ocean != nullptr)
+	{
+		if (oceanTexture == nullptr || oceanTextureSize != ocean->GetSize())
+		{
+			if (!MakeWaterTexture(device, ocean->GetSize(), &oceanTexture, &oceanSRV))
+				return;
+			oceanTextureSize = ocean->GetSize();
+			oceanTextureUpdate = ocean->GetUpdateCount() - 1;
+		}
+		if (oceanTextureUpdate != ocean->GetUpdateCount()
+			&& SUCCEEDED(context->Map(oceanTexture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		{
+			ocean->FillDisplacementTexels((float*)mapped.pData, mapped.RowPitch / sizeof(float));
+			context->Unmap(oceanTexture, 0);
+			oceanTextureUpdate = ocean->GetUpdateCount();
+		}
+	}
+
+	WakeField* wake = waterSurface->GetWake();
+	if (wake != nullptr)
+	{
+		if (wakeTexture == nullptr || wakeTextureSize != wake->GetSize())
+		{
+			if (!MakeWaterTexture(device, wake->GetSize(), &wakeTexture, &wakeSRV))
+				return;
+			wakeTextureSize = wake->GetSize();
+			wakeTextureUpdate = wake->GetUpdateCount() - 1;
+		}
+		if (wakeTextureUpdate != wake->GetUpdateCount()
+			&& SUCCEEDED(context->Map(wakeTexture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		{
+			wake->FillTexels((float*)mapped.pData, mapped.RowPitch / sizeof(float));
+			context->Unmap(wakeTexture, 0);
+			wakeTextureUpdate = wake->GetUpdateCount();
+		}
+	}
+}
+
+// Move the water's grid under the camera
+void Renderer::PlaceWater(Camera* camera)
+{
+	XMFLOAT3 centre = waterGrid->GetCentre(camera->GetPosition(), WaterSurface::GetInstance()->GetSurfaceY());
+	water->SetPosition(centre);
+
+	//Snap straight there rather than interpolating from the last simulation step
+	water->StorePreviousTransform();
+}
+
+// Draw transparent water
 void Renderer::DrawWater(ID3D11DeviceContext * context, Camera * camera)
 {
+	//Find the pieces of the grid in view (the camera's matrices are transposed for the shaders)
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMMatrixTranspose(XMLoadFloat4x4(&view)),
+		XMMatrixTranspose(XMLoadFloat4x4(&projection))));
+	XMFLOAT4 planes[6];
+	ExtendedMath::FrustumPlanes(viewProj, planes);
+	waterGrid->Cull(planes, water->GetPosition(), waterRanges);
+	if (waterRanges.empty())
+		return;
+
 	//Set render states
 	context->OMSetBlendState(waterBlendState, 0, 0xFFFFFFFF);
 	context->OMSetDepthStencilState(waterDepthState, 0);
@@ -359,20 +552,25 @@ void Renderer::DrawWater(ID3D11DeviceContext * context, Camera * camera)
 
 	// Set up the shaders
 	waterMat->PrepareMaterialCombo(water, camera);
+	waterMat->GetVertexShader()->SetShaderResourceView("OceanDisplacement", oceanSRV);
+	waterMat->GetVertexShader()->SetShaderResourceView("WakeTexture", wakeSRV);
 
 	// Set buffers in the input assembler
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	ID3D11Buffer* vertexBuffer = cubeMesh->GetVertexBuffer();
-	ID3D11Buffer* indexBuffer = cubeMesh->GetIndexBuffer();
+	ID3D11Buffer* vertexBuffer = waterGrid->GetMesh()->GetVertexBuffer();
+	ID3D11Buffer* indexBuffer = waterGrid->GetMesh()->GetIndexBuffer();
 	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
 	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	//Prepare the material's object specific variables
 	waterMat->PrepareMaterialObject(water);
 
-	// Draw
-	context->DrawIndexed(cubeMesh->GetIndexCount(), 0, 0);
+	// Draw the pieces in view
+	for (const WaterGridRange& range : waterRanges)
+	{
+		context->DrawIndexed(range.indexCount, range.startIndex, 0);
+	}
 
 	// Reset states
 	context->OMSetDepthStencilState(0, 0);
@@ -550,6 +748,9 @@ void Renderer::AddEntityToRenderer(Entity* e)
 		list.push_back(e);
 		renderMap.emplace(identifier, list);
 	}
+
+	if (e->IsStatic())
+		InvalidateStaticShadows();
 }
 
 // Remove an entity from the render list
@@ -579,6 +780,9 @@ void Renderer::RemoveEntityFromRenderer(Entity* e)
 		return;
 	}
 
+	if (e->IsStatic())
+		InvalidateStaticShadows();
+
 	//Swap it for the last one
 	std::swap(*listIt, (*list).back());
 
@@ -616,6 +820,12 @@ bool Renderer::IsEntityInRenderer(Entity* e)
 	return true;
 }
 
+// Make every light redraw its cached static shadow casters
+void Renderer::InvalidateStaticShadows()
+{
+	staticShadowVersion++;
+}
+
 // Tell the renderer to render a collider this frame
 void Renderer::AddDebugCubeToThisFrame(DirectX::XMFLOAT3 position, float size)
 {
@@ -663,6 +873,18 @@ void Renderer::SetClearColor(float r, float g, float b, float a)
 	clearColor[3] = a;
 }
 
+// Set how far between the last two simulation steps to render entities
+void Renderer::SetInterpolationAlpha(float alpha)
+{
+	interpolationAlpha = alpha;
+}
+
+// Get how far between the last two simulation steps to render entities
+float Renderer::GetInterpolationAlpha()
+{
+	return interpolationAlpha;
+}
+
 // Create the post-processing texture
 void Renderer::CreatePostProcessingResources(ID3D11Device* device, UINT width, UINT height)
 {
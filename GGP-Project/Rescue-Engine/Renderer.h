@@ -3,8 +3,12 @@
 #include <unordered_map>
 #include "SimpleShader.h"
 #include "Entity.h"
+#include "Mesh.h"
+#include "Material.h"
 #include "Camera.h"
+#include "Lights.h"
 #include "FXAA.h"
+#include "WaterGrid.h"
 
 // Basis from: https://stackoverflow.com/questions/1008019/c-singleton-design-pattern
 
@@ -30,9 +34,23 @@ private:
 	//Water
 	Material* waterMat;
 	Entity* water;
+	WaterGrid* waterGrid;       //The water entity's mesh
+	std::vector<WaterGridRange> waterRanges;       //Runs of the grid in view this frame
 	ID3D11BlendState* waterBlendState;
 	ID3D11DepthStencilState* waterDepthState;
 
+	//FFT ocean displacement (a copy of the WaterSurface's ocean)
+	ID3D11Texture2D* oceanTexture;
+	ID3D11ShaderResourceView* oceanSRV;
+	int oceanTextureSize;
+	unsigned int oceanTextureUpdate;       //Ocean update the texture was copied from
+
+	//Wake slopes and heights (a copy of the WaterSurface's wake field)
+	ID3D11Texture2D* wakeTexture;
+	ID3D11ShaderResourceView* wakeSRV;
+	int wakeTextureSize;
+	unsigned int wakeTextureUpdate;       //Wake step the texture was copied from
+
 	//Skybox
 	Material* skyboxMat;
 	ID3D11RasterizerState* skyRasterState;
@@ -43,6 +61,9 @@ private:
 	//Shadows
 	ID3D11RasterizerState* shadowRasterizer;
 	SimpleVertexShader* shadowVS;
+	SimplePixelShader* shadowFillPS;       //Clears a tile of the atlas, or copies the static casters' cache into it
+	ID3D11DepthStencilState* shadowFillDepthState;
+	unsigned int staticShadowVersion;       //Goes up whenever the static casters change
 
 	// Post-Process: FXAA ------------------
 	ID3D11RenderTargetView* fxaaRTV; // Allow us to render to a texture.
@@ -54,6 +75,9 @@ private:
 	// Clear color.
 	float clearColor[4];
 
+	//How far between the last two simulation steps we are rendering
+	float interpolationAlpha;
+
 	// --------------------------------------------------------
 	// Singleton Constructor - Set up the singleton instance of the renderer
 	// --------------------------------------------------------
@@ -81,11 +105,47 @@ private:
 		ID3D11DepthStencilView* depthStencilView,
 		UINT width, UINT height);
 
+	// --------------------------------------------------------
+	// Fill the bound tile of a shadow atlas (the viewport) with
+	// the same tile of a cache's depth, or clear it if there's no cache
+	// --------------------------------------------------------
+	void FillShadowTile(ID3D11DeviceContext* context, ID3D11ShaderResourceView* cacheSRV);
+
+	// --------------------------------------------------------
+	// Set up the shadow vertex shader to draw a light's shadow view
+	// --------------------------------------------------------
+	void SetShadowView(Light* light, int view);
+
+	// --------------------------------------------------------
+	// Draw either the static or the dynamic entities into the bound
+	// shadow map (with the shadow vertex shader already set up)
+	// --------------------------------------------------------
+	void DrawShadowCasters(ID3D11DeviceContext* context, bool staticCasters);
+
 	// --------------------------------------------------------
 	// Draw opaque objects
 	// --------------------------------------------------------
 	void DrawOpaqueObjects(ID3D11DeviceContext* context, Camera* camera);
 
+	// --------------------------------------------------------
+	// (Re)make a dynamic RGBA float texture for the water's
+	// vertex shader (releasing the old one)
+	// --------------------------------------------------------
+	bool MakeWaterTexture(ID3D11Device* device, int size,
+		ID3D11Texture2D** texture, ID3D11ShaderResourceView** srv);
+
+	// --------------------------------------------------------
+	// Copy the FFT ocean and the wakes into their textures if
+	// they've been updated since the last copy
+	// --------------------------------------------------------
+	void UpdateWaterTextures(ID3D11DeviceContext* context, ID3D11Device* device);
+
+	// --------------------------------------------------------
+	// Move the water's grid under the camera, before anything
+	// (like the shadow maps) draws it
+	// --------------------------------------------------------
+	void PlaceWater(Camera* camera);
+
 	// --------------------------------------------------------
 	// Draw transparent water
 	// --------------------------------------------------------
@@ -163,6 +223,12 @@ public:
 	// --------------------------------------------------------
 	bool IsEntityInRenderer(Entity* e);
 
+	// --------------------------------------------------------
+	// Make every light redraw its cached static shadow casters
+	// (when a static entity is added, removed or moved)
+	// --------------------------------------------------------
+	void InvalidateStaticShadows();
+
 	// --------------------------------------------------------
 	// Tell the renderer to render a collider this frame
 	// --------------------------------------------------------
@@ -184,6 +250,17 @@ public:
 	void SetClearColor(const float color[4]);
 	void SetClearColor(float r, float g, float b, float a = 1.0);
 
+	// --------------------------------------------------------
+	// Set how far between the last two simulation steps to render
+	// entities (0 = previous step, 1 = current step)
+	// --------------------------------------------------------
+	void SetInterpolationAlpha(float alpha);
+
+	// --------------------------------------------------------
+	// Get how far between the last two simulation steps to render entities
+	// --------------------------------------------------------
+	float GetInterpolationAlpha();
+
 	// --------------------------------------------------------
 	// Create the post-processing texture
 	// --------------------------------------------------------
@@ -0,0 +1,127 @@
+#pragma once
+#include <cmath>
+
+//SIMD is used on x86 (SSE is always there on x64, AVX when compiled for it, which the game is)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCH_SSE
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define BATCH_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+// --------------------------------------------------------
+// Lane types SIMD kernels can run on.
+// Each one has the same operations so a kernel only
+// has to be written once, as a template over the lanes.
+//
+// Masks are F values (all bits set in the lanes that pass),
+// and Greater returns one bit per lane instead. Floor only
+// works on values that fit in an int
+// --------------------------------------------------------
+struct ScalarLanes
+{
+	typedef float F;
+	static constexpr int Width = 1;
+
+	static F Set(float v) { return v; }
+	static F Load(const float* p) { return *p; }
+	static void Store(float* p, F a) { *p = a; }
+	static F Add(F a, F b) { return a + b; }
+	static F Sub(F a, F b) { return a - b; }
+	static F Mul(F a, F b) { return a * b; }
+	static F Div(F a, F b) { return a / b; }
+	static F Min(F a, F b) { return a < b ? a : b; }
+	static F Max(F a, F b) { return a > b ? a : b; }
+	static F Abs(F a) { return fabsf(a); }
+	static F Sqrt(F a) { return sqrtf(a); }
+	static F Floor(F a) { return floorf(a); }
+	static int Greater(F a, F b) { return a > b ? 1 : 0; }
+	static F GreaterMask(F a, F b) { return a > b ? 1.0f : 0.0f; }
+	static F LessMask(F a, F b) { return a < b ? 1.0f : 0.0f; }
+	static F Select(F mask, F a, F b) { return mask != 0 ? a : b; }
+};
+
+#ifdef BATCH_SSE
+struct SSELanes
+{
+	typedef __m128 F;
+	static constexpr int Width = 4;
+
+	static F Set(float v) { return _mm_set1_ps(v); }
+	static F Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+	static F Add(F a, F b) { return _mm_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm_div_ps(a, b); }
+	static F Min(F a, F b) { return _mm_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm_max_ps(a, b); }
+	static F Abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static F Sqrt(F a) { return _mm_sqrt_ps(a); }
+	static F Floor(F a)
+	{
+		//Truncate, then step down where that rounded up (SSE2 has no floor)
+		F t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+		return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+	}
+	static int Greater(F a, F b) { return _mm_movemask_ps(_mm_cmpgt_ps(a, b)); }
+	static F GreaterMask(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static F LessMask(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static F Select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+};
+#endif
+
+#ifdef BATCH_AVX
+struct AVXLanes
+{
+	typedef __m256 F;
+	static constexpr int Width = 8;
+
+	static F Set(float v) { return _mm256_set1_ps(v); }
+	static F Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+	static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+	static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+	static F Abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static F Sqrt(F a) { return _mm256_sqrt_ps(a); }
+	static F Floor(F a) { return _mm256_floor_ps(a); }
+	static int Greater(F a, F b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+	static F GreaterMask(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static F LessMask(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static F Select(F mask, F a, F b) { return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b)); }
+};
+#endif
+
+// --------------------------------------------------------
+// Sine of a number of turns (1 is a whole circle), for
+// L::Width values at once. Wraps to half a turn either side
+// of 0, folds that into a quarter turn either side, then uses
+// a 9th order polynomial (accurate to about 4e-6). Add a
+// quarter turn for the cosine
+// --------------------------------------------------------
+template<typename L>
+static typename L::F SinTurns(typename L::F turns)
+{
+	typedef typename L::F F;
+	const float pi = 3.14159265358979f;
+	F x = L::Mul(L::Sub(turns, L::Floor(L::Add(turns, L::Set(0.5f)))), L::Set(2 * pi));
+
+	//sin(pi - x) = sin(x)
+	x = L::Select(L::GreaterMask(x, L::Set(pi / 2)), L::Sub(L::Set(pi), x), x);
+	x = L::Select(L::LessMask(x, L::Set(-pi / 2)), L::Sub(L::Set(-pi), x), x);
+
+	F x2 = L::Mul(x, x);
+	F poly = L::Set(1.0f / 362880);
+	poly = L::Add(L::Mul(poly, x2), L::Set(-1.0f / 5040));
+	poly = L::Add(L::Mul(poly, x2), L::Set(1.0f / 120));
+	poly = L::Add(L::Mul(poly, x2), L::Set(-1.0f / 6));
+	poly = L::Add(L::Mul(poly, x2), L::Set(1));
+	return L::Mul(poly, x);
+}
@@ -0,0 +1,164 @@
+#include "ShadowAtlas.h"
+#include <algorithm>
+
+// Set up an empty atlas
+ShadowAtlas::ShadowAtlas()
+{
+	atlasSize = 0;
+	minTileSize = 1;
+	usedArea = 0;
+}
+
+// Destructor
+ShadowAtlas::~ShadowAtlas()
+{
+}
+
+// Set the atlas' size and empty it
+void ShadowAtlas::Init(int atlasSize, int minTileSize)
+{
+	this->atlasSize = atlasSize;
+	this->minTileSize = std::max(minTileSize, 1);
+	Clear();
+}
+
+// Free every tile
+void ShadowAtlas::Clear()
+{
+	nodes.clear();
+	nodes.push_back({ 0, 0, atlasSize, -1, false, false });
+	usedArea = 0;
+}
+
+// Find room for a tile
+bool ShadowAtlas::Allocate(int size, ShadowAtlasRect* rect)
+{
+	//Round down to a power of two
+	int tileSize = minTileSize;
+	while (tileSize * 2 <= size)
+	{
+		tileSize *= 2;
+	}
+	if (tileSize > atlasSize || !Allocate(0, tileSize, rect))
+	{
+		*rect = { 0, 0, 0 };
+		return false;
+	}
+	usedArea += tileSize * tileSize;
+	return true;
+}
+
+// Find room for a tile under a node
+bool ShadowAtlas::Allocate(int node, int size, ShadowAtlasRect* rect)
+{
+	if (nodes[node].used || nodes[node].full || nodes[node].size < size)
+		return false;
+
+	//Take the whole node if it fits exactly and nothing is under it
+	if (nodes[node].size == size)
+	{
+		if (nodes[node].firstChild >= 0)
+			return false;
+		nodes[node].used = true;
+		nodes[node].full = true;
+		*rect = { nodes[node].x, nodes[node].y, size };
+		return true;
+	}
+
+	//Split it into quarters (nodes can move as the list grows, so copy what's needed first)
+	if (nodes[node].firstChild < 0)
+	{
+		int x = nodes[node].x;
+		int y = nodes[node].y;
+		int half = nodes[node].size / 2;
+		nodes[node].firstChild = (int)nodes.size();
+		nodes.push_back({ x, y, half, -1, false, false });
+		nodes.push_back({ x + half, y, half, -1, false, false });
+		nodes.push_back({ x, y + half, half, -1, false, false });
+		nodes.push_back({ x + half, y + half, half, -1, false, false });
+	}
+
+	int firstChild = nodes[node].firstChild;
+	bool found = false;
+	for (int i = 0; i < 4 && !found; i++)
+	{
+		found = Allocate(firstChild + i, size, rect);
+	}
+
+	//Full once every quarter is
+	bool full = true;
+	for (int i = 0; i < 4; i++)
+	{
+		full = full && nodes[firstChild + i].full;
+	}
+	nodes[node].full = full;
+	return found;
+}
+
+// Empty the atlas and pack a set of tiles into it
+void ShadowAtlas::Pack(const int* sizes, int count, ShadowAtlasRect* rects)
+{
+	Clear();
+
+	//Round the tiles down to powers of two that fit in the atlas
+	std::vector<int> fitSizes(count);
+	long long area = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int size = minTileSize;
+		while (size * 2 <= sizes[i] && size * 2 <= atlasSize)
+		{
+			size *= 2;
+		}
+		fitSizes[i] = size;
+		area += (long long)size * size;
+	}
+
+	//Halve the biggest tiles (the last of them first) until they all fit, so every tile gets some room
+	long long atlasArea = (long long)atlasSize * atlasSize;
+	while (area > atlasArea)
+	{
+		int biggest = (int)(std::max_element(fitSizes.rbegin(), fitSizes.rend()) - fitSizes.rbegin());
+		int& size = fitSizes[count - 1 - biggest];
+		if (size <= minTileSize)
+			break;
+		size /= 2;
+		area -= (long long)size * size * 3;
+	}
+
+	//Biggest first, so the smaller tiles fill in around them (and every tile fits if their area does)
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&fitSizes](int a, int b) { return fitSizes[a] > fitSizes[b]; });
+	for (int i : order)
+	{
+		Allocate(fitSizes[i], &rects[i]);
+	}
+}
+
+// Get the tile size for how much of the screen a light covers
+int ShadowAtlas::GetTileSize(float importance, int minTileSize, int maxTileSize)
+{
+	int size = minTileSize;
+	float wanted = importance * maxTileSize;
+	while (size * 2 <= wanted && size * 2 <= maxTileSize)
+	{
+		size *= 2;
+	}
+	return size;
+}
+
+// Get texels along each side of the atlas
+int ShadowAtlas::GetSize()
+{
+	return atlasSize;
+}
+
+// Get the texels covered by tiles
+int ShadowAtlas::GetUsedArea()
+{
+	return usedArea;
+}
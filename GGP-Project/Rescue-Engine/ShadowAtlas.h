@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// A square tile of a shadow atlas (in texels)
+// --------------------------------------------------------
+struct ShadowAtlasRect
+{
+	int x;
+	int y;
+	int size;       //0 if there wasn't room
+};
+
+// --------------------------------------------------------
+// Packs square power of two tiles into one square shadow map,
+// with a quadtree: each node is either free, used by a tile,
+// or split into four nodes half its size.
+//
+// Tiles are packed biggest first, so a set of tiles fits as
+// long as their area does. If their area doesn't, the biggest
+// tiles are halved until it does (or every tile is the smallest size).
+//
+// Only does the bookkeeping (no D3D), so it can be checked on the CPU
+// --------------------------------------------------------
+class ShadowAtlas
+{
+private:
+	// --------------------------------------------------------
+	// A square of the atlas
+	// --------------------------------------------------------
+	struct Node
+	{
+		int x;
+		int y;
+		int size;
+		int firstChild;       //Index of the first of 4 children (-1 if not split)
+		bool used;       //A tile covers the whole node
+		bool full;       //No room left anywhere under the node
+	};
+
+	std::vector<Node> nodes;
+	int atlasSize;
+	int minTileSize;
+	int usedArea;       //Texels covered by tiles
+
+	// --------------------------------------------------------
+	// Find room for a tile under a node, splitting it if needed
+	// --------------------------------------------------------
+	bool Allocate(int node, int size, ShadowAtlasRect* rect);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty atlas (call Init to size it)
+	// --------------------------------------------------------
+	ShadowAtlas();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~ShadowAtlas();
+
+	// --------------------------------------------------------
+	// Set the atlas' size and empty it
+	//
+	// atlasSize - texels along each side (a power of two)
+	// minTileSize - smallest tile handed out (a power of two)
+	// --------------------------------------------------------
+	void Init(int atlasSize, int minTileSize);
+
+	// --------------------------------------------------------
+	// Free every tile
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Find room for a tile (rounded down to a power of two)
+	// --------------------------------------------------------
+	bool Allocate(int size, ShadowAtlasRect* rect);
+
+	// --------------------------------------------------------
+	// Empty the atlas and pack a set of tiles into it, biggest
+	// first (ties go to the earlier tile), halving the biggest
+	// tiles if they don't all fit
+	//
+	// sizes - size wanted for each tile
+	// rects - where each tile went (size 0 if there was no room)
+	// --------------------------------------------------------
+	void Pack(const int* sizes, int count, ShadowAtlasRect* rects);
+
+	// --------------------------------------------------------
+	// Get the tile size (a power of two) for how much of the
+	// screen a light covers
+	//
+	// importance - 0 to 1 (1 is the whole screen)
+	// --------------------------------------------------------
+	static int GetTileSize(float importance, int minTileSize, int maxTileSize);
+
+	// --------------------------------------------------------
+	// Get texels along each side of the atlas
+	// --------------------------------------------------------
+	int GetSize();
+
+	// --------------------------------------------------------
+	// Get the texels covered by tiles
+	// --------------------------------------------------------
+	int GetUsedArea();
+};
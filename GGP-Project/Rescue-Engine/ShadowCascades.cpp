@@ -0,0 +1,264 @@
+#include "ShadowCascades.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+//Cascades' sizes are rounded up to these world units, so they only change when the view does
+#define CASCADE_SIZE_STEP 1.0f
+
+//How far behind an unbounded slice (towards the light) casters are caught
+#define CASCADE_CASTER_DISTANCE 50.0f
+
+using namespace DirectX;
+
+// Set up a single cascade
+ShadowCascades::ShadowCascades()
+{
+	count = 1;
+	mapSize = 2048;
+	splitLambda = 0.5f;
+	shadowDistance = 100;
+	bounded = false;
+	boundsMin = XMFLOAT3(0, 0, 0);
+	boundsMax = XMFLOAT3(0, 0, 0);
+
+	for (int i = 0; i <= MAX_SHADOW_CASCADES; i++)
+	{
+		splits[i] = 0;
+	}
+	for (int i = 0; i < MAX_SHADOW_CASCADES; i++)
+	{
+		XMStoreFloat4x4(&views[i], XMMatrixIdentity());
+		XMStoreFloat4x4(&projections[i], XMMatrixIdentity());
+		fitCentres[i] = XMFLOAT2(0, 0);
+		fitSizes[i] = XMFLOAT2(0, 0);
+		fitDepths[i] = XMFLOAT2(0, 0);
+	}
+	fitDirection = XMFLOAT3(0, 0, 0);
+}
+
+// Destructor
+ShadowCascades::~ShadowCascades()
+{
+}
+
+// Set up the cascades
+void ShadowCascades::Init(int count, int mapSize, float splitLambda, float shadowDistance)
+{
+	this->count = std::min(std::max(count, 1), MAX_SHADOW_CASCADES);
+	this->mapSize = std::max(mapSize, 1);
+	this->splitLambda = splitLambda;
+	this->shadowDistance = shadowDistance;
+}
+
+// Only fit the cascades to what's in a box
+void ShadowCascades::SetSceneBounds(XMFLOAT3 min, XMFLOAT3 max)
+{
+	bounded = true;
+	boundsMin = min;
+	boundsMax = max;
+}
+
+// Change the texels along each side of a cascade's map
+void ShadowCascades::SetMapSize(int mapSize)
+{
+	mapSize = std::max(mapSize, 1);
+	if (mapSize == this->mapSize)
+		return;
+	this->mapSize = mapSize;
+
+	//Forget the last fits, they were snapped to the old texels
+	for (int i = 0; i < MAX_SHADOW_CASCADES; i++)
+	{
+		fitSizes[i] = XMFLOAT2(0, 0);
+	}
+}
+
+// Fit the cascades to a camera's frustum
+void ShadowCascades::Fit(XMFLOAT3 cameraPosition, XMFLOAT3 cameraForward, XMFLOAT3 cameraUp,
+	float fov, float aspectRatio, float nearClip, float farClip, XMFLOAT3 lightDirection)
+{
+	//Only split the depths the scene is at, so no cascade is wasted in front of or behind it
+	float nearDepth = nearClip;
+	float farDepth = std::min(farClip, shadowDistance);
+	if (bounded)
+	{
+		float sceneNear = FLT_MAX;
+		float sceneFar = -FLT_MAX;
+		for (int i = 0; i < 8; i++)
+		{
+			float depth =
+				(((i & 1) ? boundsMax.x : boundsMin.x) - cameraPosition.x) * cameraForward.x +
+				(((i & 2) ? boundsMax.y : boundsMin.y) - cameraPosition.y) * cameraForward.y +
+				(((i & 4) ? boundsMax.z : boundsMin.z) - cameraPosition.z) * cameraForward.z;
+			sceneNear = std::min(sceneNear, depth);
+			sceneFar = std::max(sceneFar, depth);
+		}
+		if (std::max(nearDepth, sceneNear) < std::min(farDepth, sceneFar))
+		{
+			nearDepth = std::max(nearDepth, sceneNear);
+			farDepth = std::min(farDepth, sceneFar);
+		}
+	}
+	SplitDepths(nearDepth, farDepth, count, splitLambda, splits);
+
+	//Every cascade looks down the light's direction from the origin, and is
+	//moved around by its projection (so moving it doesn't change the depths)
+	bool sameDirection = lightDirection.x == fitDirection.x && lightDirection.y == fitDirection.y &&
+		lightDirection.z == fitDirection.z;
+	fitDirection = lightDirection;
+	XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = fabsf(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+	XMMATRIX lightView = XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), direction, up);
+
+	//The scene's bounds in the light's space
+	XMFLOAT3 sceneMin(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 sceneMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	if (bounded)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			XMFLOAT3 corner;
+			XMStoreFloat3(&corner, XMVector3Transform(XMVectorSet(
+				(i & 1) ? boundsMax.x : boundsMin.x,
+				(i & 2) ? boundsMax.y : boundsMin.y,
+				(i & 4) ? boundsMax.z : boundsMin.z, 1), lightView));
+			sceneMin = XMFLOAT3(std::min(sceneMin.x, corner.x), std::min(sceneMin.y, corner.y), std::min(sceneMin.z, corner.z));
+			sceneMax = XMFLOAT3(std::max(sceneMax.x, corner.x), std::max(sceneMax.y, corner.y), std::max(sceneMax.z, corner.z));
+		}
+	}
+
+	for (int c = 0; c < count; c++)
+	{
+		//The slice's bounds in the light's space
+		XMFLOAT3 corners[8];
+		GetSliceCorners(cameraPosition, cameraForward, cameraUp, fov, aspectRatio, splits[c], splits[c + 1], corners);
+		XMFLOAT3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = 0; i < 8; i++)
+		{
+			XMFLOAT3 corner;
+			XMStoreFloat3(&corner, XMVector3Transform(XMVectorSet(corners[i].x, corners[i].y, corners[i].z, 1), lightView));
+			min = XMFLOAT3(std::min(min.x, corner.x), std::min(min.y, corner.y), std::min(min.z, corner.z));
+			max = XMFLOAT3(std::max(max.x, corner.x), std::max(max.y, corner.y), std::max(max.z, corner.z));
+		}
+
+		//Only cover the part of the slice in the scene, and every caster in front of it
+		if (bounded)
+		{
+			XMFLOAT2 clippedMin(std::max(min.x, sceneMin.x), std::max(min.y, sceneMin.y));
+			XMFLOAT2 clippedMax(std::min(max.x, sceneMax.x), std::min(max.y, sceneMax.y));
+			if (clippedMin.x < clippedMax.x && clippedMin.y < clippedMax.y)
+			{
+				min = XMFLOAT3(clippedMin.x, clippedMin.y, min.z);
+				max = XMFLOAT3(clippedMax.x, clippedMax.y, max.z);
+			}
+			min.z = sceneMin.z;
+			max.z = sceneMax.z;
+		}
+		else
+			min.z -= CASCADE_CASTER_DISTANCE;
+
+		//Round the size up (leaving a texel each side for the snapping)
+		float border = 2.0f / mapSize;
+		float width = ceilf((max.x - min.x) * (1 + border) / CASCADE_SIZE_STEP) * CASCADE_SIZE_STEP;
+		float height = ceilf((max.y - min.y) * (1 + border) / CASCADE_SIZE_STEP) * CASCADE_SIZE_STEP;
+
+		//Keep the last fit while the slice is still inside it (and it's no more than a step too big)
+		XMFLOAT2 lastCentre = fitCentres[c];
+		XMFLOAT2 lastSize = fitSizes[c];
+		if (sameDirection &&
+			lastSize.x >= width && lastSize.x <= width + CASCADE_SIZE_STEP &&
+			lastSize.y >= height && lastSize.y <= height + CASCADE_SIZE_STEP &&
+			min.x >= lastCentre.x - lastSize.x * 0.5f && max.x <= lastCentre.x + lastSize.x * 0.5f &&
+			min.y >= lastCentre.y - lastSize.y * 0.5f && max.y <= lastCentre.y + lastSize.y * 0.5f &&
+			min.z >= fitDepths[c].x && max.z <= fitDepths[c].y)
+			continue;
+
+		//Move the centre in whole texels, so the texels stay on the same spots in the world
+		float texelX = width / mapSize;
+		float texelY = height / mapSize;
+		float centreX = floorf((min.x + max.x) * 0.5f / texelX + 0.5f) * texelX;
+		float centreY = floorf((min.y + max.y) * 0.5f / texelY + 0.5f) * texelY;
+		fitCentres[c] = XMFLOAT2(centreX, centreY);
+		fitSizes[c] = XMFLOAT2(width, height);
+		fitDepths[c] = XMFLOAT2(min.z, max.z);
+		XMMATRIX projection = XMMatrixOrthographicOffCenterLH(
+			centreX - width * 0.5f, centreX + width * 0.5f,
+			centreY - height * 0.5f, centreY + height * 0.5f,
+			min.z, max.z);
+
+		//Transpose for HLSL
+		XMStoreFloat4x4(&views[c], XMMatrixTranspose(lightView));
+		XMStoreFloat4x4(&projections[c], XMMatrixTranspose(projection));
+	}
+}
+
+// Split a depth range between cascades
+void ShadowCascades::SplitDepths(float nearClip, float farClip, int count, float lambda, float* splits)
+{
+	splits[0] = nearClip;
+	for (int i = 1; i < count; i++)
+	{
+		float fraction = (float)i / count;
+		float even = nearClip + (farClip - nearClip) * fraction;
+		float logarithmic = nearClip * powf(farClip / nearClip, fraction);
+		splits[i] = even + (logarithmic - even) * lambda;
+	}
+	splits[count] = farClip;
+}
+
+// Get the 8 corners of a slice of a camera's frustum
+void ShadowCascades::GetSliceCorners(XMFLOAT3 cameraPosition, XMFLOAT3 cameraForward, XMFLOAT3 cameraUp,
+	float fov, float aspectRatio, float nearDepth, float farDepth, XMFLOAT3 corners[8])
+{
+	XMVECTOR position = XMLoadFloat3(&cameraPosition);
+	XMVECTOR forward = XMVector3Normalize(XMLoadFloat3(&cameraForward));
+	XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&cameraUp), forward));
+	XMVECTOR up = XMVector3Cross(forward, right);
+	float tanHalfFov = tanf(fov * 0.5f);
+
+	for (int i = 0; i < 2; i++)
+	{
+		float depth = i == 0 ? nearDepth : farDepth;
+		float halfHeight = depth * tanHalfFov;
+		float halfWidth = halfHeight * aspectRatio;
+		XMVECTOR centre = XMVectorAdd(position, XMVectorScale(forward, depth));
+		for (int j = 0; j < 4; j++)
+		{
+			XMVECTOR corner = XMVectorAdd(centre, XMVectorScale(right, (j & 1) ? halfWidth : -halfWidth));
+			corner = XMVectorAdd(corner, XMVectorScale(up, (j & 2) ? halfHeight : -halfHeight));
+			XMStoreFloat3(&corners[i * 4 + j], corner);
+		}
+	}
+}
+
+// Get the amount of cascades
+int ShadowCascades::GetCount()
+{
+	return count;
+}
+
+// Get texels along each side of a cascade's map
+int ShadowCascades::GetMapSize()
+{
+	return mapSize;
+}
+
+// Get the view depth a cascade starts at
+float ShadowCascades::GetSplit(int index)
+{
+	return splits[index];
+}
+
+// Get a cascade's view matrix (transposed)
+XMFLOAT4X4 ShadowCascades::GetViewMatrix(int cascade)
+{
+	return views[cascade];
+}
+
+// Get a cascade's projection matrix (transposed)
+XMFLOAT4X4 ShadowCascades::GetProjectionMatrix(int cascade)
+{
+	return projections[cascade];
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <DirectXMath.h>
+
+//Most cascades a shadow map can be split into
+#define MAX_SHADOW_CASCADES 4
+
+// --------------------------------------------------------
+// Cascaded shadow maps for a directional light.
+//
+// The camera's view frustum is split into slices by depth, and
+// each slice gets its own orthographic projection (and its own
+// tile of the shadow atlas), so the shadows close to the camera
+// get as many texels as the ones far away.
+//
+// Only the depths the scene's bounds are at are split, and each
+// slice is fit in the light's space to the part of it that
+// overlaps the scene's bounds. The fits are rounded up to whole
+// steps and moved in whole texels, so the shadows don't shimmer
+// as the camera moves, and are kept while the slice stays inside
+// them, so cached depth drawn into a cascade stays usable.
+//
+// Only does the math (no D3D), so it can be checked on the CPU
+// --------------------------------------------------------
+class ShadowCascades
+{
+private:
+	int count;
+	int mapSize;       //Texels along each side of a cascade's map
+	float splitLambda;       //0 splits the depth evenly, 1 logarithmically
+	float shadowDistance;       //Furthest from the camera shadows are drawn
+
+	//Where the casters and receivers are (everything, if unbounded)
+	bool bounded;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+
+	//View depth each cascade starts at (and the last one ends at)
+	float splits[MAX_SHADOW_CASCADES + 1];
+
+	//Matrices (transposed for HLSL)
+	DirectX::XMFLOAT4X4 views[MAX_SHADOW_CASCADES];
+	DirectX::XMFLOAT4X4 projections[MAX_SHADOW_CASCADES];
+
+	//Last fits, in the light's space
+	DirectX::XMFLOAT3 fitDirection;       //Light direction they were fit to
+	DirectX::XMFLOAT2 fitCentres[MAX_SHADOW_CASCADES];
+	DirectX::XMFLOAT2 fitSizes[MAX_SHADOW_CASCADES];
+	DirectX::XMFLOAT2 fitDepths[MAX_SHADOW_CASCADES];       //Near and far
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up a single cascade (call Init to change it)
+	// --------------------------------------------------------
+	ShadowCascades();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~ShadowCascades();
+
+	// --------------------------------------------------------
+	// Set up the cascades
+	//
+	// count - cascades to split the view into (1 to MAX_SHADOW_CASCADES)
+	// mapSize - texels along each side of a cascade's map
+	// splitLambda - 0 splits the depth evenly, 1 logarithmically
+	// shadowDistance - furthest from the camera shadows are drawn
+	// --------------------------------------------------------
+	void Init(int count, int mapSize, float splitLambda, float shadowDistance);
+
+	// --------------------------------------------------------
+	// Only fit the cascades to what's in a box (the scene that
+	// casts and receives shadows)
+	// --------------------------------------------------------
+	void SetSceneBounds(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max);
+
+	// --------------------------------------------------------
+	// Change the texels along each side of a cascade's map (the
+	// cascades are refit next time, so they snap to the new texels)
+	// --------------------------------------------------------
+	void SetMapSize(int mapSize);
+
+	// --------------------------------------------------------
+	// Fit the cascades to a camera's frustum
+	//
+	// fov - vertical field of view (radians)
+	// aspectRatio - width / height
+	// lightDirection - direction the light shines in
+	// --------------------------------------------------------
+	void Fit(DirectX::XMFLOAT3 cameraPosition, DirectX::XMFLOAT3 cameraForward, DirectX::XMFLOAT3 cameraUp,
+		float fov, float aspectRatio, float nearClip, float farClip, DirectX::XMFLOAT3 lightDirection);
+
+	// --------------------------------------------------------
+	// Split a depth range between cascades, blending even and
+	// logarithmic splits (GPU Gems 3, chapter 10)
+	//
+	// splits - count + 1 depths, from nearClip to farClip
+	// --------------------------------------------------------
+	static void SplitDepths(float nearClip, float farClip, int count, float lambda, float* splits);
+
+	// --------------------------------------------------------
+	// Get the 8 corners of a slice of a camera's frustum
+	// (near corners first)
+	// --------------------------------------------------------
+	static void GetSliceCorners(DirectX::XMFLOAT3 cameraPosition, DirectX::XMFLOAT3 cameraForward,
+		DirectX::XMFLOAT3 cameraUp, float fov, float aspectRatio, float nearDepth, float farDepth,
+		DirectX::XMFLOAT3 corners[8]);
+
+	// --------------------------------------------------------
+	// Get the amount of cascades
+	// --------------------------------------------------------
+	int GetCount();
+
+	// --------------------------------------------------------
+	// Get texels along each side of a cascade's map
+	// --------------------------------------------------------
+	int GetMapSize();
+
+	// --------------------------------------------------------
+	// Get the view depth a cascade starts at (GetSplit(count) is
+	// where the last one ends)
+	// --------------------------------------------------------
+	float GetSplit(int index);
+
+	// --------------------------------------------------------
+	// Get a cascade's view matrix (transposed)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT4X4 GetViewMatrix(int cascade);
+
+	// --------------------------------------------------------
+	// Get a cascade's projection matrix (transposed)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT4X4 GetProjectionMatrix(int cascade);
+};
@@ -116,6 +116,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_TEXTURE: // A texture resource
+		case D3D_SIT_STRUCTURED: // A structured buffer (bound through an SRV too)
 		{
 			// Create the SRV wrapper
 			SimpleSRV* srv = new SimpleSRV();
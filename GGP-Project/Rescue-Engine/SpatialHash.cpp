@@ -0,0 +1,385 @@
+#include "SpatialHash.h"
+#include <cmath>
+#include <algorithm>
+
+//Cell coordinates are packed into 21 bits each
+#define CELL_COORD_BITS 21
+#define CELL_COORD_OFFSET (1 << (CELL_COORD_BITS - 1))
+#define CELL_COORD_MASK ((1ULL << CELL_COORD_BITS) - 1)
+
+//Cells with at least this many colliders are paired up by layer
+#define LAYER_GROUP_MIN_COUNT 16
+
+//Empty cells are erased once there are this many more of them than occupied cells
+#define EMPTY_CELL_SLACK 64
+
+using namespace DirectX;
+
+// Set up an empty spatial hash
+SpatialHash::SpatialHash(float cellSize)
+{
+	this->cellSize = cellSize;
+	invCellSize = 1.0f / cellSize;
+	colliderCount = 0;
+}
+
+// Remove all colliders from the hash
+SpatialHash::~SpatialHash()
+{
+	Clear();
+}
+
+// Pack integer cell coordinates into a cell key
+unsigned long long SpatialHash::GetCellKey(int x, int y, int z)
+{
+	return ((unsigned long long)(x + CELL_COORD_OFFSET) & CELL_COORD_MASK) |
+		(((unsigned long long)(y + CELL_COORD_OFFSET) & CELL_COORD_MASK) << CELL_COORD_BITS) |
+		(((unsigned long long)(z + CELL_COORD_OFFSET) & CELL_COORD_MASK) << (CELL_COORD_BITS * 2));
+}
+
+// Get the range of cells a collider's bounds touch (and cache the bounds)
+void SpatialHash::GetCellRange(Collider* collider, int cellMin[3], int cellMax[3])
+{
+	collider->GetBounds(&collider->boundsMin, &collider->boundsMax);
+
+	const float* boundsMin = &collider->boundsMin.x;
+	const float* boundsMax = &collider->boundsMax.x;
+	for (int i = 0; i < 3; i++)
+	{
+		float low = std::max(floorf(boundsMin[i] * invCellSize), (float)-CELL_COORD_OFFSET);
+		float high = std::min(floorf(boundsMax[i] * invCellSize), (float)(CELL_COORD_OFFSET - 1));
+		cellMin[i] = (int)low;
+		cellMax[i] = std::max((int)high, cellMin[i]);
+	}
+}
+
+// Add a collider to every cell in a range
+void SpatialHash::AddToCells(Collider* collider, const int cellMin[3], const int cellMax[3])
+{
+	for (int x = cellMin[0]; x <= cellMax[0]; x++)
+		for (int y = cellMin[1]; y <= cellMax[1]; y++)
+			for (int z = cellMin[2]; z <= cellMax[2]; z++)
+			{
+				unsigned long long key = GetCellKey(x, y, z);
+				SpatialCell& cell = cells[key];
+				if (cell.occupiedIndex < 0)
+				{
+					cell.key = key;
+					cell.occupiedIndex = (int)occupiedCells.size();
+					occupiedCells.push_back(&cell);
+				}
+				cell.colliders.push_back(collider);
+				cell.layers |= collider->GetCollisionLayer();
+				cell.masks |= collider->GetCollisionMask();
+			}
+}
+
+// Remove a collider from every cell in a range
+void SpatialHash::RemoveFromCells(Collider* collider, const int cellMin[3], const int cellMax[3])
+{
+	for (int x = cellMin[0]; x <= cellMax[0]; x++)
+		for (int y = cellMin[1]; y <= cellMax[1]; y++)
+			for (int z = cellMin[2]; z <= cellMax[2]; z++)
+			{
+				auto cell = cells.find(GetCellKey(x, y, z));
+				if (cell == cells.end())
+					continue;
+
+				//Swap it for the last one and pop
+				std::vector<Collider*>& colliders = cell->second.colliders;
+				auto found = std::find(colliders.begin(), colliders.end(), collider);
+				if (found != colliders.end())
+				{
+					*found = colliders.back();
+					colliders.pop_back();
+				}
+
+				//The layers are worked out again when the cell is next paired up
+				cell->second.layersStale = true;
+
+				//Take it off the occupied list once it's empty (the last one fills its spot)
+				if (colliders.empty() && cell->second.occupiedIndex >= 0)
+				{
+					SpatialCell* last = occupiedCells.back();
+					last->occupiedIndex = cell->second.occupiedIndex;
+					occupiedCells[last->occupiedIndex] = last;
+					occupiedCells.pop_back();
+					cell->second.occupiedIndex = -1;
+				}
+			}
+}
+
+// Erase the empty cells once they outnumber the occupied ones
+void SpatialHash::PruneEmptyCells()
+{
+	if (cells.size() <= occupiedCells.size() * 2 + EMPTY_CELL_SLACK)
+		return;
+
+	for (auto cell = cells.begin(); cell != cells.end();)
+	{
+		if (cell->second.occupiedIndex < 0)
+			cell = cells.erase(cell);
+		else cell++;
+	}
+}
+
+// Check if two colliders' cached bounds overlap
+bool SpatialHash::BoundsOverlap(Collider* a, Collider* b)
+{
+	return a->boundsMin.x <= b->boundsMax.x && a->boundsMax.x >= b->boundsMin.x &&
+		a->boundsMin.y <= b->boundsMax.y && a->boundsMax.y >= b->boundsMin.y &&
+		a->boundsMin.z <= b->boundsMax.z && a->boundsMax.z >= b->boundsMin.z;
+}
+
+// Check if a cell is the first cell two colliders share
+bool SpatialHash::IsFirstSharedCell(Collider* a, Collider* b, int x, int y, int z)
+{
+	return x == std::max(a->cellMin[0], b->cellMin[0]) &&
+		y == std::max(a->cellMin[1], b->cellMin[1]) &&
+		z == std::max(a->cellMin[2], b->cellMin[2]);
+}
+
+// Add a collider to the hash
+void SpatialHash::Insert(Collider* collider)
+{
+	if (collider->spatialHash == this)
+		return;
+	if (collider->spatialHash != nullptr)
+		collider->spatialHash->Remove(collider);
+
+	GetCellRange(collider, collider->cellMin, collider->cellMax);
+	AddToCells(collider, collider->cellMin, collider->cellMax);
+	collider->spatialHash = this;
+	collider->hashDirty = false;
+	colliderCount++;
+}
+
+// Remove a collider from the hash
+void SpatialHash::Remove(Collider* collider)
+{
+	if (collider->spatialHash != this)
+		return;
+
+	//Don't leave it waiting for a refresh
+	if (collider->hashDirty)
+	{
+		std::lock_guard<std::mutex> lock(dirtyMutex);
+		auto found = std::find(dirtyColliders.begin(), dirtyColliders.end(), collider);
+		if (found != dirtyColliders.end())
+			dirtyColliders.erase(found);
+	}
+
+	RemoveFromCells(collider, collider->cellMin, collider->cellMax);
+	collider->spatialHash = nullptr;
+	collider->hashDirty = false;
+	colliderCount--;
+}
+
+// Remove every collider from the hash
+void SpatialHash::Clear()
+{
+	for (auto cell = cells.begin(); cell != cells.end(); cell++)
+	{
+		std::vector<Collider*>& colliders = cell->second.colliders;
+		for (size_t i = 0; i < colliders.size(); i++)
+		{
+			colliders[i]->spatialHash = nullptr;
+			colliders[i]->hashDirty = false;
+		}
+	}
+
+	cells.clear();
+	occupiedCells.clear();
+	dirtyColliders.clear();
+	colliderCount = 0;
+}
+
+// Queue a collider that moved to be re-bucketed on the next refresh
+void SpatialHash::MarkDirty(Collider* collider)
+{
+	std::lock_guard<std::mutex> lock(dirtyMutex);
+	dirtyColliders.push_back(collider);
+}
+
+// Move colliders that moved since the last refresh into their new cells
+void SpatialHash::Refresh()
+{
+	for (size_t i = 0; i < dirtyColliders.size(); i++)
+	{
+		Collider* collider = dirtyColliders[i];
+		collider->hashDirty = false;
+
+		//Most moves stay within the same cells
+		int cellMin[3];
+		int cellMax[3];
+		GetCellRange(collider, cellMin, cellMax);
+		if (std::equal(cellMin, cellMin + 3, collider->cellMin) &&
+			std::equal(cellMax, cellMax + 3, collider->cellMax))
+			continue;
+
+		RemoveFromCells(collider, collider->cellMin, collider->cellMax);
+		AddToCells(collider, cellMin, cellMax);
+		std::copy(cellMin, cellMin + 3, collider->cellMin);
+		std::copy(cellMax, cellMax + 3, collider->cellMax);
+	}
+	dirtyColliders.clear();
+	PruneEmptyCells();
+}
+
+// Get every collider whose bounds overlap a collider's bounds
+void SpatialHash::Query(Collider* collider, std::vector<Collider*>& results)
+{
+	results.clear();
+	Refresh();
+
+	//Colliders outside the hash still get checked against it
+	int cellMin[3];
+	int cellMax[3];
+	if (collider->spatialHash == this)
+	{
+		std::copy(collider->cellMin, collider->cellMin + 3, cellMin);
+		std::copy(collider->cellMax, collider->cellMax + 3, cellMax);
+	}
+	else
+	{
+		GetCellRange(collider, cellMin, cellMax);
+		std::copy(cellMin, cellMin + 3, collider->cellMin);
+		std::copy(cellMax, cellMax + 3, collider->cellMax);
+	}
+
+	for (int x = cellMin[0]; x <= cellMax[0]; x++)
+		for (int y = cellMin[1]; y <= cellMax[1]; y++)
+			for (int z = cellMin[2]; z <= cellMax[2]; z++)
+			{
+				auto cell = cells.find(GetCellKey(x, y, z));
+				if (cell == cells.end())
+					continue;
+
+				std::vector<Collider*>& colliders = cell->second.colliders;
+				for (size_t i = 0; i < colliders.size(); i++)
+				{
+					Collider* other = colliders[i];
+					if (other != collider && collider->CanCollideWith(other) &&
+						IsFirstSharedCell(collider, other, x, y, z) && BoundsOverlap(collider, other))
+						results.push_back(other);
+				}
+			}
+}
+
+// Get every pair of colliders whose bounds overlap
+void SpatialHash::QueryPairs(std::vector<ColliderPair>& pairs)
+{
+	pairs.clear();
+	Refresh();
+
+	for (size_t i = 0; i < occupiedCells.size(); i++)
+	{
+		SpatialCell& spatialCell = *occupiedCells[i];
+		std::vector<Collider*>& colliders = spatialCell.colliders;
+		if (colliders.size() < 2)
+			continue;
+
+		//Skip cells where no layer wants any other (like a cell full of
+		//swimmers that only collide with the boat) without touching the colliders
+		if ((spatialCell.layers & spatialCell.masks) == 0)
+			continue;
+		if (spatialCell.layersStale)
+		{
+			spatialCell.layers = 0;
+			spatialCell.masks = 0;
+			for (size_t i = 0; i < colliders.size(); i++)
+			{
+				spatialCell.layers |= colliders[i]->GetCollisionLayer();
+				spatialCell.masks |= colliders[i]->GetCollisionMask();
+			}
+			spatialCell.layersStale = false;
+			if ((spatialCell.layers & spatialCell.masks) == 0)
+				continue;
+		}
+
+		//Unpack the cell coordinates
+		int x = (int)(spatialCell.key & CELL_COORD_MASK) - CELL_COORD_OFFSET;
+		int y = (int)((spatialCell.key >> CELL_COORD_BITS) & CELL_COORD_MASK) - CELL_COORD_OFFSET;
+		int z = (int)((spatialCell.key >> (CELL_COORD_BITS * 2)) & CELL_COORD_MASK) - CELL_COORD_OFFSET;
+
+		AddCellPairs(spatialCell, x, y, z, pairs);
+	}
+}
+
+// Add the overlapping pairs in a cell to a list
+void SpatialHash::AddCellPairs(SpatialCell& cell, int x, int y, int z, std::vector<ColliderPair>& pairs)
+{
+	std::vector<Collider*>& colliders = cell.colliders;
+	if (colliders.size() < LAYER_GROUP_MIN_COUNT)
+	{
+		for (size_t i = 0; i < colliders.size(); i++)
+			for (size_t j = i + 1; j < colliders.size(); j++)
+			{
+				Collider* a = colliders[i];
+				Collider* b = colliders[j];
+				if (a->CanCollideWith(b) && IsFirstSharedCell(a, b, x, y, z) && BoundsOverlap(a, b))
+					pairs.push_back({ a, b });
+			}
+		return;
+	}
+
+	//Group the colliders by layer and mask
+	groupedColliders.assign(colliders.begin(), colliders.end());
+	std::sort(groupedColliders.begin(), groupedColliders.end(), [](const Collider* a, const Collider* b)
+	{
+		if (a->GetCollisionLayer() != b->GetCollisionLayer())
+			return a->GetCollisionLayer() < b->GetCollisionLayer();
+		return a->GetCollisionMask() < b->GetCollisionMask();
+	});
+	groupStarts.clear();
+	for (int i = 0; i < (int)groupedColliders.size(); i++)
+	{
+		if (i == 0 || groupedColliders[i]->GetCollisionLayer() != groupedColliders[i - 1]->GetCollisionLayer() ||
+			groupedColliders[i]->GetCollisionMask() != groupedColliders[i - 1]->GetCollisionMask())
+			groupStarts.push_back(i);
+	}
+	groupStarts.push_back((int)groupedColliders.size());
+
+	//Only pair up groups that collide (a crowd of swimmers around the
+	//boat only pairs with the boat, not with each other)
+	int groupCount = (int)groupStarts.size() - 1;
+	for (int g = 0; g < groupCount; g++)
+		for (int h = g; h < groupCount; h++)
+		{
+			if (!groupedColliders[groupStarts[g]]->CanCollideWith(groupedColliders[groupStarts[h]]))
+				continue;
+
+			for (int i = groupStarts[g]; i < groupStarts[g + 1]; i++)
+				for (int j = (g == h ? i + 1 : groupStarts[h]); j < groupStarts[h + 1]; j++)
+				{
+					Collider* a = groupedColliders[i];
+					Collider* b = groupedColliders[j];
+					if (IsFirstSharedCell(a, b, x, y, z) && BoundsOverlap(a, b))
+						pairs.push_back({ a, b });
+				}
+		}
+}
+
+// Get the amount of colliders in the hash
+int SpatialHash::GetColliderCount()
+{
+	return colliderCount;
+}
+
+// Get the amount of cells with colliders in them
+int SpatialHash::GetOccupiedCellCount()
+{
+	return (int)occupiedCells.size();
+}
+
+// Get the amount of cells in the hash
+int SpatialHash::GetCellCount()
+{
+	return (int)cells.size();
+}
+
+// Get the width of a grid cell
+float SpatialHash::GetCellSize()
+{
+	return cellSize;
+}
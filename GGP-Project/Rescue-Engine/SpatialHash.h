@@ -0,0 +1,173 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "Collider.h"
+
+//A pair of colliders whose bounds overlap
+struct ColliderPair
+{
+	Collider* a;
+	Collider* b;
+};
+
+//A grid cell and the colliders touching it
+struct SpatialCell
+{
+	std::vector<Collider*> colliders;
+	unsigned int layers;       //Every layer in the cell
+	unsigned int masks;       //Every layer anything in the cell collides with
+	bool layersStale;       //Something left, so the layers may have extra bits
+	unsigned long long key;
+	int occupiedIndex = -1;       //Spot in the occupied cell list (-1 if the cell is empty)
+};
+
+// --------------------------------------------------------
+// A uniform grid broadphase for colliders.
+//
+// Colliders are bucketed into every cell their world bounds touch,
+// and move between cells as they are moved. Queries only return
+// colliders whose bounds overlap (each one once) and whose collision
+// layers let them collide, so the full SAT test only runs on nearby pairs
+// --------------------------------------------------------
+class SpatialHash
+{
+private:
+	float cellSize;
+	float invCellSize;
+
+	//Cell key -> colliders touching that cell
+	std::unordered_map<unsigned long long, SpatialCell> cells;
+	std::vector<SpatialCell*> occupiedCells;       //Cells with colliders in them (pair queries only walk these)
+	int colliderCount;
+
+	//Scratch space for pairing up big cells by layer
+	std::vector<Collider*> groupedColliders;
+	std::vector<int> groupStarts;
+
+	//Colliders that moved since the last refresh
+	std::vector<Collider*> dirtyColliders;
+	std::mutex dirtyMutex;       //Colliders can be moved from worker threads
+
+	// --------------------------------------------------------
+	// Pack integer cell coordinates into a cell key
+	// --------------------------------------------------------
+	static unsigned long long GetCellKey(int x, int y, int z);
+
+	// --------------------------------------------------------
+	// Get the range of cells a collider's bounds touch
+	// --------------------------------------------------------
+	void GetCellRange(Collider* collider, int cellMin[3], int cellMax[3]);
+
+	// --------------------------------------------------------
+	// Add or remove a collider from every cell in a range
+	// --------------------------------------------------------
+	void AddToCells(Collider* collider, const int cellMin[3], const int cellMax[3]);
+	void RemoveFromCells(Collider* collider, const int cellMin[3], const int cellMax[3]);
+
+	// --------------------------------------------------------
+	// Erase the empty cells once they outnumber the occupied ones
+	// (they're kept until then, so colliders moving back and forth
+	// don't reallocate them)
+	// --------------------------------------------------------
+	void PruneEmptyCells();
+
+	// --------------------------------------------------------
+	// Add the overlapping pairs in a cell to a list, checking every pair
+	// in small cells and only pairing up layers that collide in big ones
+	// --------------------------------------------------------
+	void AddCellPairs(SpatialCell& cell, int x, int y, int z, std::vector<ColliderPair>& pairs);
+
+	// --------------------------------------------------------
+	// Check if two colliders' cached bounds overlap
+	// --------------------------------------------------------
+	static bool BoundsOverlap(Collider* a, Collider* b);
+
+	// --------------------------------------------------------
+	// Check if a cell is the first cell two colliders share
+	// (so pairs touching several cells are only reported once)
+	// --------------------------------------------------------
+	static bool IsFirstSharedCell(Collider* a, Collider* b, int x, int y, int z);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty spatial hash
+	//
+	// cellSize - width of a grid cell. Works best at about the size
+	//			  of the most common collider
+	// --------------------------------------------------------
+	SpatialHash(float cellSize = 2.0f);
+
+	// --------------------------------------------------------
+	// Destructor - Remove all colliders from the hash
+	// --------------------------------------------------------
+	~SpatialHash();
+
+	//Delete this
+	SpatialHash(SpatialHash const&) = delete;
+	void operator=(SpatialHash const&) = delete;
+
+	// --------------------------------------------------------
+	// Add a collider to the hash. It tracks its own movement from then on
+	// --------------------------------------------------------
+	void Insert(Collider* collider);
+
+	// --------------------------------------------------------
+	// Remove a collider from the hash
+	// --------------------------------------------------------
+	void Remove(Collider* collider);
+
+	// --------------------------------------------------------
+	// Remove every collider from the hash
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// NOT FOR USE OUTSIDE OF COLLIDER.CPP
+	// Queue a collider that moved to be re-bucketed on the next refresh
+	// --------------------------------------------------------
+	void MarkDirty(Collider* collider);
+
+	// --------------------------------------------------------
+	// Move colliders that moved since the last refresh into their new cells.
+	// Queries refresh automatically
+	// --------------------------------------------------------
+	void Refresh();
+
+	// --------------------------------------------------------
+	// Get every collider whose bounds overlap a collider's bounds
+	// (not including itself)
+	//
+	// collider - the collider to check around
+	// results - cleared and filled with the overlapping colliders
+	// --------------------------------------------------------
+	void Query(Collider* collider, std::vector<Collider*>& results);
+
+	// --------------------------------------------------------
+	// Get every pair of colliders whose bounds overlap
+	//
+	// pairs - cleared and filled with the overlapping pairs
+	// --------------------------------------------------------
+	void QueryPairs(std::vector<ColliderPair>& pairs);
+
+	// --------------------------------------------------------
+	// Get the amount of colliders in the hash
+	// --------------------------------------------------------
+	int GetColliderCount();
+
+	// --------------------------------------------------------
+	// Get the amount of cells with colliders in them
+	// --------------------------------------------------------
+	int GetOccupiedCellCount();
+
+	// --------------------------------------------------------
+	// Get the amount of cells in the hash (occupied or not)
+	// --------------------------------------------------------
+	int GetCellCount();
+
+	// --------------------------------------------------------
+	// Get the width of a grid cell
+	// --------------------------------------------------------
+	float GetCellSize();
+};
@@ -0,0 +1,247 @@
+#include "TimerWheel.h"
+#include <cmath>
+#include <cstdio>
+
+//Ticks per second to start with (two per step at 60 Hz)
+#define DEFAULT_TICK_RATE 120.0
+
+//Fraction of a tick that floating point error is allowed to be off by
+#define TICK_EPSILON 0.000001
+
+//Farthest a timer can be placed (the rest is waited out by cascading again)
+#define MAX_TICKS ((1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)
+
+// Set up an empty wheel
+TimerWheel::TimerWheel()
+{
+	freeNode = -1;
+	for (int i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++)
+	{
+		slotHeads[i] = -1;
+		slotTails[i] = -1;
+	}
+	pendingCount = 0;
+
+	currentTick = 0;
+	time = 0;
+	tickLength = 1.0 / DEFAULT_TICK_RATE;
+	firedCount = 0;
+}
+
+// Destructor
+TimerWheel::~TimerWheel()
+{
+}
+
+// Put a node in the slot for its due tick
+void TimerWheel::Insert(int node)
+{
+	TimerNode& timer = nodes[node];
+	unsigned long long delta = timer.dueTick > currentTick ? timer.dueTick - currentTick : 0;
+	unsigned long long due = delta > MAX_TICKS ? currentTick + MAX_TICKS : timer.dueTick;
+	if (delta > MAX_TICKS)
+		delta = MAX_TICKS;
+
+	//The lowest level whose turn still reaches the due tick
+	int level = 0;
+	while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << ((level + 1) * TIMER_WHEEL_SLOT_BITS)))
+		level++;
+	int slot = level * TIMER_WHEEL_SLOTS
+		+ (int)((due >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+
+	//Append so timers in a slot fire in the order they were scheduled
+	timer.slot = slot;
+	timer.prev = slotTails[slot];
+	timer.next = -1;
+	if (slotTails[slot] != -1)
+		nodes[slotTails[slot]].next = node;
+	else slotHeads[slot] = node;
+	slotTails[slot] = node;
+}
+
+// Take a node out of its slot
+void TimerWheel::Unlink(int node)
+{
+	TimerNode& timer = nodes[node];
+	if (timer.prev != -1)
+		nodes[timer.prev].next = timer.next;
+	else slotHeads[timer.slot] = timer.next;
+	if (timer.next != -1)
+		nodes[timer.next].prev = timer.prev;
+	else slotTails[timer.slot] = timer.prev;
+	timer.prev = -1;
+	timer.next = -1;
+}
+
+// Take a node out of its slot and put it on the free list
+void TimerWheel::Free(int node)
+{
+	TimerNode& timer = nodes[node];
+	if (timer.slot != -1)
+		Unlink(node);
+	timer.callback = nullptr;
+	timer.slot = -1;
+	timer.generation++;
+	timer.next = freeNode;
+	freeNode = node;
+	pendingCount--;
+}
+
+// Spread the current slot of a level back down
+void TimerWheel::Cascade(int level)
+{
+	int index = (int)((currentTick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+
+	//This level wrapped around too, so the level above spreads into it first
+	if (index == 0 && level + 1 < TIMER_WHEEL_LEVELS)
+		Cascade(level + 1);
+
+	int slot = level * TIMER_WHEEL_SLOTS + index;
+	int node = slotHeads[slot];
+	slotHeads[slot] = -1;
+	slotTails[slot] = -1;
+	while (node != -1)
+	{
+		int next = nodes[node].next;
+		Insert(node);
+		node = next;
+	}
+}
+
+// Move to the next tick and run the timers due on it
+void TimerWheel::Tick()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	currentTick++;
+	if ((currentTick & (TIMER_WHEEL_SLOTS - 1)) == 0)
+		Cascade(1);
+
+	//Everything in this slot is due (later timers would be on a higher level)
+	int slot = (int)(currentTick & (TIMER_WHEEL_SLOTS - 1));
+	while (slotHeads[slot] != -1)
+	{
+		int node = slotHeads[slot];
+		std::function<void()> callback = std::move(nodes[node].callback);
+		Free(node);
+		firedCount++;
+
+		//Callbacks can use the wheel
+		lock.unlock();
+		callback();
+		lock.lock();
+	}
+}
+
+// Schedule a callback some ticks from now
+TimerHandle TimerWheel::ScheduleTicks(unsigned long long ticks, std::function<void()> callback)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (ticks < 1)
+		ticks = 1;
+
+	//Reuse a free node if there is one
+	int node = freeNode;
+	if (node != -1)
+		freeNode = nodes[node].next;
+	else
+	{
+		node = (int)nodes.size();
+		nodes.push_back(TimerNode());
+		nodes[node].generation = 0;
+	}
+
+	TimerNode& timer = nodes[node];
+	timer.callback = std::move(callback);
+	timer.dueTick = currentTick + ticks;
+	Insert(node);
+	pendingCount++;
+
+	TimerHandle handle;
+	handle.index = node;
+	handle.generation = timer.generation;
+	return handle;
+}
+
+// Schedule a callback some seconds from now
+TimerHandle TimerWheel::Schedule(double seconds, std::function<void()> callback)
+{
+	//First tick at or after the time (the tick could have been advanced past it already)
+	double dueTick = std::ceil((time + seconds) / tickLength - TICK_EPSILON);
+	unsigned long long ticks = 1;
+	if (dueTick > (double)currentTick)
+		ticks = (unsigned long long)dueTick - currentTick;
+	return ScheduleTicks(ticks, std::move(callback));
+}
+
+// Cancel a timer
+void TimerWheel::Cancel(TimerHandle& handle)
+{
+	if (handle.index < 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	TimerNode& timer = nodes[handle.index];
+	if (timer.generation == handle.generation && timer.slot != -1)
+		Free(handle.index);
+	handle.index = -1;
+}
+
+// Check if a timer is still waiting to fire
+bool TimerWheel::IsPending(const TimerHandle& handle)
+{
+	if (handle.index < 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	const TimerNode& timer = nodes[handle.index];
+	return timer.generation == handle.generation && timer.slot != -1;
+}
+
+// Advance the wheel by a simulation step
+void TimerWheel::Advance(float deltaTime)
+{
+	time += deltaTime;
+	while ((currentTick + 1) * tickLength <= time + tickLength * TICK_EPSILON)
+	{
+		Tick();
+	}
+}
+
+// Set how long a tick is
+void TimerWheel::SetTickLength(double seconds)
+{
+	if (seconds <= 0)
+		return;
+	if (pendingCount > 0)
+	{
+		printf("Cannot change the tick length with %d timers pending\n", pendingCount);
+		return;
+	}
+
+	tickLength = seconds;
+	currentTick = (unsigned long long)std::floor(time / tickLength + TICK_EPSILON);
+}
+
+// Get the seconds the wheel has been advanced by
+double TimerWheel::GetTime()
+{
+	return time;
+}
+
+// Get the current tick
+unsigned long long TimerWheel::GetTick()
+{
+	return currentTick;
+}
+
+// Get the amount of timers waiting to fire
+int TimerWheel::GetPendingCount()
+{
+	return pendingCount;
+}
+
+// Get the amount of timers fired so far
+unsigned long long TimerWheel::GetFiredCount()
+{
+	return firedCount;
+}
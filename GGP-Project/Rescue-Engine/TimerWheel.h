@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <mutex>
+
+//Wheel layout (each level's slots span a whole turn of the level below)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+//Identifies a scheduled timer (stays safe to use after the timer fires)
+struct TimerHandle {
+	int index = -1;
+	unsigned int generation = 0;
+};
+
+// --------------------------------------------------------
+// Singleton
+//
+// Hierarchical timer wheel for gameplay timers. Callbacks are
+// scheduled at a future simulation time and run when the wheel
+// is advanced past it, so objects don't have to count down their
+// own timers every frame (and can sleep until they fire).
+//
+// Time is split into fixed ticks. Level 0 has a slot per tick for
+// the next 256 ticks, each level above has a slot per turn of the
+// level below. Scheduling and cancelling are O(1), and each tick
+// only looks at its own slot. Whenever level 0 wraps around, the
+// next slot of level 1 is spread back down (and so on up).
+//
+// Callbacks run on the thread that advances the wheel, in the
+// order they were scheduled within a tick. They can schedule and
+// cancel timers themselves
+// --------------------------------------------------------
+class TimerWheel
+{
+private:
+	//A scheduled callback, linked into its slot's list
+	struct TimerNode {
+		std::function<void()> callback;
+		unsigned long long dueTick;
+		int slot;       //-1 when the node is free
+		int prev;
+		int next;
+		unsigned int generation;       //Bumped whenever the node is freed
+	};
+
+	std::vector<TimerNode> nodes;
+	int freeNode;       //Head of the free list (linked through next)
+	int slotHeads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+	int slotTails[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+	int pendingCount;
+
+	unsigned long long currentTick;
+	double time;       //Seconds advanced so far
+	double tickLength;
+	unsigned long long firedCount;
+	std::mutex mutex;       //Timers can be scheduled and cancelled from worker threads
+
+	// --------------------------------------------------------
+	// Singleton Constructor - Set up an empty wheel
+	// --------------------------------------------------------
+	TimerWheel();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~TimerWheel();
+
+	// --------------------------------------------------------
+	// Put a node in the slot for its due tick
+	// --------------------------------------------------------
+	void Insert(int node);
+
+	// --------------------------------------------------------
+	// Take a node out of its slot
+	// --------------------------------------------------------
+	void Unlink(int node);
+
+	// --------------------------------------------------------
+	// Take a node out of its slot and put it on the free list
+	// --------------------------------------------------------
+	void Free(int node);
+
+	// --------------------------------------------------------
+	// Spread the current slot of a level back down into the levels below
+	// (cascading the level above first if this level wrapped too)
+	// --------------------------------------------------------
+	void Cascade(int level);
+
+	// --------------------------------------------------------
+	// Move to the next tick and run the timers due on it
+	// --------------------------------------------------------
+	void Tick();
+
+public:
+	// Returns the TimerWheel Instance ---
+	static TimerWheel* GetInstance()
+	{
+		static TimerWheel instance;
+		return &instance;
+	}
+
+	//Delete this
+	TimerWheel(TimerWheel const&) = delete;
+	void operator=(TimerWheel const&) = delete;
+
+	// --------------------------------------------------------
+	// Schedule a callback some ticks from now (at least one)
+	// --------------------------------------------------------
+	TimerHandle ScheduleTicks(unsigned long long ticks, std::function<void()> callback);
+
+	// --------------------------------------------------------
+	// Schedule a callback some seconds from now. It runs on the first
+	// tick at or after that time (and never on the current tick)
+	// --------------------------------------------------------
+	TimerHandle Schedule(double seconds, std::function<void()> callback);
+
+	// --------------------------------------------------------
+	// Cancel a timer. Does nothing if it already fired or was cancelled.
+	// Resets the handle
+	// --------------------------------------------------------
+	void Cancel(TimerHandle& handle);
+
+	// --------------------------------------------------------
+	// Check if a timer is still waiting to fire
+	// --------------------------------------------------------
+	bool IsPending(const TimerHandle& handle);
+
+	// --------------------------------------------------------
+	// Advance the wheel by a simulation step, running every
+	// timer that comes due. Main thread only
+	// --------------------------------------------------------
+	void Advance(float deltaTime);
+
+	// --------------------------------------------------------
+	// Set how long a tick is (only while no timers are pending).
+	// Shorter ticks fire timers closer to their time
+	// --------------------------------------------------------
+	void SetTickLength(double seconds);
+
+	// --------------------------------------------------------
+	// Get the seconds the wheel has been advanced by
+	// --------------------------------------------------------
+	double GetTime();
+
+	// --------------------------------------------------------
+	// Get the current tick
+	// --------------------------------------------------------
+	unsigned long long GetTick();
+
+	// --------------------------------------------------------
+	// Get the amount of timers waiting to fire
+	// --------------------------------------------------------
+	int GetPendingCount();
+
+	// --------------------------------------------------------
+	// Get the amount of timers fired so far
+	// --------------------------------------------------------
+	unsigned long long GetFiredCount();
+};
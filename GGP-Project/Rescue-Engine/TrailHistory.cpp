@@ -0,0 +1,123 @@
+#include "TrailHistory.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+// Lerp between two positions
+static XMFLOAT3 LerpPosition(const XMFLOAT3& a, const XMFLOAT3& b, float t)
+{
+	return XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+// Set up an empty history
+TrailHistory::TrailHistory(float sampleSpacing)
+{
+	this->sampleSpacing = sampleSpacing;
+	Clear();
+}
+
+// Forget the whole path
+void TrailHistory::Clear()
+{
+	samples.clear();
+	firstSampleIndex = 0;
+	head = XMFLOAT3(0, 0, 0);
+	headDistance = 0;
+	started = false;
+}
+
+// Record the leader's position
+void TrailHistory::Record(XMFLOAT3 position)
+{
+	if (!started)
+	{
+		head = position;
+		samples.push_back({ position, 0 });
+		started = true;
+		return;
+	}
+
+	XMFLOAT3 diff = XMFLOAT3(position.x - head.x, position.y - head.y, position.z - head.z);
+	headDistance += sqrtf(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z);
+	head = position;
+
+	//Keep a point every sampleSpacing units
+	if (headDistance - samples.back().distance >= sampleSpacing)
+		samples.push_back({ position, headDistance });
+}
+
+// Get the position a distance behind the leader along its path
+XMFLOAT3 TrailHistory::Sample(float distanceBehind)
+{
+	if (samples.empty())
+		return head;
+
+	double target = headDistance - distanceBehind;
+	const TrailSample& newest = samples.back();
+	const TrailSample& oldest = samples.front();
+
+	//Between the newest point and the leader
+	if (target >= newest.distance)
+	{
+		double span = headDistance - newest.distance;
+		float t = span > 0 ? (float)((target - newest.distance) / span) : 0;
+		return LerpPosition(newest.position, head, t);
+	}
+
+	//Past the end of the path
+	if (target <= oldest.distance)
+		return oldest.position;
+
+	//First point past the target, and the one before it
+	auto next = std::upper_bound(samples.begin(), samples.end(), target,
+		[](double distance, const TrailSample& sample) { return distance < sample.distance; });
+	auto previous = next - 1;
+
+	double span = next->distance - previous->distance;
+	float t = span > 0 ? (float)((target - previous->distance) / span) : 0;
+	return LerpPosition(previous->position, next->position, t);
+}
+
+// Forget the points more than a distance behind the leader
+void TrailHistory::Trim(float keepDistance)
+{
+	double cutoff = headDistance - keepDistance;
+	while (samples.size() > 1 && samples[1].distance <= cutoff)
+	{
+		samples.pop_front();
+		firstSampleIndex++;
+	}
+}
+
+// Get a kept point by its index
+const TrailSample& TrailHistory::GetSample(int index)
+{
+	return samples[index - firstSampleIndex];
+}
+
+// Get the index of the oldest point that's kept
+int TrailHistory::GetFirstSampleIndex()
+{
+	return firstSampleIndex;
+}
+
+// Get the total distance the leader has travelled
+double TrailHistory::GetHeadDistance()
+{
+	return headDistance;
+}
+
+// Get the length of the path that's kept
+float TrailHistory::GetLength()
+{
+	if (samples.empty())
+		return 0;
+	return (float)(headDistance - samples.front().distance);
+}
+
+// Get the amount of points that are kept
+int TrailHistory::GetSampleCount()
+{
+	return (int)samples.size();
+}
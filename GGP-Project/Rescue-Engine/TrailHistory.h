@@ -0,0 +1,88 @@
+#pragma once
+#include <DirectXMath.h>
+#include <deque>
+
+//A point on a trail history
+struct TrailSample
+{
+	DirectX::XMFLOAT3 position;
+	double distance;       //Distance travelled when the point was recorded
+};
+
+// --------------------------------------------------------
+// The path a leader has travelled, stored by distance instead of time.
+//
+// The leader records its position every step, and points are kept
+// every sampleSpacing units along the path. Followers ask for the
+// position a distance behind the leader, so the whole trail shares
+// one history, it doesn't depend on the frame rate, and memory only
+// grows with the length of the path that's kept
+// --------------------------------------------------------
+class TrailHistory
+{
+private:
+	std::deque<TrailSample> samples;       //Oldest first
+	int firstSampleIndex;       //Index of the oldest point (counts every point recorded)
+	DirectX::XMFLOAT3 head;       //Where the leader is now
+	double headDistance;       //Total distance travelled
+	float sampleSpacing;
+	bool started;
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty history
+	//
+	// sampleSpacing - distance between the points that are kept
+	// --------------------------------------------------------
+	TrailHistory(float sampleSpacing = 0.1f);
+
+	// --------------------------------------------------------
+	// Forget the whole path
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Record the leader's position. Call once per step
+	// --------------------------------------------------------
+	void Record(DirectX::XMFLOAT3 position);
+
+	// --------------------------------------------------------
+	// Get the position a distance behind the leader along its path
+	// (the oldest point if the path isn't that long yet). O(log n)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3 Sample(float distanceBehind);
+
+	// --------------------------------------------------------
+	// Forget the points more than a distance behind the leader
+	// (keeps one point past it to sample between)
+	// --------------------------------------------------------
+	void Trim(float keepDistance);
+
+	// --------------------------------------------------------
+	// Get a kept point by its index. Points keep their index (and
+	// never move) until they're trimmed, so a path built from them
+	// only has to add the new ones
+	// --------------------------------------------------------
+	const TrailSample& GetSample(int index);
+
+	// --------------------------------------------------------
+	// Get the index of the oldest point that's kept (the newest is
+	// this plus the amount of points kept, minus one)
+	// --------------------------------------------------------
+	int GetFirstSampleIndex();
+
+	// --------------------------------------------------------
+	// Get the total distance the leader has travelled
+	// --------------------------------------------------------
+	double GetHeadDistance();
+
+	// --------------------------------------------------------
+	// Get the length of the path that's kept
+	// --------------------------------------------------------
+	float GetLength();
+
+	// --------------------------------------------------------
+	// Get the amount of points that are kept
+	// --------------------------------------------------------
+	int GetSampleCount();
+};
@@ -0,0 +1,296 @@
+#include "TrailPath.h"
+#include "ExtendedMath.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+// Set up an empty path
+TrailPath::TrailPath(float radius)
+{
+	this->radius = radius;
+	points.resize(1);
+	firstPoint = 0;
+	pointCount = 0;
+	leafStart = 1;
+	dirty = true;
+	lastNodeVisits = 0;
+}
+
+// Remove every point from the path
+void TrailPath::Clear()
+{
+	firstPoint = 0;
+	pointCount = 0;
+	dirty = true;
+}
+
+// Add a point to the end of the path
+void TrailPath::AddPoint(XMFLOAT3 point)
+{
+	Reserve(pointCount + 1);
+	GetPoint(pointCount) = point;
+	pointCount++;
+
+	//The old last point starts a segment now (or is the lone point)
+	if (!dirty)
+	{
+		RefitLeaf((firstPoint + std::max(pointCount - 2, 0)) & (leafStart - 1));
+		RefitLeaf((firstPoint + pointCount - 1) & (leafStart - 1));
+	}
+}
+
+// Add a point to the start of the path
+void TrailPath::AddFirstPoint(XMFLOAT3 point)
+{
+	Reserve(pointCount + 1);
+	firstPoint = (firstPoint - 1) & (leafStart - 1);
+	pointCount++;
+	GetPoint(0) = point;
+
+	//The new point starts a segment, and the old first point may have
+	//been the lone point
+	if (!dirty)
+	{
+		RefitLeaf(firstPoint);
+		RefitLeaf((firstPoint + 1) & (leafStart - 1));
+	}
+}
+
+// Remove the first point of the path
+void TrailPath::RemoveFirstPoint()
+{
+	if (pointCount == 0)
+		return;
+
+	int oldSlot = firstPoint;
+	firstPoint = (firstPoint + 1) & (leafStart - 1);
+	pointCount--;
+
+	//The old first segment is gone, and the new first point may be alone
+	if (!dirty)
+	{
+		RefitLeaf(oldSlot);
+		RefitLeaf(firstPoint);
+	}
+}
+
+// Move a point that is already on the path
+void TrailPath::SetPoint(int index, XMFLOAT3 point)
+{
+	GetPoint(index) = point;
+
+	//Both segments that share the point
+	if (!dirty)
+	{
+		RefitLeaf((firstPoint + index) & (leafStart - 1));
+		if (index > 0)
+			RefitLeaf((firstPoint + index - 1) & (leafStart - 1));
+	}
+}
+
+// Get a point on the path by its index from the first point
+XMFLOAT3& TrailPath::GetPoint(int index)
+{
+	return points[(firstPoint + index) & (leafStart - 1)];
+}
+
+// Make room in the ring for an amount of points
+void TrailPath::Reserve(int count)
+{
+	if (count <= leafStart)
+		return;
+
+	//Unroll the ring into the first slots of a bigger one
+	int newSize = leafStart;
+	while (newSize < count)
+		newSize *= 2;
+	std::vector<XMFLOAT3> newPoints(newSize);
+	for (int i = 0; i < pointCount; i++)
+		newPoints[i] = GetPoint(i);
+
+	points.swap(newPoints);
+	leafStart = newSize;
+	firstPoint = 0;
+	dirty = true;
+}
+
+// Get the start and end of a segment
+void TrailPath::GetSegment(int segment, XMFLOAT3* start, XMFLOAT3* end)
+{
+	*start = GetPoint(segment);
+	*end = pointCount > 1 ? GetPoint(segment + 1) : GetPoint(segment);
+}
+
+// Fit the leaf of a ring slot to its segment, then refit its parents
+void TrailPath::RefitLeaf(int slot)
+{
+	TrailNode& leaf = nodes[leafStart + slot];
+	int segment = (slot - firstPoint) & (leafStart - 1);
+	if (segment >= GetSegmentCount())
+	{
+		//Empty box that nothing overlaps
+		leaf.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		leaf.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+	else
+	{
+		XMFLOAT3 start;
+		XMFLOAT3 end;
+		GetSegment(segment, &start, &end);
+		leaf.min = XMFLOAT3(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z));
+		leaf.max = XMFLOAT3(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z));
+	}
+
+	//Parents up to the root hold both children
+	for (int i = (leafStart + slot) / 2; i >= 1; i /= 2)
+	{
+		const TrailNode& left = nodes[i * 2];
+		const TrailNode& right = nodes[i * 2 + 1];
+		nodes[i].min = XMFLOAT3(std::min(left.min.x, right.min.x), std::min(left.min.y, right.min.y), std::min(left.min.z, right.min.z));
+		nodes[i].max = XMFLOAT3(std::max(left.max.x, right.max.x), std::max(left.max.y, right.max.y), std::max(left.max.z, right.max.z));
+	}
+}
+
+// Rebuild the bounding hierarchy
+void TrailPath::Build()
+{
+	dirty = false;
+	int segmentCount = GetSegmentCount();
+
+	//One leaf per ring slot (slots with no segment are empty boxes that nothing overlaps)
+	nodes.resize(leafStart * 2);
+	for (int i = 0; i < leafStart; i++)
+	{
+		TrailNode& node = nodes[leafStart + ((firstPoint + i) & (leafStart - 1))];
+		if (i >= segmentCount)
+		{
+			node.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			node.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			continue;
+		}
+
+		XMFLOAT3 start;
+		XMFLOAT3 end;
+		GetSegment(i, &start, &end);
+		node.min = XMFLOAT3(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z));
+		node.max = XMFLOAT3(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z));
+	}
+
+	//Parents hold both children
+	for (int i = leafStart - 1; i >= 1; i--)
+	{
+		const TrailNode& left = nodes[i * 2];
+		const TrailNode& right = nodes[i * 2 + 1];
+		nodes[i].min = XMFLOAT3(std::min(left.min.x, right.min.x), std::min(left.min.y, right.min.y), std::min(left.min.z, right.min.z));
+		nodes[i].max = XMFLOAT3(std::max(left.max.x, right.max.x), std::max(left.max.y, right.max.y), std::max(left.max.z, right.max.z));
+	}
+}
+
+// Check if a capsule touches a segment
+bool TrailPath::SegmentTouches(int segment, const XMFLOAT3& start, const XMFLOAT3& end, float reachSq)
+{
+	XMFLOAT3 segmentStart;
+	XMFLOAT3 segmentEnd;
+	GetSegment(segment, &segmentStart, &segmentEnd);
+	return ExtendedMath::SegmentSegmentDistanceSq(start, end, segmentStart, segmentEnd) <= reachSq;
+}
+
+// Check if a capsule touches the path
+bool TrailPath::IntersectsCapsule(XMFLOAT3 start, XMFLOAT3 end, float capsuleRadius, int* segment)
+{
+	lastNodeVisits = 0;
+	int segmentCount = GetSegmentCount();
+	if (segmentCount == 0)
+		return false;
+	if (dirty)
+		Build();
+
+	//The capsule's box, grown by the path's thickness
+	float reach = capsuleRadius + radius;
+	XMFLOAT3 queryMin = XMFLOAT3(std::min(start.x, end.x) - reach, std::min(start.y, end.y) - reach, std::min(start.z, end.z) - reach);
+	XMFLOAT3 queryMax = XMFLOAT3(std::max(start.x, end.x) + reach, std::max(start.y, end.y) + reach, std::max(start.z, end.z) + reach);
+
+	//Depth first, lower ring slots first
+	int stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 1;
+	while (stackSize > 0)
+	{
+		int index = stack[--stackSize];
+		const TrailNode& node = nodes[index];
+		lastNodeVisits++;
+
+		if (node.min.x > queryMax.x || node.max.x < queryMin.x ||
+			node.min.y > queryMax.y || node.max.y < queryMin.y ||
+			node.min.z > queryMax.z || node.max.z < queryMin.z)
+			continue;
+
+		//Leaf
+		if (index >= leafStart)
+		{
+			int leaf = (index - leafStart - firstPoint) & (leafStart - 1);
+			if (SegmentTouches(leaf, start, end, reach * reach))
+			{
+				if (segment != nullptr)
+					*segment = leaf;
+				return true;
+			}
+			continue;
+		}
+
+		stack[stackSize++] = index * 2 + 1;
+		stack[stackSize++] = index * 2;
+	}
+	return false;
+}
+
+// Check if a capsule touches the path by testing every segment
+bool TrailPath::IntersectsCapsuleBruteForce(XMFLOAT3 start, XMFLOAT3 end, float capsuleRadius, int* segment)
+{
+	float reach = capsuleRadius + radius;
+	int segmentCount = GetSegmentCount();
+	for (int i = 0; i < segmentCount; i++)
+	{
+		if (SegmentTouches(i, start, end, reach * reach))
+		{
+			if (segment != nullptr)
+				*segment = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Get the amount of points on the path
+int TrailPath::GetPointCount()
+{
+	return pointCount;
+}
+
+// Get the amount of segments on the path
+int TrailPath::GetSegmentCount()
+{
+	//A lone point still counts as a (zero length) segment
+	if (pointCount < 2)
+		return pointCount;
+	return pointCount - 1;
+}
+
+// Get the thickness of the path
+float TrailPath::GetRadius()
+{
+	return radius;
+}
+
+// Set the thickness of the path
+void TrailPath::SetRadius(float radius)
+{
+	this->radius = radius;
+}
+
+// Get the amount of hierarchy nodes the last query visited
+int TrailPath::GetLastNodeVisits()
+{
+	return lastNodeVisits;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+//A node of a trail path's bounding hierarchy
+struct TrailNode
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+};
+
+// --------------------------------------------------------
+// A polyline with a thickness (a chain of capsules), used for
+// the centerline of a trail.
+//
+// Segments are kept in a bounding box hierarchy built over
+// consecutive segments (which are close to each other along
+// a trail), so capsule queries only visit the branches near
+// the capsule: O(log n) in the amount of segments.
+//
+// Points are kept in a ring, so a trail that grows at one end and
+// is trimmed at the other only refits the leaves that changed and
+// their parents (O(log n) per point) instead of rebuilding
+// --------------------------------------------------------
+class TrailPath
+{
+private:
+	std::vector<DirectX::XMFLOAT3> points;       //Ring with one slot per leaf
+	int firstPoint;       //Slot of the first point
+	int pointCount;
+	float radius;
+
+	//Complete binary tree stored in an array. Node 1 is the root,
+	//node i's children are 2i and 2i + 1, and the segment that starts
+	//at the point in slot s is leaf leafStart + s
+	std::vector<TrailNode> nodes;
+	int leafStart;
+	bool dirty;       //The whole hierarchy needs a build
+
+	//Stats
+	int lastNodeVisits;
+
+	// --------------------------------------------------------
+	// Get a point on the path by its index from the first point
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3& GetPoint(int index);
+
+	// --------------------------------------------------------
+	// Make room in the ring for an amount of points (the
+	// hierarchy needs a build if it grows)
+	// --------------------------------------------------------
+	void Reserve(int count);
+
+	// --------------------------------------------------------
+	// Fit the leaf of a ring slot to its segment (or empty it if
+	// no segment starts there), then refit its parents
+	// --------------------------------------------------------
+	void RefitLeaf(int slot);
+
+	// --------------------------------------------------------
+	// Get the start and end of a segment (a lone point is a segment
+	// that starts and ends at the same place)
+	// --------------------------------------------------------
+	void GetSegment(int segment, DirectX::XMFLOAT3* start, DirectX::XMFLOAT3* end);
+
+	// --------------------------------------------------------
+	// Check if a capsule touches a segment
+	// --------------------------------------------------------
+	bool SegmentTouches(int segment, const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& end, float reachSq);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty path
+	//
+	// radius - thickness of the path
+	// --------------------------------------------------------
+	TrailPath(float radius = 0);
+
+	// --------------------------------------------------------
+	// Remove every point from the path (keeps the memory)
+	// --------------------------------------------------------
+	void Clear();
+
+	// --------------------------------------------------------
+	// Add a point to the end of the path
+	// --------------------------------------------------------
+	void AddPoint(DirectX::XMFLOAT3 point);
+
+	// --------------------------------------------------------
+	// Add a point to the start of the path
+	// --------------------------------------------------------
+	void AddFirstPoint(DirectX::XMFLOAT3 point);
+
+	// --------------------------------------------------------
+	// Remove the first point of the path
+	// --------------------------------------------------------
+	void RemoveFirstPoint();
+
+	// --------------------------------------------------------
+	// Move a point that is already on the path
+	// --------------------------------------------------------
+	void SetPoint(int index, DirectX::XMFLOAT3 point);
+
+	// --------------------------------------------------------
+	// Rebuild the whole bounding hierarchy. Queries build automatically
+	// after a Clear or when the ring grows; adding, removing and moving
+	// points otherwise only refits the leaves they touch
+	// --------------------------------------------------------
+	void Build();
+
+	// --------------------------------------------------------
+	// Check if a capsule touches the path
+	//
+	// start, end - the capsule's segment
+	// capsuleRadius - the capsule's radius
+	// segment - set to a segment touched (if not nullptr)
+	// --------------------------------------------------------
+	bool IntersectsCapsule(DirectX::XMFLOAT3 start, DirectX::XMFLOAT3 end, float capsuleRadius, int* segment = nullptr);
+
+	// --------------------------------------------------------
+	// Check if a capsule touches the path by testing every segment
+	// (for checking and benchmarking the hierarchy)
+	// --------------------------------------------------------
+	bool IntersectsCapsuleBruteForce(DirectX::XMFLOAT3 start, DirectX::XMFLOAT3 end, float capsuleRadius, int* segment = nullptr);
+
+	// --------------------------------------------------------
+	// Get the amount of points on the path
+	// --------------------------------------------------------
+	int GetPointCount();
+
+	// --------------------------------------------------------
+	// Get the amount of segments on the path
+	// --------------------------------------------------------
+	int GetSegmentCount();
+
+	// --------------------------------------------------------
+	// Get the thickness of the path
+	// --------------------------------------------------------
+	float GetRadius();
+
+	// --------------------------------------------------------
+	// Set the thickness of the path
+	// --------------------------------------------------------
+	void SetRadius(float radius);
+
+	// --------------------------------------------------------
+	// Get the amount of hierarchy nodes the last query visited
+	// --------------------------------------------------------
+	int GetLastNodeVisits();
+};
@@ -0,0 +1,274 @@
+#include "WakeField.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#define PI 3.14159265358979f
+
+//Largest stencil coefficient that stays stable (2D wave equation)
+#define MAX_COEFFICIENT 0.5f
+
+//Most steps run in one advance (so a long frame doesn't stall)
+#define MAX_STEPS_PER_ADVANCE 4
+
+//Rows each job works through
+#define WAKE_ROWS_PER_JOB 16
+
+// Set up an empty field
+WakeField::WakeField()
+{
+	size = 0;
+	extent = 1;
+	cellSize = 1;
+	stepLength = 1;
+	stepTime = 0;
+	coefficient = 0;
+	damping = 1;
+	updateCount = 0;
+	current = 0;
+}
+
+// Destructor
+WakeField::~WakeField()
+{
+}
+
+// Set up a flat field
+bool WakeField::Init(int size, float extent, float waveSpeed, float damping, float stepLength)
+{
+	if (size < 4 || extent <= 0 || stepLength <= 0)
+		return false;
+
+	this->size = size;
+	this->extent = extent;
+	this->stepLength = stepLength;
+	cellSize = extent / (size - 1);
+	stepTime = 0;
+
+	//Ripples faster than a cell a step would blow up, so they're capped
+	float courant = waveSpeed * stepLength / cellSize;
+	coefficient = std::min(courant * courant, MAX_COEFFICIENT);
+	this->damping = expf(-damping * stepLength);
+
+	buffers[0].assign(size * size, 0);
+	buffers[1].assign(size * size, 0);
+	texels.assign(size * size * 4, 0);
+	current = 0;
+	impulses.clear();
+	updateCount++;
+	return true;
+}
+
+// Push the water around a point on the next step
+void WakeField::AddImpulse(float x, float z, float strength, float radius)
+{
+	if (size == 0 || radius <= 0)
+		return;
+
+	Impulse impulse;
+	impulse.x = x;
+	impulse.z = z;
+	impulse.strength = strength;
+	impulse.radius = radius;
+	impulses.push_back(impulse);
+}
+
+// Add the waiting impulses to the current heights
+void WakeField::ApplyImpulses()
+{
+	float* heights = buffers[current].data();
+	float half = extent * 0.5f;
+	for (const Impulse& impulse : impulses)
+	{
+		//Cells the impulse covers (never the edges)
+		int minX = std::max(1, (int)ceilf((impulse.x - impulse.radius + half) / cellSize));
+		int maxX = std::min(size - 2, (int)floorf((impulse.x + impulse.radius + half) / cellSize));
+		int minZ = std::max(1, (int)ceilf((impulse.z - impulse.radius + half) / cellSize));
+		int maxZ = std::min(size - 2, (int)floorf((impulse.z + impulse.radius + half) / cellSize));
+
+		//Smooth bump that falls off to 0 at the radius
+		for (int z = minZ; z <= maxZ; z++)
+		{
+			float dz = z * cellSize - half - impulse.z;
+			for (int x = minX; x <= maxX; x++)
+			{
+				float dx = x * cellSize - half - impulse.x;
+				float distance = sqrtf(dx * dx + dz * dz);
+				if (distance < impulse.radius)
+					heights[z * size + x] -= impulse.strength * 0.5f * (1 + cosf(PI * distance / impulse.radius));
+			}
+		}
+	}
+	impulses.clear();
+}
+
+// Run the steps that are due
+void WakeField::Advance(float deltaTime)
+{
+	if (size == 0)
+		return;
+
+	stepTime += deltaTime;
+	int steps = 0;
+	while (stepTime >= stepLength && steps < MAX_STEPS_PER_ADVANCE)
+	{
+		stepTime -= stepLength;
+		Step();
+		steps++;
+	}
+
+	//Drop the time that couldn't be caught up on
+	if (steps == MAX_STEPS_PER_ADVANCE)
+		stepTime = std::min(stepTime, stepLength);
+}
+
+// Run a step
+void WakeField::Step()
+{
+	ApplyImpulses();
+
+	//Rows only read the current heights and write their own, so they can run in parallel
+	const float* heights = buffers[current].data();
+	float* previous = buffers[1 - current].data();
+	float c = coefficient;
+	float d = damping;
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	jobSystem->ParallelFor(size - 2, WAKE_ROWS_PER_JOB, [&](int begin, int end)
+	{
+		for (int z = begin + 1; z < end + 1; z++)
+		{
+			const float* up = &heights[(z - 1) * size];
+			const float* row = &heights[z * size];
+			const float* down = &heights[(z + 1) * size];
+			float* next = &previous[z * size];
+
+			//The edge cells are left at 0
+			for (int x = 1; x < size - 1; x++)
+			{
+				float laplacian = row[x - 1] + row[x + 1] + (up[x] + down[x]) - row[x] * 4;
+				next[x] = ((row[x] + row[x]) - next[x] + laplacian * c) * d;
+			}
+		}
+	});
+	current = 1 - current;
+
+	//Every row's texels need the rows around it stepped first
+	jobSystem->ParallelFor(size, WAKE_ROWS_PER_JOB, [&](int begin, int end) { UpdateTexels(begin, end); });
+	updateCount++;
+}
+
+// Work out the texels of some rows of the current heights
+void WakeField::UpdateTexels(int begin, int end)
+{
+	const float* heights = buffers[current].data();
+	for (int z = begin; z < end; z++)
+	{
+		float* row = &texels[z * size * 4];
+		for (int x = 0; x < size; x++)
+		{
+			int index = z * size + x;
+			float left = x > 0 ? heights[index - 1] : 0;
+			float right = x < size - 1 ? heights[index + 1] : 0;
+			float up = z > 0 ? heights[index - size] : 0;
+			float down = z < size - 1 ? heights[index + size] : 0;
+			row[x * 4 + 0] = (right - left) / (2 * cellSize);
+			row[x * 4 + 1] = heights[index];
+			row[x * 4 + 2] = (down - up) / (2 * cellSize);
+			row[x * 4 + 3] = 0;
+		}
+	}
+}
+
+// Sample the texels between cells at a world position
+void WakeField::SampleTexel(float x, float z, float* texel)
+{
+	float u = (x + extent * 0.5f) / cellSize;
+	float v = (z + extent * 0.5f) / cellSize;
+	if (!(u >= 0 && v >= 0 && u < size - 1 && v < size - 1))
+	{
+		texel[0] = texel[1] = texel[2] = texel[3] = 0;
+		return;
+	}
+
+	int x0 = (int)u;
+	int z0 = (int)v;
+	float fu = u - x0;
+	float fv = v - z0;
+	const float* topLeft = &texels[(z0 * size + x0) * 4];
+	const float* bottomLeft = topLeft + size * 4;
+	for (int c = 0; c < 4; c++)
+	{
+		float top = topLeft[c] + (topLeft[c + 4] - topLeft[c]) * fu;
+		float bottom = bottomLeft[c] + (bottomLeft[c + 4] - bottomLeft[c]) * fu;
+		texel[c] = top + (bottom - top) * fv;
+	}
+}
+
+// Add the ripples' height under some points to the heights
+void WakeField::AddHeights(const float* xs, const float* zs, float* heights, int count)
+{
+	if (size == 0)
+		return;
+
+	float texel[4];
+	for (int i = 0; i < count; i++)
+	{
+		SampleTexel(xs[i], zs[i], texel);
+		heights[i] += texel[1];
+	}
+}
+
+// Tilt normals by the ripples' slopes under some points
+void WakeField::TiltNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count)
+{
+	if (size == 0)
+		return;
+
+	float texel[4];
+	for (int i = 0; i < count; i++)
+	{
+		SampleTexel(xs[i], zs[i], texel);
+
+		//A normal is (-slope x, 1, -slope z), so slopes just add
+		float nx = nxs[i] / nys[i] - texel[0];
+		float nz = nzs[i] / nys[i] - texel[2];
+		float length = sqrtf(nx * nx + 1 + nz * nz);
+		nxs[i] = nx / length;
+		nys[i] = 1 / length;
+		nzs[i] = nz / length;
+	}
+}
+
+// Fill RGBA texels with the slopes and height
+void WakeField::FillTexels(float* texels, int rowPitch)
+{
+	for (int z = 0; z < size; z++)
+	{
+		memcpy(&texels[z * rowPitch], &this->texels[z * size * 4], size * 4 * sizeof(float));
+	}
+}
+
+// Get the current heights
+const float* WakeField::GetHeights()
+{
+	return buffers[current].data();
+}
+
+// Get the cells along each side
+int WakeField::GetSize()
+{
+	return size;
+}
+
+// Get the world units from one edge to the other
+float WakeField::GetExtent()
+{
+	return extent;
+}
+
+// Get how many steps have been run
+unsigned int WakeField::GetUpdateCount()
+{
+	return updateCount;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// Ripples and wakes on the water, as a damped wave equation on a
+// square heightfield centred on the origin.
+//
+// Things moving through the water push impulses into it, and it's
+// stepped at a fixed rate (which can be lower than the simulation's)
+// with a five-point stencil spread over the JobSystem. The stencil is
+// a plain loop: compilers vectorize it as well as hand-written SIMD.
+// Two buffers are kept, and each step writes the next heights over
+// the previous ones, since that's all a cell's next height needs
+// from them.
+//
+// Each step also lays out every cell's height and slopes together
+// (the same texels the renderer uploads), so a query point only
+// needs one bilinear sample for its height and both slopes.
+//
+// The edges are held flat, so ripples die out at the edge of the
+// field (and it's flat everywhere outside)
+// --------------------------------------------------------
+class WakeField
+{
+private:
+	// --------------------------------------------------------
+	// An impulse waiting for the next step
+	// --------------------------------------------------------
+	struct Impulse
+	{
+		float x;
+		float z;
+		float strength;
+		float radius;
+	};
+
+	int size;       //Cells along each side
+	float extent;       //World units from one edge to the other
+	float cellSize;
+	float stepLength;
+	float stepTime;       //Time waiting to be stepped
+	float coefficient;       //(wave speed * step length / cell size)^2
+	float damping;       //Height kept each step
+	unsigned int updateCount;
+
+	std::vector<float> buffers[2];
+	int current;       //Buffer with the current heights (the other has the previous ones)
+	std::vector<float> texels;       //Slope x, height, slope z and 0 for each cell of the current heights
+	std::vector<Impulse> impulses;
+
+	// --------------------------------------------------------
+	// Add the waiting impulses to the current heights
+	// --------------------------------------------------------
+	void ApplyImpulses();
+
+	// --------------------------------------------------------
+	// Work out the texels of some rows of the current heights
+	// --------------------------------------------------------
+	void UpdateTexels(int begin, int end);
+
+	// --------------------------------------------------------
+	// Sample the texels between cells at a world position
+	// (all 0 outside the field)
+	//
+	// texel - filled with slope x, height, slope z and 0
+	// --------------------------------------------------------
+	void SampleTexel(float x, float z, float* texel);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Set up an empty field (call Init before using it)
+	// --------------------------------------------------------
+	WakeField();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~WakeField();
+
+	// --------------------------------------------------------
+	// Set up a flat field. Returns false if it's too small
+	//
+	// size - cells along each side
+	// extent - world units from one edge to the other
+	// waveSpeed - how fast ripples spread (world units per second)
+	// damping - fraction of the ripples' height lost per second
+	// stepLength - seconds per step (can be longer than a simulation step)
+	// --------------------------------------------------------
+	bool Init(int size, float extent, float waveSpeed, float damping, float stepLength);
+
+	// --------------------------------------------------------
+	// Push the water down (or up, with a negative strength) around
+	// a point on the next step
+	// --------------------------------------------------------
+	void AddImpulse(float x, float z, float strength, float radius);
+
+	// --------------------------------------------------------
+	// Run the steps that are due. Call from the main thread
+	// (it uses the JobSystem)
+	// --------------------------------------------------------
+	void Advance(float deltaTime);
+
+	// --------------------------------------------------------
+	// Run a step
+	// --------------------------------------------------------
+	void Step();
+
+	// --------------------------------------------------------
+	// Add the ripples' height under some points to the heights
+	// --------------------------------------------------------
+	void AddHeights(const float* xs, const float* zs, float* heights, int count);
+
+	// --------------------------------------------------------
+	// Tilt normals by the ripples' slopes under some points
+	// --------------------------------------------------------
+	void TiltNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count);
+
+	// --------------------------------------------------------
+	// Fill RGBA texels with slope x, height, slope z and 0
+	// (rowPitch is in floats)
+	// --------------------------------------------------------
+	void FillTexels(float* texels, int rowPitch);
+
+	// --------------------------------------------------------
+	// Get the current heights (rows along z)
+	// --------------------------------------------------------
+	const float* GetHeights();
+
+	// --------------------------------------------------------
+	// Get the cells along each side
+	// --------------------------------------------------------
+	int GetSize();
+
+	// --------------------------------------------------------
+	// Get the world units from one edge to the other
+	// --------------------------------------------------------
+	float GetExtent();
+
+	// --------------------------------------------------------
+	// Get how many steps have been run
+	// (so copies of the heights know when they're stale)
+	// --------------------------------------------------------
+	unsigned int GetUpdateCount();
+};
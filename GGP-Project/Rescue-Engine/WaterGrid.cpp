@@ -0,0 +1,218 @@
+#include "WaterGrid.h"
+#include "ExtendedMath.h"
+#include <map>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+using namespace DirectX;
+
+// Build the mesh
+WaterGrid::WaterGrid(int ringCount, int cellsAcross, float cellSize, float maxDisplacement, ID3D11Device* device)
+{
+	mesh = nullptr;
+
+	//Rings only line up if the inner square is a whole number of the ring's cells
+	ringCount = std::max(1, ringCount);
+	cellsAcross = std::max(4, cellsAcross / 4 * 4);
+	snapSize = cellSize * (1 << (ringCount - 1));
+	extent = cellsAcross * snapSize;
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned> indices;
+	Build(ringCount, cellsAcross, cellSize, maxDisplacement, vertices, indices);
+	mesh = new Mesh(vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size(), device);
+}
+
+// Destructor for when an instance is deleted
+WaterGrid::~WaterGrid()
+{
+	if (mesh != nullptr)
+		delete mesh;
+}
+
+// Build the rings' vertices, indices and pieces
+void WaterGrid::Build(int ringCount, int cellsAcross, float cellSize, float maxDisplacement,
+	std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+	//Vertices are shared between cells and rings, keyed by their spot in half centre cells
+	std::map<std::pair<int, int>, unsigned> lookup;
+	float halfCell = cellSize * 0.5f;
+	auto vertexAt = [&](int hx, int hz) -> unsigned
+	{
+		auto found = lookup.find(std::make_pair(hx, hz));
+		if (found != lookup.end())
+			return found->second;
+
+		Vertex v;
+		v.Position = XMFLOAT3(hx * halfCell, 0, hz * halfCell);
+		v.UV = XMFLOAT2(v.Position.x, v.Position.z);
+		v.Normal = XMFLOAT3(0, 1, 0);
+		v.Tangent = XMFLOAT3(1, 0, 0);
+		vertices.push_back(v);
+		lookup[std::make_pair(hx, hz)] = (unsigned)vertices.size() - 1;
+		return (unsigned)vertices.size() - 1;
+	};
+
+	int half = cellsAcross / 2;
+	int inner = cellsAcross / 4;
+	for (int ring = 0; ring < ringCount; ring++)
+	{
+		//Rings are split into the strips in front of, behind and to the sides of
+		//the inner ring (and the centre grid into quarters), so pieces behind
+		//the camera don't reach around to the front of it
+		std::vector<unsigned> pieceIndices[4];
+		XMFLOAT2 boundsMin[4], boundsMax[4];
+		for (int q = 0; q < 4; q++)
+		{
+			boundsMin[q] = XMFLOAT2(FLT_MAX, FLT_MAX);
+			boundsMax[q] = XMFLOAT2(-FLT_MAX, -FLT_MAX);
+		}
+		int unit = 2 << ring;       //Half centre cells per cell of this ring
+
+		//Adds a triangle facing up
+		auto addTriangle = [&](std::vector<unsigned>& list, unsigned a, unsigned b, unsigned c)
+		{
+			XMFLOAT3 pa = vertices[a].Position;
+			XMFLOAT3 pb = vertices[b].Position;
+			XMFLOAT3 pc = vertices[c].Position;
+			if ((pb.z - pa.z) * (pc.x - pa.x) - (pb.x - pa.x) * (pc.z - pa.z) < 0)
+				std::swap(b, c);
+			list.push_back(a);
+			list.push_back(b);
+			list.push_back(c);
+		};
+
+		for (int z = -half; z < half; z++)
+		{
+			for (int x = -half; x < half; x++)
+			{
+				bool insideX = x >= -inner && x < inner;
+				bool insideZ = z >= -inner && z < inner;
+				if (ring > 0 && insideX && insideZ)
+					continue;
+
+				int q;
+				if (ring == 0)
+					q = (x >= 0 ? 1 : 0) + (z >= 0 ? 2 : 0);
+				else if (z < -inner)
+					q = 0;
+				else if (z >= inner)
+					q = 1;
+				else
+					q = x < 0 ? 2 : 3;
+				std::vector<unsigned>& list = pieceIndices[q];
+				int x0 = x * unit;
+				int x1 = x0 + unit;
+				int z0 = z * unit;
+				int z1 = z0 + unit;
+				boundsMin[q] = XMFLOAT2(std::min(boundsMin[q].x, x0 * halfCell), std::min(boundsMin[q].y, z0 * halfCell));
+				boundsMax[q] = XMFLOAT2(std::max(boundsMax[q].x, x1 * halfCell), std::max(boundsMax[q].y, z1 * halfCell));
+
+				//Find the edge against the inner ring (P) and the one across from it (Q)
+				int p0x, p0z, p1x, p1z, q0x, q0z, q1x, q1z;
+				bool stitched = ring > 0;
+				if (ring > 0 && insideZ && x == -inner - 1)
+				{
+					p0x = x1; p0z = z0; p1x = x1; p1z = z1;
+					q0x = x0; q0z = z0; q1x = x0; q1z = z1;
+				}
+				else if (ring > 0 && insideZ && x == inner)
+				{
+					p0x = x0; p0z = z0; p1x = x0; p1z = z1;
+					q0x = x1; q0z = z0; q1x = x1; q1z = z1;
+				}
+				else if (ring > 0 && insideX && z == -inner - 1)
+				{
+					p0x = x0; p0z = z1; p1x = x1; p1z = z1;
+					q0x = x0; q0z = z0; q1x = x1; q1z = z0;
+				}
+				else if (ring > 0 && insideX && z == inner)
+				{
+					p0x = x0; p0z = z0; p1x = x1; p1z = z0;
+					q0x = x0; q0z = z1; q1x = x1; q1z = z1;
+				}
+				else
+					stitched = false;
+
+				if (stitched)
+				{
+					//Fan from the inner edge's midpoint, which the inner ring has a vertex on
+					unsigned p0 = vertexAt(p0x, p0z);
+					unsigned p1 = vertexAt(p1x, p1z);
+					unsigned m = vertexAt((p0x + p1x) / 2, (p0z + p1z) / 2);
+					unsigned q0 = vertexAt(q0x, q0z);
+					unsigned q1 = vertexAt(q1x, q1z);
+					addTriangle(list, p0, m, q0);
+					addTriangle(list, m, q1, q0);
+					addTriangle(list, m, p1, q1);
+				}
+				else
+				{
+					unsigned v00 = vertexAt(x0, z0);
+					unsigned v01 = vertexAt(x0, z1);
+					unsigned v10 = vertexAt(x1, z0);
+					unsigned v11 = vertexAt(x1, z1);
+					addTriangle(list, v00, v01, v11);
+					addTriangle(list, v00, v11, v10);
+				}
+			}
+		}
+
+		//Pieces cover their cells, plus how far the waves can move them
+		for (int q = 0; q < 4; q++)
+		{
+			Piece piece;
+			piece.startIndex = (unsigned)indices.size();
+			piece.indexCount = (unsigned)pieceIndices[q].size();
+			piece.min = XMFLOAT3(boundsMin[q].x - maxDisplacement, -maxDisplacement, boundsMin[q].y - maxDisplacement);
+			piece.max = XMFLOAT3(boundsMax[q].x + maxDisplacement, maxDisplacement, boundsMax[q].y + maxDisplacement);
+			pieces.push_back(piece);
+			indices.insert(indices.end(), pieceIndices[q].begin(), pieceIndices[q].end());
+		}
+	}
+}
+
+// Get where the grid's centre goes for a camera position
+XMFLOAT3 WaterGrid::GetCentre(XMFLOAT3 cameraPosition, float surfaceY)
+{
+	return XMFLOAT3(floorf(cameraPosition.x / snapSize + 0.5f) * snapSize, surfaceY,
+		floorf(cameraPosition.z / snapSize + 0.5f) * snapSize);
+}
+
+// Find the runs of the index buffer that are in view
+void WaterGrid::Cull(const XMFLOAT4 planes[6], XMFLOAT3 centre, std::vector<WaterGridRange>& ranges)
+{
+	ranges.clear();
+	for (const Piece& piece : pieces)
+	{
+		XMFLOAT3 min(piece.min.x + centre.x, piece.min.y + centre.y, piece.min.z + centre.z);
+		XMFLOAT3 max(piece.max.x + centre.x, piece.max.y + centre.y, piece.max.z + centre.z);
+		if (piece.indexCount == 0 || !ExtendedMath::BoxInFrustum(planes, min, max))
+			continue;
+
+		//Carry on the last run if this piece follows it
+		if (!ranges.empty() && ranges.back().startIndex + ranges.back().indexCount == piece.startIndex)
+			ranges.back().indexCount += piece.indexCount;
+		else
+			ranges.push_back({ piece.startIndex, piece.indexCount });
+	}
+}
+
+// Get the mesh
+Mesh* WaterGrid::GetMesh()
+{
+	return mesh;
+}
+
+// Get the amount of pieces the rings are split into
+int WaterGrid::GetPieceCount()
+{
+	return (int)pieces.size();
+}
+
+// Get the world units from one edge to the other
+float WaterGrid::GetExtent()
+{
+	return extent;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include "Mesh.h"
+
+// --------------------------------------------------------
+// A run of the water grid's index buffer to draw
+// --------------------------------------------------------
+struct WaterGridRange
+{
+	unsigned int startIndex;
+	unsigned int indexCount;
+};
+
+// --------------------------------------------------------
+// A flat mesh for the water's surface, made of square rings of
+// grid around a fine centre grid (a geometry clipmap, GPU Gems 2,
+// chapter 2). Each ring's cells are twice as big as the ring
+// inside it, and the cells against the inner ring are fanned from
+// the midpoints of its edge so there are no cracks between rings.
+//
+// The mesh is made once and follows the camera around, snapped to
+// the biggest cells so its vertices always land on the same spots
+// on the water (so the waves don't swim over it). Each ring is
+// split into four strips around the ring inside it (and the centre
+// grid into quarters) that are culled against the view frustum
+// --------------------------------------------------------
+class WaterGrid
+{
+private:
+	// --------------------------------------------------------
+	// A strip of a ring, and the box it can be displaced within
+	// --------------------------------------------------------
+	struct Piece
+	{
+		unsigned int startIndex;
+		unsigned int indexCount;
+		DirectX::XMFLOAT3 min;
+		DirectX::XMFLOAT3 max;
+	};
+
+	Mesh* mesh;
+	std::vector<Piece> pieces;       //In index buffer order
+	float snapSize;       //Size of the biggest cells
+	float extent;       //World units from one edge to the other
+
+	// --------------------------------------------------------
+	// Build the rings' vertices, indices and pieces
+	// --------------------------------------------------------
+	void Build(int ringCount, int cellsAcross, float cellSize, float maxDisplacement,
+		std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+
+public:
+	// --------------------------------------------------------
+	// Constructor - Build the mesh
+	//
+	// ringCount - rings around the centre grid (and including it)
+	// cellsAcross - cells along each side of every ring (a multiple of 4)
+	// cellSize - size of the centre grid's cells
+	// maxDisplacement - furthest the waves can move a vertex (for culling)
+	// device - The ID3D11Device for the mesh
+	// --------------------------------------------------------
+	WaterGrid(int ringCount, int cellsAcross, float cellSize, float maxDisplacement, ID3D11Device* device);
+
+	// --------------------------------------------------------
+	// Destructor for when an instance is deleted
+	// --------------------------------------------------------
+	~WaterGrid();
+
+	// --------------------------------------------------------
+	// Get where the grid's centre goes for a camera position
+	// (snapped to the biggest cells)
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3 GetCentre(DirectX::XMFLOAT3 cameraPosition, float surfaceY);
+
+	// --------------------------------------------------------
+	// Find the runs of the index buffer that are in view, with the
+	// grid's centre at a spot. Pieces next to each other in the
+	// buffer are drawn together
+	//
+	// planes - the view frustum's planes (ExtendedMath::FrustumPlanes)
+	// --------------------------------------------------------
+	void Cull(const DirectX::XMFLOAT4 planes[6], DirectX::XMFLOAT3 centre, std::vector<WaterGridRange>& ranges);
+
+	// --------------------------------------------------------
+	// Get the mesh
+	// --------------------------------------------------------
+	Mesh* GetMesh();
+
+	// --------------------------------------------------------
+	// Get the amount of pieces the rings are split into
+	// --------------------------------------------------------
+	int GetPieceCount();
+
+	// --------------------------------------------------------
+	// Get the world units from one edge to the other
+	// --------------------------------------------------------
+	float GetExtent();
+};
@@ -0,0 +1,362 @@
+#include "WaterSurface.h"
+#include "SIMDLanes.h"
+#include <cmath>
+
+//Deep water waves travel at sqrt(g / k)
+#define GRAVITY 9.81f
+
+//Times the height queries step back by the sideways displacement
+#define HEIGHT_ITERATIONS 2
+
+#define TWO_PI 6.28318530717959f
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// The waves, laid out for the kernels. Phases are in turns
+// (1 is a whole wave) so they can be wrapped with a floor
+// --------------------------------------------------------
+struct WaveConstants
+{
+	int count;
+	float kx[MAX_WATER_WAVES];       //Turns per unit along x
+	float kz[MAX_WATER_WAVES];       //Turns per unit along z
+	float phase[MAX_WATER_WAVES];       //Turns at the origin
+	float amplitude[MAX_WATER_WAVES];
+	float sideX[MAX_WATER_WAVES];       //Sideways displacement at the crest (Q * A * D)
+	float sideZ[MAX_WATER_WAVES];
+	float slopeX[MAX_WATER_WAVES];       //Slope at the crest (k * A * D)
+	float slopeZ[MAX_WATER_WAVES];
+	float pinch[MAX_WATER_WAVES];       //How much crests bunch up (Q * k * A)
+};
+
+// --------------------------------------------------------
+// Phase (in turns) of a wave at some points
+// --------------------------------------------------------
+template<typename L>
+static typename L::F WaveTurns(const WaveConstants& c, int w, typename L::F x, typename L::F z)
+{
+	return L::Add(L::Add(L::Mul(L::Set(c.kx[w]), x), L::Mul(L::Set(c.kz[w]), z)), L::Set(c.phase[w]));
+}
+
+// --------------------------------------------------------
+// Find the points on the calm surface that the waves move over
+// the queried points (so their heights are the ones under them)
+// --------------------------------------------------------
+template<typename L>
+static void FindUndisplaced(const WaveConstants& c, typename L::F x, typename L::F z,
+	typename L::F* px, typename L::F* pz)
+{
+	typedef typename L::F F;
+	*px = x;
+	*pz = z;
+	for (int i = 0; i < HEIGHT_ITERATIONS; i++)
+	{
+		F dx = L::Set(0);
+		F dz = L::Set(0);
+		for (int w = 0; w < c.count; w++)
+		{
+			F cosine = SinTurns<L>(L::Add(WaveTurns<L>(c, w, *px, *pz), L::Set(0.25f)));
+			dx = L::Add(dx, L::Mul(L::Set(c.sideX[w]), cosine));
+			dz = L::Add(dz, L::Mul(L::Set(c.sideZ[w]), cosine));
+		}
+		*px = L::Sub(x, dx);
+		*pz = L::Sub(z, dz);
+	}
+}
+
+// --------------------------------------------------------
+// Height kernel - samples the heights under L::Width points
+// --------------------------------------------------------
+template<typename L>
+static void HeightKernel(const WaveConstants& c, float surfaceY, const float* xs, const float* zs, float* heights)
+{
+	typedef typename L::F F;
+	F px, pz;
+	FindUndisplaced<L>(c, L::Load(xs), L::Load(zs), &px, &pz);
+
+	F y = L::Set(surfaceY);
+	for (int w = 0; w < c.count; w++)
+	{
+		y = L::Add(y, L::Mul(L::Set(c.amplitude[w]), SinTurns<L>(WaveTurns<L>(c, w, px, pz))));
+	}
+	L::Store(heights, y);
+}
+
+// --------------------------------------------------------
+// Normal kernel - samples the normals under L::Width points
+// --------------------------------------------------------
+template<typename L>
+static void NormalKernel(const WaveConstants& c, const float* xs, const float* zs,
+	float* nxs, float* nys, float* nzs)
+{
+	typedef typename L::F F;
+	F px, pz;
+	FindUndisplaced<L>(c, L::Load(xs), L::Load(zs), &px, &pz);
+
+	F nx = L::Set(0);
+	F ny = L::Set(1);
+	F nz = L::Set(0);
+	for (int w = 0; w < c.count; w++)
+	{
+		F turns = WaveTurns<L>(c, w, px, pz);
+		F sine = SinTurns<L>(turns);
+		F cosine = SinTurns<L>(L::Add(turns, L::Set(0.25f)));
+		nx = L::Sub(nx, L::Mul(L::Set(c.slopeX[w]), cosine));
+		ny = L::Sub(ny, L::Mul(L::Set(c.pinch[w]), sine));
+		nz = L::Sub(nz, L::Mul(L::Set(c.slopeZ[w]), cosine));
+	}
+
+	F length = L::Sqrt(L::Add(L::Add(L::Mul(nx, nx), L::Mul(ny, ny)), L::Mul(nz, nz)));
+	L::Store(nxs, L::Div(nx, length));
+	L::Store(nys, L::Div(ny, length));
+	L::Store(nzs, L::Div(nz, length));
+}
+
+// --------------------------------------------------------
+// Lay the waves out for the kernels
+// --------------------------------------------------------
+static void GetWaveConstants(const WaterWaveStruct* waves, int count, WaveConstants* c)
+{
+	c->count = count;
+	for (int w = 0; w < count; w++)
+	{
+		const WaterWaveStruct& wave = waves[w];
+		float turnsPerUnit = wave.Frequency / TWO_PI;
+		float slope = wave.Frequency * wave.Amplitude;
+		c->kx[w] = wave.Direction.x * turnsPerUnit;
+		c->kz[w] = wave.Direction.y * turnsPerUnit;
+		c->phase[w] = wave.Phase / TWO_PI;
+		c->amplitude[w] = wave.Amplitude;
+		c->sideX[w] = wave.Steepness * wave.Amplitude * wave.Direction.x;
+		c->sideZ[w] = wave.Steepness * wave.Amplitude * wave.Direction.y;
+		c->slopeX[w] = slope * wave.Direction.x;
+		c->slopeZ[w] = slope * wave.Direction.y;
+		c->pinch[w] = wave.Steepness * slope;
+	}
+}
+
+// Set up a flat surface
+WaterSurface::WaterSurface()
+{
+	waveCount = 0;
+	surfaceY = 0;
+	time = 0;
+	ocean = nullptr;
+	wake = nullptr;
+}
+
+// Destructor
+WaterSurface::~WaterSurface()
+{
+}
+
+// Add a wave to the surface
+bool WaterSurface::AddWave(XMFLOAT2 direction, float wavelength, float amplitude, float steepness)
+{
+	if (waveCount >= MAX_WATER_WAVES || wavelength <= 0)
+		return false;
+
+	//Normalize the direction
+	float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+	if (length <= 0)
+		return false;
+
+	WaterWaveStruct& wave = waves[waveCount];
+	wave.Direction = XMFLOAT2(direction.x / length, direction.y / length);
+	wave.Frequency = TWO_PI / wavelength;
+	wave.Amplitude = amplitude;
+	wave.Phase = 0;
+	wave.Padding = XMFLOAT2(0, 0);
+	this->steepness[waveCount] = steepness;
+	speeds[waveCount] = sqrtf(GRAVITY * wave.Frequency);
+	phases[waveCount] = 0;
+	waveCount++;
+
+	//Steepness is shared between the waves, so adding one flattens the rest
+	for (int w = 0; w < waveCount; w++)
+	{
+		float slope = waves[w].Frequency * waves[w].Amplitude;
+		waves[w].Steepness = slope > 0 ? this->steepness[w] / (slope * waveCount) : 0;
+	}
+	return true;
+}
+
+// Remove every wave
+void WaterSurface::ClearWaves()
+{
+	waveCount = 0;
+}
+
+// Lay an FFT ocean on top of the waves
+void WaterSurface::SetOcean(OceanFFT* ocean)
+{
+	this->ocean = ocean;
+	if (ocean != nullptr)
+		ocean->Update(time);
+}
+
+// Get the FFT ocean on top of the waves
+OceanFFT* WaterSurface::GetOcean()
+{
+	return ocean;
+}
+
+// Lay a wake field on top of the waves
+void WaterSurface::SetWake(WakeField* wake)
+{
+	this->wake = wake;
+}
+
+// Get the wake field on top of the waves
+WakeField* WaterSurface::GetWake()
+{
+	return wake;
+}
+
+// Move the waves forward in time
+void WaterSurface::Advance(float deltaTime)
+{
+	time += deltaTime;
+	for (int w = 0; w < waveCount; w++)
+	{
+		//The crests move along the direction, so the phase at the origin goes down
+		phases[w] = fmod(phases[w] - speeds[w] * (double)deltaTime, (double)TWO_PI);
+		if (phases[w] < 0)
+			phases[w] += TWO_PI;
+		waves[w].Phase = (float)phases[w];
+	}
+
+	if (ocean != nullptr)
+		ocean->Update(time);
+	if (wake != nullptr)
+		wake->Advance(deltaTime);
+}
+
+// Get the time the waves are at
+double WaterSurface::GetTime()
+{
+	return time;
+}
+
+// Set the height of the calm surface
+void WaterSurface::SetSurfaceY(float y)
+{
+	surfaceY = y;
+}
+
+// Get the height of the calm surface
+float WaterSurface::GetSurfaceY()
+{
+	return surfaceY;
+}
+
+// Sample the surface's height under some points
+void WaterSurface::SampleHeights(const float* xs, const float* zs, float* heights, int count)
+{
+	WaveConstants c;
+	GetWaveConstants(waves, waveCount, &c);
+	int i = 0;
+
+#ifdef BATCH_AVX
+	for (; i + AVXLanes::Width <= count; i += AVXLanes::Width)
+	{
+		HeightKernel<AVXLanes>(c, surfaceY, &xs[i], &zs[i], &heights[i]);
+	}
+#endif
+
+#ifdef BATCH_SSE
+	for (; i + SSELanes::Width <= count; i += SSELanes::Width)
+	{
+		HeightKernel<SSELanes>(c, surfaceY, &xs[i], &zs[i], &heights[i]);
+	}
+#endif
+
+	//Leftovers
+	for (; i < count; i++)
+	{
+		HeightKernel<ScalarLanes>(c, surfaceY, &xs[i], &zs[i], &heights[i]);
+	}
+
+	if (ocean != nullptr)
+		ocean->AddHeights(xs, zs, heights, count);
+	if (wake != nullptr)
+		wake->AddHeights(xs, zs, heights, count);
+}
+
+// Sample the surface's normal under some points
+void WaterSurface::SampleNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count)
+{
+	WaveConstants c;
+	GetWaveConstants(waves, waveCount, &c);
+	int i = 0;
+
+#ifdef BATCH_AVX
+	for (; i + AVXLanes::Width <= count; i += AVXLanes::Width)
+	{
+		NormalKernel<AVXLanes>(c, &xs[i], &zs[i], &nxs[i], &nys[i], &nzs[i]);
+	}
+#endif
+
+#ifdef BATCH_SSE
+	for (; i + SSELanes::Width <= count; i += SSELanes::Width)
+	{
+		NormalKernel<SSELanes>(c, &xs[i], &zs[i], &nxs[i], &nys[i], &nzs[i]);
+	}
+#endif
+
+	//Leftovers
+	for (; i < count; i++)
+	{
+		NormalKernel<ScalarLanes>(c, &xs[i], &zs[i], &nxs[i], &nys[i], &nzs[i]);
+	}
+
+	if (ocean != nullptr)
+		ocean->TiltNormals(xs, zs, nxs, nys, nzs, count);
+	if (wake != nullptr)
+		wake->TiltNormals(xs, zs, nxs, nys, nzs, count);
+}
+
+// Sample the heights one point at a time
+void WaterSurface::SampleHeightsScalar(const float* xs, const float* zs, float* heights, int count)
+{
+	WaveConstants c;
+	GetWaveConstants(waves, waveCount, &c);
+	for (int i = 0; i < count; i++)
+	{
+		HeightKernel<ScalarLanes>(c, surfaceY, &xs[i], &zs[i], &heights[i]);
+	}
+
+	if (ocean != nullptr)
+		ocean->AddHeights(xs, zs, heights, count);
+	if (wake != nullptr)
+		wake->AddHeights(xs, zs, heights, count);
+}
+
+// Sample the surface's height under a single point
+float WaterSurface::GetHeight(float x, float z)
+{
+	float height;
+	SampleHeightsScalar(&x, &z, &height, 1);
+	return height;
+}
+
+// Sample the surface's normal under a single point
+XMFLOAT3 WaterSurface::GetNormal(float x, float z)
+{
+	XMFLOAT3 normal;
+	SampleNormals(&x, &z, &normal.x, &normal.y, &normal.z, 1);
+	return normal;
+}
+
+// Get the waves for the vertex shader
+WaterWaveStruct* WaterSurface::GetWaveStructArray()
+{
+	return waves;
+}
+
+// Get the amount of waves
+int WaterSurface::GetWaveCount()
+{
+	return waveCount;
+}
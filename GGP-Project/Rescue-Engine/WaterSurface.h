@@ -0,0 +1,173 @@
+#pragma once
+#include <DirectXMath.h>
+#include "OceanFFT.h"
+#include "WakeField.h"
+
+//Most waves the surface (and the water vertex shader) can sum
+#define MAX_WATER_WAVES 4
+
+// --------------------------------------------------------
+// A Gerstner wave struct definition
+//
+// Wave data to be passed to shaders
+// (matches GerstnerWave in VS_Water.hlsl)
+// --------------------------------------------------------
+struct WaterWaveStruct
+{
+	DirectX::XMFLOAT2	Direction;
+	float				Frequency;	// 2 pi / wavelength
+	float				Amplitude;	// 16 bytes
+
+	float				Steepness;	// Q / (frequency * amplitude * wave count)
+	float				Phase;		// Radians at the origin right now (0 to 2 pi)
+	DirectX::XMFLOAT2	Padding;	// 32 bytes
+};
+
+// --------------------------------------------------------
+// Singleton
+//
+// The water's surface as a sum of Gerstner waves (GPU Gems 1,
+// chapter 1). Heights and normals can be sampled on the CPU a
+// whole array of points at a time with SIMD (8 points at once
+// with AVX, 4 with SSE), and the same waves are handed to the
+// water's vertex shader, so what floats matches what's drawn.
+//
+// Gerstner waves move the surface sideways as well as up, so the
+// height at a point is found by stepping back by the sideways
+// displacement a couple of times before sampling. Phases are kept
+// wrapped in double precision, so the waves don't lose precision
+// however long the game runs.
+//
+// An FFT ocean can be laid on top of the waves for finer chop,
+// and a wake field for ripples, and they're sampled along with them
+// --------------------------------------------------------
+class WaterSurface
+{
+private:
+	WaterWaveStruct waves[MAX_WATER_WAVES];
+	float steepness[MAX_WATER_WAVES];       //Steepness each wave was added with (0 to 1)
+	float speeds[MAX_WATER_WAVES];       //Phase change per second
+	double phases[MAX_WATER_WAVES];
+	int waveCount;
+	float surfaceY;
+	double time;
+	OceanFFT* ocean;       //Not owned
+	WakeField* wake;       //Not owned
+
+	// --------------------------------------------------------
+	// Singleton Constructor - Set up a flat surface
+	// --------------------------------------------------------
+	WaterSurface();
+
+	// --------------------------------------------------------
+	// Destructor
+	// --------------------------------------------------------
+	~WaterSurface();
+
+public:
+	// Returns the WaterSurface Instance ---
+	static WaterSurface* GetInstance()
+	{
+		static WaterSurface instance;
+		return &instance;
+	}
+
+	//Delete this
+	WaterSurface(WaterSurface const&) = delete;
+	void operator=(WaterSurface const&) = delete;
+
+	// --------------------------------------------------------
+	// Add a wave to the surface. Its speed comes from its wavelength
+	// (deep water waves). Returns false if there are too many waves
+	//
+	// direction - which way the wave travels on the XZ plane
+	// wavelength - distance between crests
+	// amplitude - height of the crests above the surface
+	// steepness - how sharp the crests are (0 is a sine wave, 1 is
+	//			   as sharp as they get when every wave's at its peak)
+	// --------------------------------------------------------
+	bool AddWave(DirectX::XMFLOAT2 direction, float wavelength, float amplitude, float steepness);
+
+	// --------------------------------------------------------
+	// Remove every wave (the surface is flat)
+	// --------------------------------------------------------
+	void ClearWaves();
+
+	// --------------------------------------------------------
+	// Lay an FFT ocean on top of the waves (nullptr for none).
+	// The ocean is updated as the waves are advanced
+	// --------------------------------------------------------
+	void SetOcean(OceanFFT* ocean);
+
+	// --------------------------------------------------------
+	// Get the FFT ocean on top of the waves (nullptr if there's none)
+	// --------------------------------------------------------
+	OceanFFT* GetOcean();
+
+	// --------------------------------------------------------
+	// Lay a wake field on top of the waves (nullptr for none).
+	// The field is stepped as the waves are advanced
+	// --------------------------------------------------------
+	void SetWake(WakeField* wake);
+
+	// --------------------------------------------------------
+	// Get the wake field on top of the waves (nullptr if there's none)
+	// --------------------------------------------------------
+	WakeField* GetWake();
+
+	// --------------------------------------------------------
+	// Move the waves forward in time
+	// --------------------------------------------------------
+	void Advance(float deltaTime);
+
+	// --------------------------------------------------------
+	// Get the time the waves are at
+	// --------------------------------------------------------
+	double GetTime();
+
+	// --------------------------------------------------------
+	// Set the height of the calm surface
+	// --------------------------------------------------------
+	void SetSurfaceY(float y);
+
+	// --------------------------------------------------------
+	// Get the height of the calm surface
+	// --------------------------------------------------------
+	float GetSurfaceY();
+
+	// --------------------------------------------------------
+	// Sample the surface's height under some points
+	// --------------------------------------------------------
+	void SampleHeights(const float* xs, const float* zs, float* heights, int count);
+
+	// --------------------------------------------------------
+	// Sample the surface's normal under some points
+	// --------------------------------------------------------
+	void SampleNormals(const float* xs, const float* zs, float* nxs, float* nys, float* nzs, int count);
+
+	// --------------------------------------------------------
+	// Sample the heights one point at a time
+	// (for checking and benchmarking the SIMD path)
+	// --------------------------------------------------------
+	void SampleHeightsScalar(const float* xs, const float* zs, float* heights, int count);
+
+	// --------------------------------------------------------
+	// Sample the surface's height under a single point
+	// --------------------------------------------------------
+	float GetHeight(float x, float z);
+
+	// --------------------------------------------------------
+	// Sample the surface's normal under a single point
+	// --------------------------------------------------------
+	DirectX::XMFLOAT3 GetNormal(float x, float z);
+
+	// --------------------------------------------------------
+	// Get the waves for the vertex shader
+	// --------------------------------------------------------
+	WaterWaveStruct* GetWaveStructArray();
+
+	// --------------------------------------------------------
+	// Get the amount of waves
+	// --------------------------------------------------------
+	int GetWaveCount();
+};